@@ -19,12 +19,43 @@
  * If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* POSIX and GNU extensions (mmap, pthread, sysconf). */
+#define _GNU_SOURCE
+
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <time.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+#include <linux/perf_event.h>
+
+#include "gplgen.h"
+
+#if defined(GPLGEN_PNG)
+#include <zlib.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 extern int errno;
 
@@ -33,6 +64,104 @@ enum {
     TRUE
 };
 
+/* Level ramps of the channel tables. */
+enum {
+    RAMP_LINEAR,
+    RAMP_SRGB,
+    RAMP_GAMMA
+};
+
+/*
+ * Linear level of a channel table (see bchn_lgen_f()),
+ * as a constant expression to build all depths at compile time:
+ * round half away from zero of index*255/(2**byte - 1).
+ */
+#define RAMP_LEVEL(byte, index) \
+    ((index) <= (1 << (byte)) - 1 \
+      ? ((index)*255 + (index)*255 % ((1 << (byte)) - 1)) \
+        / ((1 << (byte)) - 1) \
+      : 0)
+#define RAMP_4(byte, index) \
+    RAMP_LEVEL(byte, (index)), RAMP_LEVEL(byte, (index) + 1), \
+    RAMP_LEVEL(byte, (index) + 2), RAMP_LEVEL(byte, (index) + 3)
+#define RAMP_16(byte, index) \
+    RAMP_4(byte, (index)), RAMP_4(byte, (index) + 4), \
+    RAMP_4(byte, (index) + 8), RAMP_4(byte, (index) + 12)
+#define RAMP_64(byte, index) \
+    RAMP_16(byte, (index)), RAMP_16(byte, (index) + 16), \
+    RAMP_16(byte, (index) + 32), RAMP_16(byte, (index) + 48)
+#define RAMP_256(byte) \
+    RAMP_64(byte, 0), RAMP_64(byte, 64), \
+    RAMP_64(byte, 128), RAMP_64(byte, 192)
+
+/* Output formats of the emitters. */
+enum {
+    FORMAT_GPL,
+    FORMAT_HEX,
+    FORMAT_CSS,
+    FORMAT_JSON,
+    FORMAT_C,
+    FORMAT_ACT
+};
+
+/* Colour names of the GPL records. */
+enum {
+    NAMES_NONE,
+    NAMES_HEX,
+    NAMES_RGB,
+    NAMES_CVD
+};
+
+/* Colour spaces of the grid types (hsv, hsl and oklab). */
+enum {
+    SPACE_HSV,
+    SPACE_HSL,
+    SPACE_OKLAB
+};
+
+/* Interpolation spaces of the gradient type (see gradient_lgen_f()). */
+enum {
+    BLEND_SRGB,
+    BLEND_LINEAR,
+    BLEND_OKLAB
+};
+
+/* Sort keys of the sort stage (see sort_f()). */
+enum {
+    SORT_NONE,
+    SORT_LUMINANCE,
+    SORT_HUE,
+    SORT_SATURATION,
+    SORT_DISTANCE
+};
+
+/*
+ * Pages of the large buffers (see huge_alloc_f()), the pages key:
+ * small (malloc), thp or hugetlb, with prefault and sequential.
+ */
+enum {
+    PAGES_SMALL = 0,
+    PAGES_THP = 1 << 0,
+    PAGES_HUGETLB = 1 << 1,
+    PAGES_PREFAULT = 1 << 2,
+    PAGES_SEQUENTIAL = 1 << 3
+};
+
+/* Longest colour name of a loaded GPL palette (see gpl_lgen_f()). */
+#define GPL_NAMEL ((1 << 8) - 1)
+
+/* Specialised GPL writer for reds levels (make SPECIALISE=1). */
+#define FMT_KERNEL(reds) \
+    unsigned long long \
+    fmt_kernel_##reds##_f( \
+        struct Self *self_sp, \
+        char *output_gp, \
+        unsigned int start, \
+        unsigned int count \
+    ) { \
+        return fmt_kernel_f(self_sp, output_gp, start, count, reds); \
+    }
+
 /*
  * All variables/properties and fuctions/methods
  * are created by structure style,
@@ -40,6 +169,139 @@ enum {
  */
 
 
+#if defined(GPLGEN_LIBRARY)
+/* Requests of the library functions to run_f(). */
+enum {
+    LIBRARY_NONE,
+    LIBRARY_CPAL,
+    LIBRARY_OPEN,
+    LIBRARY_NEXT,
+    LIBRARY_CLOSE
+};
+
+/*
+ * Request of a library function and its result from run_f()
+ * (per thread): the palette string of gplgen_cpal()
+ * or the structure (context) and the chunk of the pull API.
+ */
+static _Thread_local struct {
+    unsigned char mode;
+    char *cpal_gp;
+    unsigned long long cpall;
+    unsigned long long filel;
+    int code;
+    void *self_vp;
+    char *buffer_gp;
+    unsigned long long cap;
+} library_s;
+#endif
+
+/*
+ * Large buffers (sort keys, raw colours and the palette string
+ * of gplgen_cpal()), walked in order or scattered by the radix sort:
+ * 2 MiB pages (hugetlb, else transparent huge pages aligned to 2 MiB)
+ * when they have 2 MiB at least, with the optional prefault
+ * and sequential hints. Any failed mapping falls back
+ * to the next pages, at last to malloc().
+ * The head before the buffer keeps the mapping to free it.
+ */
+#define HUGE_PAGEL (1 << 21)
+#define HUGE_HEADL 64
+
+static void *
+huge_alloc_f(size_t size, unsigned char pages)
+{
+    struct {
+        size_t mapl;
+        unsigned char *map_ap;
+        unsigned char *base_ap;
+    } tmp_s;
+    memset(&tmp_s, 0, sizeof(tmp_s));
+
+    tmp_s.mapl = (size + HUGE_HEADL + HUGE_PAGEL - 1) & ~(size_t)(HUGE_PAGEL - 1);
+    tmp_s.base_ap = MAP_FAILED;
+
+    if (size >= HUGE_PAGEL && (pages & PAGES_HUGETLB))
+        tmp_s.base_ap = mmap(
+            NULL,
+            tmp_s.mapl,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+            -1,
+            0
+        );
+
+    /* Aligned to 2 MiB, so all the mapping can be huge pages. */
+    if (tmp_s.base_ap == MAP_FAILED && size >= HUGE_PAGEL
+          && (pages & (PAGES_THP | PAGES_HUGETLB))) {
+        tmp_s.map_ap = mmap(
+            NULL,
+            tmp_s.mapl + HUGE_PAGEL,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS,
+            -1,
+            0
+        );
+
+        if (tmp_s.map_ap != MAP_FAILED) {
+            tmp_s.base_ap = (unsigned char *)(
+                ((size_t)tmp_s.map_ap + HUGE_PAGEL - 1) & ~(size_t)(HUGE_PAGEL - 1)
+            );
+            if (tmp_s.base_ap > tmp_s.map_ap)
+                munmap(tmp_s.map_ap, tmp_s.base_ap - tmp_s.map_ap);
+            munmap(
+                tmp_s.base_ap + tmp_s.mapl,
+                tmp_s.map_ap + HUGE_PAGEL - tmp_s.base_ap
+            );
+            madvise(tmp_s.base_ap, tmp_s.mapl, MADV_HUGEPAGE);
+        }
+    }
+
+    if (tmp_s.base_ap == MAP_FAILED) {
+        tmp_s.mapl = 0;
+        tmp_s.base_ap = malloc(size + HUGE_HEADL);
+        if (! tmp_s.base_ap)
+            return NULL;
+    } else {
+        if (pages & PAGES_SEQUENTIAL)
+            madvise(tmp_s.base_ap, tmp_s.mapl, MADV_SEQUENTIAL);
+
+        /* Prefault by the kernel (Linux 5.14), else a write per 4 KiB. */
+        if ((pages & PAGES_PREFAULT)
+              && madvise(tmp_s.base_ap, tmp_s.mapl, MADV_POPULATE_WRITE) != 0)
+            for (size_t offset = 0; offset < tmp_s.mapl; offset += 1 << 12)
+                tmp_s.base_ap[offset] = 0;
+    }
+
+    memcpy(tmp_s.base_ap, &tmp_s.mapl, sizeof(size_t));
+
+    return tmp_s.base_ap + HUGE_HEADL;
+}
+
+static void
+huge_free_f(void *buffer_vp)
+{
+    unsigned char *base_ap;
+    size_t mapl;
+
+    if (! buffer_vp)
+        return;
+
+    base_ap = (unsigned char *)buffer_vp - HUGE_HEADL;
+    memcpy(&mapl, base_ap, sizeof(size_t));
+
+    if (mapl)
+        munmap(base_ap, mapl);
+    else
+        free(base_ap);
+}
+
+/*
+ * Exit status of the command (see main()):
+ * 1 when verify has depths different from (or missing in) the manifest.
+ */
+static int status;
+
 /*
  * This function with structure (map) as return,
  * emulate a class with constructor.
@@ -54,11 +316,54 @@ GPLGenC(int argc, char *arg_gap[])
      * are defined inside of this structure definition,
      * to allow use only on a new declared structure (class).
      */
+
+    /*
+     * Loaded GPL palette (see gpl_lgen_f()):
+     * packed RGB entries and a pool of names without terminators,
+     * the name N is from name_ap[N] to name_ap[N + 1] of name_gp.
+     * An empty name is the "#" (no name) of the generated palettes.
+     */
+    struct Palette {
+        unsigned char *rgb_ap;
+        unsigned int count;
+        char *name_gp;
+        unsigned int *name_ap;
+        unsigned char titlel;
+        char title_g[1 << 8];
+        int columns;
+    };
+
+    /* Sidecar index (see index_f()), a native binary file. */
+    struct Index {
+        char magic_g[8];
+        unsigned long long size;
+        long long mtime;
+        unsigned long long head;
+        unsigned int count;
+        unsigned int stride;
+        unsigned int recordl;
+        unsigned int samples;
+    };
+
+    /*
+     * Checkpoint of an output file (see emit_f()), a native binary file:
+     * the chunks written, their end offset and the hash chain
+     * of the key (config), the head and each chunk.
+     */
+    struct Checkpoint {
+        char magic_g[8];
+        unsigned long long key;
+        unsigned long long chunks;
+        unsigned long long offset;
+        unsigned long long hash;
+    };
+
     struct Self {
         struct {
             unsigned char bchn_lmin1;
             unsigned short headerl: 11;
             unsigned long long cpall: 33;
+            unsigned int colourl;
         } buffer_s;
 
         struct {
@@ -67,12 +372,21 @@ GPLGenC(int argc, char *arg_gap[])
                 char *type_gp;
                 unsigned char depthl: 2;
                 unsigned char depth_a[3];
+                unsigned char dedup: 1;
+                unsigned char ramp: 2;
+                float gamma;
+                unsigned short levell_a[3];
+                unsigned char level_a[3][1 << 8];
             } colour_s;
 
             struct {
                 unsigned char titlel;
                 char *title_gp;
                 unsigned char columns;
+                /* Set by the config: 1 (title) and 2 (columns). */
+                unsigned char configured: 2;
+                /* Swatch cell size in pixels, see render_f(). */
+                unsigned short cell;
             } pmap_s;
 
             struct {
@@ -81,14 +395,122 @@ GPLGenC(int argc, char *arg_gap[])
                 unsigned char yearsl;
                 char *years_gp;
             } copyright_s;
+
+            struct {
+                unsigned char pathl;
+                char *path_gp;
+                unsigned short colours;
+            } image_s;
+
+            struct {
+                unsigned char pathl;
+                char *path_gp;
+                /* Palette made by merge_f(), instead of the file. */
+                struct Palette palette_s;
+            } gpl_s;
+
+            struct {
+                unsigned char sort;
+                unsigned char ref_a[3];
+            } sort_s;
+
+            struct {
+                unsigned char stopl;
+                unsigned char stop_aa[32][3];
+                unsigned int steps;
+                unsigned char blend: 2;
+            } gradient_s;
+
+            struct {
+                /* Generator seed of the reduce subcommand. */
+                unsigned long long seed;
+            } reduce_s;
+
+            struct {
+                unsigned short threads;
+                /* Pages of the large buffers (see huge_alloc_f()). */
+                unsigned char pages;
+            } task_s;
         } data_s;
 
         struct {
-            int code: 5;
+            int code: 8;
             unsigned char valuel;
             char *value_gp;
         } error_s;
 
+        struct {
+            unsigned char srgb_ready: 1;
+            /* 3 more bytes to gather 32 bits from the last value. */
+            unsigned char srgb_a[(1 << 16) + 3];
+            /* Cached channel tables of the last non-linear ramp. */
+            unsigned char ramp: 2;
+            float gamma;
+            unsigned char ramp_ready;
+            unsigned char ramp_a[8][1 << 8];
+            /* num*255/den (see sort_key_f()), 3 more bytes to gather. */
+            unsigned char div_ready: 1;
+            unsigned char div_a[(1 << 16) + 3];
+        } table_s;
+
+        struct {
+            unsigned char format;
+            unsigned char names: 2;
+            unsigned int slice_a[2];
+            /* Source of the entries, see src_lgen_f(). */
+            unsigned char gray: 1;
+            const unsigned char *table_ap[3];
+            unsigned short tablel_a[3];
+            unsigned char *colour_ap;
+            unsigned int count;
+            unsigned int start;
+            unsigned int end;
+            /* Names of a loaded palette (GPL only), see gpl_lgen_f(). */
+            char *name_gp;
+            unsigned int *name_ap;
+            /* Records, head and tail, see head_lgen_f() and fmt_f(). */
+            unsigned char generic: 1;
+            unsigned short recordl;
+            unsigned char digits;
+            unsigned short headl;
+            unsigned short taill;
+            char tail_g[(1 << 8)*3 + 4];
+            unsigned char text_ready: 1;
+            char dec_a[1 << 8][4];
+            char zero_a[1 << 8][4];
+            char hex_a[1 << 8][2];
+            /* Sidecar index of the output (recordl 0 to scan it). */
+            unsigned char index: 1;
+            struct Index index_s;
+            /* The GPL terminator was the last byte (see fanout_close_f()). */
+            unsigned char terminator: 1;
+            /* Checkpoint of the output file (resume), see emit_f(). */
+            unsigned char resume: 1;
+            char *ckpt_gp;
+            struct Checkpoint ckpt_s;
+            /*
+             * Simulated colours (protan, deutan and tritan) of the entries,
+             * variant files of the output (cvd), see cvd_lgen_f().
+             */
+            unsigned char cvd: 1;
+            char *cvd_gp;
+            unsigned char *cvd_apa[3];
+        } emit_s;
+
+        /*
+         * Loop position of the pull API (library), see pull_f():
+         * the piece (head, body or tail), the bytes done of it
+         * and a record split between chunks.
+         */
+        struct {
+            char *head_gp;
+            unsigned char piece;
+            unsigned int entry;
+            unsigned long long offset;
+            unsigned short recordl;
+            char *record_gp;
+        } pull_s;
+
         struct Input {
             unsigned char typel;
             char type_g[1 << 8];
@@ -102,17 +524,142 @@ GPLGenC(int argc, char *arg_gap[])
             char author_g[1 << 8];
             unsigned char yearsl;
             char years_g[1 << 8];
+            unsigned char imagel;
+            char image_g[1 << 8];
+            unsigned char coloursl;
+            char colours_g[1 << 8];
+            unsigned char threadsl;
+            char threads_g[1 << 8];
+            unsigned char dedupl;
+            char dedup_g[1 << 8];
+            unsigned char rampl;
+            char ramp_g[1 << 8];
+            unsigned char levelsl;
+            char levels_g[1 << 8];
+            unsigned char rlevelsl;
+            char rlevels_g[1 << 8];
+            unsigned char glevelsl;
+            char glevels_g[1 << 8];
+            unsigned char blevelsl;
+            char blevels_g[1 << 8];
+            unsigned char formatl;
+            char format_g[1 << 8];
+            unsigned char slicel;
+            char slice_g[1 << 8];
+            unsigned char namesl;
+            char names_g[1 << 8];
+            unsigned char palettel;
+            char palette_g[1 << 8];
+            unsigned char sortl;
+            char sort_g[1 << 8];
+            unsigned char indexl;
+            char index_g[1 << 8];
+            unsigned char celll;
+            char cell_g[1 << 8];
+            unsigned char resumel;
+            char resume_g[1 << 8];
+            unsigned char cvdl;
+            char cvd_g[1 << 8];
+            unsigned char stopsl;
+            char stops_g[1 << 8];
+            unsigned char stepsl;
+            char steps_g[1 << 8];
+            unsigned char blendl;
+            char blend_g[1 << 8];
+            unsigned char seedl;
+            char seed_g[1 << 8];
+            unsigned char pagesl;
+            char pages_g[1 << 8];
         } input_s;
 
-        unsigned char *(*bchn_lgen_mp)(struct Self *, unsigned char);
+        const unsigned char *(*bchn_lgen_mp)(
+            struct Self *,
+            unsigned char,
+            unsigned char
+        );
+        unsigned char *(*image_lgen_mp)(struct Self *);
+        unsigned char *(*space_lgen_mp)(struct Self *, unsigned char);
+        unsigned char *(*gradient_lgen_mp)(struct Self *);
+        int (*gpl_lgen_mp)(
+            struct Self *,
+            const char *,
+            struct Palette *,
+            unsigned short
+        );
+        int (*index_mp)(struct Self *, const char *, const struct Index *);
+        int (*lookup_mp)(
+            struct Self *,
+            const char *,
+            unsigned int,
+            unsigned int,
+            struct Palette *
+        );
+        void (*merge_mp)(struct Self *, const char *, int, char *[]);
+        void (*sort_mp)(struct Self *);
+        void (*gpl_free_mp)(struct Palette *);
         char *(*header_lgen_mp)(struct Self *);
+        void (*src_lgen_mp)(struct Self *);
+        char *(*head_lgen_mp)(struct Self *);
+        void (*emit_free_mp)(struct Self *, char *);
         char *(*cpal_lgen_mp)(struct Self *);
+        void (*emit_mp)(struct Self *, FILE *);
+        void (*render_mp)(struct Self *, FILE *, unsigned char);
+        void (*analyse_mp)(struct Self *, FILE *);
+        void (*reduce_mp)(struct Self *, FILE *);
+        void (*error_mp)(struct Self *, int, const char *);
         void (*finput_mp)(struct Self *, FILE *);
+        void (*setup_mp)(struct Self *);
+        void (*config_mp)(struct Self *, struct Input *);
+        void (*setup_free_mp)(struct Self *);
+        int (*server_mp)(struct Self *, const char *, size_t);
+        void (*verify_mp)(struct Self *, const char *);
+        int (*watch_mp)(struct Self *, int, char *[]);
+        int (*batch_mp)(struct Self *, int, char *[]);
+        void (*bench_mp)(struct Self *, int, char *[]);
         void (*run_mp)(struct Self *, int, char *[]);
     };
 
-    unsigned char *
-    bchn_lgen_f(struct Self *self_sp, unsigned char byte) {
+    void
+    error_f(struct Self *self_sp, int code, const char *value_gp) {
+        /* Save the error code and a copy of its value (file name...). */
+        self_sp->error_s.code = code;
+        self_sp->error_s.valuel = strlen(value_gp) + 1;
+        self_sp->error_s.value_gp = (
+            realloc(
+                self_sp->error_s.value_gp,
+                sizeof(char) * self_sp->error_s.valuel
+            )
+        );
+        strcpy(self_sp->error_s.value_gp, value_gp);
+    }
+
+    /* Linear channel tables of all depths (1 to 8), see bchn_lgen_f(). */
+    static const unsigned char linear_a[8][1 << 8] = {
+        {RAMP_256(1)},
+        {RAMP_256(2)},
+        {RAMP_256(3)},
+        {RAMP_256(4)},
+        {RAMP_256(5)},
+        {RAMP_256(6)},
+        {RAMP_256(7)},
+        {RAMP_256(8)}
+    };
+
+    /*
+     * Channel table layer:
+     * the returned tables are shared (compile time or cached),
+     * do not free or change them.
+     */
+    const unsigned char *
+    bchn_lgen_f(struct Self *self_sp, unsigned char byte, unsigned char channel) {
+        /* Explicit levels of this channel (levels, rlevels...). */
+        if (channel < 3 && self_sp->data_s.colour_s.levell_a[channel]) {
+            self_sp->buffer_s.bchn_lmin1 = (
+                self_sp->data_s.colour_s.levell_a[channel] - 1
+            );
+            return self_sp->data_s.colour_s.level_a[channel];
+        }
+
         if (byte<1 || byte>8)
             byte = 8;
 
@@ -124,11 +671,10 @@ GPLGenC(int argc, char *arg_gap[])
         unsigned char quantity = (1 << byte) - 1;
         unsigned char max = (1 << 8) - 1;
 
-        /* Declare and add dynamic memory to the channel array. */
-        unsigned char *channel_ap = malloc(sizeof(char) * (quantity + 1));
-        memset(channel_ap, 0, sizeof(char) * (quantity + 1));
-
         /*
+         * The linear ramp is the RAMP_LEVEL() macro on linear_a,
+         * built at compile time with this formula.
+         *
          * Round half away from zero division for integer calcutation:
          * https://www.calculator.net/rounding-calculator.html
          *
@@ -182,1110 +728,11585 @@ GPLGenC(int argc, char *arg_gap[])
          *
          * Integers calcutation:  (x + x%y)/y
          */
-        for (unsigned char index = 0; index <= quantity; index++) {
-            /* Integers calcutation:  (x + x%y)/y */
-            channel_ap[index] = (
-                (index*max + index*max%quantity)/quantity
-            );
+        if (self_sp->data_s.colour_s.ramp == RAMP_LINEAR) {
+            /* Save the lenght and return the channel array. */
+            self_sp->buffer_s.bchn_lmin1 = quantity;
+            return linear_a[byte - 1];
+        }
+
+        /* Other ramps are computed once and cached. */
+        if (self_sp->table_s.ramp != self_sp->data_s.colour_s.ramp
+              || self_sp->table_s.gamma != self_sp->data_s.colour_s.gamma) {
+            self_sp->table_s.ramp = self_sp->data_s.colour_s.ramp;
+            self_sp->table_s.gamma = self_sp->data_s.colour_s.gamma;
+            self_sp->table_s.ramp_ready = 0;
+        }
+
+        if (! (self_sp->table_s.ramp_ready & 1 << (byte - 1))) {
+            /*
+             * Levels linear in light, encoded to 8 bits:
+             * sRGB transfer function or a pure gamma (1/gamma).
+             */
+            for (unsigned short index = 0; index <= quantity; index++) {
+                double value = (double)index/quantity;
+
+                if (self_sp->data_s.colour_s.ramp == RAMP_SRGB)
+                    value = (
+                        value <= 0.0031308
+                          ? 12.92*value
+                          : 1.055*pow(value, 1/2.4) - 0.055
+                    );
+                else
+                    value = pow(value, 1/self_sp->data_s.colour_s.gamma);
+
+                self_sp->table_s.ramp_a[byte - 1][index] = (
+                    (int)(value*max + 0.5)
+                );
+            }
+            self_sp->table_s.ramp_ready |= 1 << (byte - 1);
         }
 
         /* Save the lenght and return the channel array. */
         self_sp->buffer_s.bchn_lmin1 = quantity;
-        byte, quantity = 0, 0;
-        return channel_ap;
+        return self_sp->table_s.ramp_a[byte - 1];
     }
 
-    char *
-    header_lgen_f(struct Self *self_sp) {
-        /* Default values. */
-        struct {
-            unsigned char authorl;
-            char *author_gp;
-            unsigned char columns;
-            unsigned char columns_lmin1: 2;
-            unsigned char *columns_gp;
-            unsigned char titlel;
-            char *title_gp;
-            unsigned char yearsl;
-            char *years_gp;
-        } tmp_s = {
-            self_sp->data_s.copyright_s.authorl,
-            self_sp->data_s.copyright_s.author_gp,
-            self_sp->data_s.pmap_s.columns,
-            0,
-            NULL,
-            self_sp->data_s.pmap_s.titlel,
-            self_sp->data_s.pmap_s.title_gp,
-            self_sp->data_s.copyright_s.yearsl,
-            self_sp->data_s.copyright_s.years_gp
-        };
+    /*
+     * Slice of a parallel job.
+     * Each thread reads only its own source range
+     * and writes only its own table.
+     */
+    struct Work {
+        const unsigned char *source_ap;
+        unsigned long long start;
+        unsigned long long end;
+        unsigned char channels;
+        unsigned int *table_ap;
+        /* Without a thread, the slice is done by the calling thread. */
+        unsigned char threaded: 1;
+    };
 
-        /* Set columns values. */
-        if (tmp_s.columns < 10)
-            tmp_s.columns_lmin1 = 1;
-        else if (tmp_s.columns < 100)
-            tmp_s.columns_lmin1 = 2;
-        else
-            tmp_s.columns_lmin1 = 3;
+    /* Colour box of the median cut, in 5 bits per channel. */
+    struct Box {
+        unsigned char low_a[3];
+        unsigned char high_a[3];
+        unsigned long long count;
+    };
 
-        /* Declare and add dynamic memory to the columns string. */
-        tmp_s.columns_gp = (
-            malloc(sizeof(char) * (tmp_s.columns_lmin1 + 1))
-        );
-        sprintf(tmp_s.columns_gp, "%hu", tmp_s.columns);
+    void *
+    hist_work_f(void *work_vp) {
+        struct Work *work_sp = work_vp;
+        const unsigned char *pixel_ap;
+        unsigned int bin, last = 0, run = 0;
 
-        /* Default string values. */
+        /*
+         * The table has 1 << 15 bins (5 bits per channel),
+         * 128 KiB per thread, so it stays on the L2 cache
+         * while the source is read only once, block by block.
+         * Same bins in a row are common on images,
+         * count them on a register before touch the table.
+         */
+        for (unsigned long long block = work_sp->start;
+              block < work_sp->end;
+              block += 1 << 14) {
+            unsigned long long end = block + (1 << 14);
+
+            if (end > work_sp->end)
+                end = work_sp->end;
+
+            pixel_ap = work_sp->source_ap + block*work_sp->channels;
+            for (unsigned long long index = block; index < end; index++) {
+                if (work_sp->channels == 3)
+                    bin = (
+                        (pixel_ap[0] >> 3) << 10
+                          | (pixel_ap[1] >> 3) << 5
+                          | pixel_ap[2] >> 3
+                    );
+                else
+                    bin = (
+                        (pixel_ap[0] >> 3) << 10
+                          | (pixel_ap[0] >> 3) << 5
+                          | pixel_ap[0] >> 3
+                    );
+                pixel_ap += work_sp->channels;
+
+                if (bin == last) {
+                    run++;
+                } else {
+                    work_sp->table_ap[last] += run;
+                    last = bin;
+                    run = 1;
+                }
+            }
+        }
+        work_sp->table_ap[last] += run;
+
+        return NULL;
+    }
+
+    void
+    mcut_box_f(const unsigned int *table_ap, struct Box *box_sp) {
+        unsigned char low_a[3] = {31, 31, 31};
+        unsigned char high_a[3] = {0, 0, 0};
+        unsigned char channel_a[3];
+
+        /* Shrink the box to the used bins and count them. */
+        box_sp->count = 0;
+        for (channel_a[0] = box_sp->low_a[0];
+              channel_a[0] <= box_sp->high_a[0];
+              channel_a[0]++)
+            for (channel_a[1] = box_sp->low_a[1];
+                  channel_a[1] <= box_sp->high_a[1];
+                  channel_a[1]++)
+                for (channel_a[2] = box_sp->low_a[2];
+                      channel_a[2] <= box_sp->high_a[2];
+                      channel_a[2]++) {
+                    unsigned int count = table_ap[
+                        channel_a[0] << 10 | channel_a[1] << 5 | channel_a[2]
+                    ];
+
+                    if (! count)
+                        continue;
+
+                    box_sp->count += count;
+                    for (unsigned char index = 0; index < 3; index++) {
+                        if (channel_a[index] < low_a[index])
+                            low_a[index] = channel_a[index];
+                        if (channel_a[index] > high_a[index])
+                            high_a[index] = channel_a[index];
+                    }
+                }
+
+        if (box_sp->count) {
+            memcpy(box_sp->low_a, low_a, sizeof(low_a));
+            memcpy(box_sp->high_a, high_a, sizeof(high_a));
+        }
+    }
+
+    unsigned char *
+    image_lgen_f(struct Self *self_sp) {
         struct {
-            char line1_g[13];
-            char line2a_g[7];
-            char line3a_g[10];
-            char line5a_g[14];
-            char line5c_g[5];
-            char line6a_g[36];
-            char line6b_g[44];
-            char line7a_g[40];
-            char line7b_g[36];
-            char line8a_g[13];
-            char line8b_g[52];
-            char line9a_g[34];
-            char line9b_g[43];
-            char line10_g[34];
-            char line11_g[56];
-            char newline_g[2];
-            char n_sing_g[2];
-            unsigned short lenght: 11;
-        } stg_s = {
-            "GIMP Palette",
-            "Name: ",
-            "Columns: ",
-            "# Written in ",
-            " by ",
-            "# To the extent possible under law,",
-            " the author(s) have dedicated all copyright",
-            "# and related and neighboring rights to",
-            " this software to the public domain",
-            "# worldwide.",
-            " This software is distributed without any warranty.",
-            "# You should have received a copy",
-            " of the CC0 Public Domain Dedication along",
-            "# with this software. If not, see",
-            "# <https://creativecommons.org/publicdomain/zero/1.0/>.",
-            {'\n', '\0'},
-            {'#', '\0'},
-            0
-        };
+            int file;
+            struct stat stat_s;
+            unsigned char *map_ap;
+            unsigned long long index;
+            unsigned char channels;
+            unsigned int value_a[3];
+            unsigned long long pixell;
+            unsigned short threads;
+            unsigned int *table_ap;
+            pthread_t *thread_ap;
+            struct Work *work_ap;
+            struct Box *box_ap;
+            unsigned short boxl;
+            unsigned short colours;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        self_sp->buffer_s.colourl = 0;
+        errno = 0;
+        tmp_s.file = open(self_sp->data_s.image_s.path_gp, O_RDONLY);
+
+        if (tmp_s.file >= 0 && fstat(tmp_s.file, &tmp_s.stat_s) == 0
+              && tmp_s.stat_s.st_size > 2)
+            tmp_s.map_ap = mmap(
+                NULL,
+                tmp_s.stat_s.st_size,
+                PROT_READ,
+                MAP_PRIVATE,
+                tmp_s.file,
+                0
+            );
 
-        /* Declare the lenght of the header string. */
-        stg_s.lenght = (
-            sizeof(stg_s.line1_g)/sizeof(char) - 1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.line2a_g)/sizeof(char) - 1
-              + (unsigned short)tmp_s.titlel - 1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.line3a_g)/sizeof(char) - 1
-              + (unsigned short)tmp_s.columns_lmin1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.n_sing_g)/sizeof(char) - 1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.line5a_g)/sizeof(char) - 1
-              + (unsigned short)tmp_s.yearsl - 1
-              + sizeof(stg_s.line5c_g)/sizeof(char) - 1
-              + (unsigned short)tmp_s.authorl - 1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.line6a_g)/sizeof(char) - 1
-              + sizeof(stg_s.line6b_g)/sizeof(char) - 1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.line7b_g)/sizeof(char) - 1
-              + sizeof(stg_s.line7a_g)/sizeof(char) - 1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.line8b_g)/sizeof(char) - 1
-              + sizeof(stg_s.line8a_g)/sizeof(char) - 1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.line9b_g)/sizeof(char) - 1
-              + sizeof(stg_s.line9a_g)/sizeof(char) - 1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.line10_g)/sizeof(char) - 1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.line11_g)/sizeof(char) - 1
-              + sizeof(stg_s.newline_g)/sizeof(char) - 1
-              + sizeof(stg_s.n_sing_g)/sizeof(char) - 1
-              + sizeof(stg_s.newline_g)/sizeof(char)
-        );
+        if (! tmp_s.map_ap || tmp_s.map_ap == MAP_FAILED) {
+            if (tmp_s.file >= 0 && ! errno)
+                errno = EINVAL;
+            tmp_s.map_ap = NULL;
+        } else {
+            /*
+             * Binary PNM header:
+             * P6 (RGB) or P5 (gray), width, height, maxval,
+             * all separated by spaces or "#" comments.
+             */
+            if (tmp_s.map_ap[0] == 'P' && tmp_s.map_ap[1] == '6')
+                tmp_s.channels = 3;
+            else if (tmp_s.map_ap[0] == 'P' && tmp_s.map_ap[1] == '5')
+                tmp_s.channels = 1;
+            tmp_s.index = 2;
+
+            for (unsigned char value = 0;
+                  tmp_s.channels && value < 3;
+                  value++) {
+                while (tmp_s.index < (unsigned long long)tmp_s.stat_s.st_size
+                      && (isspace(tmp_s.map_ap[tmp_s.index])
+                        || tmp_s.map_ap[tmp_s.index] == '#')) {
+                    if (tmp_s.map_ap[tmp_s.index] == '#')
+                        while (tmp_s.index < (unsigned long long)tmp_s.stat_s.st_size
+                              && tmp_s.map_ap[tmp_s.index] != '\n')
+                            tmp_s.index++;
+                    else
+                        tmp_s.index++;
+                }
 
-        /* Declare and add dynamic memory to the header string. */
-        char *stg_gp = malloc(sizeof(char) * stg_s.lenght);
-        memset(stg_gp, '\0', sizeof(char) * stg_s.lenght);
+                while (tmp_s.index < (unsigned long long)tmp_s.stat_s.st_size
+                      && isdigit(tmp_s.map_ap[tmp_s.index])
+                      && tmp_s.value_a[value] < 1 << 24) {
+                    tmp_s.value_a[value] = (
+                        tmp_s.value_a[value]*10
+                          + tmp_s.map_ap[tmp_s.index] - '0'
+                    );
+                    tmp_s.index++;
+                }
+            }
+            /* Only one space character before the pixels. */
+            tmp_s.index++;
 
-        /* Copy all strings to the header string. */
-        strcat(stg_gp, stg_s.line1_g);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.line2a_g);
-        strcat(stg_gp, tmp_s.title_gp);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.line3a_g);
-        strcat(stg_gp, tmp_s.columns_gp);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.n_sing_g);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.line5a_g);
-        strcat(stg_gp, tmp_s.years_gp);
-        strcat(stg_gp, stg_s.line5c_g);
-        strcat(stg_gp, tmp_s.author_gp);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.line6a_g);
-        strcat(stg_gp, stg_s.line6b_g);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.line7a_g);
-        strcat(stg_gp, stg_s.line7b_g);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.line8a_g);
-        strcat(stg_gp, stg_s.line8b_g);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.line9a_g);
-        strcat(stg_gp, stg_s.line9b_g);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.line10_g);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.line11_g);
-        strcat(stg_gp, stg_s.newline_g);
-        strcat(stg_gp, stg_s.n_sing_g);
-        strcat(stg_gp, stg_s.newline_g);
-        stg_gp[stg_s.lenght - 1] = '\0';
+            tmp_s.pixell = (
+                (unsigned long long)tmp_s.value_a[0] * tmp_s.value_a[1]
+            );
 
-        /* Save the lenght of the header string. */
-        self_sp->buffer_s.headerl = stg_s.lenght;
+            if (! tmp_s.channels
+                  || tmp_s.value_a[2] != (1 << 8) - 1
+                  || tmp_s.index + tmp_s.pixell*tmp_s.channels
+                    > (unsigned long long)tmp_s.stat_s.st_size) {
+                errno = EINVAL;
+                tmp_s.pixell = 0;
+            }
+        }
 
-        /*
-         * Free unused memory.
-         * 0 == '\0' == NULL
-         */
-        memset(
-            self_sp->data_s.copyright_s.author_gp,
-            '\0',
-            sizeof(char) * self_sp->data_s.copyright_s.authorl
-        );
-        memset(
-            self_sp->data_s.pmap_s.title_gp,
-            '\0',
-            sizeof(char) * self_sp->data_s.pmap_s.titlel
-        );
-        memset(
-            self_sp->data_s.copyright_s.years_gp,
-            '\0',
-            sizeof(char) * self_sp->data_s.copyright_s.yearsl
-        );
-        memset(
-            tmp_s.columns_gp,
-            '\0',
-            sizeof(char) * (tmp_s.columns_lmin1 + 1)
-        );
-        self_sp->data_s.copyright_s.authorl = 0;
-        self_sp->data_s.pmap_s.titlel = 0;
-        self_sp->data_s.copyright_s.yearsl = 0;
-        free(self_sp->data_s.copyright_s.author_gp);
-        free(self_sp->data_s.pmap_s.title_gp);
-        free(self_sp->data_s.copyright_s.years_gp);
-        free(tmp_s.columns_gp);
-        self_sp->data_s.copyright_s.author_gp = NULL;
-        self_sp->data_s.pmap_s.title_gp = NULL;
-        self_sp->data_s.copyright_s.years_gp = NULL;
+        if (tmp_s.pixell) {
+            madvise(tmp_s.map_ap, tmp_s.stat_s.st_size, MADV_SEQUENTIAL);
 
-        /*
-         * Clear all unused data.
-         * 0 == '\0' == NULL
-         */
-        memset(&tmp_s, '\0', sizeof(tmp_s));
-        memset(&stg_s, '\0', sizeof(stg_s));
-        self_sp->data_s.pmap_s.columns = 0;
+            /* Small images does not need all threads. */
+            tmp_s.threads = self_sp->data_s.task_s.threads;
+            if (tmp_s.threads > tmp_s.pixell/(1 << 16) + 1)
+                tmp_s.threads = tmp_s.pixell/(1 << 16) + 1;
 
-        /* Return the header string. */
-        return stg_gp;
-    }
+            tmp_s.table_ap = calloc(
+                (unsigned long)tmp_s.threads << 15,
+                sizeof(unsigned int)
+            );
+            tmp_s.thread_ap = calloc(tmp_s.threads, sizeof(pthread_t));
+            tmp_s.work_ap = calloc(tmp_s.threads, sizeof(struct Work));
 
-    char *
-    cpal_lgen_f(struct Self *self_sp) {
-        struct {
-            unsigned char channelsl: 2;
-            unsigned char *channels_ap;
-            unsigned char typel;
-            char *type_gp;
-            unsigned short headerl: 11;
-            char *header_gp;
-            unsigned long long pmapl: 33;
-            char *pmap_gp;
-        } tmp_s = {
-            self_sp->data_s.colour_s.depthl,
-            self_sp->data_s.colour_s.depth_a,
-            self_sp->data_s.colour_s.typel,
-            self_sp->data_s.colour_s.type_gp,
-            self_sp->buffer_s.headerl,
-            self_sp->header_lgen_mp(self_sp),
-            0,
-            NULL
-        };
+            /* Per-thread histograms. */
+            for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+                tmp_s.work_ap[thread].source_ap = (
+                    tmp_s.map_ap + tmp_s.index
+                );
+                tmp_s.work_ap[thread].start = (
+                    tmp_s.pixell*thread/tmp_s.threads
+                );
+                tmp_s.work_ap[thread].end = (
+                    tmp_s.pixell*(thread + 1)/tmp_s.threads
+                );
+                tmp_s.work_ap[thread].channels = tmp_s.channels;
+                tmp_s.work_ap[thread].table_ap = (
+                    tmp_s.table_ap + ((unsigned long)thread << 15)
+                );
 
-        if (strcmp(tmp_s.type_gp, "g") == 0
-              || strcmp(tmp_s.type_gp, "gr") == 0
-              || strcmp(tmp_s.type_gp, "gry") == 0
-              || strcmp(tmp_s.type_gp, "gray") == 0
-              || strcmp(tmp_s.type_gp, "grey") == 0) {
-            /*
-             * Default channel values.
-             * 0 == '\0' == NULL
-             */
-            struct {
-                unsigned char *key_ap;
-                unsigned char key_lmin1;
-                char spaces_g[6];
-                unsigned char key_g[4];
-            } channels_s;
-            memset(&channels_s, '\0', sizeof(channels_s));
+                if (thread) {
+                    tmp_s.work_ap[thread].threaded = ! pthread_create(
+                        &tmp_s.thread_ap[thread],
+                        NULL,
+                        &hist_work_f,
+                        &tmp_s.work_ap[thread]
+                    );
+                    if (! tmp_s.work_ap[thread].threaded)
+                        hist_work_f(&tmp_s.work_ap[thread]);
+                }
+            }
+            hist_work_f(&tmp_s.work_ap[0]);
 
-            /* Set key colour lenght and array. */
-            channels_s.key_ap = (
-                self_sp->bchn_lgen_mp(self_sp, tmp_s.channels_ap[0])
-            );
+            /* Merge all tables to the first table. */
+            for (unsigned short thread = 1; thread < tmp_s.threads; thread++) {
+                if (tmp_s.work_ap[thread].threaded)
+                    pthread_join(tmp_s.thread_ap[thread], NULL);
 
-            /* Set lenght generated by bchn_lgen_mp(). */
-            channels_s.key_lmin1 = self_sp->buffer_s.bchn_lmin1;
+                for (unsigned int bin = 0; bin < 1 << 15; bin++)
+                    tmp_s.table_ap[bin] += (
+                        tmp_s.table_ap[((unsigned long)thread << 15) + bin]
+                    );
+            }
+
+            tmp_s.colours = self_sp->data_s.image_s.colours;
 
             /*
-             * Line lenght is:
-             * 4-1 + 2-1 + 4-1 + 2-1 + 4-1 + 2-1 + 2-1 + 2-1 == 14
-             * tmp_s.pmap_gp lenght is:
-             * sizeof(char) * (keys*line + \0)
+             * Median cut:
+             * split the most populated box on its longest channel,
+             * at the median of its pixels.
              */
-            tmp_s.pmapl = (
-                (channels_s.key_lmin1 + 1)*14 + 1
-            );
+            tmp_s.box_ap = calloc(tmp_s.colours, sizeof(struct Box));
+            memset(tmp_s.box_ap[0].high_a, 31, 3);
+            mcut_box_f(tmp_s.table_ap, &tmp_s.box_ap[0]);
+            tmp_s.boxl = tmp_s.box_ap[0].count ? 1 : 0;
+
+            while (tmp_s.boxl < tmp_s.colours) {
+                struct Box *box_sp = NULL;
+                unsigned char axis = 0;
+                unsigned long long half, count = 0;
+                unsigned char median;
+
+                for (unsigned short box = 0; box < tmp_s.boxl; box++)
+                    if ((! box_sp || tmp_s.box_ap[box].count > box_sp->count)
+                          && (tmp_s.box_ap[box].low_a[0]
+                                != tmp_s.box_ap[box].high_a[0]
+                            || tmp_s.box_ap[box].low_a[1]
+                              != tmp_s.box_ap[box].high_a[1]
+                            || tmp_s.box_ap[box].low_a[2]
+                              != tmp_s.box_ap[box].high_a[2]))
+                        box_sp = &tmp_s.box_ap[box];
+
+                /* All boxes are single bins. */
+                if (! box_sp)
+                    break;
+
+                for (unsigned char index = 1; index < 3; index++)
+                    if (box_sp->high_a[index] - box_sp->low_a[index]
+                          > box_sp->high_a[axis] - box_sp->low_a[axis])
+                        axis = index;
+
+                /* Find the median plane (keeping both halves non-empty). */
+                half = box_sp->count/2;
+                for (median = box_sp->low_a[axis];
+                      median < box_sp->high_a[axis] - 1;
+                      median++) {
+                    struct Box plane_s = *box_sp;
+
+                    plane_s.low_a[axis] = median;
+                    plane_s.high_a[axis] = median;
+                    mcut_box_f(tmp_s.table_ap, &plane_s);
+                    count += plane_s.count;
+
+                    if (count >= half)
+                        break;
+                }
 
-            /* Declare and add dynamic memory to the pmap string. */
-            tmp_s.pmap_gp = malloc(sizeof(char) * tmp_s.pmapl);
-            memset(tmp_s.pmap_gp, '\0', sizeof(char) * tmp_s.pmapl);
+                tmp_s.box_ap[tmp_s.boxl] = *box_sp;
+                box_sp->high_a[axis] = median;
+                tmp_s.box_ap[tmp_s.boxl].low_a[axis] = median + 1;
+                mcut_box_f(tmp_s.table_ap, box_sp);
+                mcut_box_f(tmp_s.table_ap, &tmp_s.box_ap[tmp_s.boxl]);
+                tmp_s.boxl++;
+            }
+        }
 
-            for (unsigned char key_index = 0;
-                  key_index <= (channels_s.key_lmin1 + 1)-1;
-                  key_index++) {
-                if (channels_s.key_ap[key_index] <= 9)
-                    strcpy(channels_s.spaces_g, "  %hu");
-                else if (channels_s.key_ap[key_index] <= 99)
-                    strcpy(channels_s.spaces_g, " %hu\0");
-                else
-                    strcpy(channels_s.spaces_g, "%hu\0\0");
+        /* Declare and add dynamic memory to the colour array. */
+        unsigned char *colour_ap = malloc(sizeof(char) * 3*tmp_s.boxl + 1);
+
+        /* Box colour is the mean of its bins (center of the bin). */
+        for (unsigned short box = 0; box < tmp_s.boxl; box++) {
+            unsigned long long sum_a[3] = {0, 0, 0};
+            unsigned char channel_a[3];
+            struct Box *box_sp = &tmp_s.box_ap[box];
+
+            for (channel_a[0] = box_sp->low_a[0];
+                  channel_a[0] <= box_sp->high_a[0];
+                  channel_a[0]++)
+                for (channel_a[1] = box_sp->low_a[1];
+                      channel_a[1] <= box_sp->high_a[1];
+                      channel_a[1]++)
+                    for (channel_a[2] = box_sp->low_a[2];
+                          channel_a[2] <= box_sp->high_a[2];
+                          channel_a[2]++) {
+                        unsigned int count = tmp_s.table_ap[
+                            channel_a[0] << 10
+                              | channel_a[1] << 5
+                              | channel_a[2]
+                        ];
+
+                        for (unsigned char index = 0; index < 3; index++)
+                            sum_a[index] += (
+                                (unsigned long long)count
+                                  * (channel_a[index]*8 + 4)
+                            );
+                    }
 
-                sprintf(
-                    channels_s.key_g,
-                    channels_s.spaces_g,
-                    channels_s.key_ap[key_index]
+            /* Integers calcutation:  (x + y/2)/y */
+            for (unsigned char index = 0; index < 3; index++)
+                colour_ap[box*3 + index] = (
+                    (sum_a[index] + box_sp->count/2)/box_sp->count
                 );
+        }
 
-                strcat(tmp_s.pmap_gp, channels_s.key_g);
-                strcat(tmp_s.pmap_gp, " ");
-                strcat(tmp_s.pmap_gp, channels_s.key_g);
-                strcat(tmp_s.pmap_gp, " ");
-                strcat(tmp_s.pmap_gp, channels_s.key_g);
-                strcat(tmp_s.pmap_gp, "\t");
-                strcat(tmp_s.pmap_gp, "#");
-                strcat(tmp_s.pmap_gp, "\n");
-            }
+        /* Save the errors. */
+        if (! tmp_s.pixell)
+            self_sp->error_mp(self_sp, errno, self_sp->data_s.image_s.path_gp);
 
-            /*
-             * Free unused channels memory.
-             * 0 == '\0' == NULL
-             */
-            memset(
-                channels_s.key_ap,
-                0,
-                sizeof(char) * (channels_s.key_lmin1 + 1)
-            );
-            free(channels_s.key_ap);
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        if (tmp_s.map_ap)
+            munmap(tmp_s.map_ap, tmp_s.stat_s.st_size);
+        if (tmp_s.file >= 0)
+            close(tmp_s.file);
+        free(tmp_s.table_ap);
+        free(tmp_s.thread_ap);
+        free(tmp_s.work_ap);
+        free(tmp_s.box_ap);
+
+        /* Save the lenght and return the colour array. */
+        self_sp->buffer_s.colourl = tmp_s.boxl;
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+        return colour_ap;
+    }
 
-            /*
-             * Clear all unused channels data.
-             * 0 == '\0' == NULL
-             */
-            memset(&channels_s, '\0', sizeof(channels_s));
-        } else {
-            /*
-             * Default channel values.
-             * 0 == '\0' == NULL
-             */
-            struct {
-                unsigned char *red_ap;
-                unsigned char *green_ap;
-                unsigned char *blue_ap;
-                unsigned char red_lmin1;
-                unsigned char green_lmin1;
-                unsigned char blue_lmin1;
-                char spaces_g[6];
-                unsigned char red_g[4];
-                unsigned char green_g[4];
-                unsigned char blue_g[4];
-            } channels_s;
-            memset(&channels_s, '\0', sizeof(channels_s));
+    void
+    space_conv_f(
+        unsigned char space,
+        const float *x_ap,
+        const float *y_ap,
+        const float *z_ap,
+        unsigned char *rgb_ap,
+        unsigned int count,
+        const unsigned char *srgb_ap
+    ) {
+        /*
+         * Scalar conversion to 8 bits sRGB.
+         * Keep the same operations (and order) of the AVX2 version,
+         * both versions must return the same bytes.
+         */
+        for (unsigned int index = 0; index < count; index++) {
+            float x = x_ap[index], y = y_ap[index], z = z_ap[index];
+            float channel_a[3];
+
+            if (space == SPACE_OKLAB) {
+                /* OKLab (L, a, b) to linear sRGB. */
+                float l = x + 0.3963377774f*y + 0.2158037573f*z;
+                float m = x - 0.1055613458f*y - 0.0638541728f*z;
+                float s = x - 0.0894841775f*y - 1.2914855480f*z;
+
+                l = l*l*l;
+                m = m*m*m;
+                s = s*s*s;
+
+                channel_a[0] = (
+                    4.0767416621f*l - 3.3077115913f*m + 0.2309699292f*s
+                );
+                channel_a[1] = (
+                    -1.2684380046f*l + 2.6097574011f*m - 0.3413193965f*s
+                );
+                channel_a[2] = (
+                    -0.0041960863f*l - 0.7034186147f*m + 1.7076147010f*s
+                );
 
-            /* Set blue colour lenght and array. */
-            channels_s.blue_ap = (
-                self_sp->bchn_lgen_mp(self_sp, tmp_s.channels_ap[2])
-            );
+                for (unsigned char channel = 0; channel < 3; channel++) {
+                    float value = channel_a[channel];
 
-            /* Set lenght generated by bchn_lgen_mp(). */
-            channels_s.blue_lmin1 = self_sp->buffer_s.bchn_lmin1;
+                    value = value > 0.0f ? value : 0.0f;
+                    value = value < 1.0f ? value : 1.0f;
+                    rgb_ap[index*3 + channel] = (
+                        srgb_ap[(int)(value*65535.0f + 0.5f)]
+                    );
+                }
+                continue;
+            }
 
-            /* Set green colour lenght and array. */
-            channels_s.green_ap = (
-                self_sp->bchn_lgen_mp(self_sp, tmp_s.channels_ap[1])
-            );
+            for (unsigned char channel = 0; channel < 3; channel++) {
+                float turn, sector, weight, value;
+
+                if (space == SPACE_HSV) {
+                    /* f(n) = v - v*s*max(0, min(k, 4 - k, 1)) */
+                    turn = (float)(5 - channel*2) + 6.0f*x;
+                    sector = turn >= 6.0f ? turn - 6.0f : turn;
+                    weight = sector < 4.0f - sector ? sector : 4.0f - sector;
+                    weight = weight < 1.0f ? weight : 1.0f;
+                    weight = weight > 0.0f ? weight : 0.0f;
+                    value = z - z*y*weight;
+                } else {
+                    /* f(n) = l - s*min(l, 1 - l)*max(-1, min(k - 3, 9 - k, 1)) */
+                    float chroma = z < 1.0f - z ? z : 1.0f - z;
+
+                    chroma = y*chroma;
+                    turn = (float)((12 - channel*4) % 12) + 12.0f*x;
+                    sector = turn >= 12.0f ? turn - 12.0f : turn;
+                    weight = (
+                        sector - 3.0f < 9.0f - sector
+                          ? sector - 3.0f
+                          : 9.0f - sector
+                    );
+                    weight = weight < 1.0f ? weight : 1.0f;
+                    weight = weight > -1.0f ? weight : -1.0f;
+                    value = z - chroma*weight;
+                }
 
-            /* Set lenght generated by bchn_lgen_mp(). */
-            channels_s.green_lmin1 = self_sp->buffer_s.bchn_lmin1;
+                value = value > 0.0f ? value : 0.0f;
+                value = value < 1.0f ? value : 1.0f;
+                rgb_ap[index*3 + channel] = (int)(value*255.0f + 0.5f);
+            }
+        }
+    }
 
-            /* Set red colour lenght and array. */
-            channels_s.red_ap = (
-                self_sp->bchn_lgen_mp(self_sp, tmp_s.channels_ap[0])
-            );
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("avx2")))
+    void
+    space_conv_avx2_f(
+        unsigned char space,
+        const float *x_ap,
+        const float *y_ap,
+        const float *z_ap,
+        unsigned char *rgb_ap,
+        unsigned int count,
+        const unsigned char *srgb_ap
+    ) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        unsigned int index = 0;
+        int value_a[3][8];
+
+        for (; index + 8 <= count; index += 8) {
+            __m256 x = _mm256_loadu_ps(&x_ap[index]);
+            __m256 y = _mm256_loadu_ps(&y_ap[index]);
+            __m256 z = _mm256_loadu_ps(&z_ap[index]);
+            __m256 channel_a[3];
+
+            if (space == SPACE_OKLAB) {
+                __m256 l = _mm256_add_ps(
+                    _mm256_add_ps(
+                        x,
+                        _mm256_mul_ps(_mm256_set1_ps(0.3963377774f), y)
+                    ),
+                    _mm256_mul_ps(_mm256_set1_ps(0.2158037573f), z)
+                );
+                __m256 m = _mm256_sub_ps(
+                    _mm256_sub_ps(
+                        x,
+                        _mm256_mul_ps(_mm256_set1_ps(0.1055613458f), y)
+                    ),
+                    _mm256_mul_ps(_mm256_set1_ps(0.0638541728f), z)
+                );
+                __m256 s = _mm256_sub_ps(
+                    _mm256_sub_ps(
+                        x,
+                        _mm256_mul_ps(_mm256_set1_ps(0.0894841775f), y)
+                    ),
+                    _mm256_mul_ps(_mm256_set1_ps(1.2914855480f), z)
+                );
 
-            /* Set lenght generated by bchn_lgen_mp(). */
-            channels_s.red_lmin1 = self_sp->buffer_s.bchn_lmin1;
+                l = _mm256_mul_ps(_mm256_mul_ps(l, l), l);
+                m = _mm256_mul_ps(_mm256_mul_ps(m, m), m);
+                s = _mm256_mul_ps(_mm256_mul_ps(s, s), s);
 
-            /*
-             * Line lenght is:
-             * 4-1 + 2-1 + 4-1 + 2-1 + 4-1 + 2-1 + 2-1 + 2-1 == 14
-             * tmp_s.pmap_gp lenght is:
-             * sizeof(char) * (reds*greens*blues*line + \0)
-             */
-            tmp_s.pmapl = (
-                (
-                    (channels_s.red_lmin1 + 1)
-                      * (channels_s.green_lmin1 + 1)
-                      * (channels_s.blue_lmin1 + 1)
-                      * 14
-                ) + 1
-            );
-
-            /* Declare and add dynamic memory to the pmap string. */
-            tmp_s.pmap_gp = malloc(sizeof(char) * tmp_s.pmapl);
-            memset(tmp_s.pmap_gp, '\0', sizeof(char) * tmp_s.pmapl);
-
-            for (unsigned char blue_index = 0;
-                  blue_index <= (channels_s.blue_lmin1 + 1)-1;
-                  blue_index++) {
-                for (unsigned char green_index = 0;
-                      green_index <= (channels_s.green_lmin1 + 1)-1;
-                      green_index++) {
-                    for (unsigned char red_index = 0;
-                           red_index <= (channels_s.red_lmin1 + 1)-1;
-                           red_index++) {
-
-                        if (channels_s.blue_ap[blue_index] <= 9)
-                            strcpy(channels_s.spaces_g, "  %hu");
-                        else if (channels_s.blue_ap[blue_index] <= 99)
-                            strcpy(channels_s.spaces_g, " %hu\0");
-                        else
-                            strcpy(channels_s.spaces_g, "%hu\0\0");
+                channel_a[0] = _mm256_add_ps(
+                    _mm256_sub_ps(
+                        _mm256_mul_ps(_mm256_set1_ps(4.0767416621f), l),
+                        _mm256_mul_ps(_mm256_set1_ps(3.3077115913f), m)
+                    ),
+                    _mm256_mul_ps(_mm256_set1_ps(0.2309699292f), s)
+                );
+                channel_a[1] = _mm256_sub_ps(
+                    _mm256_add_ps(
+                        _mm256_mul_ps(_mm256_set1_ps(-1.2684380046f), l),
+                        _mm256_mul_ps(_mm256_set1_ps(2.6097574011f), m)
+                    ),
+                    _mm256_mul_ps(_mm256_set1_ps(0.3413193965f), s)
+                );
+                channel_a[2] = _mm256_add_ps(
+                    _mm256_sub_ps(
+                        _mm256_mul_ps(_mm256_set1_ps(-0.0041960863f), l),
+                        _mm256_mul_ps(_mm256_set1_ps(0.7034186147f), m)
+                    ),
+                    _mm256_mul_ps(_mm256_set1_ps(1.7076147010f), s)
+                );
 
-                        sprintf(
-                            channels_s.blue_g,
-                            channels_s.spaces_g,
-                            channels_s.blue_ap[blue_index]
-                        );
+                /* Linear light to sRGB by the table (gather). */
+                for (unsigned char channel = 0; channel < 3; channel++) {
+                    __m256 value = _mm256_min_ps(
+                        _mm256_max_ps(channel_a[channel], zero),
+                        one
+                    );
+                    __m256i key = _mm256_cvttps_epi32(
+                        _mm256_add_ps(
+                            _mm256_mul_ps(value, _mm256_set1_ps(65535.0f)),
+                            _mm256_set1_ps(0.5f)
+                        )
+                    );
 
-                        if (channels_s.green_ap[green_index] <= 9)
-                            strcpy(channels_s.spaces_g, "  %hu");
-                        else if (channels_s.green_ap[green_index] <= 99)
-                            strcpy(channels_s.spaces_g, " %hu\0");
-                        else
-                            strcpy(channels_s.spaces_g, "%hu\0\0");
+                    _mm256_storeu_si256(
+                        (__m256i *)value_a[channel],
+                        _mm256_and_si256(
+                            _mm256_i32gather_epi32(
+                                (const int *)srgb_ap,
+                                key,
+                                1
+                            ),
+                            _mm256_set1_epi32(0xff)
+                        )
+                    );
+                }
+            } else {
+                for (unsigned char channel = 0; channel < 3; channel++) {
+                    __m256 turn, sector, weight, value;
 
-                        sprintf(
-                            channels_s.green_g,
-                            channels_s.spaces_g,
-                            channels_s.green_ap[green_index]
+                    if (space == SPACE_HSV) {
+                        turn = _mm256_add_ps(
+                            _mm256_set1_ps((float)(5 - channel*2)),
+                            _mm256_mul_ps(_mm256_set1_ps(6.0f), x)
                         );
-
-                        if (channels_s.red_ap[red_index] <= 9)
-                            strcpy(channels_s.spaces_g, "  %hu");
-                        else if (channels_s.red_ap[red_index] <= 99)
-                            strcpy(channels_s.spaces_g, " %hu\0");
-                        else
-                            strcpy(channels_s.spaces_g, "%hu\0\0");
-
-                        sprintf(
-                            channels_s.red_g,
-                            channels_s.spaces_g,
-                            channels_s.red_ap[red_index]
+                        sector = _mm256_sub_ps(
+                            turn,
+                            _mm256_and_ps(
+                                _mm256_cmp_ps(
+                                    turn,
+                                    _mm256_set1_ps(6.0f),
+                                    _CMP_GE_OQ
+                                ),
+                                _mm256_set1_ps(6.0f)
+                            )
+                        );
+                        weight = _mm256_min_ps(
+                            sector,
+                            _mm256_sub_ps(_mm256_set1_ps(4.0f), sector)
+                        );
+                        weight = _mm256_max_ps(
+                            _mm256_min_ps(weight, one),
+                            zero
+                        );
+                        value = _mm256_sub_ps(
+                            z,
+                            _mm256_mul_ps(_mm256_mul_ps(z, y), weight)
+                        );
+                    } else {
+                        __m256 chroma = _mm256_mul_ps(
+                            y,
+                            _mm256_min_ps(z, _mm256_sub_ps(one, z))
                         );
 
-                        strcat(tmp_s.pmap_gp, channels_s.red_g);
-                        strcat(tmp_s.pmap_gp, " ");
-                        strcat(tmp_s.pmap_gp, channels_s.green_g);
-                        strcat(tmp_s.pmap_gp, " ");
-                        strcat(tmp_s.pmap_gp, channels_s.blue_g);
-                        strcat(tmp_s.pmap_gp, "\t");
-                        strcat(tmp_s.pmap_gp, "#");
-                        strcat(tmp_s.pmap_gp, "\n");
+                        turn = _mm256_add_ps(
+                            _mm256_set1_ps((float)((12 - channel*4) % 12)),
+                            _mm256_mul_ps(_mm256_set1_ps(12.0f), x)
+                        );
+                        sector = _mm256_sub_ps(
+                            turn,
+                            _mm256_and_ps(
+                                _mm256_cmp_ps(
+                                    turn,
+                                    _mm256_set1_ps(12.0f),
+                                    _CMP_GE_OQ
+                                ),
+                                _mm256_set1_ps(12.0f)
+                            )
+                        );
+                        weight = _mm256_min_ps(
+                            _mm256_sub_ps(sector, _mm256_set1_ps(3.0f)),
+                            _mm256_sub_ps(_mm256_set1_ps(9.0f), sector)
+                        );
+                        weight = _mm256_max_ps(
+                            _mm256_min_ps(weight, one),
+                            _mm256_set1_ps(-1.0f)
+                        );
+                        value = _mm256_sub_ps(z, _mm256_mul_ps(chroma, weight));
                     }
+
+                    value = _mm256_min_ps(_mm256_max_ps(value, zero), one);
+                    _mm256_storeu_si256(
+                        (__m256i *)value_a[channel],
+                        _mm256_cvttps_epi32(
+                            _mm256_add_ps(
+                                _mm256_mul_ps(value, _mm256_set1_ps(255.0f)),
+                                _mm256_set1_ps(0.5f)
+                            )
+                        )
+                    );
                 }
             }
 
-            /*
-             * Free unused channels memory.
-             * 0 == '\0' == NULL
-             */
-            memset(
-                channels_s.blue_ap,
-                0,
-                sizeof(char) * (channels_s.blue_lmin1 + 1)
-            );
-            memset(
-                channels_s.green_ap,
-                0,
-                sizeof(char) * (channels_s.green_lmin1 + 1)
-            );
-            memset(
-                channels_s.red_ap,
-                0,
-                sizeof(char) * (channels_s.red_lmin1 + 1)
-            );
-            free(channels_s.blue_ap);
-            free(channels_s.green_ap);
-            free(channels_s.red_ap);
-
-            /*
-             * Clear all unused channels data.
-             * 0 == '\0' == NULL
-             */
-            memset(&channels_s, '\0', sizeof(channels_s));
+            for (unsigned char lane = 0; lane < 8; lane++) {
+                rgb_ap[(index + lane)*3] = value_a[0][lane];
+                rgb_ap[(index + lane)*3 + 1] = value_a[1][lane];
+                rgb_ap[(index + lane)*3 + 2] = value_a[2][lane];
+            }
         }
-        tmp_s.pmap_gp[tmp_s.pmapl - 1] = '\0';
 
-        /* Save the cpal lenght. */
-        self_sp->buffer_s.cpall = (
-            self_sp->buffer_s.headerl + tmp_s.pmapl - 1
+        /* Remainder. */
+        space_conv_f(
+            space,
+            &x_ap[index],
+            &y_ap[index],
+            &z_ap[index],
+            &rgb_ap[index*3],
+            count - index,
+            srgb_ap
         );
+    }
+#endif
 
-        /* Declare and add dynamic memory to the cpal string. */
-        char *cpal_gp = (
-            malloc(sizeof(char) * self_sp->buffer_s.cpall)
-        );
-        memset(cpal_gp, '\0', sizeof(char) * self_sp->buffer_s.cpall);
+    void
+    srgb_table_f(struct Self *self_sp) {
+        /* Linear light (16 bits) to sRGB (8 bits) table. */
+        if (self_sp->table_s.srgb_ready)
+            return;
+
+        for (unsigned int index = 0; index < 1 << 16; index++) {
+            double value = index/65535.0;
+
+            value = (
+                value <= 0.0031308
+                  ? 12.92*value
+                  : 1.055*pow(value, 1/2.4) - 0.055
+            );
+            self_sp->table_s.srgb_a[index] = (int)(value*255 + 0.5);
+        }
+        self_sp->table_s.srgb_ready = TRUE;
+    }
 
-        /* Merge the palette string to the header string. */
-        strcat(cpal_gp, tmp_s.header_gp);
-        strcat(cpal_gp, tmp_s.pmap_gp);
+    unsigned char *
+    space_lgen_f(struct Self *self_sp, unsigned char space) {
+        struct {
+            unsigned short level_a[3];
+            float *axis_ap[3];
+            float *y_ap;
+            float *z_ap;
+            unsigned int colourl;
+            unsigned char *bitmap_ap;
+            void (*conv_fp)(
+                unsigned char,
+                const float *,
+                const float *,
+                const float *,
+                unsigned char *,
+                unsigned int,
+                const unsigned char *
+            );
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
 
         /*
-         * Free unused memory.
-         * 0 == '\0' == NULL
+         * Levels per axis, same depth rules of bchn_lgen_f().
+         * Axis 0 is the inner loop, as red on rgb type.
          */
-        memset(
-            self_sp->data_s.colour_s.depth_a,
-            0,
-            self_sp->data_s.colour_s.depthl
-        );
+        for (unsigned char axis = 0; axis < 3; axis++) {
+            unsigned char byte = self_sp->data_s.colour_s.depth_a[axis];
+
+            if (axis >= self_sp->data_s.colour_s.depthl
+                  || byte < 1 || byte > 8)
+                byte = 8;
+
+            tmp_s.level_a[axis] = 1 << byte;
+            tmp_s.axis_ap[axis] = malloc(sizeof(float) * tmp_s.level_a[axis]);
+
+            for (unsigned short level = 0;
+                  level < tmp_s.level_a[axis];
+                  level++) {
+                if (space != SPACE_OKLAB && axis == 0)
+                    /* Hue is a circle, 1.0 is 0.0. */
+                    tmp_s.axis_ap[axis][level] = (
+                        (float)level/tmp_s.level_a[axis]
+                    );
+                else if (space == SPACE_OKLAB && axis == 1)
+                    /* a of the sRGB gamut: -0.234 .. 0.276 */
+                    tmp_s.axis_ap[axis][level] = (
+                        -0.234f + 0.510f*level/(tmp_s.level_a[axis] - 1)
+                    );
+                else if (space == SPACE_OKLAB && axis == 2)
+                    /* b of the sRGB gamut: -0.312 .. 0.199 */
+                    tmp_s.axis_ap[axis][level] = (
+                        -0.312f + 0.511f*level/(tmp_s.level_a[axis] - 1)
+                    );
+                else
+                    tmp_s.axis_ap[axis][level] = (
+                        (float)level/(tmp_s.level_a[axis] - 1)
+                    );
+            }
+        }
+
+        srgb_table_f(self_sp);
+
+        tmp_s.conv_fp = &space_conv_f;
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx2"))
+            tmp_s.conv_fp = &space_conv_avx2_f;
+#endif
+
+        tmp_s.colourl = (
+            tmp_s.level_a[0] * tmp_s.level_a[1] * tmp_s.level_a[2]
+        );
+
+        /* Declare and add dynamic memory to the colour array. */
+        unsigned char *colour_ap = malloc(sizeof(char) * tmp_s.colourl*3 + 1);
+        tmp_s.y_ap = malloc(sizeof(float) * tmp_s.level_a[0]);
+        tmp_s.z_ap = malloc(sizeof(float) * tmp_s.level_a[0]);
+
+        /* One row (inner axis) per conversion call. */
+        for (unsigned short index2 = 0; index2 < tmp_s.level_a[2]; index2++) {
+            for (unsigned short index1 = 0;
+                  index1 < tmp_s.level_a[1];
+                  index1++) {
+                for (unsigned short index0 = 0;
+                      index0 < tmp_s.level_a[0];
+                      index0++) {
+                    tmp_s.y_ap[index0] = tmp_s.axis_ap[1][index1];
+                    tmp_s.z_ap[index0] = tmp_s.axis_ap[2][index2];
+                }
+
+                tmp_s.conv_fp(
+                    space,
+                    tmp_s.axis_ap[0],
+                    tmp_s.y_ap,
+                    tmp_s.z_ap,
+                    &colour_ap[
+                        ((index2*tmp_s.level_a[1] + index1)
+                          * tmp_s.level_a[0]) * 3
+                    ],
+                    tmp_s.level_a[0],
+                    self_sp->table_s.srgb_a
+                );
+            }
+        }
+
+        /*
+         * Remove the colours that collapse to an already used sRGB value,
+         * keeping the first one (24 bits bitmap, 2 MiB).
+         */
+        if (self_sp->data_s.colour_s.dedup) {
+            unsigned int kept = 0;
+
+            tmp_s.bitmap_ap = calloc(1 << 21, sizeof(char));
+            for (unsigned int index = 0; index < tmp_s.colourl; index++) {
+                unsigned int key = (
+                    colour_ap[index*3] << 16
+                      | colour_ap[index*3 + 1] << 8
+                      | colour_ap[index*3 + 2]
+                );
+
+                if (tmp_s.bitmap_ap[key >> 3] & 1 << (key & 7))
+                    continue;
+
+                tmp_s.bitmap_ap[key >> 3] |= 1 << (key & 7);
+                memmove(&colour_ap[kept*3], &colour_ap[index*3], 3);
+                kept++;
+            }
+            tmp_s.colourl = kept;
+            free(tmp_s.bitmap_ap);
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        for (unsigned char axis = 0; axis < 3; axis++)
+            free(tmp_s.axis_ap[axis]);
+        free(tmp_s.y_ap);
+        free(tmp_s.z_ap);
+
+        /* Save the lenght and return the colour array. */
+        self_sp->buffer_s.colourl = tmp_s.colourl;
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+        return colour_ap;
+    }
+
+    /*
+     * Gradient type: steps entries between the stops (evenly spaced),
+     * interpolated on sRGB, linear RGB or OKLab with 16 bits fixed
+     * point weights, in blocks of 256 steps by the threads.
+     */
+    struct Gradient {
+        struct Self *self_sp;
+        unsigned char *colour_ap;
+        unsigned int start;
+        unsigned int end;
+        /* Stops on the blend space, 16 bits fixed point (see gradient_lgen_f()). */
+        const int (*stop_aa)[3];
+        void (*blend_fp)(
+            const int (*)[3],
+            const unsigned char *,
+            const int *,
+            int [3][1 << 8],
+            unsigned int
+        );
+        void (*conv_fp)(
+            unsigned char,
+            const float *,
+            const float *,
+            const float *,
+            unsigned char *,
+            unsigned int,
+            const unsigned char *
+        );
+        /* Without a thread, the steps are done by the calling thread. */
+        unsigned char threaded: 1;
+    };
+
+    void
+    gradient_blend_f(
+        const int (*stop_aa)[3],
+        const unsigned char *stop_ap,
+        const int *weight_ap,
+        int value_aa[3][1 << 8],
+        unsigned int count
+    ) {
+        /* Values of the steps: each stop to the next by its weight. */
+        for (unsigned int index = 0; index < count; index++)
+            for (unsigned char channel = 0; channel < 3; channel++) {
+                int first = stop_aa[stop_ap[index]][channel];
+                int last = stop_aa[stop_ap[index] + 1][channel];
+
+                value_aa[channel][index] = (
+                    first
+                      + (int)(((long long)(last - first)*weight_ap[index] + (1 << 15)) >> 16)
+                );
+            }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("avx2")))
+    void
+    gradient_blend_avx2_f(
+        const int (*stop_aa)[3],
+        const unsigned char *stop_ap,
+        const int *weight_ap,
+        int value_aa[3][1 << 8],
+        unsigned int count
+    ) {
+        /*
+         * The same values, 8 steps at once:
+         * (difference*weight + 2**15) >> 16 is taken in 32 bits
+         * as ((difference*(weight >> 8)
+         * + ((difference*(weight & 255) + 2**15) >> 8)) >> 8).
+         */
+        const int *base_ap = &stop_aa[0][0];
+        unsigned int index = 0;
+
+        for (; index + 8 <= count; index += 8) {
+            __m256i offset = _mm256_mullo_epi32(
+                _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)&stop_ap[index])),
+                _mm256_set1_epi32(3)
+            );
+            __m256i weight = _mm256_loadu_si256((const __m256i *)&weight_ap[index]);
+            __m256i high = _mm256_srli_epi32(weight, 8);
+            __m256i low = _mm256_and_si256(weight, _mm256_set1_epi32(0xff));
+
+            for (unsigned char channel = 0; channel < 3; channel++) {
+                __m256i first = _mm256_i32gather_epi32(
+                    base_ap + channel,
+                    offset,
+                    4
+                );
+                __m256i last = _mm256_i32gather_epi32(
+                    base_ap + 3 + channel,
+                    offset,
+                    4
+                );
+                __m256i difference = _mm256_sub_epi32(last, first);
+                __m256i part = _mm256_srai_epi32(
+                    _mm256_add_epi32(
+                        _mm256_mullo_epi32(difference, low),
+                        _mm256_set1_epi32(1 << 15)
+                    ),
+                    8
+                );
+
+                _mm256_storeu_si256(
+                    (__m256i *)&value_aa[channel][index],
+                    _mm256_add_epi32(
+                        first,
+                        _mm256_srai_epi32(
+                            _mm256_add_epi32(
+                                _mm256_mullo_epi32(difference, high),
+                                part
+                            ),
+                            8
+                        )
+                    )
+                );
+            }
+        }
+
+        gradient_blend_f(
+            stop_aa,
+            &stop_ap[index],
+            &weight_ap[index],
+            (int (*)[1 << 8])&value_aa[0][index],
+            count - index
+        );
+    }
+#endif
+
+    void *
+    gradient_work_f(void *gradient_vp) {
+        struct Gradient *gradient_sp = gradient_vp;
+        struct Self *self_sp = gradient_sp->self_sp;
+        const unsigned int steps = self_sp->data_s.gradient_s.steps;
+        const unsigned char stops = self_sp->data_s.gradient_s.stopl;
+        const unsigned char blend = self_sp->data_s.gradient_s.blend;
+        /*
+         * Position of a step, stop (high bits) and weight (16 bits)
+         * to the next stop: step*(stops - 1)*2**16/(steps - 1),
+         * kept as a quotient and remainder added by each step.
+         */
+        const unsigned long long span = steps > 1 ? steps - 1 : 1;
+        const unsigned long long rise = steps > 1 ? (stops - 1ull) << 16 : 0;
+        unsigned char stop_a[1 << 8];
+        int weight_a[1 << 8];
+        int value_aa[3][1 << 8];
+        float axis_aa[3][1 << 8];
+
+        for (unsigned int start = gradient_sp->start;
+              start < gradient_sp->end;
+              start += 1 << 8) {
+            unsigned int count = (
+                gradient_sp->end - start < 1 << 8 ? gradient_sp->end - start : 1 << 8
+            );
+            unsigned char *rgb_ap = &gradient_sp->colour_ap[
+                (unsigned long long)start*3
+            ];
+
+            /*
+             * One division by block, the last step is the last stop
+             * (a single stop is its own next stop).
+             */
+            unsigned long long position = start*rise/span;
+            unsigned long long remainder = start*rise % span;
+
+            for (unsigned int index = 0; index < count; index++) {
+                unsigned int stop = position >> 16;
+                int weight = position & 0xffff;
+
+                if (stop + 1 >= stops) {
+                    stop = stops > 1 ? stops - 2u : 0;
+                    weight = stops > 1 ? 1 << 16 : 0;
+                }
+                stop_a[index] = stop;
+                weight_a[index] = weight;
+
+                position += rise/span;
+                remainder += rise % span;
+                if (remainder >= span) {
+                    remainder -= span;
+                    position++;
+                }
+            }
+
+            gradient_sp->blend_fp(
+                gradient_sp->stop_aa,
+                stop_a,
+                weight_a,
+                value_aa,
+                count
+            );
+
+            /* Back to 8 bits sRGB. */
+            switch (blend) {
+                case BLEND_LINEAR:
+                    for (unsigned int index = 0; index < count; index++)
+                        for (unsigned char channel = 0; channel < 3; channel++)
+                            rgb_ap[index*3 + channel] = (
+                                self_sp->table_s.srgb_a[value_aa[channel][index]]
+                            );
+                    break;
+                case BLEND_OKLAB:
+                    for (unsigned char axis = 0; axis < 3; axis++)
+                        for (unsigned int index = 0; index < count; index++)
+                            axis_aa[axis][index] = value_aa[axis][index]/65536.0f;
+
+                    gradient_sp->conv_fp(
+                        SPACE_OKLAB,
+                        axis_aa[0],
+                        axis_aa[1],
+                        axis_aa[2],
+                        rgb_ap,
+                        count,
+                        self_sp->table_s.srgb_a
+                    );
+                    break;
+                default:
+                    for (unsigned int index = 0; index < count; index++)
+                        for (unsigned char channel = 0; channel < 3; channel++)
+                            rgb_ap[index*3 + channel] = (
+                                (value_aa[channel][index]*255 + 32767)/65535
+                            );
+            }
+        }
+
+        return NULL;
+    }
+
+    unsigned char *
+    gradient_lgen_f(struct Self *self_sp) {
+        struct {
+            int stop_aa[32][3];
+            unsigned short threads;
+            pthread_t *thread_ap;
+            struct Gradient *gradient_ap;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        srgb_table_f(self_sp);
+
+        /*
+         * Stops on the blend space (16 bits fixed point):
+         * sRGB and linear light are 0 to 65535,
+         * OKLab is L, a and b multiplied by 65536.
+         */
+        for (unsigned char stop = 0; stop < self_sp->data_s.gradient_s.stopl; stop++) {
+            const unsigned char *rgb_ap = self_sp->data_s.gradient_s.stop_aa[stop];
+            double linear_a[3];
+
+            for (unsigned char channel = 0; channel < 3; channel++) {
+                double value = rgb_ap[channel]/255.0;
+
+                linear_a[channel] = (
+                    value <= 0.04045 ? value/12.92 : pow((value + 0.055)/1.055, 2.4)
+                );
+            }
+
+            if (self_sp->data_s.gradient_s.blend == BLEND_OKLAB) {
+                double l = cbrt(
+                    0.4122214708*linear_a[0]
+                      + 0.5363325363*linear_a[1]
+                      + 0.0514459929*linear_a[2]
+                );
+                double m = cbrt(
+                    0.2119034982*linear_a[0]
+                      + 0.6806995451*linear_a[1]
+                      + 0.1073969566*linear_a[2]
+                );
+                double s = cbrt(
+                    0.0883024619*linear_a[0]
+                      + 0.2817188376*linear_a[1]
+                      + 0.6299787005*linear_a[2]
+                );
+
+                tmp_s.stop_aa[stop][0] = lround(
+                    (0.2104542553*l + 0.7936177850*m - 0.0040720468*s)*65536
+                );
+                tmp_s.stop_aa[stop][1] = lround(
+                    (1.9779984951*l - 2.4285922050*m + 0.4505937099*s)*65536
+                );
+                tmp_s.stop_aa[stop][2] = lround(
+                    (0.0259040371*l + 0.7827717662*m - 0.8086757660*s)*65536
+                );
+            } else {
+                for (unsigned char channel = 0; channel < 3; channel++)
+                    tmp_s.stop_aa[stop][channel] = (
+                        self_sp->data_s.gradient_s.blend == BLEND_LINEAR
+                          ? lround(linear_a[channel]*65535)
+                          : rgb_ap[channel]*257
+                    );
+            }
+        }
+
+        /* Declare and add dynamic memory to the colour array. */
+        unsigned char *colour_ap = malloc(
+            sizeof(char) * (unsigned long long)self_sp->data_s.gradient_s.steps*3 + 1
+        );
+
+        tmp_s.threads = self_sp->data_s.task_s.threads;
+        if (tmp_s.threads > self_sp->data_s.gradient_s.steps/(1 << 16) + 1)
+            tmp_s.threads = self_sp->data_s.gradient_s.steps/(1 << 16) + 1;
+        tmp_s.thread_ap = calloc(tmp_s.threads, sizeof(pthread_t));
+        tmp_s.gradient_ap = calloc(tmp_s.threads, sizeof(struct Gradient));
+
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            struct Gradient *gradient_sp = &tmp_s.gradient_ap[thread];
+
+            gradient_sp->self_sp = self_sp;
+            gradient_sp->colour_ap = colour_ap;
+            gradient_sp->start = (
+                (unsigned long long)self_sp->data_s.gradient_s.steps*thread/tmp_s.threads
+            );
+            gradient_sp->end = (
+                (unsigned long long)self_sp->data_s.gradient_s.steps*(thread + 1)
+                  / tmp_s.threads
+            );
+            gradient_sp->stop_aa = (const int (*)[3])tmp_s.stop_aa;
+            gradient_sp->blend_fp = &gradient_blend_f;
+            gradient_sp->conv_fp = &space_conv_f;
+#if defined(__x86_64__) || defined(__i386__)
+            if (__builtin_cpu_supports("avx2")) {
+                gradient_sp->blend_fp = &gradient_blend_avx2_f;
+                gradient_sp->conv_fp = &space_conv_avx2_f;
+            }
+#endif
+
+            if (thread) {
+                gradient_sp->threaded = ! pthread_create(
+                    &tmp_s.thread_ap[thread],
+                    NULL,
+                    &gradient_work_f,
+                    gradient_sp
+                );
+                if (! gradient_sp->threaded)
+                    gradient_work_f(gradient_sp);
+            }
+        }
+        gradient_work_f(&tmp_s.gradient_ap[0]);
+
+        for (unsigned short thread = 1; thread < tmp_s.threads; thread++)
+            if (tmp_s.gradient_ap[thread].threaded)
+                pthread_join(tmp_s.thread_ap[thread], NULL);
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        free(tmp_s.thread_ap);
+        free(tmp_s.gradient_ap);
+
+        /* Save the lenght and return the colour array. */
+        self_sp->buffer_s.colourl = self_sp->data_s.gradient_s.steps;
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+        return colour_ap;
+    }
+
+    /*
+     * Colour vision deficiency simulation (Machado et al. 2009,
+     * severity 1.0): protanopia, deuteranopia and tritanopia matrices
+     * on linear light, back to sRGB by the 16 bits table.
+     * The variants are written as GPL files next to the output file
+     * (cvd = yes, not on stdout)
+     * or as the names of the records (names = cvd).
+     */
+    static const float cvd_matrix_a[3][9] = {
+        {
+            0.152286f, 1.052583f, -0.204868f,
+            0.114503f, 0.786281f, 0.099216f,
+            -0.003882f, -0.048116f, 1.051998f
+        },
+        {
+            0.367322f, 0.860646f, -0.227968f,
+            0.280085f, 0.672501f, 0.047413f,
+            -0.011820f, 0.042940f, 0.968881f
+        },
+        {
+            1.255528f, -0.076749f, -0.178779f,
+            -0.078411f, 0.930809f, 0.147602f,
+            0.004733f, 0.691367f, 0.303900f
+        }
+    };
+    static const char *cvd_gpa[3] = {"protan", "deutan", "tritan"};
+
+    void
+    cvd_conv_f(
+        const float *red_ap,
+        const float *green_ap,
+        const float *blue_ap,
+        unsigned char *rgb_apa[3],
+        unsigned int count,
+        const unsigned char *srgb_ap
+    ) {
+        /*
+         * Scalar simulation of the 3 variants.
+         * Keep the same operations (and order) of the AVX2 version,
+         * both versions must return the same bytes.
+         */
+        for (unsigned int index = 0; index < count; index++)
+            for (unsigned char cvd = 0; cvd < 3; cvd++)
+                for (unsigned char channel = 0; channel < 3; channel++) {
+                    const float *row_ap = &cvd_matrix_a[cvd][channel*3];
+                    float value = (
+                        row_ap[0]*red_ap[index]
+                          + row_ap[1]*green_ap[index]
+                          + row_ap[2]*blue_ap[index]
+                    );
+
+                    value = value > 0.0f ? value : 0.0f;
+                    value = value < 1.0f ? value : 1.0f;
+                    rgb_apa[cvd][index*3 + channel] = (
+                        srgb_ap[(int)(value*65535.0f + 0.5f)]
+                    );
+                }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("avx2")))
+    void
+    cvd_conv_avx2_f(
+        const float *red_ap,
+        const float *green_ap,
+        const float *blue_ap,
+        unsigned char *rgb_apa[3],
+        unsigned int count,
+        const unsigned char *srgb_ap
+    ) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        unsigned int index = 0;
+        int value_a[3][8];
+
+        for (; index + 8 <= count; index += 8) {
+            __m256 red = _mm256_loadu_ps(&red_ap[index]);
+            __m256 green = _mm256_loadu_ps(&green_ap[index]);
+            __m256 blue = _mm256_loadu_ps(&blue_ap[index]);
+
+            for (unsigned char cvd = 0; cvd < 3; cvd++) {
+                for (unsigned char channel = 0; channel < 3; channel++) {
+                    const float *row_ap = &cvd_matrix_a[cvd][channel*3];
+                    __m256 value = _mm256_add_ps(
+                        _mm256_add_ps(
+                            _mm256_mul_ps(_mm256_set1_ps(row_ap[0]), red),
+                            _mm256_mul_ps(_mm256_set1_ps(row_ap[1]), green)
+                        ),
+                        _mm256_mul_ps(_mm256_set1_ps(row_ap[2]), blue)
+                    );
+                    __m256i key;
+
+                    /* Linear light to sRGB by the table (gather). */
+                    value = _mm256_min_ps(_mm256_max_ps(value, zero), one);
+                    key = _mm256_cvttps_epi32(
+                        _mm256_add_ps(
+                            _mm256_mul_ps(value, _mm256_set1_ps(65535.0f)),
+                            _mm256_set1_ps(0.5f)
+                        )
+                    );
+                    _mm256_storeu_si256(
+                        (__m256i *)value_a[channel],
+                        _mm256_and_si256(
+                            _mm256_i32gather_epi32((const int *)srgb_ap, key, 1),
+                            _mm256_set1_epi32(0xff)
+                        )
+                    );
+                }
+
+                for (unsigned char lane = 0; lane < 8; lane++) {
+                    rgb_apa[cvd][(index + lane)*3] = value_a[0][lane];
+                    rgb_apa[cvd][(index + lane)*3 + 1] = value_a[1][lane];
+                    rgb_apa[cvd][(index + lane)*3 + 2] = value_a[2][lane];
+                }
+            }
+        }
+
+        /* Remainder. */
+        unsigned char *rest_apa[3] = {
+            &rgb_apa[0][index*3],
+            &rgb_apa[1][index*3],
+            &rgb_apa[2][index*3]
+        };
+
+        cvd_conv_f(
+            &red_ap[index],
+            &green_ap[index],
+            &blue_ap[index],
+            rest_apa,
+            count - index,
+            srgb_ap
+        );
+    }
+#endif
+
+    /* Blocks of entries simulated by each thread, see cvd_lgen_f(). */
+    struct Cvd {
+        struct Self *self_sp;
+        unsigned int start;
+        unsigned int end;
+        const float *linear_ap;
+        void (*conv_fp)(
+            const float *,
+            const float *,
+            const float *,
+            unsigned char *[3],
+            unsigned int,
+            const unsigned char *
+        );
+        /* Without a thread, the block is done by the calling thread. */
+        unsigned char threaded: 1;
+    };
+
+    void *
+    cvd_work_f(void *cvd_vp) {
+        struct Cvd *cvd_sp = cvd_vp;
+        struct Self *self_sp = cvd_sp->self_sp;
+        const unsigned short *tablel_ap = self_sp->emit_s.tablel_a;
+        float channel_aa[3][1 << 8];
+        unsigned short index_a[3] = {0, 0, 0};
+
+        /* The loop position of the first entry (see fmt_f()). */
+        if (! self_sp->emit_s.colour_ap) {
+            index_a[0] = cvd_sp->start % tablel_ap[0];
+            index_a[1] = cvd_sp->start/tablel_ap[0] % tablel_ap[1];
+            index_a[2] = cvd_sp->start/tablel_ap[0]/tablel_ap[1];
+        }
+
+        for (unsigned int start = cvd_sp->start; start < cvd_sp->end; start += 1 << 8) {
+            unsigned int count = cvd_sp->end - start < 1 << 8 ? cvd_sp->end - start : 1 << 8;
+            unsigned char *rgb_apa[3] = {
+                &self_sp->emit_s.cvd_apa[0][(unsigned long long)start*3],
+                &self_sp->emit_s.cvd_apa[1][(unsigned long long)start*3],
+                &self_sp->emit_s.cvd_apa[2][(unsigned long long)start*3]
+            };
+
+            /* Linear light of the entries (colour array or tables). */
+            for (unsigned int entry = 0; entry < count; entry++) {
+                unsigned char rgb_a[3];
+
+                if (self_sp->emit_s.colour_ap) {
+                    memcpy(
+                        rgb_a,
+                        &self_sp->emit_s.colour_ap[(unsigned long long)(start + entry)*3],
+                        3
+                    );
+                } else {
+                    rgb_a[0] = self_sp->emit_s.table_ap[0][index_a[0]];
+                    rgb_a[1] = rgb_a[0];
+                    rgb_a[2] = rgb_a[0];
+
+                    if (! self_sp->emit_s.gray) {
+                        rgb_a[1] = self_sp->emit_s.table_ap[1][index_a[1]];
+                        rgb_a[2] = self_sp->emit_s.table_ap[2][index_a[2]];
+                    }
+
+                    if (++index_a[0] == tablel_ap[0]) {
+                        index_a[0] = 0;
+
+                        if (++index_a[1] == tablel_ap[1]) {
+                            index_a[1] = 0;
+                            index_a[2]++;
+                        }
+                    }
+                }
+
+                for (unsigned char channel = 0; channel < 3; channel++)
+                    channel_aa[channel][entry] = cvd_sp->linear_ap[rgb_a[channel]];
+            }
+
+            cvd_sp->conv_fp(
+                channel_aa[0],
+                channel_aa[1],
+                channel_aa[2],
+                rgb_apa,
+                count,
+                self_sp->table_s.srgb_a
+            );
+        }
+
+        return NULL;
+    }
+
+    void
+    cvd_lgen_f(struct Self *self_sp) {
+        /*
+         * Simulated colours of the entries (start to end),
+         * 3 packed RGB arrays (emit_s.cvd_apa), by the threads.
+         */
+        struct {
+            float linear_a[1 << 8];
+            unsigned short threads;
+            pthread_t *thread_ap;
+            struct Cvd *cvd_ap;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        srgb_table_f(self_sp);
+        for (unsigned short value = 0; value < 1 << 8; value++) {
+            double channel = value/255.0;
+
+            tmp_s.linear_a[value] = (
+                channel <= 0.04045
+                  ? channel/12.92
+                  : pow((channel + 0.055)/1.055, 2.4)
+            );
+        }
+
+        for (unsigned char cvd = 0; cvd < 3; cvd++)
+            self_sp->emit_s.cvd_apa[cvd] = malloc(
+                sizeof(char) * (unsigned long long)self_sp->emit_s.count*3 + 1
+            );
+
+        tmp_s.threads = self_sp->data_s.task_s.threads;
+        if (tmp_s.threads > (self_sp->emit_s.end - self_sp->emit_s.start)/(1 << 16) + 1)
+            tmp_s.threads = (self_sp->emit_s.end - self_sp->emit_s.start)/(1 << 16) + 1;
+        tmp_s.thread_ap = calloc(tmp_s.threads, sizeof(pthread_t));
+        tmp_s.cvd_ap = calloc(tmp_s.threads, sizeof(struct Cvd));
+
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            unsigned int entries = self_sp->emit_s.end - self_sp->emit_s.start;
+
+            tmp_s.cvd_ap[thread].self_sp = self_sp;
+            tmp_s.cvd_ap[thread].start = (
+                self_sp->emit_s.start
+                  + (unsigned long long)entries*thread/tmp_s.threads
+            );
+            tmp_s.cvd_ap[thread].end = (
+                self_sp->emit_s.start
+                  + (unsigned long long)entries*(thread + 1)/tmp_s.threads
+            );
+            tmp_s.cvd_ap[thread].linear_ap = tmp_s.linear_a;
+            tmp_s.cvd_ap[thread].conv_fp = &cvd_conv_f;
+#if defined(__x86_64__) || defined(__i386__)
+            if (__builtin_cpu_supports("avx2"))
+                tmp_s.cvd_ap[thread].conv_fp = &cvd_conv_avx2_f;
+#endif
+
+            if (thread) {
+                tmp_s.cvd_ap[thread].threaded = ! pthread_create(
+                    &tmp_s.thread_ap[thread],
+                    NULL,
+                    &cvd_work_f,
+                    &tmp_s.cvd_ap[thread]
+                );
+                if (! tmp_s.cvd_ap[thread].threaded)
+                    cvd_work_f(&tmp_s.cvd_ap[thread]);
+            }
+        }
+        cvd_work_f(&tmp_s.cvd_ap[0]);
+
+        for (unsigned short thread = 1; thread < tmp_s.threads; thread++)
+            if (tmp_s.cvd_ap[thread].threaded)
+                pthread_join(tmp_s.thread_ap[thread], NULL);
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        free(tmp_s.thread_ap);
+        free(tmp_s.cvd_ap);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    /*
+     * GPL reader:
+     * the file is mapped and split on new lines to some chunks,
+     * each thread parses its own chunk to its own palette
+     * and the palettes are joined in order.
+     */
+    struct Parse {
+        const char *start_gp;
+        const char *end_gp;
+        struct Palette palette_s;
+        /* Without a thread, the chunk is parsed by the calling thread. */
+        unsigned char threaded: 1;
+    };
+
+    const char *
+    line_end_f(const char *line_gp, const char *end_gp) {
+        /* New line search, 16 characters per step with SSE2. */
+#if defined(__SSE2__)
+        const __m128i newline_v = _mm_set1_epi8('\n');
+
+        while (end_gp - line_gp >= 16) {
+            int mask = _mm_movemask_epi8(
+                _mm_cmpeq_epi8(
+                    _mm_loadu_si128((const __m128i *)line_gp),
+                    newline_v
+                )
+            );
+
+            if (mask)
+                return line_gp + __builtin_ctz(mask);
+            line_gp += 16;
+        }
+#endif
+        while (line_gp < end_gp && *line_gp != '\n')
+            line_gp++;
+
+        return line_gp;
+    }
+
+    const char *
+    gpl_entry_f(
+        const char *line_gp,
+        const char *end_gp,
+        unsigned short *value_ap
+    ) {
+        /*
+         * Entry line: red, green and blue (0 to 255) and the name,
+         * the return is the name (to end_gp) or NULL (no entry).
+         * Fast path to the records of the generator,
+         * "RRR GGG BBB\t" with right aligned values.
+         */
+        const char *char_gp = line_gp;
+        unsigned char values = 0;
+
+        if (end_gp - line_gp >= 12
+              && line_gp[3] == ' '
+              && line_gp[7] == ' '
+              && line_gp[11] == '\t') {
+            for (values = 0; values < 3; values++) {
+                const char *digit_gp = &line_gp[values*4];
+
+                if (digit_gp[2] < '0' || digit_gp[2] > '9'
+                      || (digit_gp[1] != ' '
+                        && (digit_gp[1] < '0' || digit_gp[1] > '9'))
+                      || (digit_gp[0] != ' '
+                        && (digit_gp[0] < '0' || digit_gp[0] > '9'
+                          || digit_gp[1] == ' ')))
+                    break;
+
+                value_ap[values] = (
+                    (digit_gp[0] == ' ' ? 0 : (digit_gp[0] - '0')*100)
+                      + (digit_gp[1] == ' ' ? 0 : (digit_gp[1] - '0')*10)
+                      + digit_gp[2] - '0'
+                );
+                if (value_ap[values] > (1 << 8) - 1)
+                    break;
+            }
+
+            if (values == 3)
+                char_gp = &line_gp[12];
+            else
+                values = 0;
+        }
+
+        while (! values
+              && char_gp < end_gp
+              && (*char_gp == ' ' || *char_gp == '\t'))
+            char_gp++;
+
+        for (; values < 3; values++) {
+            const char *digit_gp = char_gp;
+
+            value_ap[values] = 0;
+            while (char_gp < end_gp
+                  && char_gp - digit_gp < 4
+                  && *char_gp >= '0' && *char_gp <= '9')
+                value_ap[values] = value_ap[values]*10 + *char_gp++ - '0';
+
+            if (char_gp == digit_gp
+                  || value_ap[values] > (1 << 8) - 1
+                  || (char_gp < end_gp
+                    && ! isspace((unsigned char)*char_gp)))
+                break;
+
+            while (char_gp < end_gp && isspace((unsigned char)*char_gp))
+                char_gp++;
+        }
+
+        return values == 3 ? char_gp : NULL;
+    }
+
+    void *
+    gpl_parse_work_f(void *parse_vp) {
+        struct Parse *parse_sp = parse_vp;
+        struct Palette *palette_sp = &parse_sp->palette_s;
+        const char *line_gp = parse_sp->start_gp;
+        unsigned long long lines = (
+            (parse_sp->end_gp - parse_sp->start_gp)/6 + 1
+        );
+        unsigned int namel = 0;
+
+        /*
+         * A colour (and a name) per line at most,
+         * the shortest entry line is "0 0 0\n".
+         * Only the used pages of these arrays are touched.
+         */
+        palette_sp->rgb_ap = malloc(sizeof(char) * lines*3);
+        palette_sp->name_ap = malloc(sizeof(unsigned int) * (lines + 1));
+        palette_sp->name_gp = malloc(
+            sizeof(char) * (parse_sp->end_gp - parse_sp->start_gp + 1)
+        );
+        palette_sp->count = 0;
+        palette_sp->titlel = 0;
+        palette_sp->columns = -1;
+
+        while (line_gp < parse_sp->end_gp) {
+            const char *end_gp = line_end_f(line_gp, parse_sp->end_gp);
+            unsigned short value_a[3];
+            const char *char_gp = gpl_entry_f(line_gp, end_gp, value_a);
+
+            if (char_gp) {
+                const char *name_end_gp = end_gp;
+                unsigned int *name_ap = palette_sp->name_ap;
+
+                while (name_end_gp > char_gp
+                      && isspace((unsigned char)name_end_gp[-1]))
+                    name_end_gp--;
+                if (name_end_gp - char_gp > GPL_NAMEL)
+                    name_end_gp = char_gp + GPL_NAMEL;
+                if (name_end_gp - char_gp == 1 && *char_gp == '#')
+                    name_end_gp = char_gp;
+
+                palette_sp->rgb_ap[palette_sp->count*3] = value_a[0];
+                palette_sp->rgb_ap[palette_sp->count*3 + 1] = value_a[1];
+                palette_sp->rgb_ap[palette_sp->count*3 + 2] = value_a[2];
+                name_ap[palette_sp->count++] = namel;
+                memcpy(
+                    &palette_sp->name_gp[namel],
+                    char_gp,
+                    name_end_gp - char_gp
+                );
+                namel += name_end_gp - char_gp;
+            } else if (! palette_sp->titlel
+                  && end_gp - line_gp > 5
+                  && strncmp(line_gp, "Name:", 5) == 0) {
+                const char *title_gp = line_gp + 5;
+                const char *title_end_gp = end_gp;
+
+                while (title_end_gp > title_gp
+                      && isspace((unsigned char)title_end_gp[-1]))
+                    title_end_gp--;
+                while (title_gp < title_end_gp
+                      && isspace((unsigned char)*title_gp))
+                    title_gp++;
+                if (title_end_gp - title_gp > (1 << 8) - 1)
+                    title_end_gp = title_gp + (1 << 8) - 1;
+
+                palette_sp->titlel = title_end_gp - title_gp + 1;
+                memcpy(palette_sp->title_g, title_gp, title_end_gp - title_gp);
+                palette_sp->title_g[palette_sp->titlel - 1] = '\0';
+            } else if (palette_sp->columns < 0
+                  && end_gp - line_gp > 8
+                  && strncmp(line_gp, "Columns:", 8) == 0) {
+                palette_sp->columns = 0;
+
+                for (char_gp = line_gp + 8; char_gp < end_gp; char_gp++)
+                    if (*char_gp >= '0' && *char_gp <= '9')
+                        palette_sp->columns = (
+                            palette_sp->columns < 1 << 16
+                              ? palette_sp->columns*10 + *char_gp - '0'
+                              : palette_sp->columns
+                        );
+                    else if (! isspace((unsigned char)*char_gp))
+                        break;
+            }
+
+            line_gp = end_gp + 1;
+        }
+        palette_sp->name_ap[palette_sp->count] = namel;
+
+        return NULL;
+    }
+
+    void
+    gpl_parse_f(
+        const char *data_gp,
+        unsigned long long datal,
+        struct Palette *palette_sp,
+        unsigned short threads
+    ) {
+        struct {
+            unsigned short threads;
+            pthread_t *thread_ap;
+            struct Parse *parse_ap;
+            unsigned long long count;
+            unsigned long long namel;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+        memset(palette_sp, 0, sizeof(*palette_sp));
+        palette_sp->columns = -1;
+
+        /* Small palettes does not need all threads. */
+        tmp_s.threads = threads ? threads : 1;
+        if (tmp_s.threads > datal/(1 << 20) + 1)
+            tmp_s.threads = datal/(1 << 20) + 1;
+        tmp_s.thread_ap = calloc(tmp_s.threads, sizeof(pthread_t));
+        tmp_s.parse_ap = calloc(tmp_s.threads, sizeof(struct Parse));
+
+        /* Each chunk starts after a new line. */
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            tmp_s.parse_ap[thread].start_gp = data_gp;
+            tmp_s.parse_ap[thread].end_gp = data_gp + datal;
+
+            if (thread) {
+                const char *start_gp = (
+                    data_gp + datal*thread/tmp_s.threads
+                );
+
+                if (start_gp < tmp_s.parse_ap[thread - 1].start_gp)
+                    start_gp = tmp_s.parse_ap[thread - 1].start_gp;
+                start_gp = line_end_f(start_gp, data_gp + datal);
+                if (start_gp < data_gp + datal)
+                    start_gp++;
+
+                tmp_s.parse_ap[thread].start_gp = start_gp;
+                tmp_s.parse_ap[thread - 1].end_gp = start_gp;
+            }
+        }
+
+        for (unsigned short thread = 1; thread < tmp_s.threads; thread++) {
+            tmp_s.parse_ap[thread].threaded = ! pthread_create(
+                &tmp_s.thread_ap[thread],
+                NULL,
+                &gpl_parse_work_f,
+                &tmp_s.parse_ap[thread]
+            );
+            if (! tmp_s.parse_ap[thread].threaded)
+                gpl_parse_work_f(&tmp_s.parse_ap[thread]);
+        }
+        gpl_parse_work_f(&tmp_s.parse_ap[0]);
+
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            if (tmp_s.parse_ap[thread].threaded)
+                pthread_join(tmp_s.thread_ap[thread], NULL);
+
+            tmp_s.count += tmp_s.parse_ap[thread].palette_s.count;
+            tmp_s.namel += tmp_s.parse_ap[thread].palette_s.name_ap[
+                tmp_s.parse_ap[thread].palette_s.count
+            ];
+        }
+
+        /* A single chunk is the palette. */
+        if (tmp_s.threads == 1) {
+            *palette_sp = tmp_s.parse_ap[0].palette_s;
+            tmp_s.threads = 0;
+        } else {
+            palette_sp->rgb_ap = malloc(sizeof(char) * (tmp_s.count*3 + 1));
+            palette_sp->name_ap = malloc(
+                sizeof(unsigned int) * (tmp_s.count + 1)
+            );
+            palette_sp->name_gp = malloc(sizeof(char) * (tmp_s.namel + 1));
+        }
+
+        /* Join the palettes of all chunks (the first title and columns). */
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            struct Palette *chunk_sp = &tmp_s.parse_ap[thread].palette_s;
+            unsigned int namel = palette_sp->name_ap[palette_sp->count];
+
+            if (! palette_sp->count)
+                namel = 0;
+
+            memcpy(
+                &palette_sp->rgb_ap[(unsigned long long)palette_sp->count*3],
+                chunk_sp->rgb_ap,
+                (unsigned long long)chunk_sp->count*3
+            );
+            for (unsigned int entry = 0; entry <= chunk_sp->count; entry++)
+                palette_sp->name_ap[palette_sp->count + entry] = (
+                    namel + chunk_sp->name_ap[entry]
+                );
+            memcpy(
+                &palette_sp->name_gp[namel],
+                chunk_sp->name_gp,
+                chunk_sp->name_ap[chunk_sp->count]
+            );
+            palette_sp->count += chunk_sp->count;
+
+            if (! palette_sp->titlel && chunk_sp->titlel) {
+                palette_sp->titlel = chunk_sp->titlel;
+                memcpy(palette_sp->title_g, chunk_sp->title_g, chunk_sp->titlel);
+            }
+            if (palette_sp->columns < 0)
+                palette_sp->columns = chunk_sp->columns;
+
+            free(chunk_sp->rgb_ap);
+            free(chunk_sp->name_ap);
+            free(chunk_sp->name_gp);
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        free(tmp_s.thread_ap);
+        free(tmp_s.parse_ap);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    int
+    gpl_lgen_f(
+        struct Self *self_sp,
+        const char *path_gp,
+        struct Palette *palette_sp,
+        unsigned short threads
+    ) {
+        /*
+         * Load a GPL file to a palette (always allocated)
+         * with some threads, the return is 0 or the error code:
+         * no error_mp() here, merge_f() loads files from many threads.
+         */
+        struct {
+            int file;
+            struct stat stat_s;
+            char *map_gp;
+            int code;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+        (void)self_sp;
+
+        errno = 0;
+        tmp_s.file = open(path_gp, O_RDONLY);
+
+        if (tmp_s.file >= 0 && fstat(tmp_s.file, &tmp_s.stat_s) == 0
+              && tmp_s.stat_s.st_size > 0)
+            tmp_s.map_gp = mmap(
+                NULL,
+                tmp_s.stat_s.st_size,
+                PROT_READ,
+                MAP_PRIVATE,
+                tmp_s.file,
+                0
+            );
+
+        if (! tmp_s.map_gp || tmp_s.map_gp == MAP_FAILED) {
+            tmp_s.code = errno ? errno : EINVAL;
+            tmp_s.map_gp = NULL;
+            gpl_parse_f("", 0, palette_sp, 1);
+        } else if (tmp_s.stat_s.st_size < 12
+              || strncmp(tmp_s.map_gp, "GIMP Palette", 12) != 0) {
+            tmp_s.code = EINVAL;
+            gpl_parse_f("", 0, palette_sp, 1);
+        } else {
+            madvise(tmp_s.map_gp, tmp_s.stat_s.st_size, MADV_SEQUENTIAL);
+            gpl_parse_f(
+                tmp_s.map_gp,
+                tmp_s.stat_s.st_size,
+                palette_sp,
+                threads
+            );
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        if (tmp_s.map_gp)
+            munmap(tmp_s.map_gp, tmp_s.stat_s.st_size);
+        if (tmp_s.file >= 0)
+            close(tmp_s.file);
+
+        return tmp_s.code;
+    }
+
+    void
+    gpl_free_f(struct Palette *palette_sp) {
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        free(palette_sp->rgb_ap);
+        free(palette_sp->name_ap);
+        free(palette_sp->name_gp);
+        memset(palette_sp, '\0', sizeof(*palette_sp));
+    }
+
+    /*
+     * Sidecar index of a GPL file (PATH.idx):
+     * struct Index and its samples (offsets of the entries
+     * 0, stride, 2*stride...), or only the formula
+     * head + N*recordl (stride 0) for fixed records.
+     */
+    int
+    index_scan_f(
+        const char *data_gp,
+        unsigned long long datal,
+        struct Index *index_sp,
+        unsigned long long **sample_app
+    ) {
+        const char *line_gp = data_gp;
+        unsigned long long samplel = 1 << 10;
+        unsigned char fixed = TRUE;
+
+        if (datal < 12 || strncmp(data_gp, "GIMP Palette", 12) != 0)
+            return EINVAL;
+
+        index_sp->count = 0;
+        index_sp->head = datal;
+        index_sp->stride = 1 << 10;
+        index_sp->recordl = 0;
+        index_sp->samples = 0;
+        *sample_app = malloc(sizeof(unsigned long long) * samplel);
+
+        while (line_gp < data_gp + datal) {
+            const char *end_gp = line_end_f(line_gp, data_gp + datal);
+            unsigned short value_a[3];
+
+            if (gpl_entry_f(line_gp, end_gp, value_a)) {
+                unsigned long long offset = line_gp - data_gp;
+
+                /* Fixed records: same lenght, one after the other. */
+                if (! index_sp->count) {
+                    index_sp->head = offset;
+                    index_sp->recordl = end_gp + 1 - line_gp;
+                } else if (end_gp + 1 - line_gp != index_sp->recordl
+                      || offset
+                        != index_sp->head
+                          + (unsigned long long)index_sp->count
+                            * index_sp->recordl) {
+                    fixed = FALSE;
+                }
+
+                if (index_sp->count % index_sp->stride == 0) {
+                    if (index_sp->samples == samplel) {
+                        samplel *= 2;
+                        *sample_app = realloc(
+                            *sample_app,
+                            sizeof(unsigned long long) * samplel
+                        );
+                    }
+                    (*sample_app)[index_sp->samples++] = offset;
+                }
+                index_sp->count++;
+            }
+
+            line_gp = end_gp + 1;
+        }
+
+        if (fixed) {
+            index_sp->stride = 0;
+            index_sp->samples = 0;
+        }
+
+        return 0;
+    }
+
+    int
+    index_f(struct Self *self_sp, const char *path_gp, const struct Index *formula_sp) {
+        /*
+         * Write the sidecar index of a GPL file:
+         * the formula of the writer (fixed records)
+         * or a scan of the file (formula_sp is NULL).
+         */
+        struct {
+            int file;
+            struct stat stat_s;
+            char *map_gp;
+            struct Index index_s;
+            unsigned long long *sample_ap;
+            char *index_gp;
+            FILE *index_lp;
+            int code;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+        (void)self_sp;
+
+        errno = 0;
+        tmp_s.file = open(path_gp, O_RDONLY);
+
+        if (tmp_s.file < 0 || fstat(tmp_s.file, &tmp_s.stat_s) != 0)
+            tmp_s.code = errno;
+        else if (formula_sp)
+            tmp_s.index_s = *formula_sp;
+        else if (tmp_s.stat_s.st_size < 12)
+            tmp_s.code = EINVAL;
+        else {
+            tmp_s.map_gp = mmap(
+                NULL,
+                tmp_s.stat_s.st_size,
+                PROT_READ,
+                MAP_PRIVATE,
+                tmp_s.file,
+                0
+            );
+
+            if (tmp_s.map_gp == MAP_FAILED) {
+                tmp_s.code = errno;
+                tmp_s.map_gp = NULL;
+            } else {
+                madvise(tmp_s.map_gp, tmp_s.stat_s.st_size, MADV_SEQUENTIAL);
+                tmp_s.code = index_scan_f(
+                    tmp_s.map_gp,
+                    tmp_s.stat_s.st_size,
+                    &tmp_s.index_s,
+                    &tmp_s.sample_ap
+                );
+            }
+        }
+
+        if (! tmp_s.code) {
+            memcpy(tmp_s.index_s.magic_g, "GPLIDX1", 8);
+            tmp_s.index_s.size = tmp_s.stat_s.st_size;
+            tmp_s.index_s.mtime = tmp_s.stat_s.st_mtime;
+
+            tmp_s.index_gp = malloc(sizeof(char) * (strlen(path_gp) + 5));
+            sprintf(tmp_s.index_gp, "%s.idx", path_gp);
+            tmp_s.index_lp = fopen(tmp_s.index_gp, "w");
+
+            if (! tmp_s.index_lp
+                  || fwrite(&tmp_s.index_s, sizeof(tmp_s.index_s), 1, tmp_s.index_lp)
+                    != 1
+                  || (tmp_s.index_s.samples && fwrite(
+                      tmp_s.sample_ap,
+                      sizeof(unsigned long long),
+                      tmp_s.index_s.samples,
+                      tmp_s.index_lp
+                  ) != tmp_s.index_s.samples))
+                tmp_s.code = errno ? errno : EIO;
+            if (tmp_s.index_lp && fclose(tmp_s.index_lp) != 0 && ! tmp_s.code)
+                tmp_s.code = errno;
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        if (tmp_s.map_gp)
+            munmap(tmp_s.map_gp, tmp_s.stat_s.st_size);
+        if (tmp_s.file >= 0)
+            close(tmp_s.file);
+        free(tmp_s.sample_ap);
+        free(tmp_s.index_gp);
+
+        return tmp_s.code;
+    }
+
+    int
+    lookup_f(
+        struct Self *self_sp,
+        const char *path_gp,
+        unsigned int first,
+        unsigned int last,
+        struct Palette *palette_sp
+    ) {
+        /*
+         * Entries first to last (not included) of a GPL file,
+         * by its sidecar index (made or remade if it is old):
+         * only the pages from the sample before the first entry
+         * to the sample after the last entry are mapped.
+         */
+        struct {
+            int file;
+            struct stat stat_s;
+            struct Index index_s;
+            unsigned long long *sample_ap;
+            char *index_gp;
+            FILE *index_lp;
+            unsigned long long start;
+            unsigned long long end;
+            unsigned long long page;
+            char *map_gp;
+            const char *first_gp;
+            const char *last_gp;
+            int code;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        tmp_s.index_gp = malloc(sizeof(char) * (strlen(path_gp) + 5));
+        sprintf(tmp_s.index_gp, "%s.idx", path_gp);
+
+        errno = 0;
+        tmp_s.file = open(path_gp, O_RDONLY);
+        if (tmp_s.file < 0 || fstat(tmp_s.file, &tmp_s.stat_s) != 0)
+            tmp_s.code = errno;
+
+        /* Read the index, twice at most (the second one is remade). */
+        for (unsigned char read = 0; ! tmp_s.code && read < 2; read++) {
+            tmp_s.index_lp = fopen(tmp_s.index_gp, "r");
+
+            if (tmp_s.index_lp
+                  && fread(&tmp_s.index_s, sizeof(tmp_s.index_s), 1, tmp_s.index_lp)
+                    == 1
+                  && memcmp(tmp_s.index_s.magic_g, "GPLIDX1", 8) == 0
+                  && tmp_s.index_s.size == (unsigned long long)tmp_s.stat_s.st_size
+                  && tmp_s.index_s.mtime == tmp_s.stat_s.st_mtime) {
+                tmp_s.sample_ap = malloc(
+                    sizeof(unsigned long long) * (tmp_s.index_s.samples + 1)
+                );
+
+                if (fread(
+                      tmp_s.sample_ap,
+                      sizeof(unsigned long long),
+                      tmp_s.index_s.samples,
+                      tmp_s.index_lp
+                    ) == tmp_s.index_s.samples) {
+                    fclose(tmp_s.index_lp);
+                    tmp_s.index_lp = NULL;
+                    break;
+                }
+
+                free(tmp_s.sample_ap);
+                tmp_s.sample_ap = NULL;
+            }
+
+            if (tmp_s.index_lp)
+                fclose(tmp_s.index_lp);
+            tmp_s.index_lp = NULL;
+
+            if (read)
+                tmp_s.code = EINVAL;
+            else
+                tmp_s.code = index_f(self_sp, path_gp, NULL);
+        }
+
+        /* No entry or an entry after the last one is an error. */
+        if (! tmp_s.code && (first >= last || last > tmp_s.index_s.count))
+            tmp_s.code = EINVAL;
+
+        if (! tmp_s.code) {
+            /* Byte range with the entries. */
+            if (! tmp_s.index_s.stride) {
+                tmp_s.start = (
+                    tmp_s.index_s.head
+                      + (unsigned long long)first*tmp_s.index_s.recordl
+                );
+                tmp_s.end = (
+                    tmp_s.index_s.head
+                      + (unsigned long long)last*tmp_s.index_s.recordl
+                );
+            } else {
+                unsigned int sample = (
+                    (last + tmp_s.index_s.stride - 1)/tmp_s.index_s.stride
+                );
+
+                tmp_s.start = (
+                    first < tmp_s.index_s.count
+                      ? tmp_s.sample_ap[first/tmp_s.index_s.stride]
+                      : (unsigned long long)tmp_s.stat_s.st_size
+                );
+                tmp_s.end = (
+                    sample < tmp_s.index_s.samples
+                      ? tmp_s.sample_ap[sample]
+                      : (unsigned long long)tmp_s.stat_s.st_size
+                );
+            }
+            if (tmp_s.end > (unsigned long long)tmp_s.stat_s.st_size)
+                tmp_s.end = tmp_s.stat_s.st_size;
+            if (tmp_s.start > tmp_s.end)
+                tmp_s.start = tmp_s.end;
+
+            /* Map from the page of the start. */
+            tmp_s.page = sysconf(_SC_PAGESIZE);
+            tmp_s.page = tmp_s.start/tmp_s.page*tmp_s.page;
+
+            if (tmp_s.end > tmp_s.page)
+                tmp_s.map_gp = mmap(
+                    NULL,
+                    tmp_s.end - tmp_s.page,
+                    PROT_READ,
+                    MAP_PRIVATE,
+                    tmp_s.file,
+                    tmp_s.page
+                );
+            if (tmp_s.map_gp == MAP_FAILED) {
+                tmp_s.code = errno;
+                tmp_s.map_gp = NULL;
+            }
+        }
+
+        if (tmp_s.map_gp) {
+            const char *end_gp = tmp_s.map_gp + (tmp_s.end - tmp_s.page);
+            unsigned int skip = (
+                tmp_s.index_s.stride ? first % tmp_s.index_s.stride : 0
+            );
+            unsigned int entries = last - first;
+            unsigned short value_a[3];
+
+            /* Skip the entries from the sample to the first entry. */
+            tmp_s.first_gp = tmp_s.map_gp + (tmp_s.start - tmp_s.page);
+            while (tmp_s.index_s.stride && tmp_s.first_gp < end_gp) {
+                const char *line_end_gp = line_end_f(tmp_s.first_gp, end_gp);
+
+                if (gpl_entry_f(tmp_s.first_gp, line_end_gp, value_a)) {
+                    if (! skip)
+                        break;
+                    skip--;
+                }
+                tmp_s.first_gp = line_end_gp + 1;
+            }
+
+            tmp_s.last_gp = tmp_s.first_gp;
+            while (tmp_s.index_s.stride && entries && tmp_s.last_gp < end_gp) {
+                const char *line_end_gp = line_end_f(tmp_s.last_gp, end_gp);
+
+                if (gpl_entry_f(tmp_s.last_gp, line_end_gp, value_a))
+                    entries--;
+                tmp_s.last_gp = line_end_gp + 1;
+            }
+            if (! tmp_s.index_s.stride)
+                tmp_s.last_gp = end_gp;
+            if (tmp_s.last_gp > end_gp)
+                tmp_s.last_gp = end_gp;
+
+            gpl_parse_f(
+                tmp_s.first_gp,
+                tmp_s.last_gp - tmp_s.first_gp,
+                palette_sp,
+                self_sp->data_s.task_s.threads
+            );
+        } else {
+            gpl_parse_f("", 0, palette_sp, 1);
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        if (tmp_s.map_gp)
+            munmap(tmp_s.map_gp, tmp_s.end - tmp_s.page);
+        if (tmp_s.file >= 0)
+            close(tmp_s.file);
+        free(tmp_s.sample_ap);
+        free(tmp_s.index_gp);
+
+        return tmp_s.code;
+    }
+
+    /*
+     * Palettes merge:
+     * the files are loaded by some threads (a file per thread),
+     * with a window of loaded files to keep the memory bounded,
+     * and merged in order by the caller thread.
+     */
+    struct Merge {
+        struct Self *self_sp;
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        char **path_gpa;
+        unsigned int paths;
+        unsigned int next;
+        unsigned int done;
+        unsigned short window;
+        struct Palette *palette_ap;
+        int *code_ap;
+        unsigned char *ready_ap;
+    };
+
+    void *
+    merge_work_f(void *merge_vp) {
+        struct Merge *merge_sp = merge_vp;
+
+        pthread_mutex_lock(&merge_sp->mutex);
+        while (TRUE) {
+            unsigned int path;
+            struct Palette palette_s;
+            int code;
+
+            /* Wait for a free place on the window. */
+            while (merge_sp->next < merge_sp->paths
+                  && merge_sp->next >= merge_sp->done + merge_sp->window)
+                pthread_cond_wait(&merge_sp->cond, &merge_sp->mutex);
+
+            if (merge_sp->next >= merge_sp->paths)
+                break;
+
+            path = merge_sp->next++;
+            pthread_mutex_unlock(&merge_sp->mutex);
+
+            code = gpl_lgen_f(
+                merge_sp->self_sp,
+                merge_sp->path_gpa[path],
+                &palette_s,
+                1
+            );
+
+            pthread_mutex_lock(&merge_sp->mutex);
+            merge_sp->palette_ap[path % merge_sp->window] = palette_s;
+            merge_sp->code_ap[path % merge_sp->window] = code;
+            merge_sp->ready_ap[path % merge_sp->window] = TRUE;
+            pthread_cond_broadcast(&merge_sp->cond);
+        }
+        pthread_mutex_unlock(&merge_sp->mutex);
+
+        return NULL;
+    }
+
+    void
+    merge_f(struct Self *self_sp, const char *mode_gp, int paths, char *path_gpa[]) {
+        /*
+         * Modes:
+         * union (all colours of all palettes),
+         * intersection (colours of the first palette on all palettes)
+         * and difference (colours of the first palette on no other one).
+         * Colours are compared by RGB with a bitmap of 1 << 24 bits,
+         * first seen colours and names are kept, in order.
+         */
+        struct {
+            unsigned char mode;
+            unsigned short threads;
+            pthread_t *thread_ap;
+            struct Merge merge_s;
+            unsigned char *bitmap_ap;
+            struct Palette palette_s;
+            unsigned int capacity;
+            unsigned int namecap;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        if (strcmp(mode_gp, "union") == 0)
+            tmp_s.mode = 1;
+        else if (strcmp(mode_gp, "intersection") == 0)
+            tmp_s.mode = 2;
+        else if (strcmp(mode_gp, "difference") == 0)
+            tmp_s.mode = 3;
+        else
+            self_sp->error_mp(self_sp, EINVAL, mode_gp);
+
+        if (! tmp_s.mode || paths < 1)
+            paths = 0;
+
+        void
+        merge_add_f(const struct Palette *palette_sp, unsigned int entry) {
+            unsigned int namel = (
+                palette_sp->name_ap[entry + 1] - palette_sp->name_ap[entry]
+            );
+
+            /* Double the arrays, if they are full. */
+            if (tmp_s.palette_s.count == tmp_s.capacity) {
+                tmp_s.capacity = tmp_s.capacity ? tmp_s.capacity*2 : 1 << 12;
+                tmp_s.palette_s.rgb_ap = realloc(
+                    tmp_s.palette_s.rgb_ap,
+                    sizeof(char) * tmp_s.capacity*3
+                );
+                tmp_s.palette_s.name_ap = realloc(
+                    tmp_s.palette_s.name_ap,
+                    sizeof(unsigned int) * (tmp_s.capacity + 1)
+                );
+            }
+            while (tmp_s.palette_s.name_ap[tmp_s.palette_s.count] + namel
+                  > tmp_s.namecap) {
+                tmp_s.namecap = tmp_s.namecap ? tmp_s.namecap*2 : 1 << 12;
+                tmp_s.palette_s.name_gp = realloc(
+                    tmp_s.palette_s.name_gp,
+                    sizeof(char) * tmp_s.namecap
+                );
+            }
+
+            memcpy(
+                &tmp_s.palette_s.rgb_ap[tmp_s.palette_s.count*3],
+                &palette_sp->rgb_ap[entry*3],
+                3
+            );
+            memcpy(
+                &tmp_s.palette_s.name_gp[
+                    tmp_s.palette_s.name_ap[tmp_s.palette_s.count]
+                ],
+                &palette_sp->name_gp[palette_sp->name_ap[entry]],
+                namel
+            );
+            tmp_s.palette_s.count++;
+            tmp_s.palette_s.name_ap[tmp_s.palette_s.count] = (
+                tmp_s.palette_s.name_ap[tmp_s.palette_s.count - 1] + namel
+            );
+        }
+
+        /* Empty palette, title and columns from the first palette. */
+        tmp_s.palette_s.name_ap = calloc(1, sizeof(unsigned int));
+        tmp_s.palette_s.columns = -1;
+        tmp_s.bitmap_ap = calloc(1 << 21, sizeof(char));
+
+        tmp_s.threads = self_sp->data_s.task_s.threads;
+        if (tmp_s.threads > paths)
+            tmp_s.threads = paths;
+
+        tmp_s.merge_s.self_sp = self_sp;
+        tmp_s.merge_s.path_gpa = path_gpa;
+        tmp_s.merge_s.paths = paths;
+        tmp_s.merge_s.window = tmp_s.threads*2;
+        if (! tmp_s.merge_s.window)
+            tmp_s.merge_s.window = 1;
+        tmp_s.merge_s.palette_ap = calloc(
+            tmp_s.merge_s.window,
+            sizeof(struct Palette)
+        );
+        tmp_s.merge_s.code_ap = calloc(tmp_s.merge_s.window, sizeof(int));
+        tmp_s.merge_s.ready_ap = calloc(tmp_s.merge_s.window, sizeof(char));
+        pthread_mutex_init(&tmp_s.merge_s.mutex, NULL);
+        pthread_cond_init(&tmp_s.merge_s.cond, NULL);
+
+        /* The threads created (none: the files are loaded by this thread). */
+        tmp_s.thread_ap = calloc(tmp_s.threads + 1, sizeof(pthread_t));
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++)
+            if (pthread_create(
+                  &tmp_s.thread_ap[thread],
+                  NULL,
+                  &merge_work_f,
+                  &tmp_s.merge_s
+                ) != 0) {
+                tmp_s.threads = thread;
+                break;
+            }
+
+        for (int path = 0; path < paths; path++) {
+            unsigned short slot = path % tmp_s.merge_s.window;
+            struct Palette *palette_sp = &tmp_s.merge_s.palette_ap[slot];
+            unsigned int kept = 0;
+
+            if (! tmp_s.threads) {
+                tmp_s.merge_s.code_ap[slot] = gpl_lgen_f(
+                    self_sp,
+                    path_gpa[path],
+                    palette_sp,
+                    1
+                );
+                tmp_s.merge_s.ready_ap[slot] = TRUE;
+            }
+
+            /* Wait for the file of this turn. */
+            pthread_mutex_lock(&tmp_s.merge_s.mutex);
+            while (! tmp_s.merge_s.ready_ap[slot])
+                pthread_cond_wait(&tmp_s.merge_s.cond, &tmp_s.merge_s.mutex);
+            pthread_mutex_unlock(&tmp_s.merge_s.mutex);
+
+            if (tmp_s.merge_s.code_ap[slot])
+                self_sp->error_mp(
+                    self_sp,
+                    tmp_s.merge_s.code_ap[slot],
+                    path_gpa[path]
+                );
+
+            if (! tmp_s.palette_s.titlel && palette_sp->titlel) {
+                tmp_s.palette_s.titlel = palette_sp->titlel;
+                memcpy(
+                    tmp_s.palette_s.title_g,
+                    palette_sp->title_g,
+                    palette_sp->titlel
+                );
+            }
+            if (tmp_s.palette_s.columns < 0)
+                tmp_s.palette_s.columns = palette_sp->columns;
+
+            if (! path || tmp_s.mode == 1) {
+                /* New colours (on the bitmap of all seen colours). */
+                for (unsigned int entry = 0; entry < palette_sp->count; entry++) {
+                    unsigned int key = (
+                        palette_sp->rgb_ap[entry*3] << 16
+                          | palette_sp->rgb_ap[entry*3 + 1] << 8
+                          | palette_sp->rgb_ap[entry*3 + 2]
+                    );
+
+                    if (tmp_s.bitmap_ap[key >> 3] & 1 << (key & 7))
+                        continue;
+
+                    tmp_s.bitmap_ap[key >> 3] |= 1 << (key & 7);
+                    merge_add_f(palette_sp, entry);
+                }
+            } else {
+                /*
+                 * Keep the colours on this palette (intersection)
+                 * or not on this palette (difference),
+                 * with the bitmap of the colours of this palette.
+                 */
+                memset(tmp_s.bitmap_ap, 0, sizeof(char) * (1 << 21));
+                for (unsigned int entry = 0; entry < palette_sp->count; entry++) {
+                    unsigned int key = (
+                        palette_sp->rgb_ap[entry*3] << 16
+                          | palette_sp->rgb_ap[entry*3 + 1] << 8
+                          | palette_sp->rgb_ap[entry*3 + 2]
+                    );
+
+                    tmp_s.bitmap_ap[key >> 3] |= 1 << (key & 7);
+                }
+
+                for (unsigned int entry = 0, name = 0;
+                      entry < tmp_s.palette_s.count;
+                      entry++) {
+                    unsigned char *rgb_ap = &tmp_s.palette_s.rgb_ap[entry*3];
+                    unsigned int key = rgb_ap[0] << 16 | rgb_ap[1] << 8 | rgb_ap[2];
+                    unsigned int *name_ap = tmp_s.palette_s.name_ap;
+                    unsigned int name_end = name_ap[entry + 1];
+
+                    if (! (tmp_s.bitmap_ap[key >> 3] & 1 << (key & 7))
+                          == (tmp_s.mode == 2)) {
+                        name = name_end;
+                        continue;
+                    }
+
+                    /*
+                     * Move the colour and its name (never forward),
+                     * "name" is the old offset of this name.
+                     */
+                    memmove(&tmp_s.palette_s.rgb_ap[kept*3], rgb_ap, 3);
+                    memmove(
+                        &tmp_s.palette_s.name_gp[name_ap[kept]],
+                        &tmp_s.palette_s.name_gp[name],
+                        name_end - name
+                    );
+                    name_ap[kept + 1] = name_ap[kept] + name_end - name;
+                    name = name_end;
+                    kept++;
+                }
+                tmp_s.palette_s.count = kept;
+            }
+
+            gpl_free_f(palette_sp);
+            pthread_mutex_lock(&tmp_s.merge_s.mutex);
+            tmp_s.merge_s.ready_ap[slot] = FALSE;
+            tmp_s.merge_s.done++;
+            pthread_cond_broadcast(&tmp_s.merge_s.cond);
+            pthread_mutex_unlock(&tmp_s.merge_s.mutex);
+        }
+
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++)
+            pthread_join(tmp_s.thread_ap[thread], NULL);
+
+        /* Source of the gpl type. */
+        if (! tmp_s.palette_s.rgb_ap)
+            tmp_s.palette_s.rgb_ap = malloc(sizeof(char));
+        if (! tmp_s.palette_s.name_gp)
+            tmp_s.palette_s.name_gp = malloc(sizeof(char));
+        gpl_free_f(&self_sp->data_s.gpl_s.palette_s);
+        self_sp->data_s.gpl_s.palette_s = tmp_s.palette_s;
+
+        self_sp->data_s.colour_s.typel = 4;
+        self_sp->data_s.colour_s.type_gp = realloc(
+            self_sp->data_s.colour_s.type_gp,
+            sizeof(char) * self_sp->data_s.colour_s.typel
+        );
+        strcpy(self_sp->data_s.colour_s.type_gp, "gpl");
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        pthread_mutex_destroy(&tmp_s.merge_s.mutex);
+        pthread_cond_destroy(&tmp_s.merge_s.cond);
+        free(tmp_s.merge_s.palette_ap);
+        free(tmp_s.merge_s.code_ap);
+        free(tmp_s.merge_s.ready_ap);
+        free(tmp_s.thread_ap);
+        free(tmp_s.bitmap_ap);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    /*
+     * Integer sort keys (see sort_f()):
+     * luminance  54*R + 183*G + 19*B (16 bits)
+     * hue        0 (gray) or 1 + sector*256 + position (11 bits)
+     * saturation (max - min)*255/max (8 bits)
+     * distance   squared RGB distance to the reference (18 bits)
+     * div_ap is the num*255/den table, on div_ap[den*256 + num].
+     */
+    void
+    sort_key_f(
+        unsigned char sort,
+        const unsigned char *rgb_ap,
+        unsigned int *key_ap,
+        unsigned int count,
+        const unsigned char *ref_ap,
+        const unsigned char *div_ap
+    ) {
+        for (unsigned int index = 0; index < count; index++) {
+            int red = rgb_ap[index*3];
+            int green = rgb_ap[index*3 + 1];
+            int blue = rgb_ap[index*3 + 2];
+            int max = red > green ? red : green;
+            int min = red < green ? red : green;
+            int delta, value, sector;
+
+            max = max > blue ? max : blue;
+            min = min < blue ? min : blue;
+            delta = max - min;
+
+            switch (sort) {
+                case SORT_LUMINANCE:
+                    key_ap[index] = 54*red + 183*green + 19*blue;
+                    break;
+                case SORT_SATURATION:
+                    key_ap[index] = div_ap[max*256 + delta];
+                    break;
+                case SORT_DISTANCE:
+                    key_ap[index] = (
+                        (red - ref_ap[0])*(red - ref_ap[0])
+                          + (green - ref_ap[1])*(green - ref_ap[1])
+                          + (blue - ref_ap[2])*(blue - ref_ap[2])
+                    );
+                    break;
+                default:
+                    /* Sectors of 60 degrees, from red. */
+                    if (red == max) {
+                        value = green - blue;
+                        sector = value < 0 ? 5 : 0;
+                    } else if (green == max) {
+                        value = blue - red;
+                        sector = value < 0 ? 1 : 2;
+                    } else {
+                        value = red - green;
+                        sector = value < 0 ? 3 : 4;
+                    }
+                    if (value < 0)
+                        value += delta;
+
+                    key_ap[index] = (
+                        delta ? 1 + sector*256 + div_ap[delta*256 + value] : 0
+                    );
+            }
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("avx2")))
+    void
+    sort_key_avx2_f(
+        unsigned char sort,
+        const unsigned char *rgb_ap,
+        unsigned int *key_ap,
+        unsigned int count,
+        const unsigned char *ref_ap,
+        const unsigned char *div_ap
+    ) {
+        /*
+         * 8 entries per step: 4 entries (12 bytes) per 128 bits lane,
+         * so each lane loads 16 bytes (4 bytes after the entries).
+         */
+        const __m256i shuffle_a[3] = {
+            _mm256_setr_epi8(
+                0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1,
+                0, -1, -1, -1, 3, -1, -1, -1, 6, -1, -1, -1, 9, -1, -1, -1
+            ),
+            _mm256_setr_epi8(
+                1, -1, -1, -1, 4, -1, -1, -1, 7, -1, -1, -1, 10, -1, -1, -1,
+                1, -1, -1, -1, 4, -1, -1, -1, 7, -1, -1, -1, 10, -1, -1, -1
+            ),
+            _mm256_setr_epi8(
+                2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1,
+                2, -1, -1, -1, 5, -1, -1, -1, 8, -1, -1, -1, 11, -1, -1, -1
+            )
+        };
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i byte = _mm256_set1_epi32(0xff);
+        unsigned int index = 0;
+
+        for (; index + 10 <= count; index += 8) {
+            __m256i pack = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(
+                    _mm_loadu_si128((const __m128i *)&rgb_ap[index*3])
+                ),
+                _mm_loadu_si128((const __m128i *)&rgb_ap[index*3 + 12]),
+                1
+            );
+            __m256i red = _mm256_shuffle_epi8(pack, shuffle_a[0]);
+            __m256i green = _mm256_shuffle_epi8(pack, shuffle_a[1]);
+            __m256i blue = _mm256_shuffle_epi8(pack, shuffle_a[2]);
+            __m256i max = _mm256_max_epi32(_mm256_max_epi32(red, green), blue);
+            __m256i min = _mm256_min_epi32(_mm256_min_epi32(red, green), blue);
+            __m256i delta = _mm256_sub_epi32(max, min);
+            __m256i key;
+
+            if (sort == SORT_LUMINANCE) {
+                key = _mm256_add_epi32(
+                    _mm256_add_epi32(
+                        _mm256_mullo_epi32(red, _mm256_set1_epi32(54)),
+                        _mm256_mullo_epi32(green, _mm256_set1_epi32(183))
+                    ),
+                    _mm256_mullo_epi32(blue, _mm256_set1_epi32(19))
+                );
+            } else if (sort == SORT_SATURATION) {
+                key = _mm256_and_si256(
+                    _mm256_i32gather_epi32(
+                        (const int *)div_ap,
+                        _mm256_add_epi32(_mm256_slli_epi32(max, 8), delta),
+                        1
+                    ),
+                    byte
+                );
+            } else if (sort == SORT_DISTANCE) {
+                red = _mm256_sub_epi32(red, _mm256_set1_epi32(ref_ap[0]));
+                green = _mm256_sub_epi32(green, _mm256_set1_epi32(ref_ap[1]));
+                blue = _mm256_sub_epi32(blue, _mm256_set1_epi32(ref_ap[2]));
+                key = _mm256_add_epi32(
+                    _mm256_add_epi32(
+                        _mm256_mullo_epi32(red, red),
+                        _mm256_mullo_epi32(green, green)
+                    ),
+                    _mm256_mullo_epi32(blue, blue)
+                );
+            } else {
+                /* Same branches of sort_key_f(), as masks. */
+                __m256i is_red = _mm256_cmpeq_epi32(red, max);
+                __m256i is_green = _mm256_andnot_si256(
+                    is_red,
+                    _mm256_cmpeq_epi32(green, max)
+                );
+                __m256i value = _mm256_blendv_epi8(
+                    _mm256_blendv_epi8(
+                        _mm256_sub_epi32(red, green),
+                        _mm256_sub_epi32(blue, red),
+                        is_green
+                    ),
+                    _mm256_sub_epi32(green, blue),
+                    is_red
+                );
+                __m256i negative = _mm256_cmpgt_epi32(zero, value);
+                __m256i sector = _mm256_blendv_epi8(
+                    _mm256_blendv_epi8(
+                        _mm256_blendv_epi8(
+                            _mm256_set1_epi32(4),
+                            _mm256_set1_epi32(2),
+                            is_green
+                        ),
+                        zero,
+                        is_red
+                    ),
+                    _mm256_blendv_epi8(
+                        _mm256_blendv_epi8(
+                            _mm256_set1_epi32(3),
+                            _mm256_set1_epi32(1),
+                            is_green
+                        ),
+                        _mm256_set1_epi32(5),
+                        is_red
+                    ),
+                    negative
+                );
+
+                value = _mm256_add_epi32(value, _mm256_and_si256(negative, delta));
+                key = _mm256_add_epi32(
+                    _mm256_add_epi32(
+                        _mm256_set1_epi32(1),
+                        _mm256_slli_epi32(sector, 8)
+                    ),
+                    _mm256_and_si256(
+                        _mm256_i32gather_epi32(
+                            (const int *)div_ap,
+                            _mm256_add_epi32(_mm256_slli_epi32(delta, 8), value),
+                            1
+                        ),
+                        byte
+                    )
+                );
+                key = _mm256_andnot_si256(_mm256_cmpeq_epi32(delta, zero), key);
+            }
+
+            _mm256_storeu_si256((__m256i *)&key_ap[index], key);
+        }
+
+        /* Remainder. */
+        sort_key_f(
+            sort,
+            &rgb_ap[index*3],
+            &key_ap[index],
+            count - index,
+            ref_ap,
+            div_ap
+        );
+    }
+#endif
+
+    /*
+     * Parallel LSD radix sort (stable) of keys and values:
+     * each thread counts the digits of its own range,
+     * the offsets are the digits of all threads in order
+     * (digit, then thread), and each thread moves its range.
+     */
+    struct Sort {
+        unsigned char phase;
+        unsigned char sort;
+        void (*key_fp)(
+            unsigned char,
+            const unsigned char *,
+            unsigned int *,
+            unsigned int,
+            const unsigned char *,
+            const unsigned char *
+        );
+        const unsigned char *rgb_ap;
+        const unsigned char *ref_ap;
+        const unsigned char *div_ap;
+        unsigned char names: 1;
+        unsigned int *key_ap[2];
+        unsigned int *value_ap[2];
+        unsigned char source: 1;
+        unsigned char shift;
+        unsigned int mask;
+        unsigned int start;
+        unsigned int end;
+        unsigned int *count_ap;
+        /* Without a thread, the range is done by the calling thread. */
+        unsigned char threaded: 1;
+    };
+
+    void *
+    sort_work_f(void *sort_vp) {
+        struct Sort *sort_sp = sort_vp;
+        unsigned int *key_ap = sort_sp->key_ap[sort_sp->source];
+        unsigned int *value_ap = sort_sp->value_ap[sort_sp->source];
+
+        switch (sort_sp->phase) {
+            case 0:
+                /* Keys and values (the index or the colour). */
+                sort_sp->key_fp(
+                    sort_sp->sort,
+                    &sort_sp->rgb_ap[(unsigned long long)sort_sp->start*3],
+                    &key_ap[sort_sp->start],
+                    sort_sp->end - sort_sp->start,
+                    sort_sp->ref_ap,
+                    sort_sp->div_ap
+                );
+                for (unsigned int index = sort_sp->start;
+                      index < sort_sp->end;
+                      index++)
+                    value_ap[index] = (
+                        sort_sp->names
+                          ? index
+                          : (unsigned int)sort_sp->rgb_ap[index*3] << 16
+                            | sort_sp->rgb_ap[index*3 + 1] << 8
+                            | sort_sp->rgb_ap[index*3 + 2]
+                    );
+                break;
+            case 1:
+                memset(
+                    sort_sp->count_ap,
+                    0,
+                    sizeof(unsigned int) * (sort_sp->mask + 1)
+                );
+                for (unsigned int index = sort_sp->start;
+                      index < sort_sp->end;
+                      index++)
+                    sort_sp->count_ap[
+                        key_ap[index] >> sort_sp->shift & sort_sp->mask
+                    ]++;
+                break;
+            default:
+                for (unsigned int index = sort_sp->start;
+                      index < sort_sp->end;
+                      index++) {
+                    unsigned int target = sort_sp->count_ap[
+                        key_ap[index] >> sort_sp->shift & sort_sp->mask
+                    ]++;
+
+                    sort_sp->key_ap[! sort_sp->source][target] = key_ap[index];
+                    sort_sp->value_ap[! sort_sp->source][target] = (
+                        value_ap[index]
+                    );
+                }
+        }
+
+        return NULL;
+    }
+
+    void
+    sort_f(struct Self *self_sp) {
+        /*
+         * Sort stage, between the source and the emitters:
+         * the colour array (made from the channel tables, if needed)
+         * and the names are sorted by the sort key, stable.
+         */
+        struct {
+            unsigned int count;
+            unsigned short threads;
+            pthread_t *thread_ap;
+            struct Sort *sort_ap;
+            unsigned int *count_ap;
+            unsigned int *key_ap[2];
+            unsigned int *value_ap[2];
+            unsigned char bits;
+            unsigned char passes;
+            unsigned char digit;
+            unsigned char source: 1;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        tmp_s.count = self_sp->emit_s.count;
+
+        void
+        sort_run_f(unsigned char phase) {
+            for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+                tmp_s.sort_ap[thread].phase = phase;
+                tmp_s.sort_ap[thread].source = tmp_s.source;
+
+                if (thread) {
+                    tmp_s.sort_ap[thread].threaded = ! pthread_create(
+                        &tmp_s.thread_ap[thread],
+                        NULL,
+                        &sort_work_f,
+                        &tmp_s.sort_ap[thread]
+                    );
+                    if (! tmp_s.sort_ap[thread].threaded)
+                        sort_work_f(&tmp_s.sort_ap[thread]);
+                }
+            }
+            sort_work_f(&tmp_s.sort_ap[0]);
+
+            for (unsigned short thread = 1; thread < tmp_s.threads; thread++)
+                if (tmp_s.sort_ap[thread].threaded)
+                    pthread_join(tmp_s.thread_ap[thread], NULL);
+        }
+
+        /* Colour array of the channel tables, in the loop order. */
+        if (! self_sp->emit_s.colour_ap) {
+            unsigned short index_a[3] = {0, 0, 0};
+            const unsigned short *tablel_ap = self_sp->emit_s.tablel_a;
+
+            self_sp->emit_s.colour_ap = malloc(
+                sizeof(char) * ((unsigned long long)tmp_s.count*3 + 1)
+            );
+
+            for (unsigned int entry = 0; entry < tmp_s.count; entry++) {
+                unsigned char *rgb_ap = &self_sp->emit_s.colour_ap[entry*3];
+
+                rgb_ap[0] = self_sp->emit_s.table_ap[0][index_a[0]];
+                rgb_ap[1] = (
+                    self_sp->emit_s.gray
+                      ? rgb_ap[0]
+                      : self_sp->emit_s.table_ap[1][index_a[1]]
+                );
+                rgb_ap[2] = (
+                    self_sp->emit_s.gray
+                      ? rgb_ap[0]
+                      : self_sp->emit_s.table_ap[2][index_a[2]]
+                );
+
+                if (++index_a[0] == tablel_ap[0]) {
+                    index_a[0] = 0;
+
+                    if (++index_a[1] == tablel_ap[1]) {
+                        index_a[1] = 0;
+                        index_a[2]++;
+                    }
+                }
+            }
+        }
+
+        /* Division table of hue and saturation. */
+        if (! self_sp->table_s.div_ready) {
+            for (unsigned int den = 1; den < 1 << 8; den++)
+                for (unsigned int num = 0; num <= den; num++)
+                    self_sp->table_s.div_a[den*256 + num] = num*255/den;
+            self_sp->table_s.div_ready = TRUE;
+        }
+
+        switch (self_sp->data_s.sort_s.sort) {
+            case SORT_LUMINANCE:
+                tmp_s.bits = 16;
+                break;
+            case SORT_HUE:
+                tmp_s.bits = 11;
+                break;
+            case SORT_SATURATION:
+                tmp_s.bits = 8;
+                break;
+            default:
+                tmp_s.bits = 18;
+        }
+
+        /* Digits of 11 bits at most (2048 counters per thread). */
+        tmp_s.passes = (tmp_s.bits + 10)/11;
+        tmp_s.digit = (tmp_s.bits + tmp_s.passes - 1)/tmp_s.passes;
+
+        tmp_s.threads = self_sp->data_s.task_s.threads;
+        if (tmp_s.threads > tmp_s.count/(1 << 16) + 1)
+            tmp_s.threads = tmp_s.count/(1 << 16) + 1;
+
+        for (unsigned char buffer = 0; buffer < 2; buffer++) {
+            tmp_s.key_ap[buffer] = huge_alloc_f(
+                sizeof(unsigned int) * tmp_s.count,
+                self_sp->data_s.task_s.pages
+            );
+            tmp_s.value_ap[buffer] = huge_alloc_f(
+                sizeof(unsigned int) * tmp_s.count,
+                self_sp->data_s.task_s.pages
+            );
+        }
+        tmp_s.thread_ap = calloc(tmp_s.threads, sizeof(pthread_t));
+        tmp_s.sort_ap = calloc(tmp_s.threads, sizeof(struct Sort));
+        tmp_s.count_ap = calloc(
+            (unsigned long)tmp_s.threads << tmp_s.digit,
+            sizeof(unsigned int)
+        );
+
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            struct Sort *sort_sp = &tmp_s.sort_ap[thread];
+
+            sort_sp->sort = self_sp->data_s.sort_s.sort;
+            sort_sp->key_fp = &sort_key_f;
+#if defined(__x86_64__) || defined(__i386__)
+            if (__builtin_cpu_supports("avx2"))
+                sort_sp->key_fp = &sort_key_avx2_f;
+#endif
+            sort_sp->rgb_ap = self_sp->emit_s.colour_ap;
+            sort_sp->ref_ap = self_sp->data_s.sort_s.ref_a;
+            sort_sp->div_ap = self_sp->table_s.div_a;
+            sort_sp->names = self_sp->emit_s.name_ap != NULL;
+            memcpy(sort_sp->key_ap, tmp_s.key_ap, sizeof(tmp_s.key_ap));
+            memcpy(sort_sp->value_ap, tmp_s.value_ap, sizeof(tmp_s.value_ap));
+            sort_sp->mask = (1 << tmp_s.digit) - 1;
+            sort_sp->start = (
+                (unsigned long long)tmp_s.count*thread/tmp_s.threads
+            );
+            sort_sp->end = (
+                (unsigned long long)tmp_s.count*(thread + 1)/tmp_s.threads
+            );
+            sort_sp->count_ap = (
+                tmp_s.count_ap + ((unsigned long)thread << tmp_s.digit)
+            );
+        }
+        sort_run_f(0);
+
+        for (unsigned char pass = 0; pass < tmp_s.passes; pass++) {
+            unsigned int offset = 0;
+
+            for (unsigned short thread = 0; thread < tmp_s.threads; thread++)
+                tmp_s.sort_ap[thread].shift = pass*tmp_s.digit;
+            sort_run_f(1);
+
+            /* Counters to offsets, digit by digit, thread by thread. */
+            for (unsigned int digit = 0; digit < 1U << tmp_s.digit; digit++)
+                for (unsigned short thread = 0;
+                      thread < tmp_s.threads;
+                      thread++) {
+                    unsigned int count = tmp_s.sort_ap[thread].count_ap[digit];
+
+                    tmp_s.sort_ap[thread].count_ap[digit] = offset;
+                    offset += count;
+                }
+
+            sort_run_f(2);
+            tmp_s.source = ! tmp_s.source;
+        }
+
+        /* Sorted colours (and names). */
+        if (self_sp->emit_s.name_ap) {
+            unsigned char *colour_ap = malloc(
+                sizeof(char) * ((unsigned long long)tmp_s.count*3 + 1)
+            );
+            unsigned int *name_ap = malloc(
+                sizeof(unsigned int) * (tmp_s.count + 1)
+            );
+            char *name_gp = malloc(
+                sizeof(char) * (self_sp->emit_s.name_ap[tmp_s.count] + 1)
+            );
+
+            name_ap[0] = 0;
+            for (unsigned int entry = 0; entry < tmp_s.count; entry++) {
+                unsigned int index = tmp_s.value_ap[tmp_s.source][entry];
+                unsigned int namel = (
+                    self_sp->emit_s.name_ap[index + 1]
+                      - self_sp->emit_s.name_ap[index]
+                );
+
+                memcpy(
+                    &colour_ap[entry*3],
+                    &self_sp->emit_s.colour_ap[index*3],
+                    3
+                );
+                memcpy(
+                    &name_gp[name_ap[entry]],
+                    &self_sp->emit_s.name_gp[self_sp->emit_s.name_ap[index]],
+                    namel
+                );
+                name_ap[entry + 1] = name_ap[entry] + namel;
+            }
+
+            free(self_sp->emit_s.colour_ap);
+            free(self_sp->emit_s.name_ap);
+            free(self_sp->emit_s.name_gp);
+            self_sp->emit_s.colour_ap = colour_ap;
+            self_sp->emit_s.name_ap = name_ap;
+            self_sp->emit_s.name_gp = name_gp;
+        } else {
+            for (unsigned int entry = 0; entry < tmp_s.count; entry++) {
+                unsigned int value = tmp_s.value_ap[tmp_s.source][entry];
+
+                self_sp->emit_s.colour_ap[entry*3] = value >> 16;
+                self_sp->emit_s.colour_ap[entry*3 + 1] = value >> 8 & 0xff;
+                self_sp->emit_s.colour_ap[entry*3 + 2] = value & 0xff;
+            }
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        for (unsigned char buffer = 0; buffer < 2; buffer++) {
+            huge_free_f(tmp_s.key_ap[buffer]);
+            huge_free_f(tmp_s.value_ap[buffer]);
+        }
+        free(tmp_s.thread_ap);
+        free(tmp_s.sort_ap);
+        free(tmp_s.count_ap);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    char *
+    header_lgen_f(struct Self *self_sp) {
+        /* Default values. */
+        struct {
+            unsigned char authorl;
+            char *author_gp;
+            unsigned char columns;
+            unsigned char columns_lmin1: 2;
+            unsigned char *columns_gp;
+            unsigned char titlel;
+            char *title_gp;
+            unsigned char yearsl;
+            char *years_gp;
+        } tmp_s = {
+            self_sp->data_s.copyright_s.authorl,
+            self_sp->data_s.copyright_s.author_gp,
+            self_sp->data_s.pmap_s.columns,
+            0,
+            NULL,
+            self_sp->data_s.pmap_s.titlel,
+            self_sp->data_s.pmap_s.title_gp,
+            self_sp->data_s.copyright_s.yearsl,
+            self_sp->data_s.copyright_s.years_gp
+        };
+
+        /* Set columns values. */
+        if (tmp_s.columns < 10)
+            tmp_s.columns_lmin1 = 1;
+        else if (tmp_s.columns < 100)
+            tmp_s.columns_lmin1 = 2;
+        else
+            tmp_s.columns_lmin1 = 3;
+
+        /* Declare and add dynamic memory to the columns string. */
+        tmp_s.columns_gp = (
+            malloc(sizeof(char) * (tmp_s.columns_lmin1 + 1))
+        );
+        sprintf(tmp_s.columns_gp, "%hu", tmp_s.columns);
+
+        /* Default string values. */
+        struct {
+            char line1_g[13];
+            char line2a_g[7];
+            char line3a_g[10];
+            char line5a_g[14];
+            char line5c_g[5];
+            char line6a_g[36];
+            char line6b_g[44];
+            char line7a_g[40];
+            char line7b_g[36];
+            char line8a_g[13];
+            char line8b_g[52];
+            char line9a_g[34];
+            char line9b_g[43];
+            char line10_g[34];
+            char line11_g[56];
+            char newline_g[2];
+            char n_sing_g[2];
+            unsigned short lenght: 11;
+        } stg_s = {
+            "GIMP Palette",
+            "Name: ",
+            "Columns: ",
+            "# Written in ",
+            " by ",
+            "# To the extent possible under law,",
+            " the author(s) have dedicated all copyright",
+            "# and related and neighboring rights to",
+            " this software to the public domain",
+            "# worldwide.",
+            " This software is distributed without any warranty.",
+            "# You should have received a copy",
+            " of the CC0 Public Domain Dedication along",
+            "# with this software. If not, see",
+            "# <https://creativecommons.org/publicdomain/zero/1.0/>.",
+            {'\n', '\0'},
+            {'#', '\0'},
+            0
+        };
+
+        /* Declare the lenght of the header string. */
+        stg_s.lenght = (
+            sizeof(stg_s.line1_g)/sizeof(char) - 1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.line2a_g)/sizeof(char) - 1
+              + (unsigned short)tmp_s.titlel - 1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.line3a_g)/sizeof(char) - 1
+              + (unsigned short)tmp_s.columns_lmin1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.n_sing_g)/sizeof(char) - 1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.line5a_g)/sizeof(char) - 1
+              + (unsigned short)tmp_s.yearsl - 1
+              + sizeof(stg_s.line5c_g)/sizeof(char) - 1
+              + (unsigned short)tmp_s.authorl - 1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.line6a_g)/sizeof(char) - 1
+              + sizeof(stg_s.line6b_g)/sizeof(char) - 1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.line7b_g)/sizeof(char) - 1
+              + sizeof(stg_s.line7a_g)/sizeof(char) - 1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.line8b_g)/sizeof(char) - 1
+              + sizeof(stg_s.line8a_g)/sizeof(char) - 1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.line9b_g)/sizeof(char) - 1
+              + sizeof(stg_s.line9a_g)/sizeof(char) - 1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.line10_g)/sizeof(char) - 1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.line11_g)/sizeof(char) - 1
+              + sizeof(stg_s.newline_g)/sizeof(char) - 1
+              + sizeof(stg_s.n_sing_g)/sizeof(char) - 1
+              + sizeof(stg_s.newline_g)/sizeof(char)
+        );
+
+        /* Declare and add dynamic memory to the header string. */
+        char *stg_gp = malloc(sizeof(char) * stg_s.lenght);
+        memset(stg_gp, '\0', sizeof(char) * stg_s.lenght);
+
+        /* Copy all strings to the header string. */
+        strcat(stg_gp, stg_s.line1_g);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.line2a_g);
+        strcat(stg_gp, tmp_s.title_gp);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.line3a_g);
+        strcat(stg_gp, tmp_s.columns_gp);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.n_sing_g);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.line5a_g);
+        strcat(stg_gp, tmp_s.years_gp);
+        strcat(stg_gp, stg_s.line5c_g);
+        strcat(stg_gp, tmp_s.author_gp);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.line6a_g);
+        strcat(stg_gp, stg_s.line6b_g);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.line7a_g);
+        strcat(stg_gp, stg_s.line7b_g);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.line8a_g);
+        strcat(stg_gp, stg_s.line8b_g);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.line9a_g);
+        strcat(stg_gp, stg_s.line9b_g);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.line10_g);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.line11_g);
+        strcat(stg_gp, stg_s.newline_g);
+        strcat(stg_gp, stg_s.n_sing_g);
+        strcat(stg_gp, stg_s.newline_g);
+        stg_gp[stg_s.lenght - 1] = '\0';
+
+        /* Save the lenght of the header string. */
+        self_sp->buffer_s.headerl = stg_s.lenght;
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        memset(
+            self_sp->data_s.copyright_s.author_gp,
+            '\0',
+            sizeof(char) * self_sp->data_s.copyright_s.authorl
+        );
+        memset(
+            self_sp->data_s.pmap_s.title_gp,
+            '\0',
+            sizeof(char) * self_sp->data_s.pmap_s.titlel
+        );
+        memset(
+            self_sp->data_s.copyright_s.years_gp,
+            '\0',
+            sizeof(char) * self_sp->data_s.copyright_s.yearsl
+        );
+        memset(
+            tmp_s.columns_gp,
+            '\0',
+            sizeof(char) * (tmp_s.columns_lmin1 + 1)
+        );
+        self_sp->data_s.copyright_s.authorl = 0;
+        self_sp->data_s.pmap_s.titlel = 0;
+        self_sp->data_s.copyright_s.yearsl = 0;
+        free(self_sp->data_s.copyright_s.author_gp);
+        free(self_sp->data_s.pmap_s.title_gp);
+        free(self_sp->data_s.copyright_s.years_gp);
+        free(tmp_s.columns_gp);
+        self_sp->data_s.copyright_s.author_gp = NULL;
+        self_sp->data_s.pmap_s.title_gp = NULL;
+        self_sp->data_s.copyright_s.years_gp = NULL;
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+        memset(&stg_s, '\0', sizeof(stg_s));
+        self_sp->data_s.pmap_s.columns = 0;
+
+        /* Return the header string. */
+        return stg_gp;
+    }
+
+    void
+    src_lgen_f(struct Self *self_sp) {
+        /*
+         * Entries source of the emitters:
+         * a colour array (image, hsv, hsl, oklab and gpl types)
+         * or the channel tables (gray and rgb types).
+         */
+        char *type_gp = self_sp->data_s.colour_s.type_gp;
+        unsigned char *depth_ap = self_sp->data_s.colour_s.depth_a;
+
+        self_sp->emit_s.gray = FALSE;
+        self_sp->emit_s.colour_ap = NULL;
+        self_sp->emit_s.name_gp = NULL;
+        self_sp->emit_s.name_ap = NULL;
+        memset(self_sp->emit_s.table_ap, 0, sizeof(self_sp->emit_s.table_ap));
+
+        if (strcmp(type_gp, "gpl") == 0) {
+            struct Palette palette_s;
+            int code = EINVAL;
+
+            /*
+             * A palette made by merge_f()
+             * or the palette file (on the palette key).
+             */
+            if (self_sp->data_s.gpl_s.palette_s.rgb_ap) {
+                palette_s = self_sp->data_s.gpl_s.palette_s;
+                memset(
+                    &self_sp->data_s.gpl_s.palette_s,
+                    '\0',
+                    sizeof(self_sp->data_s.gpl_s.palette_s)
+                );
+                code = 0;
+            } else if (self_sp->data_s.gpl_s.path_gp) {
+                code = self_sp->gpl_lgen_mp(
+                    self_sp,
+                    self_sp->data_s.gpl_s.path_gp,
+                    &palette_s,
+                    self_sp->data_s.task_s.threads
+                );
+            } else {
+                gpl_parse_f("", 0, &palette_s, 1);
+            }
+
+            if (code)
+                self_sp->error_mp(
+                    self_sp,
+                    code,
+                    self_sp->data_s.gpl_s.path_gp
+                      ? self_sp->data_s.gpl_s.path_gp
+                      : "palette"
+                );
+
+            self_sp->emit_s.colour_ap = palette_s.rgb_ap;
+            self_sp->emit_s.count = palette_s.count;
+
+            /* Names only if some colour has a name. */
+            if (palette_s.name_ap[palette_s.count]) {
+                self_sp->emit_s.name_gp = palette_s.name_gp;
+                self_sp->emit_s.name_ap = palette_s.name_ap;
+            } else {
+                free(palette_s.name_gp);
+                free(palette_s.name_ap);
+            }
+
+            /* Title and columns of the file, if the config has not them. */
+            if (palette_s.titlel && ! (self_sp->data_s.pmap_s.configured & 1)) {
+                self_sp->data_s.pmap_s.titlel = palette_s.titlel;
+                self_sp->data_s.pmap_s.title_gp = (
+                    realloc(
+                        self_sp->data_s.pmap_s.title_gp,
+                        sizeof(char) * self_sp->data_s.pmap_s.titlel
+                    )
+                );
+                strcpy(self_sp->data_s.pmap_s.title_gp, palette_s.title_g);
+            }
+            if (palette_s.columns >= 0
+                  && ! (self_sp->data_s.pmap_s.configured & 2))
+                self_sp->data_s.pmap_s.columns = (
+                    palette_s.columns < 1 << 8 ? palette_s.columns : (1 << 8) - 1
+                );
+
+            free(self_sp->data_s.gpl_s.path_gp);
+            self_sp->data_s.gpl_s.path_gp = NULL;
+            self_sp->data_s.gpl_s.pathl = 0;
+            memset(&palette_s, '\0', sizeof(palette_s));
+        } else if (strcmp(type_gp, "image") == 0
+              || strcmp(type_gp, "hsv") == 0
+              || strcmp(type_gp, "hsl") == 0
+              || strcmp(type_gp, "oklab") == 0
+              || strcmp(type_gp, "gradient") == 0) {
+            /* Set colour lenght and array. */
+            if (strcmp(type_gp, "gradient") == 0)
+                self_sp->emit_s.colour_ap = self_sp->gradient_lgen_mp(self_sp);
+            else if (strcmp(type_gp, "hsv") == 0)
+                self_sp->emit_s.colour_ap = (
+                    self_sp->space_lgen_mp(self_sp, SPACE_HSV)
+                );
+            else if (strcmp(type_gp, "hsl") == 0)
+                self_sp->emit_s.colour_ap = (
+                    self_sp->space_lgen_mp(self_sp, SPACE_HSL)
+                );
+            else if (strcmp(type_gp, "oklab") == 0)
+                self_sp->emit_s.colour_ap = (
+                    self_sp->space_lgen_mp(self_sp, SPACE_OKLAB)
+                );
+            else if (self_sp->data_s.image_s.path_gp)
+                self_sp->emit_s.colour_ap = self_sp->image_lgen_mp(self_sp);
+            else {
+                /* No image key. */
+                self_sp->emit_s.colour_ap = malloc(sizeof(char));
+                self_sp->buffer_s.colourl = 0;
+                self_sp->error_mp(self_sp, EINVAL, "image");
+            }
+
+            /*
+             * Set lenght generated by image_lgen_mp(), space_lgen_mp()
+             * or gradient_lgen_mp().
+             */
+            self_sp->emit_s.count = self_sp->buffer_s.colourl;
+
+            if (strcmp(type_gp, "image") == 0) {
+                free(self_sp->data_s.image_s.path_gp);
+                self_sp->data_s.image_s.path_gp = NULL;
+                self_sp->data_s.image_s.pathl = 0;
+            }
+        } else if (strcmp(type_gp, "g") == 0
+              || strcmp(type_gp, "gr") == 0
+              || strcmp(type_gp, "gry") == 0
+              || strcmp(type_gp, "gray") == 0
+              || strcmp(type_gp, "grey") == 0) {
+            /* Set key colour lenght and table (red, green and blue). */
+            self_sp->emit_s.gray = TRUE;
+            self_sp->emit_s.table_ap[0] = (
+                self_sp->bchn_lgen_mp(self_sp, depth_ap[0], 0)
+            );
+            self_sp->emit_s.tablel_a[0] = self_sp->buffer_s.bchn_lmin1 + 1;
+            self_sp->emit_s.tablel_a[1] = 1;
+            self_sp->emit_s.tablel_a[2] = 1;
+        } else {
+            /* Set red, green and blue colour lenghts and tables. */
+            for (unsigned char channel = 0; channel < 3; channel++) {
+                self_sp->emit_s.table_ap[channel] = (
+                    self_sp->bchn_lgen_mp(self_sp, depth_ap[channel], channel)
+                );
+                self_sp->emit_s.tablel_a[channel] = (
+                    self_sp->buffer_s.bchn_lmin1 + 1
+                );
+            }
+        }
+
+        if (! self_sp->emit_s.colour_ap)
+            self_sp->emit_s.count = (
+                self_sp->emit_s.tablel_a[0]
+                  * self_sp->emit_s.tablel_a[1]
+                  * self_sp->emit_s.tablel_a[2]
+            );
+
+        /* Sort stage. */
+        if (self_sp->data_s.sort_s.sort != SORT_NONE
+              && self_sp->emit_s.count > 1)
+            self_sp->sort_mp(self_sp);
+
+        /* ACT files have 256 colours at most. */
+        if (self_sp->emit_s.format == FORMAT_ACT
+              && self_sp->emit_s.count > 1 << 8) {
+            self_sp->emit_s.count = 1 << 8;
+            self_sp->error_mp(self_sp, EFBIG, "act");
+        }
+
+        /* Slice of entries (start to end, the end is not included). */
+        self_sp->emit_s.start = self_sp->emit_s.slice_a[0];
+        self_sp->emit_s.end = self_sp->emit_s.slice_a[1];
+        if (! self_sp->emit_s.end || self_sp->emit_s.end > self_sp->emit_s.count)
+            self_sp->emit_s.end = self_sp->emit_s.count;
+        if (self_sp->emit_s.start > self_sp->emit_s.end)
+            self_sp->emit_s.start = self_sp->emit_s.end;
+
+        /* Simulated colours of the cvd names or variant files. */
+        memset(self_sp->emit_s.cvd_apa, 0, sizeof(self_sp->emit_s.cvd_apa));
+        if ((self_sp->emit_s.names == NAMES_CVD
+              && self_sp->emit_s.format == FORMAT_GPL)
+              || (self_sp->emit_s.cvd && self_sp->emit_s.cvd_gp))
+            cvd_lgen_f(self_sp);
+
+        /*
+         * Fixed record lenght of each format:
+         * GPL   "RRR GGG BBB\t#\n"
+         *       "RRR GGG BBB\t#rrggbb\n" (hex names)
+         *       "RRR GGG BBB\tRRR-GGG-BBB\n" (rgb names, 0 padded)
+         *       "RRR GGG BBB\tprotan #rrggbb deutan #rrggbb tritan #rrggbb\n"
+         *       (cvd names)
+         * hex   "#rrggbb\n"
+         * CSS   "  --palette-N: #rrggbb;\n" (N with fixed digits)
+         * JSON  "  \"#rrggbb\",\n" (last one without comma)
+         * C     "  {RRR, GGG, BBB},\n"
+         * ACT   3 bytes (red, green, blue)
+         */
+        self_sp->emit_s.digits = 1;
+        for (unsigned int count = 10;
+              count < self_sp->emit_s.count;
+              count *= 10)
+            self_sp->emit_s.digits++;
+
+        switch (self_sp->emit_s.format) {
+            case FORMAT_HEX:
+                self_sp->emit_s.recordl = 8;
+                break;
+            case FORMAT_CSS:
+                self_sp->emit_s.recordl = 23 + self_sp->emit_s.digits;
+                break;
+            case FORMAT_JSON:
+                self_sp->emit_s.recordl = 13;
+                break;
+            case FORMAT_C:
+                self_sp->emit_s.recordl = 19;
+                break;
+            case FORMAT_ACT:
+                self_sp->emit_s.recordl = 3;
+                break;
+            default:
+                if (self_sp->emit_s.names == NAMES_HEX)
+                    self_sp->emit_s.recordl = 20;
+                else if (self_sp->emit_s.names == NAMES_RGB)
+                    self_sp->emit_s.recordl = 24;
+                else if (self_sp->emit_s.names == NAMES_CVD)
+                    self_sp->emit_s.recordl = 57;
+                else
+                    self_sp->emit_s.recordl = 14;
+        }
+
+        /*
+         * Names of a loaded palette (GPL without other names):
+         * "RRR GGG BBB\tname\n", the longest record.
+         */
+        if (self_sp->emit_s.name_ap
+              && (self_sp->emit_s.format != FORMAT_GPL
+                || self_sp->emit_s.names != NAMES_NONE)) {
+            free(self_sp->emit_s.name_gp);
+            free(self_sp->emit_s.name_ap);
+            self_sp->emit_s.name_gp = NULL;
+            self_sp->emit_s.name_ap = NULL;
+        }
+
+        if (self_sp->emit_s.name_ap)
+            for (unsigned int entry = 0;
+                  entry < self_sp->emit_s.count;
+                  entry++)
+                if (13 + self_sp->emit_s.name_ap[entry + 1]
+                      - self_sp->emit_s.name_ap[entry]
+                      > self_sp->emit_s.recordl)
+                    self_sp->emit_s.recordl = (
+                        13 + self_sp->emit_s.name_ap[entry + 1]
+                          - self_sp->emit_s.name_ap[entry]
+                    );
+
+        /* Channel text tables, "  0" and "000" to "255", "00" to "ff". */
+        if (! self_sp->emit_s.text_ready) {
+            for (unsigned short value = 0; value < 1 << 8; value++) {
+                self_sp->emit_s.dec_a[value][0] = (
+                    value > 99 ? '0' + value/100 : ' '
+                );
+                self_sp->emit_s.dec_a[value][1] = (
+                    value > 9 ? '0' + value/10%10 : ' '
+                );
+                self_sp->emit_s.dec_a[value][2] = '0' + value%10;
+                self_sp->emit_s.zero_a[value][0] = '0' + value/100;
+                self_sp->emit_s.zero_a[value][1] = '0' + value/10%10;
+                self_sp->emit_s.zero_a[value][2] = '0' + value%10;
+                self_sp->emit_s.hex_a[value][0] = "0123456789abcdef"[value >> 4];
+                self_sp->emit_s.hex_a[value][1] = "0123456789abcdef"[value & 15];
+            }
+            self_sp->emit_s.text_ready = TRUE;
+        }
+    }
+
+    char *
+    head_lgen_f(struct Self *self_sp) {
+        /*
+         * Head of the output (and tail on emit_s.tail_g).
+         * The GPL header is always generated,
+         * header_lgen_f() also releases the header data.
+         */
+        char *head_gp = self_sp->header_lgen_mp(self_sp);
+
+        self_sp->emit_s.headl = self_sp->buffer_s.headerl - 1;
+        self_sp->emit_s.taill = 0;
+
+        if (self_sp->emit_s.format == FORMAT_GPL)
+            return head_gp;
+
+        head_gp = realloc(head_gp, sizeof(char) * (1 << 8));
+        head_gp[0] = '\0';
+
+        switch (self_sp->emit_s.format) {
+            case FORMAT_CSS:
+                strcpy(head_gp, ":root {\n");
+                strcpy(self_sp->emit_s.tail_g, "}\n");
+                break;
+            case FORMAT_JSON:
+                strcpy(head_gp, "[\n");
+                strcpy(self_sp->emit_s.tail_g, "]\n");
+                break;
+            case FORMAT_C:
+                sprintf(
+                    head_gp,
+                    "#ifndef GPLGEN_PALETTE_H\n"
+                      "#define GPLGEN_PALETTE_H\n"
+                      "\n"
+                      "static const unsigned char gplgen_palette_a[%u][3] = {\n",
+                    self_sp->emit_s.count
+                );
+                strcpy(self_sp->emit_s.tail_g, "};\n\n#endif\n");
+                break;
+            case FORMAT_ACT:
+                /*
+                 * Unused colours (black), colours count
+                 * and no transparent colour (0xffff), big endian.
+                 */
+                memset(self_sp->emit_s.tail_g, 0, sizeof(self_sp->emit_s.tail_g));
+                self_sp->emit_s.taill = (
+                    ((1 << 8) - self_sp->emit_s.count)*3 + 4
+                );
+                self_sp->emit_s.tail_g[self_sp->emit_s.taill - 4] = (
+                    self_sp->emit_s.count >> 8
+                );
+                self_sp->emit_s.tail_g[self_sp->emit_s.taill - 3] = (
+                    self_sp->emit_s.count & 0xff
+                );
+                self_sp->emit_s.tail_g[self_sp->emit_s.taill - 2] = '\xff';
+                self_sp->emit_s.tail_g[self_sp->emit_s.taill - 1] = '\xff';
+                break;
+            default:
+                self_sp->emit_s.tail_g[0] = '\0';
+        }
+
+        self_sp->emit_s.headl = strlen(head_gp);
+        if (self_sp->emit_s.format != FORMAT_ACT)
+            self_sp->emit_s.taill = strlen(self_sp->emit_s.tail_g);
+
+        return head_gp;
+    }
+
+#if defined(GPLGEN_SPECIALISE)
+    /*
+     * Specialised GPL records (without names) of the channel tables,
+     * with the red levels (reds) known at compile time:
+     * a record is 2 stores of 8 bytes, "RRR GGG " and "G BBB\t#\n",
+     * the red digits are ORed to the row (green and blue) template.
+     */
+    inline __attribute__((always_inline)) unsigned long long
+    fmt_kernel_f(
+        struct Self *self_sp,
+        char *output_gp,
+        unsigned int start,
+        unsigned int count,
+        const unsigned short reds
+    ) {
+        const char (*dec_ap)[4] = self_sp->emit_s.dec_a;
+        const unsigned char *const *table_ap = self_sp->emit_s.table_ap;
+        const unsigned short *tablel_ap = self_sp->emit_s.tablel_a;
+        unsigned long long red_a[reds];
+        unsigned long long high_a[reds];
+        unsigned long long low;
+        unsigned long long high;
+        char row_g[16] = "    000 000\t#\n";
+        char *record_gp = output_gp;
+        unsigned short red = start % reds;
+        unsigned short green = start/reds % tablel_ap[1];
+        unsigned short blue = start/reds/tablel_ap[1];
+
+        for (unsigned short level = 0; level < reds; level++) {
+            char red_g[8] = {0};
+
+            memcpy(red_g, dec_ap[table_ap[0][level]], 3);
+            memcpy(&red_a[level], red_g, 8);
+
+            /* Gray records have the same value 3 times. */
+            if (self_sp->emit_s.gray) {
+                memcpy(&row_g[4], dec_ap[table_ap[0][level]], 3);
+                memcpy(&row_g[8], dec_ap[table_ap[0][level]], 3);
+                memcpy(&high_a[level], &row_g[6], 8);
+                memcpy(&low, row_g, 8);
+                red_a[level] |= low;
+            }
+        }
+
+        if (self_sp->emit_s.gray) {
+            for (unsigned int level = start; level < start + count; level++) {
+                memcpy(record_gp, &red_a[level], 8);
+                memcpy(&record_gp[6], &high_a[level], 8);
+                record_gp += 14;
+            }
+
+            return record_gp - output_gp;
+        }
+
+        while (count) {
+            unsigned short last = (
+                count < (unsigned int)(reds - red) ? red + count : reds
+            );
+
+            memcpy(&row_g[4], dec_ap[table_ap[1][green]], 3);
+            memcpy(&row_g[8], dec_ap[table_ap[2][blue]], 3);
+            memset(row_g, 0, 3);
+            memcpy(&low, row_g, 8);
+            memcpy(&high, &row_g[6], 8);
+
+            if (! red && last == reds) {
+                /* Full rows: the unrolled loop. */
+                #pragma GCC unroll 16
+                for (unsigned short level = 0; level < reds; level++) {
+                    unsigned long long record = low | red_a[level];
+
+                    memcpy(record_gp, &record, 8);
+                    memcpy(&record_gp[6], &high, 8);
+                    record_gp += 14;
+                }
+            } else {
+                for (unsigned short level = red; level < last; level++) {
+                    unsigned long long record = low | red_a[level];
+
+                    memcpy(record_gp, &record, 8);
+                    memcpy(&record_gp[6], &high, 8);
+                    record_gp += 14;
+                }
+            }
+
+            count -= last - red;
+            red = 0;
+            if (++green == tablel_ap[1]) {
+                green = 0;
+                blue++;
+            }
+        }
+
+        return record_gp - output_gp;
+    }
+
+    FMT_KERNEL(2)
+    FMT_KERNEL(4)
+    FMT_KERNEL(8)
+    FMT_KERNEL(16)
+    FMT_KERNEL(32)
+    FMT_KERNEL(64)
+    FMT_KERNEL(128)
+    FMT_KERNEL(256)
+#endif
+
+    unsigned long long
+    fmt_f(struct Self *self_sp, char *output_gp, unsigned int start, unsigned int count) {
+        /*
+         * Fast record writer:
+         * each record has a fixed lenght (emit_s.recordl),
+         * so the record N is always on N*recordl
+         * (but the names of a loaded palette, see fmtl_f()).
+         * The loop position of the entry "start" is:
+         * start == (blue*greens + green)*reds + red
+         */
+        const char (*dec_ap)[4] = self_sp->emit_s.dec_a;
+        const char (*zero_ap)[4] = self_sp->emit_s.zero_a;
+        const char (*hex_ap)[2] = self_sp->emit_s.hex_a;
+        const unsigned char *colour_ap = self_sp->emit_s.colour_ap;
+        const unsigned short *tablel_ap = self_sp->emit_s.tablel_a;
+        unsigned short index_a[3] = {0, 0, 0};
+        unsigned char rgb_a[3];
+        char *record_gp = output_gp;
+
+#if defined(GPLGEN_SPECIALISE)
+        /* Dispatch table by the red levels (see fmt_kernel_f()). */
+        unsigned long long (*kernel_apa[9])(
+            struct Self *,
+            char *,
+            unsigned int,
+            unsigned int
+        ) = {
+            NULL,
+            &fmt_kernel_2_f,
+            &fmt_kernel_4_f,
+            &fmt_kernel_8_f,
+            &fmt_kernel_16_f,
+            &fmt_kernel_32_f,
+            &fmt_kernel_64_f,
+            &fmt_kernel_128_f,
+            &fmt_kernel_256_f
+        };
+
+        if (! self_sp->emit_s.generic
+              && ! colour_ap
+              && self_sp->emit_s.format == FORMAT_GPL
+              && ! self_sp->emit_s.name_ap
+              && self_sp->emit_s.names == NAMES_NONE
+              && self_sp->emit_s.recordl == 14
+              && tablel_ap[0] > 1
+              && tablel_ap[0] <= 1 << 8
+              && ! (tablel_ap[0] & (tablel_ap[0] - 1)))
+            return kernel_apa[__builtin_ctz(tablel_ap[0])](
+                self_sp,
+                output_gp,
+                start,
+                count
+            );
+#endif
+
+        if (! colour_ap) {
+            index_a[0] = start % tablel_ap[0];
+            index_a[1] = start/tablel_ap[0] % tablel_ap[1];
+            index_a[2] = start/tablel_ap[0]/tablel_ap[1];
+        }
+
+        for (unsigned int entry = start; entry < start + count; entry++) {
+            if (colour_ap) {
+                memcpy(rgb_a, &colour_ap[(unsigned long long)entry*3], 3);
+            } else {
+                rgb_a[0] = self_sp->emit_s.table_ap[0][index_a[0]];
+
+                if (self_sp->emit_s.gray) {
+                    rgb_a[1] = rgb_a[0];
+                    rgb_a[2] = rgb_a[0];
+                } else {
+                    rgb_a[1] = self_sp->emit_s.table_ap[1][index_a[1]];
+                    rgb_a[2] = self_sp->emit_s.table_ap[2][index_a[2]];
+                }
+
+                /* Next red, next green or next blue. */
+                if (++index_a[0] == tablel_ap[0]) {
+                    index_a[0] = 0;
+
+                    if (++index_a[1] == tablel_ap[1]) {
+                        index_a[1] = 0;
+                        index_a[2]++;
+                    }
+                }
+            }
+
+            switch (self_sp->emit_s.format) {
+                case FORMAT_HEX:
+                    record_gp[0] = '#';
+                    memcpy(&record_gp[1], hex_ap[rgb_a[0]], 2);
+                    memcpy(&record_gp[3], hex_ap[rgb_a[1]], 2);
+                    memcpy(&record_gp[5], hex_ap[rgb_a[2]], 2);
+                    record_gp[7] = '\n';
+                    break;
+                case FORMAT_CSS:
+                    memcpy(record_gp, "  --palette-", 12);
+                    for (unsigned int digit = self_sp->emit_s.digits, value = entry;
+                          digit > 0;
+                          digit--, value /= 10)
+                        record_gp[11 + digit] = '0' + value%10;
+                    record_gp += self_sp->emit_s.digits;
+                    memcpy(&record_gp[12], ": #", 3);
+                    memcpy(&record_gp[15], hex_ap[rgb_a[0]], 2);
+                    memcpy(&record_gp[17], hex_ap[rgb_a[1]], 2);
+                    memcpy(&record_gp[19], hex_ap[rgb_a[2]], 2);
+                    memcpy(&record_gp[21], ";\n", 2);
+                    record_gp -= self_sp->emit_s.digits;
+                    break;
+                case FORMAT_JSON:
+                    memcpy(record_gp, "  \"#", 4);
+                    memcpy(&record_gp[4], hex_ap[rgb_a[0]], 2);
+                    memcpy(&record_gp[6], hex_ap[rgb_a[1]], 2);
+                    memcpy(&record_gp[8], hex_ap[rgb_a[2]], 2);
+                    record_gp[10] = '"';
+                    record_gp[11] = (
+                        entry + 1 == self_sp->emit_s.count ? ' ' : ','
+                    );
+                    record_gp[12] = '\n';
+                    break;
+                case FORMAT_C:
+                    memcpy(record_gp, "  {", 3);
+                    memcpy(&record_gp[3], dec_ap[rgb_a[0]], 3);
+                    memcpy(&record_gp[6], ", ", 2);
+                    memcpy(&record_gp[8], dec_ap[rgb_a[1]], 3);
+                    memcpy(&record_gp[11], ", ", 2);
+                    memcpy(&record_gp[13], dec_ap[rgb_a[2]], 3);
+                    memcpy(&record_gp[16], "},\n", 3);
+                    break;
+                case FORMAT_ACT:
+                    memcpy(record_gp, rgb_a, 3);
+                    break;
+                default:
+                    memcpy(record_gp, dec_ap[rgb_a[0]], 3);
+                    record_gp[3] = ' ';
+                    memcpy(&record_gp[4], dec_ap[rgb_a[1]], 3);
+                    record_gp[7] = ' ';
+                    memcpy(&record_gp[8], dec_ap[rgb_a[2]], 3);
+
+                    if (self_sp->emit_s.name_ap) {
+                        unsigned int namel = (
+                            self_sp->emit_s.name_ap[entry + 1]
+                              - self_sp->emit_s.name_ap[entry]
+                        );
+
+                        record_gp[11] = '\t';
+                        if (namel)
+                            memcpy(
+                                &record_gp[12],
+                                &self_sp->emit_s.name_gp[
+                                    self_sp->emit_s.name_ap[entry]
+                                ],
+                                namel
+                            );
+                        else
+                            record_gp[12] = '#';
+                        namel += ! namel;
+                        record_gp[12 + namel] = '\n';
+                        record_gp += 13 + namel;
+                        continue;
+                    } else if (self_sp->emit_s.names == NAMES_HEX) {
+                        memcpy(&record_gp[11], "\t#", 2);
+                        memcpy(&record_gp[13], hex_ap[rgb_a[0]], 2);
+                        memcpy(&record_gp[15], hex_ap[rgb_a[1]], 2);
+                        memcpy(&record_gp[17], hex_ap[rgb_a[2]], 2);
+                        record_gp[19] = '\n';
+                    } else if (self_sp->emit_s.names == NAMES_RGB) {
+                        record_gp[11] = '\t';
+                        memcpy(&record_gp[12], zero_ap[rgb_a[0]], 3);
+                        record_gp[15] = '-';
+                        memcpy(&record_gp[16], zero_ap[rgb_a[1]], 3);
+                        record_gp[19] = '-';
+                        memcpy(&record_gp[20], zero_ap[rgb_a[2]], 3);
+                        record_gp[23] = '\n';
+                    } else if (self_sp->emit_s.names == NAMES_CVD) {
+                        record_gp[11] = '\t';
+                        for (unsigned char cvd = 0; cvd < 3; cvd++) {
+                            const unsigned char *cvd_ap = (
+                                &self_sp->emit_s.cvd_apa[cvd][
+                                    (unsigned long long)entry*3
+                                ]
+                            );
+
+                            memcpy(&record_gp[12 + cvd*15], cvd_gpa[cvd], 6);
+                            memcpy(&record_gp[18 + cvd*15], " #", 2);
+                            memcpy(&record_gp[20 + cvd*15], hex_ap[cvd_ap[0]], 2);
+                            memcpy(&record_gp[22 + cvd*15], hex_ap[cvd_ap[1]], 2);
+                            memcpy(&record_gp[24 + cvd*15], hex_ap[cvd_ap[2]], 2);
+                            record_gp[26 + cvd*15] = ' ';
+                        }
+                        record_gp[56] = '\n';
+                    } else {
+                        memcpy(&record_gp[11], "\t#\n", 3);
+                    }
+            }
+            record_gp += self_sp->emit_s.recordl;
+        }
+
+        return record_gp - output_gp;
+    }
+
+    unsigned long long
+    fmtl_f(struct Self *self_sp, unsigned int start, unsigned int end) {
+        /* Lenght of the records from start to end (see fmt_f()). */
+        unsigned long long lenght = 0;
+
+        if (! self_sp->emit_s.name_ap)
+            return (unsigned long long)(end - start)*self_sp->emit_s.recordl;
+
+        for (unsigned int entry = start; entry < end; entry++)
+            lenght += (
+                13 + self_sp->emit_s.name_ap[entry + 1]
+                  - self_sp->emit_s.name_ap[entry]
+                  + (self_sp->emit_s.name_ap[entry + 1]
+                    == self_sp->emit_s.name_ap[entry])
+            );
+
+        return lenght;
+    }
+
+    /*
+     * 64 bits hash (XXH64) of a block,
+     * see the checkpoints of emit_f() and verify_f().
+     */
+    unsigned long long
+    hash_f(const unsigned char *data_ap, unsigned long long datal, unsigned long long seed) {
+        const unsigned long long prime_a[5] = {
+            0x9e3779b185ebca87ull,
+            0xc2b2ae3d27d4eb4full,
+            0x165667b19e3779f9ull,
+            0x85ebca77c2b2ae63ull,
+            0x27d4eb2f165667c5ull
+        };
+        const unsigned char *end_ap = data_ap + datal;
+        unsigned long long hash;
+        unsigned long long lane;
+
+        unsigned long long
+        rotl_f(unsigned long long value, unsigned char bits) {
+            return value << bits | value >> (64 - bits);
+        }
+
+        unsigned long long
+        round_f(unsigned long long acc, unsigned long long input) {
+            return rotl_f(acc + input*prime_a[1], 31)*prime_a[0];
+        }
+
+        if (datal >= 32) {
+            unsigned long long acc_a[4] = {
+                seed + prime_a[0] + prime_a[1],
+                seed + prime_a[1],
+                seed,
+                seed - prime_a[0]
+            };
+
+            for (; data_ap + 32 <= end_ap; data_ap += 32)
+                for (unsigned char index = 0; index < 4; index++) {
+                    memcpy(&lane, &data_ap[index*8], 8);
+                    acc_a[index] = round_f(acc_a[index], lane);
+                }
+
+            hash = (
+                rotl_f(acc_a[0], 1) + rotl_f(acc_a[1], 7)
+                  + rotl_f(acc_a[2], 12) + rotl_f(acc_a[3], 18)
+            );
+            for (unsigned char index = 0; index < 4; index++)
+                hash = (hash ^ round_f(0, acc_a[index]))*prime_a[0] + prime_a[3];
+        } else {
+            hash = seed + prime_a[4];
+        }
+        hash += datal;
+
+        for (; data_ap + 8 <= end_ap; data_ap += 8) {
+            memcpy(&lane, data_ap, 8);
+            hash = rotl_f(hash ^ round_f(0, lane), 27)*prime_a[0] + prime_a[3];
+        }
+        if (data_ap + 4 <= end_ap) {
+            unsigned int word;
+
+            memcpy(&word, data_ap, 4);
+            hash = rotl_f(hash ^ word*prime_a[0], 23)*prime_a[1] + prime_a[2];
+            data_ap += 4;
+        }
+        for (; data_ap < end_ap; data_ap++)
+            hash = rotl_f(hash ^ *data_ap*prime_a[4], 11)*prime_a[0];
+
+        hash ^= hash >> 33;
+        hash *= prime_a[1];
+        hash ^= hash >> 29;
+        hash *= prime_a[2];
+        hash ^= hash >> 32;
+
+        return hash;
+    }
+
+    /*
+     * Asynchronous writer of the batch subcommand:
+     * slots (buffers of 1 MiB) filled by the chunk threads
+     * and written at their file offset by io_uring (raw syscalls,
+     * the slots are registered buffers) or, without io_uring,
+     * by a pool of threads (pwrite()), while the next chunks
+     * and palettes are generated.
+     * A file is closed after its last write.
+     */
+    struct WriterFile {
+        int fd;
+        unsigned long long offset;
+        unsigned int pending;
+        unsigned char closing: 1;
+        char *path_gp;
+    };
+
+    struct Writer {
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        unsigned char uring: 1;
+        unsigned char fixed: 1;
+        unsigned char stop: 1;
+        unsigned short slots;
+        unsigned int slotl;
+        char *buffer_gp;
+        /* Free slots (a stack) and the slot writes. */
+        unsigned short *free_ap;
+        unsigned short freel;
+        struct {
+            struct WriterFile *file_sp;
+            unsigned long long offset;
+            unsigned int lenght;
+            unsigned int done;
+        } *slot_ap;
+        /* Queue of the thread pool (a ring of slots). */
+        unsigned short *queue_ap;
+        unsigned int queue_first;
+        unsigned int queue_next;
+        unsigned short threads;
+        pthread_t *thread_ap;
+        /* Submission and completion rings of io_uring. */
+        int ring;
+        unsigned char *ring_ap;
+        size_t ringl;
+        struct io_uring_sqe *sqe_ap;
+        size_t sqel;
+        unsigned int *sq_tail_p;
+        unsigned int sq_mask;
+        unsigned int *cq_head_p;
+        unsigned int *cq_tail_p;
+        unsigned int cq_mask;
+        struct io_uring_cqe *cqe_ap;
+        unsigned int inflight;
+        /* First error and its file, bytes written. */
+        int code;
+        char *error_gp;
+        unsigned long long bytes;
+    };
+
+    void
+    writer_file_close_f(struct Writer *writer_sp, struct WriterFile *file_sp) {
+        /* Close and free a file (with the writer mutex). */
+        if (close(file_sp->fd) != 0 && ! writer_sp->code) {
+            writer_sp->code = errno;
+            writer_sp->error_gp = strdup(file_sp->path_gp);
+        }
+        free(file_sp->path_gp);
+        free(file_sp);
+    }
+
+    void
+    writer_finish_f(struct Writer *writer_sp, unsigned short slot, long long result) {
+        /*
+         * The write of a slot is finished (with the writer mutex):
+         * free the slot and close its file after its last write.
+         */
+        struct WriterFile *file_sp = writer_sp->slot_ap[slot].file_sp;
+
+        if (result < 0 && ! writer_sp->code) {
+            writer_sp->code = -result;
+            writer_sp->error_gp = strdup(file_sp->path_gp);
+        }
+
+        if (! --file_sp->pending && file_sp->closing)
+            writer_file_close_f(writer_sp, file_sp);
+        writer_sp->free_ap[writer_sp->freel++] = slot;
+        pthread_cond_broadcast(&writer_sp->cond);
+    }
+
+    void
+    writer_submit_f(struct Writer *writer_sp, unsigned short slot) {
+        /*
+         * Submit (the rest of) a slot write (with the writer mutex).
+         * One io_uring_enter() by slot (1 MiB): a slot is submitted
+         * as soon as its chunk is in turn, not held for a batch.
+         */
+        unsigned int done = writer_sp->slot_ap[slot].done;
+
+        if (writer_sp->uring) {
+            unsigned int tail = *writer_sp->sq_tail_p;
+            struct io_uring_sqe *sqe_sp = (
+                &writer_sp->sqe_ap[tail & writer_sp->sq_mask]
+            );
+            long result;
+
+            memset(sqe_sp, 0, sizeof(*sqe_sp));
+            sqe_sp->opcode = writer_sp->fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+            sqe_sp->fd = writer_sp->slot_ap[slot].file_sp->fd;
+            sqe_sp->addr = (unsigned long)(
+                &writer_sp->buffer_gp[(size_t)slot*writer_sp->slotl + done]
+            );
+            sqe_sp->len = writer_sp->slot_ap[slot].lenght - done;
+            sqe_sp->off = writer_sp->slot_ap[slot].offset + done;
+            sqe_sp->buf_index = slot;
+            sqe_sp->user_data = slot;
+            __atomic_store_n(writer_sp->sq_tail_p, tail + 1, __ATOMIC_RELEASE);
+
+            do
+                result = syscall(__NR_io_uring_enter, writer_sp->ring, 1, 0, 0, NULL, 0);
+            while (result < 0 && errno == EINTR);
+
+            /* Not submitted: take it back from the ring. */
+            if (result < 0) {
+                __atomic_store_n(writer_sp->sq_tail_p, tail, __ATOMIC_RELEASE);
+                writer_finish_f(writer_sp, slot, -errno);
+                return;
+            }
+            writer_sp->inflight++;
+        } else if (! writer_sp->threads) {
+            /* Without the pool, written by the calling thread. */
+            long long result = 0;
+
+            while (writer_sp->slot_ap[slot].done < writer_sp->slot_ap[slot].lenght) {
+                done = writer_sp->slot_ap[slot].done;
+                result = pwrite(
+                    writer_sp->slot_ap[slot].file_sp->fd,
+                    &writer_sp->buffer_gp[(size_t)slot*writer_sp->slotl + done],
+                    writer_sp->slot_ap[slot].lenght - done,
+                    writer_sp->slot_ap[slot].offset + done
+                );
+                if (result <= 0) {
+                    result = result < 0 ? -errno : -EIO;
+                    break;
+                }
+                writer_sp->slot_ap[slot].done += result;
+                writer_sp->bytes += result;
+            }
+
+            writer_finish_f(writer_sp, slot, result);
+            return;
+        } else {
+            writer_sp->queue_ap[writer_sp->queue_next++ % writer_sp->slots] = slot;
+        }
+
+        /* Wake the pool, or the writers waiting for a slot to reap it. */
+        pthread_cond_broadcast(&writer_sp->cond);
+    }
+
+    void
+    writer_done_f(struct Writer *writer_sp, unsigned short slot, long long result) {
+        /* A write of a slot is done: write the rest of a short write. */
+        if (writer_sp->uring)
+            writer_sp->inflight--;
+
+        if (result > 0) {
+            writer_sp->slot_ap[slot].done += result;
+            writer_sp->bytes += result;
+
+            if (writer_sp->slot_ap[slot].done < writer_sp->slot_ap[slot].lenght) {
+                writer_submit_f(writer_sp, slot);
+                return;
+            }
+        } else if (! result) {
+            result = -EIO;
+        }
+
+        writer_finish_f(writer_sp, slot, result);
+    }
+
+    void
+    writer_reap_f(struct Writer *writer_sp, unsigned char wait) {
+        /* Completions of io_uring (with the writer mutex). */
+        unsigned int head = *writer_sp->cq_head_p;
+
+        if (wait
+              && head == __atomic_load_n(writer_sp->cq_tail_p, __ATOMIC_ACQUIRE))
+            syscall(
+                __NR_io_uring_enter,
+                writer_sp->ring,
+                0,
+                1,
+                IORING_ENTER_GETEVENTS,
+                NULL,
+                0
+            );
+
+        while (head != __atomic_load_n(writer_sp->cq_tail_p, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe *cqe_sp = &writer_sp->cqe_ap[head & writer_sp->cq_mask];
+            unsigned short slot = cqe_sp->user_data;
+            int result = cqe_sp->res;
+
+            __atomic_store_n(writer_sp->cq_head_p, ++head, __ATOMIC_RELEASE);
+            writer_done_f(writer_sp, slot, result);
+        }
+    }
+
+    void *
+    writer_work_f(void *writer_vp) {
+        /* A thread of the pool: the queued slots by pwrite(). */
+        struct Writer *writer_sp = writer_vp;
+
+        pthread_mutex_lock(&writer_sp->mutex);
+        while (TRUE) {
+            unsigned short slot;
+            long long result;
+
+            while (writer_sp->queue_first == writer_sp->queue_next
+                  && ! writer_sp->stop)
+                pthread_cond_wait(&writer_sp->cond, &writer_sp->mutex);
+            if (writer_sp->queue_first == writer_sp->queue_next)
+                break;
+
+            slot = writer_sp->queue_ap[writer_sp->queue_first++ % writer_sp->slots];
+            pthread_mutex_unlock(&writer_sp->mutex);
+
+            result = pwrite(
+                writer_sp->slot_ap[slot].file_sp->fd,
+                &writer_sp->buffer_gp[
+                    (size_t)slot*writer_sp->slotl + writer_sp->slot_ap[slot].done
+                ],
+                writer_sp->slot_ap[slot].lenght - writer_sp->slot_ap[slot].done,
+                writer_sp->slot_ap[slot].offset + writer_sp->slot_ap[slot].done
+            );
+
+            pthread_mutex_lock(&writer_sp->mutex);
+            writer_done_f(writer_sp, slot, result < 0 ? -errno : result);
+        }
+        pthread_mutex_unlock(&writer_sp->mutex);
+
+        return NULL;
+    }
+
+    unsigned char
+    writer_uring_f(struct Writer *writer_sp) {
+        /*
+         * io_uring of the slots (one mapping of both rings,
+         * Linux 5.4), the slots are registered buffers if possible.
+         * FALSE without io_uring (as ENOSYS or a seccomp filter).
+         */
+        struct io_uring_params params_s;
+        struct iovec *iovec_ap;
+        size_t sql;
+        size_t cql;
+
+        memset(&params_s, 0, sizeof(params_s));
+        writer_sp->ring = syscall(__NR_io_uring_setup, writer_sp->slots, &params_s);
+        if (writer_sp->ring < 0)
+            return FALSE;
+        if (! (params_s.features & IORING_FEAT_SINGLE_MMAP)) {
+            close(writer_sp->ring);
+            return FALSE;
+        }
+
+        sql = params_s.sq_off.array + params_s.sq_entries*sizeof(unsigned int);
+        cql = params_s.cq_off.cqes + params_s.cq_entries*sizeof(struct io_uring_cqe);
+        writer_sp->ringl = sql > cql ? sql : cql;
+        writer_sp->ring_ap = mmap(
+            NULL,
+            writer_sp->ringl,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            writer_sp->ring,
+            IORING_OFF_SQ_RING
+        );
+        writer_sp->sqel = params_s.sq_entries*sizeof(struct io_uring_sqe);
+        writer_sp->sqe_ap = mmap(
+            NULL,
+            writer_sp->sqel,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            writer_sp->ring,
+            IORING_OFF_SQES
+        );
+        if (writer_sp->ring_ap == MAP_FAILED || writer_sp->sqe_ap == MAP_FAILED) {
+            if (writer_sp->ring_ap != MAP_FAILED)
+                munmap(writer_sp->ring_ap, writer_sp->ringl);
+            if (writer_sp->sqe_ap != MAP_FAILED)
+                munmap(writer_sp->sqe_ap, writer_sp->sqel);
+            close(writer_sp->ring);
+            return FALSE;
+        }
+
+        writer_sp->sq_tail_p = (unsigned int *)(writer_sp->ring_ap + params_s.sq_off.tail);
+        writer_sp->sq_mask = *(unsigned int *)(writer_sp->ring_ap + params_s.sq_off.ring_mask);
+        writer_sp->cq_head_p = (unsigned int *)(writer_sp->ring_ap + params_s.cq_off.head);
+        writer_sp->cq_tail_p = (unsigned int *)(writer_sp->ring_ap + params_s.cq_off.tail);
+        writer_sp->cq_mask = *(unsigned int *)(writer_sp->ring_ap + params_s.cq_off.ring_mask);
+        writer_sp->cqe_ap = (
+            (struct io_uring_cqe *)(writer_sp->ring_ap + params_s.cq_off.cqes)
+        );
+
+        /* Each submission entry N is on the index N. */
+        for (unsigned int entry = 0; entry < params_s.sq_entries; entry++)
+            ((unsigned int *)(writer_sp->ring_ap + params_s.sq_off.array))[entry] = entry;
+
+        /* Without registered buffers (RLIMIT_MEMLOCK), plain writes. */
+        iovec_ap = malloc(sizeof(struct iovec) * writer_sp->slots);
+        for (unsigned short slot = 0; slot < writer_sp->slots; slot++) {
+            iovec_ap[slot].iov_base = &writer_sp->buffer_gp[(size_t)slot*writer_sp->slotl];
+            iovec_ap[slot].iov_len = writer_sp->slotl;
+        }
+        writer_sp->fixed = (
+            syscall(
+                __NR_io_uring_register,
+                writer_sp->ring,
+                IORING_REGISTER_BUFFERS,
+                iovec_ap,
+                writer_sp->slots
+            ) == 0
+        );
+        free(iovec_ap);
+
+        return TRUE;
+    }
+
+    struct Writer *
+    writer_open_f(struct Self *self_sp, unsigned char uring) {
+        /* A writer of io_uring (uring), else of a thread pool. */
+        struct Writer *writer_sp = calloc(1, sizeof(struct Writer));
+
+        pthread_mutex_init(&writer_sp->mutex, NULL);
+        pthread_cond_init(&writer_sp->cond, NULL);
+
+        /* A slot for each chunk thread at least (see emit_work_f()). */
+        writer_sp->slots = 2*self_sp->data_s.task_s.threads;
+        if (writer_sp->slots < 16)
+            writer_sp->slots = 16;
+        writer_sp->slotl = 1 << 20;
+        writer_sp->buffer_gp = huge_alloc_f(
+            (size_t)writer_sp->slots*writer_sp->slotl,
+            self_sp->data_s.task_s.pages
+        );
+        writer_sp->free_ap = malloc(sizeof(short) * writer_sp->slots);
+        writer_sp->slot_ap = calloc(writer_sp->slots, sizeof(*writer_sp->slot_ap));
+        for (unsigned short slot = 0; slot < writer_sp->slots; slot++)
+            writer_sp->free_ap[writer_sp->freel++] = writer_sp->slots - 1 - slot;
+
+        writer_sp->uring = uring && writer_uring_f(writer_sp);
+        if (! writer_sp->uring) {
+            /* The threads created (none: see writer_submit_f()). */
+            writer_sp->queue_ap = malloc(sizeof(short) * writer_sp->slots);
+            writer_sp->thread_ap = calloc(4, sizeof(pthread_t));
+            while (writer_sp->threads < 4
+                  && pthread_create(
+                      &writer_sp->thread_ap[writer_sp->threads],
+                      NULL,
+                      &writer_work_f,
+                      writer_sp
+                    ) == 0)
+                writer_sp->threads++;
+        }
+
+        return writer_sp;
+    }
+
+    char *
+    writer_slot_f(struct Writer *writer_sp) {
+        /* A free slot, after a done write if all are used. */
+        unsigned short slot;
+
+        pthread_mutex_lock(&writer_sp->mutex);
+        while (! writer_sp->freel)
+            if (writer_sp->inflight)
+                writer_reap_f(writer_sp, TRUE);
+            else
+                pthread_cond_wait(&writer_sp->cond, &writer_sp->mutex);
+        slot = writer_sp->free_ap[--writer_sp->freel];
+        pthread_mutex_unlock(&writer_sp->mutex);
+
+        return &writer_sp->buffer_gp[(size_t)slot*writer_sp->slotl];
+    }
+
+    void
+    writer_write_f(
+        struct Writer *writer_sp,
+        struct WriterFile *file_sp,
+        char *slot_gp,
+        unsigned int lenght
+    ) {
+        /* Write lenght bytes of a slot at the end of the file (in order). */
+        unsigned short slot = (slot_gp - writer_sp->buffer_gp)/writer_sp->slotl;
+
+        pthread_mutex_lock(&writer_sp->mutex);
+        writer_sp->slot_ap[slot].file_sp = file_sp;
+        writer_sp->slot_ap[slot].offset = file_sp->offset;
+        writer_sp->slot_ap[slot].lenght = lenght;
+        writer_sp->slot_ap[slot].done = 0;
+        file_sp->offset += lenght;
+        file_sp->pending++;
+
+        if (lenght)
+            writer_submit_f(writer_sp, slot);
+        else
+            writer_finish_f(writer_sp, slot, 0);
+        if (writer_sp->uring)
+            writer_reap_f(writer_sp, FALSE);
+        pthread_mutex_unlock(&writer_sp->mutex);
+    }
+
+    struct WriterFile *
+    writer_file_f(const char *path_gp) {
+        /* A new output file (NULL and errno on errors). */
+        struct WriterFile *file_sp;
+        int fd = open(path_gp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+        if (fd < 0)
+            return NULL;
+
+        file_sp = calloc(1, sizeof(struct WriterFile));
+        file_sp->fd = fd;
+        file_sp->path_gp = strdup(path_gp);
+
+        return file_sp;
+    }
+
+    void
+    writer_close_f(struct Writer *writer_sp, struct WriterFile *file_sp) {
+        /* Close the file after its last write. */
+        pthread_mutex_lock(&writer_sp->mutex);
+        file_sp->closing = TRUE;
+        if (! file_sp->pending)
+            writer_file_close_f(writer_sp, file_sp);
+        pthread_mutex_unlock(&writer_sp->mutex);
+    }
+
+    int
+    writer_free_f(struct Writer *writer_sp, char **error_gpp, unsigned long long *bytes_p) {
+        /*
+         * Wait for all writes and free the writer.
+         * Return the first error code (and its file on *error_gpp)
+         * and the bytes written on *bytes_p.
+         */
+        int code;
+
+        pthread_mutex_lock(&writer_sp->mutex);
+        while (writer_sp->freel < writer_sp->slots)
+            if (writer_sp->inflight)
+                writer_reap_f(writer_sp, TRUE);
+            else
+                pthread_cond_wait(&writer_sp->cond, &writer_sp->mutex);
+        writer_sp->stop = TRUE;
+        pthread_cond_broadcast(&writer_sp->cond);
+        pthread_mutex_unlock(&writer_sp->mutex);
+
+        for (unsigned short thread = 0; thread < writer_sp->threads; thread++)
+            pthread_join(writer_sp->thread_ap[thread], NULL);
+
+        if (writer_sp->uring) {
+            munmap(writer_sp->sqe_ap, writer_sp->sqel);
+            munmap(writer_sp->ring_ap, writer_sp->ringl);
+            close(writer_sp->ring);
+        }
+
+        code = writer_sp->code;
+        *error_gpp = writer_sp->error_gp;
+        *bytes_p = writer_sp->bytes;
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        pthread_mutex_destroy(&writer_sp->mutex);
+        pthread_cond_destroy(&writer_sp->cond);
+        huge_free_f(writer_sp->buffer_gp);
+        free(writer_sp->free_ap);
+        free(writer_sp->slot_ap);
+        free(writer_sp->queue_ap);
+        free(writer_sp->thread_ap);
+        free(writer_sp);
+
+        return code;
+    }
+
+    /*
+     * Records of a thread:
+     * a single range written on its place (to memory),
+     * or chunks taken in turns and written in order (to a stream).
+     */
+    struct Stream {
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        unsigned long long first;
+        unsigned long long next;
+        unsigned long long chunks;
+        unsigned int chunkl;
+        unsigned short threads;
+        FILE *output_lp;
+        /* Writer of the batch subcommand (NULL on output_lp). */
+        struct Writer *writer_sp;
+        struct WriterFile *file_sp;
+        /* Checkpoint (NULL without resume) and its last time. */
+        const char *ckpt_gp;
+        struct Checkpoint *ckpt_sp;
+        time_t time;
+    };
+
+    struct Chunk {
+        struct Self *self_sp;
+        struct Stream *stream_sp;
+        unsigned short thread;
+        char *buffer_gp;
+        unsigned int start;
+        unsigned int end;
+        /* Without a thread, the range is done by the calling thread. */
+        unsigned char threaded: 1;
+    };
+
+    void
+    ckpt_write_f(struct Stream *stream_sp) {
+        /*
+         * Save the checkpoint once the written chunks are on disk
+         * (a new file renamed on the old one).
+         * A checkpoint not saved only makes the resume restart earlier.
+         */
+        struct {
+            char *path_gp;
+            int file;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        if (fflush(stream_sp->output_lp) != 0
+              || fdatasync(fileno(stream_sp->output_lp)) != 0)
+            return;
+
+        tmp_s.path_gp = malloc(sizeof(char) * (strlen(stream_sp->ckpt_gp) + 5));
+        sprintf(tmp_s.path_gp, "%s.tmp", stream_sp->ckpt_gp);
+        tmp_s.file = open(tmp_s.path_gp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (tmp_s.file >= 0) {
+            if (write(tmp_s.file, stream_sp->ckpt_sp, sizeof(struct Checkpoint))
+                  == sizeof(struct Checkpoint)
+                  && fdatasync(tmp_s.file) == 0
+                  && close(tmp_s.file) == 0)
+                rename(tmp_s.path_gp, stream_sp->ckpt_gp);
+            else
+                unlink(tmp_s.path_gp);
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        free(tmp_s.path_gp);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    void *
+    emit_work_f(void *chunk_vp) {
+        struct Chunk *chunk_sp = chunk_vp;
+        struct Stream *stream_sp = chunk_sp->stream_sp;
+
+        if (! stream_sp) {
+            fmt_f(
+                chunk_sp->self_sp,
+                chunk_sp->buffer_gp,
+                chunk_sp->start,
+                chunk_sp->end - chunk_sp->start
+            );
+            return NULL;
+        }
+
+        /* The threads are known once all are created (see emit_stream_f()). */
+        pthread_mutex_lock(&stream_sp->mutex);
+        unsigned short threads = stream_sp->threads;
+        pthread_mutex_unlock(&stream_sp->mutex);
+
+        for (unsigned long long chunk = stream_sp->first + chunk_sp->thread;
+              chunk < stream_sp->chunks;
+              chunk += threads) {
+            unsigned int start = chunk_sp->start + chunk*stream_sp->chunkl;
+            unsigned int count = stream_sp->chunkl;
+            char *buffer_gp = chunk_sp->buffer_gp;
+            unsigned long long lenght;
+
+            if (count > chunk_sp->end - start)
+                count = chunk_sp->end - start;
+
+            /* On the writer, each chunk on a slot (see writer_open_f()). */
+            if (stream_sp->writer_sp)
+                buffer_gp = writer_slot_f(stream_sp->writer_sp);
+
+            lenght = fmt_f(
+                chunk_sp->self_sp,
+                buffer_gp,
+                start,
+                count
+            );
+
+            /* Wait for the turn of this chunk. */
+            pthread_mutex_lock(&stream_sp->mutex);
+            while (stream_sp->next != chunk)
+                pthread_cond_wait(&stream_sp->cond, &stream_sp->mutex);
+            pthread_mutex_unlock(&stream_sp->mutex);
+
+            if (stream_sp->writer_sp)
+                writer_write_f(stream_sp->writer_sp, stream_sp->file_sp, buffer_gp, lenght);
+            else if (fwrite(buffer_gp, sizeof(char), lenght, stream_sp->output_lp)
+                  != lenght)
+                /* The checkpoint stays on the last chunk written. */
+                stream_sp->ckpt_sp = NULL;
+
+            /* Chain the chunk and save a checkpoint each second. */
+            if (stream_sp->ckpt_sp) {
+                stream_sp->ckpt_sp->chunks = chunk + 1;
+                stream_sp->ckpt_sp->offset += lenght;
+                stream_sp->ckpt_sp->hash = hash_f(
+                    (const unsigned char *)buffer_gp,
+                    lenght,
+                    stream_sp->ckpt_sp->hash
+                );
+
+                if (time(NULL) != stream_sp->time) {
+                    stream_sp->time = time(NULL);
+                    ckpt_write_f(stream_sp);
+                }
+            }
+
+            pthread_mutex_lock(&stream_sp->mutex);
+            stream_sp->next++;
+            pthread_cond_broadcast(&stream_sp->cond);
+            pthread_mutex_unlock(&stream_sp->mutex);
+        }
+
+        return NULL;
+    }
+
+    void
+    emit_free_f(struct Self *self_sp, char *head_gp) {
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        memset(
+            self_sp->data_s.colour_s.depth_a,
+            0,
+            self_sp->data_s.colour_s.depthl
+        );
+        memset(
+            self_sp->data_s.colour_s.type_gp,
+            '\0',
+            self_sp->data_s.colour_s.typel
+        );
+        memset(head_gp, '\0', self_sp->emit_s.headl);
+        self_sp->data_s.colour_s.depthl = 0;
+        self_sp->data_s.colour_s.typel = 0;
+        self_sp->buffer_s.headerl = 0;
+        free(self_sp->data_s.colour_s.type_gp);
+        free(self_sp->emit_s.colour_ap);
+        free(self_sp->emit_s.name_gp);
+        free(self_sp->emit_s.name_ap);
+        for (unsigned char cvd = 0; cvd < 3; cvd++) {
+            free(self_sp->emit_s.cvd_apa[cvd]);
+            self_sp->emit_s.cvd_apa[cvd] = NULL;
+        }
+        free(head_gp);
+        self_sp->data_s.colour_s.type_gp = NULL;
+        self_sp->emit_s.colour_ap = NULL;
+        self_sp->emit_s.name_gp = NULL;
+        self_sp->emit_s.name_ap = NULL;
+    }
+
+    char *
+    cpal_lgen_f(struct Self *self_sp) {
+        struct {
+            char *head_gp;
+            unsigned long long bodyl;
+            unsigned short threads;
+            pthread_t *thread_ap;
+            struct Chunk *chunk_ap;
+            char *body_gp;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        self_sp->src_lgen_mp(self_sp);
+        tmp_s.head_gp = self_sp->head_lgen_mp(self_sp);
+        tmp_s.bodyl = fmtl_f(
+            self_sp,
+            self_sp->emit_s.start,
+            self_sp->emit_s.end
+        );
+
+        /*
+         * Save the cpal lenght: head (on the first slice), body,
+         * tail (on the last slice) and, on GPL, the string terminator.
+         */
+        self_sp->buffer_s.cpall = (
+            (self_sp->emit_s.start ? 0 : self_sp->emit_s.headl)
+              + tmp_s.bodyl
+              + (
+                  self_sp->emit_s.end < self_sp->emit_s.count
+                    ? 0
+                    : self_sp->emit_s.taill
+              )
+              + (
+                  self_sp->emit_s.format == FORMAT_GPL
+                    && self_sp->emit_s.end == self_sp->emit_s.count
+                )
+        );
+
+        /* Declare and add dynamic memory to the cpal string. */
+        char *cpal_gp = huge_alloc_f(
+            sizeof(char) * (self_sp->buffer_s.cpall + 1),
+            self_sp->data_s.task_s.pages
+        );
+        cpal_gp[self_sp->buffer_s.cpall] = '\0';
+
+        tmp_s.body_gp = cpal_gp;
+        if (! self_sp->emit_s.start) {
+            memcpy(tmp_s.body_gp, tmp_s.head_gp, self_sp->emit_s.headl);
+            tmp_s.body_gp += self_sp->emit_s.headl;
+        }
+
+        /* Each thread writes its range of records on its place. */
+        tmp_s.threads = self_sp->data_s.task_s.threads;
+        if (tmp_s.threads > tmp_s.bodyl/(1 << 20) + 1)
+            tmp_s.threads = tmp_s.bodyl/(1 << 20) + 1;
+        tmp_s.thread_ap = calloc(tmp_s.threads, sizeof(pthread_t));
+        tmp_s.chunk_ap = calloc(tmp_s.threads, sizeof(struct Chunk));
+
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            unsigned int entries = self_sp->emit_s.end - self_sp->emit_s.start;
+
+            tmp_s.chunk_ap[thread].self_sp = self_sp;
+            tmp_s.chunk_ap[thread].start = (
+                self_sp->emit_s.start
+                  + (unsigned long long)entries*thread/tmp_s.threads
+            );
+            tmp_s.chunk_ap[thread].end = (
+                self_sp->emit_s.start
+                  + (unsigned long long)entries*(thread + 1)/tmp_s.threads
+            );
+            tmp_s.chunk_ap[thread].buffer_gp = (
+                tmp_s.body_gp
+                  + fmtl_f(
+                      self_sp,
+                      self_sp->emit_s.start,
+                      tmp_s.chunk_ap[thread].start
+                  )
+            );
+
+            if (thread) {
+                tmp_s.chunk_ap[thread].threaded = ! pthread_create(
+                    &tmp_s.thread_ap[thread],
+                    NULL,
+                    &emit_work_f,
+                    &tmp_s.chunk_ap[thread]
+                );
+                if (! tmp_s.chunk_ap[thread].threaded)
+                    emit_work_f(&tmp_s.chunk_ap[thread]);
+            }
+        }
+        emit_work_f(&tmp_s.chunk_ap[0]);
+
+        for (unsigned short thread = 1; thread < tmp_s.threads; thread++)
+            if (tmp_s.chunk_ap[thread].threaded)
+                pthread_join(tmp_s.thread_ap[thread], NULL);
+        tmp_s.body_gp += tmp_s.bodyl;
+
+        if (self_sp->emit_s.end == self_sp->emit_s.count) {
+            memcpy(tmp_s.body_gp, self_sp->emit_s.tail_g, self_sp->emit_s.taill);
+            tmp_s.body_gp[self_sp->emit_s.taill] = '\0';
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        self_sp->emit_free_mp(self_sp, tmp_s.head_gp);
+        free(tmp_s.thread_ap);
+        free(tmp_s.chunk_ap);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+
+        /* Return the palette string. */
+        return cpal_gp;
+    }
+
+    void
+    emit_stream_f(struct Self *self_sp, struct Stream *stream_sp) {
+        /* The records from emit_s.start to emit_s.end by the threads. */
+        struct {
+            unsigned short threads;
+            pthread_t *thread_ap;
+            struct Chunk *chunk_ap;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        pthread_mutex_init(&stream_sp->mutex, NULL);
+        pthread_cond_init(&stream_sp->cond, NULL);
+        stream_sp->chunks = (
+            (
+                self_sp->emit_s.end - self_sp->emit_s.start
+                  + stream_sp->chunkl - 1
+            ) / stream_sp->chunkl
+        );
+        stream_sp->threads = self_sp->data_s.task_s.threads;
+        if (stream_sp->threads > stream_sp->chunks)
+            stream_sp->threads = stream_sp->chunks;
+        if (! stream_sp->threads)
+            stream_sp->threads = 1;
+
+        tmp_s.threads = stream_sp->threads;
+        tmp_s.thread_ap = calloc(tmp_s.threads, sizeof(pthread_t));
+        tmp_s.chunk_ap = calloc(tmp_s.threads, sizeof(struct Chunk));
+
+        /*
+         * The chunks are taken in turns by the threads created:
+         * without a thread, the turns are shared by fewer threads.
+         */
+        pthread_mutex_lock(&stream_sp->mutex);
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            tmp_s.chunk_ap[thread].self_sp = self_sp;
+            tmp_s.chunk_ap[thread].stream_sp = stream_sp;
+            tmp_s.chunk_ap[thread].thread = thread;
+            tmp_s.chunk_ap[thread].start = self_sp->emit_s.start;
+            tmp_s.chunk_ap[thread].end = self_sp->emit_s.end;
+            if (! stream_sp->writer_sp)
+                tmp_s.chunk_ap[thread].buffer_gp = malloc(
+                    sizeof(char) * stream_sp->chunkl * self_sp->emit_s.recordl
+                );
+
+            if (thread) {
+                tmp_s.chunk_ap[thread].threaded = ! pthread_create(
+                    &tmp_s.thread_ap[thread],
+                    NULL,
+                    &emit_work_f,
+                    &tmp_s.chunk_ap[thread]
+                );
+                if (! tmp_s.chunk_ap[thread].threaded) {
+                    stream_sp->threads = thread;
+                    break;
+                }
+            }
+        }
+        pthread_mutex_unlock(&stream_sp->mutex);
+        emit_work_f(&tmp_s.chunk_ap[0]);
+
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            if (tmp_s.chunk_ap[thread].threaded)
+                pthread_join(tmp_s.thread_ap[thread], NULL);
+            free(tmp_s.chunk_ap[thread].buffer_gp);
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        pthread_mutex_destroy(&stream_sp->mutex);
+        pthread_cond_destroy(&stream_sp->cond);
+        free(tmp_s.thread_ap);
+        free(tmp_s.chunk_ap);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    unsigned long long
+    resume_f(struct Self *self_sp, FILE *output_lp, const char *head_gp, unsigned int chunkl) {
+        /*
+         * Check the output file against its checkpoint (emit_s.ckpt_s),
+         * the chunks hashed again from the file, as emit_work_f() did.
+         * Return the chunks to keep, or 0 to write it again.
+         */
+        struct Checkpoint *ckpt_sp = &self_sp->emit_s.ckpt_s;
+        struct {
+            char *buffer_gp;
+            unsigned long long hash;
+            unsigned long long offset;
+            unsigned long long chunks;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        tmp_s.hash = ckpt_sp->key;
+        tmp_s.chunks = ckpt_sp->chunks;
+        rewind(output_lp);
+
+        if (tmp_s.chunks && ! self_sp->emit_s.start) {
+            tmp_s.buffer_gp = malloc(sizeof(char) * self_sp->emit_s.headl);
+            if (fread(tmp_s.buffer_gp, sizeof(char), self_sp->emit_s.headl, output_lp)
+                  != self_sp->emit_s.headl
+                  || memcmp(tmp_s.buffer_gp, head_gp, self_sp->emit_s.headl) != 0)
+                tmp_s.chunks = 0;
+            tmp_s.hash = hash_f(
+                (const unsigned char *)head_gp,
+                self_sp->emit_s.headl,
+                tmp_s.hash
+            );
+            tmp_s.offset = self_sp->emit_s.headl;
+            free(tmp_s.buffer_gp);
+        }
+
+        if (tmp_s.chunks)
+            tmp_s.buffer_gp = malloc(sizeof(char) * chunkl * self_sp->emit_s.recordl);
+        for (unsigned long long chunk = 0; chunk < tmp_s.chunks; chunk++) {
+            unsigned int start = self_sp->emit_s.start + chunk*chunkl;
+            unsigned int end = start + chunkl;
+            unsigned long long lenght;
+
+            if (start >= self_sp->emit_s.end) {
+                tmp_s.chunks = 0;
+                break;
+            }
+            if (end > self_sp->emit_s.end)
+                end = self_sp->emit_s.end;
+
+            lenght = fmtl_f(self_sp, start, end);
+            if (fread(tmp_s.buffer_gp, sizeof(char), lenght, output_lp) != lenght) {
+                tmp_s.chunks = 0;
+                break;
+            }
+            tmp_s.hash = hash_f(
+                (const unsigned char *)tmp_s.buffer_gp,
+                lenght,
+                tmp_s.hash
+            );
+            tmp_s.offset += lenght;
+        }
+
+        if (tmp_s.hash != ckpt_sp->hash || tmp_s.offset != ckpt_sp->offset)
+            tmp_s.chunks = 0;
+
+        /* Truncate to the last consistent offset (or to nothing). */
+        if (! tmp_s.chunks) {
+            ckpt_sp->chunks = 0;
+            ckpt_sp->offset = 0;
+            ckpt_sp->hash = ckpt_sp->key;
+        }
+        fflush(output_lp);
+        if (ftruncate(fileno(output_lp), ckpt_sp->offset) != 0)
+            self_sp->error_mp(self_sp, errno, self_sp->emit_s.ckpt_gp);
+        fseeko(output_lp, ckpt_sp->offset, SEEK_SET);
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        free(tmp_s.buffer_gp);
+        tmp_s.buffer_gp = NULL;
+
+        return tmp_s.chunks;
+    }
+
+    void
+    cvd_emit_f(struct Self *self_sp, const char *head_gp) {
+        /*
+         * Variant files of the output (cvd), one per deficiency:
+         * "name.protan.gpl" (before the extension) with the simulated
+         * colours and the deficiency on the GPL name.
+         */
+        const char *suffix_gpa[3] = {
+            " (protanopia)",
+            " (deuteranopia)",
+            " (tritanopia)"
+        };
+        struct {
+            const char *base_gp;
+            const char *dot_gp;
+            char *path_gp;
+            char *head_gp;
+            const char *name_gp;
+            unsigned short headl;
+            unsigned char *colour_ap;
+            unsigned char names;
+            unsigned short recordl;
+            FILE *output_lp;
+            struct Stream stream_s;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        if (! self_sp->emit_s.cvd_apa[0])
+            return;
+
+        /* Extension of the output (after the last slash). */
+        tmp_s.base_gp = strrchr(self_sp->emit_s.cvd_gp, '/');
+        tmp_s.base_gp = tmp_s.base_gp ? tmp_s.base_gp + 1 : self_sp->emit_s.cvd_gp;
+        tmp_s.dot_gp = strrchr(tmp_s.base_gp, '.');
+        if (! tmp_s.dot_gp || tmp_s.dot_gp == tmp_s.base_gp)
+            tmp_s.dot_gp = tmp_s.base_gp + strlen(tmp_s.base_gp);
+
+        tmp_s.path_gp = malloc(sizeof(char) * (strlen(self_sp->emit_s.cvd_gp) + 8));
+        tmp_s.head_gp = malloc(sizeof(char) * (self_sp->emit_s.headl + 17));
+        tmp_s.name_gp = (
+            self_sp->emit_s.format == FORMAT_GPL ? strstr(head_gp, "\nName: ") : NULL
+        );
+        if (tmp_s.name_gp)
+            tmp_s.name_gp = strchr(tmp_s.name_gp + 1, '\n');
+
+        /* Save the entries of the output. */
+        tmp_s.headl = self_sp->emit_s.headl;
+        tmp_s.colour_ap = self_sp->emit_s.colour_ap;
+        tmp_s.names = self_sp->emit_s.names;
+        tmp_s.recordl = self_sp->emit_s.recordl;
+        if (self_sp->emit_s.names == NAMES_CVD) {
+            self_sp->emit_s.names = NAMES_NONE;
+            self_sp->emit_s.recordl = 14;
+        }
+
+        for (unsigned char cvd = 0; cvd < 3; cvd++) {
+            sprintf(
+                tmp_s.path_gp,
+                "%.*s.%s%s",
+                (int)(tmp_s.dot_gp - self_sp->emit_s.cvd_gp),
+                self_sp->emit_s.cvd_gp,
+                cvd_gpa[cvd],
+                tmp_s.dot_gp
+            );
+
+            tmp_s.output_lp = fopen(tmp_s.path_gp, "w");
+            if (! tmp_s.output_lp) {
+                self_sp->error_mp(self_sp, errno, tmp_s.path_gp);
+                continue;
+            }
+
+            /* The head with the deficiency at the end of the name line. */
+            self_sp->emit_s.headl = tmp_s.headl;
+            memcpy(tmp_s.head_gp, head_gp, tmp_s.headl);
+            if (tmp_s.name_gp) {
+                unsigned short namel = tmp_s.name_gp - head_gp;
+                unsigned char suffixl = strlen(suffix_gpa[cvd]);
+
+                memcpy(&tmp_s.head_gp[namel], suffix_gpa[cvd], suffixl);
+                memcpy(
+                    &tmp_s.head_gp[namel + suffixl],
+                    tmp_s.name_gp,
+                    tmp_s.headl - namel
+                );
+                self_sp->emit_s.headl += suffixl;
+            }
+
+            if (! self_sp->emit_s.start)
+                fwrite(
+                    tmp_s.head_gp,
+                    sizeof(char),
+                    self_sp->emit_s.headl,
+                    tmp_s.output_lp
+                );
+
+            self_sp->emit_s.colour_ap = self_sp->emit_s.cvd_apa[cvd];
+            memset(&tmp_s.stream_s, 0, sizeof(tmp_s.stream_s));
+            tmp_s.stream_s.chunkl = 1 << 15;
+            tmp_s.stream_s.output_lp = tmp_s.output_lp;
+            emit_stream_f(self_sp, &tmp_s.stream_s);
+
+            if (self_sp->emit_s.end == self_sp->emit_s.count) {
+                fwrite(
+                    self_sp->emit_s.tail_g,
+                    sizeof(char),
+                    self_sp->emit_s.taill,
+                    tmp_s.output_lp
+                );
+                if (self_sp->emit_s.format == FORMAT_GPL)
+                    fputc('\0', tmp_s.output_lp);
+            }
+
+            if (fclose(tmp_s.output_lp) != 0)
+                self_sp->error_mp(self_sp, errno, tmp_s.path_gp);
+        }
+
+        /* Restore the entries of the output. */
+        self_sp->emit_s.headl = tmp_s.headl;
+        self_sp->emit_s.colour_ap = tmp_s.colour_ap;
+        self_sp->emit_s.names = tmp_s.names;
+        self_sp->emit_s.recordl = tmp_s.recordl;
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        free(tmp_s.path_gp);
+        free(tmp_s.head_gp);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    void
+    emit_f(struct Self *self_sp, FILE *output_lp) {
+        /*
+         * Stream the output with bounded memory:
+         * each thread has its own chunk buffer
+         * and the chunks are written in order.
+         */
+        struct {
+            char *head_gp;
+            struct Stream stream_s;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        self_sp->src_lgen_mp(self_sp);
+        tmp_s.head_gp = self_sp->head_lgen_mp(self_sp);
+        tmp_s.stream_s.chunkl = 1 << 15;
+
+        /*
+         * With a checkpoint (resume), continue after its chunks
+         * or write all again.
+         */
+        if (self_sp->emit_s.ckpt_gp) {
+            tmp_s.stream_s.first = resume_f(
+                self_sp,
+                output_lp,
+                tmp_s.head_gp,
+                tmp_s.stream_s.chunkl
+            );
+            tmp_s.stream_s.next = tmp_s.stream_s.first;
+            tmp_s.stream_s.ckpt_gp = self_sp->emit_s.ckpt_gp;
+            tmp_s.stream_s.ckpt_sp = &self_sp->emit_s.ckpt_s;
+            tmp_s.stream_s.time = time(NULL);
+        }
+
+        if (! self_sp->emit_s.start && ! tmp_s.stream_s.first) {
+            if (fwrite(tmp_s.head_gp, sizeof(char), self_sp->emit_s.headl, output_lp)
+                  != self_sp->emit_s.headl)
+                tmp_s.stream_s.ckpt_sp = NULL;
+
+            if (tmp_s.stream_s.ckpt_sp) {
+                tmp_s.stream_s.ckpt_sp->offset = self_sp->emit_s.headl;
+                tmp_s.stream_s.ckpt_sp->hash = hash_f(
+                    (const unsigned char *)tmp_s.head_gp,
+                    self_sp->emit_s.headl,
+                    tmp_s.stream_s.ckpt_sp->hash
+                );
+            }
+        }
+
+        tmp_s.stream_s.output_lp = output_lp;
+        emit_stream_f(self_sp, &tmp_s.stream_s);
+
+        if (self_sp->emit_s.end == self_sp->emit_s.count)
+            fwrite(
+                self_sp->emit_s.tail_g,
+                sizeof(char),
+                self_sp->emit_s.taill,
+                output_lp
+            );
+
+        /*
+         * As the palette string, GPL ends with the string terminator
+         * on files and with a new line (printf) on stdout.
+         */
+        if (self_sp->emit_s.format == FORMAT_GPL
+              && self_sp->emit_s.end == self_sp->emit_s.count) {
+            fputc(output_lp == stdout ? '\n' : '\0', output_lp);
+            self_sp->emit_s.terminator = output_lp != stdout;
+        }
+
+        /* Fixed records are indexed by their formula. */
+        memset(&self_sp->emit_s.index_s, 0, sizeof(self_sp->emit_s.index_s));
+        if (! self_sp->emit_s.name_ap) {
+            self_sp->emit_s.index_s.head = (
+                self_sp->emit_s.start ? 0 : self_sp->emit_s.headl
+            );
+            self_sp->emit_s.index_s.count = (
+                self_sp->emit_s.end - self_sp->emit_s.start
+            );
+            self_sp->emit_s.index_s.recordl = self_sp->emit_s.recordl;
+        }
+
+        if (self_sp->emit_s.cvd && self_sp->emit_s.cvd_gp)
+            cvd_emit_f(self_sp, tmp_s.head_gp);
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        self_sp->emit_free_mp(self_sp, tmp_s.head_gp);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    FILE *
+    ckpt_open_f(struct Self *self_sp, const char *path_gp, unsigned long long key) {
+        /*
+         * Open the output with its checkpoint (PATH.ckpt):
+         * a checkpoint of the same key (config) keeps the file
+         * for emit_f() to resume it, else the file is written again.
+         */
+        struct {
+            FILE *output_lp;
+            FILE *ckpt_lp;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        self_sp->emit_s.ckpt_gp = malloc(sizeof(char) * (strlen(path_gp) + 6));
+        sprintf(self_sp->emit_s.ckpt_gp, "%s.ckpt", path_gp);
+
+        memset(&self_sp->emit_s.ckpt_s, 0, sizeof(self_sp->emit_s.ckpt_s));
+        tmp_s.ckpt_lp = fopen(self_sp->emit_s.ckpt_gp, "r");
+        if (tmp_s.ckpt_lp) {
+            if (fread(
+                  &self_sp->emit_s.ckpt_s,
+                  sizeof(self_sp->emit_s.ckpt_s),
+                  1,
+                  tmp_s.ckpt_lp
+                ) != 1
+                  || memcmp(self_sp->emit_s.ckpt_s.magic_g, "GPLCKP1", 8) != 0
+                  || self_sp->emit_s.ckpt_s.key != key)
+                memset(&self_sp->emit_s.ckpt_s, 0, sizeof(self_sp->emit_s.ckpt_s));
+            fclose(tmp_s.ckpt_lp);
+        }
+        memcpy(self_sp->emit_s.ckpt_s.magic_g, "GPLCKP1", 8);
+        self_sp->emit_s.ckpt_s.key = key;
+
+        if (self_sp->emit_s.ckpt_s.chunks)
+            tmp_s.output_lp = fopen(path_gp, "r+");
+        if (! tmp_s.output_lp) {
+            self_sp->emit_s.ckpt_s.chunks = 0;
+            tmp_s.output_lp = fopen(path_gp, "w+");
+        }
+
+        if (! tmp_s.output_lp) {
+            free(self_sp->emit_s.ckpt_gp);
+            self_sp->emit_s.ckpt_gp = NULL;
+        }
+
+        return tmp_s.output_lp;
+    }
+
+#if defined(GPLGEN_LIBRARY)
+    void
+    pull_open_f(struct Self *self_sp) {
+        /* The entries and head as emit_f(), kept until pull_free_f(). */
+        unsigned long long recordl;
+
+        self_sp->src_lgen_mp(self_sp);
+        self_sp->pull_s.head_gp = self_sp->head_lgen_mp(self_sp);
+        self_sp->pull_s.piece = self_sp->emit_s.start ? 1 : 0;
+        self_sp->pull_s.entry = self_sp->emit_s.start;
+        self_sp->pull_s.offset = 0;
+        self_sp->pull_s.recordl = 0;
+
+        /* The longest record (names of a loaded palette). */
+        recordl = self_sp->emit_s.recordl;
+        if (self_sp->emit_s.name_ap)
+            for (unsigned int entry = self_sp->emit_s.start;
+                  entry < self_sp->emit_s.end;
+                  entry++)
+                if (fmtl_f(self_sp, entry, entry + 1) > recordl)
+                    recordl = fmtl_f(self_sp, entry, entry + 1);
+        self_sp->pull_s.record_gp = malloc(sizeof(char) * recordl);
+    }
+
+    unsigned long long
+    pull_f(struct Self *self_sp, char *buffer_gp, unsigned long long cap) {
+        /*
+         * Next chunk of the palette string (no GPL terminator),
+         * up to cap bytes, from the saved loop position:
+         * the whole records are written on the buffer by fmt_f(),
+         * a record split by cap is written on record_gp
+         * and copied in turns.
+         * Return the lenght of the chunk (0 at the end).
+         */
+        unsigned long long size = 0;
+
+        while (size < cap && self_sp->pull_s.piece < 3) {
+            unsigned long long lenght = 0;
+            unsigned int count = 0;
+
+            switch (self_sp->pull_s.piece) {
+                case 0:
+                    lenght = self_sp->emit_s.headl - self_sp->pull_s.offset;
+                    if (lenght > cap - size)
+                        lenght = cap - size;
+                    memcpy(
+                        &buffer_gp[size],
+                        &self_sp->pull_s.head_gp[self_sp->pull_s.offset],
+                        lenght
+                    );
+                    size += lenght;
+                    self_sp->pull_s.offset += lenght;
+
+                    if (self_sp->pull_s.offset == self_sp->emit_s.headl) {
+                        self_sp->pull_s.piece = 1;
+                        self_sp->pull_s.offset = 0;
+                    }
+                    break;
+                case 1:
+                    /* The rest of a split record. */
+                    if (self_sp->pull_s.recordl) {
+                        lenght = self_sp->pull_s.recordl - self_sp->pull_s.offset;
+                        if (lenght > cap - size)
+                            lenght = cap - size;
+                        memcpy(
+                            &buffer_gp[size],
+                            &self_sp->pull_s.record_gp[self_sp->pull_s.offset],
+                            lenght
+                        );
+                        size += lenght;
+                        self_sp->pull_s.offset += lenght;
+
+                        if (self_sp->pull_s.offset == self_sp->pull_s.recordl) {
+                            self_sp->pull_s.entry++;
+                            self_sp->pull_s.recordl = 0;
+                            self_sp->pull_s.offset = 0;
+                        }
+                        break;
+                    }
+
+                    if (self_sp->pull_s.entry == self_sp->emit_s.end) {
+                        self_sp->pull_s.piece = (
+                            self_sp->emit_s.end < self_sp->emit_s.count ? 3 : 2
+                        );
+                        break;
+                    }
+
+                    /* The whole records on the free space. */
+                    if (! self_sp->emit_s.name_ap) {
+                        count = (cap - size)/self_sp->emit_s.recordl;
+                        if (count > self_sp->emit_s.end - self_sp->pull_s.entry)
+                            count = self_sp->emit_s.end - self_sp->pull_s.entry;
+                    } else {
+                        for (lenght = 0;
+                              self_sp->pull_s.entry + count < self_sp->emit_s.end;
+                              count++) {
+                            lenght += fmtl_f(
+                                self_sp,
+                                self_sp->pull_s.entry + count,
+                                self_sp->pull_s.entry + count + 1
+                            );
+                            if (lenght > cap - size)
+                                break;
+                        }
+                    }
+
+                    if (count) {
+                        size += fmt_f(
+                            self_sp,
+                            &buffer_gp[size],
+                            self_sp->pull_s.entry,
+                            count
+                        );
+                        self_sp->pull_s.entry += count;
+                    } else {
+                        self_sp->pull_s.recordl = fmt_f(
+                            self_sp,
+                            self_sp->pull_s.record_gp,
+                            self_sp->pull_s.entry,
+                            1
+                        );
+                    }
+                    break;
+                case 2:
+                    lenght = self_sp->emit_s.taill - self_sp->pull_s.offset;
+                    if (lenght > cap - size)
+                        lenght = cap - size;
+                    memcpy(
+                        &buffer_gp[size],
+                        &self_sp->emit_s.tail_g[self_sp->pull_s.offset],
+                        lenght
+                    );
+                    size += lenght;
+                    self_sp->pull_s.offset += lenght;
+
+                    if (self_sp->pull_s.offset == self_sp->emit_s.taill) {
+                        self_sp->pull_s.piece = 3;
+                        self_sp->pull_s.offset = 0;
+                    }
+                    break;
+            }
+        }
+
+        return size;
+    }
+
+    void
+    pull_free_f(struct Self *self_sp) {
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        self_sp->emit_free_mp(self_sp, self_sp->pull_s.head_gp);
+        free(self_sp->pull_s.record_gp);
+        free(self_sp->error_s.value_gp);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&self_sp->pull_s, '\0', sizeof(self_sp->pull_s));
+        self_sp->error_s.value_gp = NULL;
+    }
+#endif
+
+    /*
+     * Swatch image of the entries, columns wide (or square
+     * without columns), cells of pmap_s.cell pixels:
+     * PPM (P6) or PNG (make PNG=1, zlib).
+     * Each thread renders a tile (some lines) and writes it in order,
+     * PNG tiles are raw deflate streams ended by a sync flush
+     * (one IDAT each) with a combined Adler-32.
+     */
+    struct Tile {
+        struct Self *self_sp;
+        struct Stream *stream_sp;
+        unsigned short thread;
+        unsigned char png: 1;
+        unsigned int columns;
+        unsigned short cell;
+        unsigned int lines;
+        unsigned long long height;
+        unsigned char *rgb_ap;
+        unsigned char *pixel_ap;
+#if defined(GPLGEN_PNG)
+        z_stream z_s;
+        unsigned char *deflate_ap;
+        unsigned long deflatel;
+        unsigned long *adler_p;
+#endif
+        /* Without a thread, the turns are shared by fewer threads. */
+        unsigned char threaded: 1;
+    };
+
+    void *
+    render_work_f(void *tile_vp) {
+        struct Tile *tile_sp = tile_vp;
+        struct Stream *stream_sp = tile_sp->stream_sp;
+        struct Self *self_sp = tile_sp->self_sp;
+        unsigned long long rowl = (
+            (unsigned long long)tile_sp->columns*tile_sp->cell*3 + tile_sp->png
+        );
+
+        /* The threads are known once all are created (see render_f()). */
+        pthread_mutex_lock(&stream_sp->mutex);
+        unsigned short threads = stream_sp->threads;
+        pthread_mutex_unlock(&stream_sp->mutex);
+
+        for (unsigned long long tile = tile_sp->thread;
+              tile < stream_sp->chunks;
+              tile += threads) {
+            unsigned long long line = tile*tile_sp->lines;
+            unsigned int lines = tile_sp->lines;
+            unsigned long long pixell;
+            unsigned char *output_ap = tile_sp->pixel_ap;
+            unsigned long long outputl;
+
+            if (lines > tile_sp->height - line)
+                lines = tile_sp->height - line;
+            pixell = lines*rowl;
+
+            for (unsigned int index = 0; index < lines; index++) {
+                unsigned char *line_ap = &tile_sp->pixel_ap[index*rowl];
+                unsigned char *pixel_ap = line_ap + tile_sp->png;
+                unsigned int row = (line + index)/tile_sp->cell;
+                unsigned int first = self_sp->emit_s.start + row*tile_sp->columns;
+                unsigned int count = tile_sp->columns;
+
+                /* The other lines of the cells are the same. */
+                if (index && (line + index) % tile_sp->cell) {
+                    memcpy(line_ap, line_ap - rowl, rowl);
+                    continue;
+                }
+
+                /* Raw colours (ACT records) of the row, see render_f(). */
+                if (count > self_sp->emit_s.end - first)
+                    count = self_sp->emit_s.end - first;
+                fmt_f(self_sp, (char *)tile_sp->rgb_ap, first, count);
+                memset(&tile_sp->rgb_ap[count*3], 0, (tile_sp->columns - count)*3);
+
+                if (tile_sp->png)
+                    line_ap[0] = 0;
+
+                for (unsigned int column = 0; column < tile_sp->columns; column++)
+                    for (unsigned short pixel = 0; pixel < tile_sp->cell; pixel++) {
+                        memcpy(pixel_ap, &tile_sp->rgb_ap[column*3], 3);
+                        pixel_ap += 3;
+                    }
+            }
+            outputl = pixell;
+
+#if defined(GPLGEN_PNG)
+            unsigned long adler = 0;
+
+            if (tile_sp->png) {
+                unsigned long crc;
+
+                adler = adler32(adler32(0, NULL, 0), tile_sp->pixel_ap, pixell);
+
+                /* IDAT lenght, type, deflate data and CRC. */
+                deflateReset(&tile_sp->z_s);
+                tile_sp->z_s.next_in = tile_sp->pixel_ap;
+                tile_sp->z_s.avail_in = pixell;
+                tile_sp->z_s.next_out = &tile_sp->deflate_ap[8];
+                tile_sp->z_s.avail_out = tile_sp->deflatel - 12;
+                deflate(
+                    &tile_sp->z_s,
+                    tile + 1 == stream_sp->chunks ? Z_FINISH : Z_SYNC_FLUSH
+                );
+                outputl = tile_sp->z_s.total_out;
+
+                tile_sp->deflate_ap[0] = outputl >> 24;
+                tile_sp->deflate_ap[1] = outputl >> 16 & 0xff;
+                tile_sp->deflate_ap[2] = outputl >> 8 & 0xff;
+                tile_sp->deflate_ap[3] = outputl & 0xff;
+                memcpy(&tile_sp->deflate_ap[4], "IDAT", 4);
+                crc = crc32(crc32(0, NULL, 0), &tile_sp->deflate_ap[4], outputl + 4);
+                tile_sp->deflate_ap[outputl + 8] = crc >> 24;
+                tile_sp->deflate_ap[outputl + 9] = crc >> 16 & 0xff;
+                tile_sp->deflate_ap[outputl + 10] = crc >> 8 & 0xff;
+                tile_sp->deflate_ap[outputl + 11] = crc & 0xff;
+                output_ap = tile_sp->deflate_ap;
+                outputl += 12;
+            }
+#endif
+
+            /* Wait for the turn of this tile. */
+            pthread_mutex_lock(&stream_sp->mutex);
+            while (stream_sp->next != tile)
+                pthread_cond_wait(&stream_sp->cond, &stream_sp->mutex);
+            pthread_mutex_unlock(&stream_sp->mutex);
+
+            fwrite(output_ap, sizeof(char), outputl, stream_sp->output_lp);
+#if defined(GPLGEN_PNG)
+            if (tile_sp->png)
+                *tile_sp->adler_p = adler32_combine(*tile_sp->adler_p, adler, pixell);
+#endif
+
+            pthread_mutex_lock(&stream_sp->mutex);
+            stream_sp->next++;
+            pthread_cond_broadcast(&stream_sp->cond);
+            pthread_mutex_unlock(&stream_sp->mutex);
+        }
+
+        return NULL;
+    }
+
+    void
+    render_f(struct Self *self_sp, FILE *output_lp, unsigned char png) {
+        struct {
+            char *head_gp;
+            struct Stream stream_s;
+            unsigned short threads;
+            pthread_t *thread_ap;
+            struct Tile *tile_ap;
+            unsigned int count;
+            unsigned int columns;
+            unsigned int rows;
+            unsigned short cell;
+            unsigned long long width;
+            unsigned long long height;
+            unsigned long adler;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        /*
+         * Write a PNG chunk: lenght, type, data and CRC.
+         * 0 == '\0' == NULL
+         */
+        void
+        png_chunk_f(const char *type_gp, const unsigned char *data_ap, unsigned int datal) {
+#if defined(GPLGEN_PNG)
+            unsigned char lenght_a[4] = {datal >> 24, datal >> 16, datal >> 8, datal};
+            unsigned long crc = crc32(crc32(0, NULL, 0), (const unsigned char *)type_gp, 4);
+
+            fwrite(lenght_a, sizeof(char), 4, output_lp);
+            fwrite(type_gp, sizeof(char), 4, output_lp);
+
+            /* crc32() of NULL is the initial CRC. */
+            if (datal) {
+                crc = crc32(crc, data_ap, datal);
+                fwrite(data_ap, sizeof(char), datal, output_lp);
+            }
+            lenght_a[0] = crc >> 24;
+            lenght_a[1] = crc >> 16;
+            lenght_a[2] = crc >> 8;
+            lenght_a[3] = crc;
+            fwrite(lenght_a, sizeof(char), 4, output_lp);
+#else
+            /* No PNG output without zlib (PPM only). */
+            (void)type_gp;
+            (void)data_ap;
+            (void)datal;
+#endif
+        }
+
+#if ! defined(GPLGEN_PNG)
+        if (png) {
+            self_sp->error_mp(self_sp, ENOTSUP, "png");
+            return;
+        }
+#endif
+
+        /*
+         * All formats but ACT (256 colours), without names
+         * (the header releases the columns and the cell size).
+         */
+        self_sp->emit_s.format = FORMAT_HEX;
+        self_sp->src_lgen_mp(self_sp);
+        tmp_s.columns = self_sp->data_s.pmap_s.columns;
+        tmp_s.cell = self_sp->data_s.pmap_s.cell;
+        tmp_s.head_gp = self_sp->head_lgen_mp(self_sp);
+
+        /* ACT records (3 bytes) are the raw colours. */
+        self_sp->emit_s.format = FORMAT_ACT;
+        self_sp->emit_s.recordl = 3;
+
+        tmp_s.count = self_sp->emit_s.end - self_sp->emit_s.start;
+        if (! tmp_s.columns)
+            while ((unsigned long long)tmp_s.columns*tmp_s.columns < tmp_s.count)
+                tmp_s.columns++;
+        if (! tmp_s.columns)
+            tmp_s.columns = 1;
+        tmp_s.rows = (tmp_s.count + tmp_s.columns - 1)/tmp_s.columns;
+        tmp_s.width = (unsigned long long)tmp_s.columns*tmp_s.cell;
+        tmp_s.height = (unsigned long long)tmp_s.rows*tmp_s.cell;
+
+        if (! tmp_s.count || tmp_s.width > 1 << 30 || tmp_s.height > 1u << 31) {
+            self_sp->error_mp(self_sp, EINVAL, "render");
+            self_sp->emit_free_mp(self_sp, tmp_s.head_gp);
+            return;
+        }
+
+        if (png) {
+#if defined(GPLGEN_PNG)
+            /* Width, height, 8 bits, RGB, deflate, filters and no interlace. */
+            unsigned char ihdr_a[13] = {
+                tmp_s.width >> 24, tmp_s.width >> 16, tmp_s.width >> 8, tmp_s.width,
+                tmp_s.height >> 24, tmp_s.height >> 16, tmp_s.height >> 8, tmp_s.height,
+                8, 2, 0, 0, 0
+            };
+            /* zlib header (deflate, 32 KiB window). */
+            unsigned char zlib_a[2] = {0x78, 0x01};
+
+            fwrite("\x89PNG\r\n\x1a\n", sizeof(char), 8, output_lp);
+            png_chunk_f("IHDR", ihdr_a, 13);
+            png_chunk_f("IDAT", zlib_a, 2);
+            tmp_s.adler = 1;
+#endif
+        } else {
+            fprintf(output_lp, "P6\n%llu %llu\n255\n", tmp_s.width, tmp_s.height);
+        }
+
+        /* Tiles of about 1 MiB (one line at least). */
+        pthread_mutex_init(&tmp_s.stream_s.mutex, NULL);
+        pthread_cond_init(&tmp_s.stream_s.cond, NULL);
+        tmp_s.stream_s.output_lp = output_lp;
+        tmp_s.stream_s.chunkl = (1 << 20)/(tmp_s.width*3 + png);
+        if (! tmp_s.stream_s.chunkl)
+            tmp_s.stream_s.chunkl = 1;
+        tmp_s.stream_s.chunks = (
+            (tmp_s.height + tmp_s.stream_s.chunkl - 1)/tmp_s.stream_s.chunkl
+        );
+        tmp_s.stream_s.threads = self_sp->data_s.task_s.threads;
+        if (tmp_s.stream_s.threads > tmp_s.stream_s.chunks)
+            tmp_s.stream_s.threads = tmp_s.stream_s.chunks;
+
+        tmp_s.threads = tmp_s.stream_s.threads;
+        tmp_s.thread_ap = calloc(tmp_s.threads, sizeof(pthread_t));
+        tmp_s.tile_ap = calloc(tmp_s.threads, sizeof(struct Tile));
+
+        /* The tiles are taken in turns by the threads created. */
+        pthread_mutex_lock(&tmp_s.stream_s.mutex);
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            struct Tile *tile_sp = &tmp_s.tile_ap[thread];
+            unsigned long long pixell = (
+                (tmp_s.width*3 + png)*tmp_s.stream_s.chunkl
+            );
+
+            tile_sp->self_sp = self_sp;
+            tile_sp->stream_sp = &tmp_s.stream_s;
+            tile_sp->thread = thread;
+            tile_sp->png = png;
+            tile_sp->columns = tmp_s.columns;
+            tile_sp->cell = tmp_s.cell;
+            tile_sp->lines = tmp_s.stream_s.chunkl;
+            tile_sp->height = tmp_s.height;
+            tile_sp->rgb_ap = malloc(sizeof(char) * tmp_s.columns*3);
+            tile_sp->pixel_ap = malloc(sizeof(char) * pixell);
+#if defined(GPLGEN_PNG)
+            if (png) {
+                deflateInit2(
+                    &tile_sp->z_s,
+                    Z_DEFAULT_COMPRESSION,
+                    Z_DEFLATED,
+                    -15,
+                    8,
+                    Z_DEFAULT_STRATEGY
+                );
+                /* A sync flush adds an empty block (5 bytes). */
+                tile_sp->deflatel = deflateBound(&tile_sp->z_s, pixell) + 5 + 12;
+                tile_sp->deflate_ap = malloc(sizeof(char) * tile_sp->deflatel);
+                tile_sp->adler_p = &tmp_s.adler;
+            }
+#endif
+
+            if (thread) {
+                tile_sp->threaded = ! pthread_create(
+                    &tmp_s.thread_ap[thread],
+                    NULL,
+                    &render_work_f,
+                    tile_sp
+                );
+                if (! tile_sp->threaded) {
+                    tmp_s.stream_s.threads = thread;
+                    break;
+                }
+            }
+        }
+        pthread_mutex_unlock(&tmp_s.stream_s.mutex);
+        render_work_f(&tmp_s.tile_ap[0]);
+
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            if (tmp_s.tile_ap[thread].threaded)
+                pthread_join(tmp_s.thread_ap[thread], NULL);
+            free(tmp_s.tile_ap[thread].rgb_ap);
+            free(tmp_s.tile_ap[thread].pixel_ap);
+#if defined(GPLGEN_PNG)
+            if (png) {
+                deflateEnd(&tmp_s.tile_ap[thread].z_s);
+                free(tmp_s.tile_ap[thread].deflate_ap);
+            }
+#endif
+        }
+
+        if (png) {
+            unsigned char adler_a[4] = {
+                tmp_s.adler >> 24,
+                tmp_s.adler >> 16,
+                tmp_s.adler >> 8,
+                tmp_s.adler
+            };
+
+            png_chunk_f("IDAT", adler_a, 4);
+            png_chunk_f("IEND", NULL, 0);
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        self_sp->emit_free_mp(self_sp, tmp_s.head_gp);
+        pthread_mutex_destroy(&tmp_s.stream_s.mutex);
+        pthread_cond_destroy(&tmp_s.stream_s.cond);
+        free(tmp_s.thread_ap);
+        free(tmp_s.tile_ap);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    /*
+     * Analytics of the entries (analyse subcommand) on OKLab:
+     * nearest neighbour distances (ΔE OKLab) and gamut coverage
+     * by a uniform grid of cells (no pair scans), the points are
+     * sorted by cell, so each row of cells is a run of points
+     * for the distance kernel.
+     */
+    struct Grid {
+        float origin_a[3];
+        float cell;
+        unsigned short dim_a[3];
+        unsigned int *start_ap;
+        float *axis_apa[3];
+        /* Points of the repeated colours (0 to their copies). */
+        unsigned char *repeat_ap;
+    };
+
+    float
+    near_f(
+        const float *const axis_apa[3],
+        unsigned int first,
+        unsigned int last,
+        const float query_a[3],
+        unsigned int skip,
+        float best
+    ) {
+        /*
+         * Smallest squared distance of the points first to last
+         * (the point skip is the query itself).
+         * Keep the same operations (and order) of the AVX2 version.
+         */
+        for (unsigned int index = first; index < last; index++) {
+            float l = axis_apa[0][index] - query_a[0];
+            float a = axis_apa[1][index] - query_a[1];
+            float b = axis_apa[2][index] - query_a[2];
+            float distance = l*l + a*a + b*b;
+
+            if (distance < best && index != skip)
+                best = distance;
+        }
+
+        return best;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("avx2")))
+    float
+    near_avx2_f(
+        const float *const axis_apa[3],
+        unsigned int first,
+        unsigned int last,
+        const float query_a[3],
+        unsigned int skip,
+        float best
+    ) {
+        const __m256 l = _mm256_set1_ps(query_a[0]);
+        const __m256 a = _mm256_set1_ps(query_a[1]);
+        const __m256 b = _mm256_set1_ps(query_a[2]);
+        const __m256 infinity = _mm256_set1_ps(INFINITY);
+        const __m256i skip_v = _mm256_set1_epi32(skip);
+        __m256i index_v = _mm256_add_epi32(
+            _mm256_set1_epi32(first),
+            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+        );
+        __m256 best_v = _mm256_set1_ps(best);
+        unsigned int index = first;
+
+        /*
+         * The remainder is masked (no scalar code on this AVX2 state),
+         * out of range lanes and the query point are infinite.
+         */
+        for (; index < last; index += 8) {
+            __m256i mask = _mm256_cmpgt_epi32(
+                _mm256_set1_epi32(last - index),
+                _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+            );
+            __m256 dl = _mm256_sub_ps(_mm256_maskload_ps(&axis_apa[0][index], mask), l);
+            __m256 da = _mm256_sub_ps(_mm256_maskload_ps(&axis_apa[1][index], mask), a);
+            __m256 db = _mm256_sub_ps(_mm256_maskload_ps(&axis_apa[2][index], mask), b);
+            __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(dl, dl), _mm256_mul_ps(da, da)),
+                _mm256_mul_ps(db, db)
+            );
+
+            mask = _mm256_andnot_si256(_mm256_cmpeq_epi32(index_v, skip_v), mask);
+            distance = _mm256_blendv_ps(infinity, distance, _mm256_castsi256_ps(mask));
+            best_v = _mm256_min_ps(best_v, distance);
+            index_v = _mm256_add_epi32(index_v, _mm256_set1_epi32(8));
+        }
+
+        /* Minimum of the lanes. */
+        best_v = _mm256_min_ps(best_v, _mm256_permute2f128_ps(best_v, best_v, 1));
+        best_v = _mm256_min_ps(best_v, _mm256_shuffle_ps(best_v, best_v, 0x4e));
+        best_v = _mm256_min_ps(best_v, _mm256_shuffle_ps(best_v, best_v, 0xb1));
+
+        return _mm256_cvtss_f32(best_v);
+    }
+#endif
+
+    float
+    grid_near_f(
+        const struct Grid *grid_sp,
+        const float query_a[3],
+        unsigned int skip,
+        float (*near_fp)(
+            const float *const [3],
+            unsigned int,
+            unsigned int,
+            const float [3],
+            unsigned int,
+            float
+        )
+    ) {
+        /*
+         * Distance to the nearest point, by rings of cells
+         * (Chebyshev distance) around the cell of the query:
+         * after the ring N, the other points are N cells away at least.
+         */
+        const float *const *axis_apa = (const float *const *)grid_sp->axis_apa;
+        int cell_a[3];
+        int ringl = 0;
+        float best = INFINITY;
+
+        for (unsigned char axis = 0; axis < 3; axis++) {
+            cell_a[axis] = (
+                (query_a[axis] - grid_sp->origin_a[axis])/grid_sp->cell
+            );
+            if (cell_a[axis] < 0)
+                cell_a[axis] = 0;
+            if (cell_a[axis] >= grid_sp->dim_a[axis])
+                cell_a[axis] = grid_sp->dim_a[axis] - 1;
+            if (ringl < grid_sp->dim_a[axis])
+                ringl = grid_sp->dim_a[axis];
+        }
+
+        for (int ring = 0; ring <= ringl; ring++) {
+            for (int z = cell_a[2] - ring; z <= cell_a[2] + ring; z++) {
+                if (z < 0 || z >= grid_sp->dim_a[2])
+                    continue;
+
+                for (int y = cell_a[1] - ring; y <= cell_a[1] + ring; y++) {
+                    unsigned char shell;
+                    unsigned int row;
+
+                    if (y < 0 || y >= grid_sp->dim_a[1])
+                        continue;
+
+                    /* Full rows on the shell faces, else 2 cells. */
+                    shell = (
+                        z == cell_a[2] - ring || z == cell_a[2] + ring
+                          || y == cell_a[1] - ring || y == cell_a[1] + ring
+                    );
+                    row = (z*grid_sp->dim_a[1] + y)*grid_sp->dim_a[0];
+
+                    for (int x = cell_a[0] - ring;
+                          x <= cell_a[0] + ring;
+                          x += shell || ! ring ? 2*ring + 1 : 2*ring) {
+                        int first = x < 0 ? 0 : x;
+                        int last = (
+                            shell && cell_a[0] + ring < grid_sp->dim_a[0]
+                              ? cell_a[0] + ring
+                              : shell ? grid_sp->dim_a[0] - 1 : x
+                        );
+
+                        if (first >= grid_sp->dim_a[0] || last < first)
+                            continue;
+
+                        best = near_fp(
+                            axis_apa,
+                            grid_sp->start_ap[row + first],
+                            grid_sp->start_ap[row + last + 1],
+                            query_a,
+                            skip,
+                            best
+                        );
+                    }
+                }
+            }
+
+            if (best <= ring*grid_sp->cell*ring*grid_sp->cell)
+                break;
+        }
+
+        return sqrtf(best);
+    }
+
+    /* Queries of each thread (entries, then the gamut samples). */
+    struct Analyse {
+        const struct Grid *grid_sp;
+        float (*near_fp)(
+            const float *const [3],
+            unsigned int,
+            unsigned int,
+            const float [3],
+            unsigned int,
+            float
+        );
+        const float *linear_ap;
+        unsigned int start;
+        unsigned int end;
+        unsigned int sample_a[2];
+        float min;
+        float max;
+        double sum;
+        unsigned int covered;
+        float sample_max;
+        double sample_sum;
+        /* Without a thread, the range is done by the calling thread. */
+        unsigned char threaded: 1;
+    };
+
+    void
+    oklab_f(const float *linear_ap, const unsigned char *rgb_ap, float lab_a[3]) {
+        /* sRGB (8 bits) to OKLab. */
+        float red = linear_ap[rgb_ap[0]];
+        float green = linear_ap[rgb_ap[1]];
+        float blue = linear_ap[rgb_ap[2]];
+        float l = cbrtf(0.4122214708f*red + 0.5363325363f*green + 0.0514459929f*blue);
+        float m = cbrtf(0.2119034982f*red + 0.6806995451f*green + 0.1073969566f*blue);
+        float s = cbrtf(0.0883024619f*red + 0.2817188376f*green + 0.6299787005f*blue);
+
+        lab_a[0] = 0.2104542553f*l + 0.7936177850f*m - 0.0040720468f*s;
+        lab_a[1] = 1.9779984951f*l - 2.4285922050f*m + 0.4505937099f*s;
+        lab_a[2] = 0.0259040371f*l + 0.7827717662f*m - 0.8086757660f*s;
+    }
+
+    void *
+    analyse_work_f(void *analyse_vp) {
+        struct Analyse *analyse_sp = analyse_vp;
+        const struct Grid *grid_sp = analyse_sp->grid_sp;
+
+        analyse_sp->min = INFINITY;
+        for (unsigned int point = analyse_sp->start; point < analyse_sp->end; point++) {
+            const float query_a[3] = {
+                grid_sp->axis_apa[0][point],
+                grid_sp->axis_apa[1][point],
+                grid_sp->axis_apa[2][point]
+            };
+            float distance = 0.0f;
+
+            if (! grid_sp->repeat_ap[point])
+                distance = grid_near_f(grid_sp, query_a, point, analyse_sp->near_fp);
+
+            if (distance < analyse_sp->min)
+                analyse_sp->min = distance;
+            if (distance > analyse_sp->max)
+                analyse_sp->max = distance;
+            analyse_sp->sum += distance;
+        }
+
+        /*
+         * Gamut samples, a 33/33/33 grid of sRGB (steps of 8):
+         * covered on a just noticeable difference (0.02).
+         */
+        for (unsigned int sample = analyse_sp->sample_a[0];
+              sample < analyse_sp->sample_a[1];
+              sample++) {
+            const unsigned char rgb_a[3] = {
+                sample%33*8 < 256 ? sample%33*8 : 255,
+                sample/33%33*8 < 256 ? sample/33%33*8 : 255,
+                sample/33/33*8 < 256 ? sample/33/33*8 : 255
+            };
+            float query_a[3];
+            float distance;
+
+            oklab_f(analyse_sp->linear_ap, rgb_a, query_a);
+            distance = grid_near_f(grid_sp, query_a, -1, analyse_sp->near_fp);
+
+            analyse_sp->covered += distance <= 0.02f;
+            if (distance > analyse_sp->sample_max)
+                analyse_sp->sample_max = distance;
+            analyse_sp->sample_sum += distance;
+        }
+
+        return NULL;
+    }
+
+    void
+    analyse_f(struct Self *self_sp, FILE *output_lp) {
+        struct {
+            char *head_gp;
+            unsigned int count;
+            unsigned char *rgb_ap;
+            float linear_a[1 << 8];
+            float *lab_ap;
+            float min_a[3];
+            float max_a[3];
+            struct Grid grid_s;
+            unsigned int *cell_ap;
+            unsigned int cells;
+            unsigned char *bitmap_apa[2];
+            unsigned int unique;
+            unsigned char *repeat_ap;
+            unsigned int histogram_aa[4][1 << 8];
+            unsigned short threads;
+            pthread_t *thread_ap;
+            struct Analyse *analyse_ap;
+            struct Analyse total_s;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        /* The entries as raw colours (ACT records), see render_f(). */
+        self_sp->emit_s.format = FORMAT_HEX;
+        self_sp->src_lgen_mp(self_sp);
+        tmp_s.head_gp = self_sp->head_lgen_mp(self_sp);
+        self_sp->emit_s.format = FORMAT_ACT;
+        self_sp->emit_s.recordl = 3;
+
+        tmp_s.count = self_sp->emit_s.end - self_sp->emit_s.start;
+        tmp_s.rgb_ap = huge_alloc_f(
+            sizeof(char) * tmp_s.count*3 + 1,
+            self_sp->data_s.task_s.pages
+        );
+        fmt_f(self_sp, (char *)tmp_s.rgb_ap, self_sp->emit_s.start, tmp_s.count);
+
+        for (unsigned short value = 0; value < 1 << 8; value++) {
+            double channel = value/255.0;
+
+            tmp_s.linear_a[value] = (
+                channel <= 0.04045
+                  ? channel/12.92
+                  : pow((channel + 0.055)/1.055, 2.4)
+            );
+        }
+
+        /*
+         * Histograms and unique colours (24 bits bitmaps, 2 MiB each):
+         * the grid has one point per colour, the repeated ones
+         * have a nearest neighbour at 0.
+         */
+        tmp_s.bitmap_apa[0] = calloc(1 << 21, sizeof(char));
+        tmp_s.bitmap_apa[1] = calloc(1 << 21, sizeof(char));
+        for (unsigned int entry = 0; entry < tmp_s.count; entry++) {
+            const unsigned char *rgb_ap = &tmp_s.rgb_ap[entry*3];
+            unsigned int key = rgb_ap[0] << 16 | rgb_ap[1] << 8 | rgb_ap[2];
+
+            float lab_a[3];
+
+            for (unsigned char channel = 0; channel < 3; channel++)
+                tmp_s.histogram_aa[channel][rgb_ap[channel]]++;
+            oklab_f(tmp_s.linear_a, rgb_ap, lab_a);
+            tmp_s.histogram_aa[3][
+                lab_a[0] <= 0.0f ? 0 : lab_a[0] >= 1.0f ? 15 : (int)(lab_a[0]*16)
+            ]++;
+
+            if (tmp_s.bitmap_apa[0][key >> 3] & 1 << (key & 7)) {
+                tmp_s.bitmap_apa[1][key >> 3] |= 1 << (key & 7);
+            } else {
+                tmp_s.bitmap_apa[0][key >> 3] |= 1 << (key & 7);
+                tmp_s.unique++;
+            }
+        }
+
+        /* OKLab points (unique colours) and bounds. */
+        tmp_s.lab_ap = malloc(sizeof(float) * tmp_s.unique*3 + 1);
+        tmp_s.repeat_ap = malloc(sizeof(char) * tmp_s.unique + 1);
+        for (unsigned char axis = 0; axis < 3; axis++) {
+            tmp_s.min_a[axis] = INFINITY;
+            tmp_s.max_a[axis] = -INFINITY;
+        }
+
+        for (unsigned int entry = 0, point = 0; entry < tmp_s.count; entry++) {
+            const unsigned char *rgb_ap = &tmp_s.rgb_ap[entry*3];
+            unsigned int key = rgb_ap[0] << 16 | rgb_ap[1] << 8 | rgb_ap[2];
+            float *lab_ap = &tmp_s.lab_ap[point*3];
+
+            /* The first copy only. */
+            if (! (tmp_s.bitmap_apa[0][key >> 3] & 1 << (key & 7)))
+                continue;
+            tmp_s.bitmap_apa[0][key >> 3] &= ~(1 << (key & 7));
+            tmp_s.repeat_ap[point] = (
+                tmp_s.bitmap_apa[1][key >> 3] >> (key & 7) & 1
+            );
+
+            oklab_f(tmp_s.linear_a, rgb_ap, lab_ap);
+            for (unsigned char axis = 0; axis < 3; axis++) {
+                if (lab_ap[axis] < tmp_s.min_a[axis])
+                    tmp_s.min_a[axis] = lab_ap[axis];
+                if (lab_ap[axis] > tmp_s.max_a[axis])
+                    tmp_s.max_a[axis] = lab_ap[axis];
+            }
+            point++;
+        }
+
+        /*
+         * Cell size of 1 to 2 cells per point on the bounds
+         * (most cells are out of the gamut), 1024 cells per axis
+         * at most, flat palettes (gray) are only 1 cell thick.
+         */
+        if (tmp_s.unique) {
+            float extent = 0.0f;
+
+            for (unsigned char axis = 0; axis < 3; axis++)
+                if (tmp_s.max_a[axis] - tmp_s.min_a[axis] > extent)
+                    extent = tmp_s.max_a[axis] - tmp_s.min_a[axis];
+            tmp_s.grid_s.cell = extent > 0.0f ? extent/cbrtf(tmp_s.unique) : 1.0f;
+
+            for (unsigned char round = 0; round < 1 << 7; round++) {
+                unsigned long long cells = 1;
+                unsigned long long dim = 0;
+
+                for (unsigned char axis = 0; axis < 3; axis++) {
+                    dim = (
+                        (tmp_s.max_a[axis] - tmp_s.min_a[axis])/tmp_s.grid_s.cell + 1
+                    );
+                    if (dim > 1 << 10)
+                        break;
+                    cells *= dim;
+                }
+
+                if (dim > 1 << 10 || cells > 2ull*tmp_s.unique + 1)
+                    tmp_s.grid_s.cell *= 1.1f;
+                else if (cells < tmp_s.unique && round < 1 << 6)
+                    tmp_s.grid_s.cell *= 0.9f;
+                else
+                    break;
+            }
+
+            for (unsigned char axis = 0; axis < 3; axis++) {
+                tmp_s.grid_s.origin_a[axis] = tmp_s.min_a[axis];
+                tmp_s.grid_s.dim_a[axis] = (
+                    (tmp_s.max_a[axis] - tmp_s.min_a[axis])/tmp_s.grid_s.cell + 1
+                );
+            }
+        } else {
+            tmp_s.grid_s.cell = 1.0f;
+            tmp_s.grid_s.dim_a[0] = 1;
+            tmp_s.grid_s.dim_a[1] = 1;
+            tmp_s.grid_s.dim_a[2] = 1;
+        }
+
+        /* Points sorted by cell (counting sort). */
+        tmp_s.cells = (
+            tmp_s.grid_s.dim_a[0] * tmp_s.grid_s.dim_a[1] * tmp_s.grid_s.dim_a[2]
+        );
+        tmp_s.grid_s.start_ap = calloc(tmp_s.cells + 1, sizeof(int));
+        tmp_s.cell_ap = malloc(sizeof(int) * tmp_s.unique + 1);
+        for (unsigned char axis = 0; axis < 3; axis++)
+            tmp_s.grid_s.axis_apa[axis] = malloc(sizeof(float) * tmp_s.unique + 1);
+        tmp_s.grid_s.repeat_ap = malloc(sizeof(char) * tmp_s.unique + 1);
+
+        for (unsigned int point = 0; point < tmp_s.unique; point++) {
+            unsigned int cell_a[3];
+
+            for (unsigned char axis = 0; axis < 3; axis++) {
+                cell_a[axis] = (
+                    (tmp_s.lab_ap[point*3 + axis] - tmp_s.grid_s.origin_a[axis])
+                      / tmp_s.grid_s.cell
+                );
+                if (cell_a[axis] >= tmp_s.grid_s.dim_a[axis])
+                    cell_a[axis] = tmp_s.grid_s.dim_a[axis] - 1;
+            }
+            tmp_s.cell_ap[point] = (
+                (cell_a[2]*tmp_s.grid_s.dim_a[1] + cell_a[1])
+                  * tmp_s.grid_s.dim_a[0] + cell_a[0]
+            );
+            tmp_s.grid_s.start_ap[tmp_s.cell_ap[point] + 1]++;
+        }
+        for (unsigned int cell = 0; cell < tmp_s.cells; cell++)
+            tmp_s.grid_s.start_ap[cell + 1] += tmp_s.grid_s.start_ap[cell];
+        for (unsigned int point = 0; point < tmp_s.unique; point++) {
+            unsigned int sorted = tmp_s.grid_s.start_ap[tmp_s.cell_ap[point]]++;
+
+            for (unsigned char axis = 0; axis < 3; axis++)
+                tmp_s.grid_s.axis_apa[axis][sorted] = tmp_s.lab_ap[point*3 + axis];
+            tmp_s.grid_s.repeat_ap[sorted] = tmp_s.repeat_ap[point];
+        }
+        for (unsigned int cell = tmp_s.cells; cell > 0; cell--)
+            tmp_s.grid_s.start_ap[cell] = tmp_s.grid_s.start_ap[cell - 1];
+        tmp_s.grid_s.start_ap[0] = 0;
+
+        /* Nearest neighbours and gamut samples by the threads. */
+        tmp_s.threads = self_sp->data_s.task_s.threads;
+        if (! tmp_s.threads)
+            tmp_s.threads = 1;
+        tmp_s.thread_ap = calloc(tmp_s.threads, sizeof(pthread_t));
+        tmp_s.analyse_ap = calloc(tmp_s.threads, sizeof(struct Analyse));
+
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            struct Analyse *analyse_sp = &tmp_s.analyse_ap[thread];
+
+            analyse_sp->grid_sp = &tmp_s.grid_s;
+            analyse_sp->linear_ap = tmp_s.linear_a;
+            analyse_sp->near_fp = &near_f;
+#if defined(__x86_64__) || defined(__i386__)
+            if (__builtin_cpu_supports("avx2"))
+                analyse_sp->near_fp = &near_avx2_f;
+#endif
+            /* Without neighbours, no entry is queried. */
+            if (tmp_s.count > 1) {
+                analyse_sp->start = (unsigned long long)tmp_s.unique*thread/tmp_s.threads;
+                analyse_sp->end = (
+                    (unsigned long long)tmp_s.unique*(thread + 1)/tmp_s.threads
+                );
+            }
+            if (tmp_s.count) {
+                analyse_sp->sample_a[0] = 33*33*33*thread/tmp_s.threads;
+                analyse_sp->sample_a[1] = 33*33*33*(thread + 1)/tmp_s.threads;
+            }
+
+            if (thread) {
+                analyse_sp->threaded = ! pthread_create(
+                    &tmp_s.thread_ap[thread],
+                    NULL,
+                    &analyse_work_f,
+                    analyse_sp
+                );
+                if (! analyse_sp->threaded)
+                    analyse_work_f(analyse_sp);
+            }
+        }
+        analyse_work_f(&tmp_s.analyse_ap[0]);
+
+        tmp_s.total_s.min = INFINITY;
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            struct Analyse *analyse_sp = &tmp_s.analyse_ap[thread];
+
+            if (analyse_sp->threaded)
+                pthread_join(tmp_s.thread_ap[thread], NULL);
+
+            if (analyse_sp->min < tmp_s.total_s.min)
+                tmp_s.total_s.min = analyse_sp->min;
+            if (analyse_sp->max > tmp_s.total_s.max)
+                tmp_s.total_s.max = analyse_sp->max;
+            if (analyse_sp->sample_max > tmp_s.total_s.sample_max)
+                tmp_s.total_s.sample_max = analyse_sp->sample_max;
+            tmp_s.total_s.sum += analyse_sp->sum;
+            tmp_s.total_s.sample_sum += analyse_sp->sample_sum;
+            tmp_s.total_s.covered += analyse_sp->covered;
+        }
+        if (tmp_s.count < 2 || tmp_s.unique < tmp_s.count)
+            tmp_s.total_s.min = 0.0f;
+
+        /* JSON report (distances on OKLab units, L is 0 to 1). */
+        fprintf(
+            output_lp,
+            "{\n"
+              "  \"entries\": %u,\n"
+              "  \"unique\": %u,\n"
+              "  \"duplicates\": %u,\n"
+              "  \"srgb\": %.6f,\n"
+              "  \"distance\": {\n"
+              "    \"space\": \"oklab\",\n"
+              "    \"min\": %.6f,\n"
+              "    \"mean\": %.6f,\n"
+              "    \"max\": %.6f\n"
+              "  },\n"
+              "  \"coverage\": {\n"
+              "    \"samples\": %u,\n"
+              "    \"jnd\": 0.02,\n"
+              "    \"covered\": %.6f,\n"
+              "    \"mean\": %.6f,\n"
+              "    \"max\": %.6f\n"
+              "  },\n"
+              "  \"bounds\": {\n"
+              "    \"l\": [%.6f, %.6f],\n"
+              "    \"a\": [%.6f, %.6f],\n"
+              "    \"b\": [%.6f, %.6f]\n"
+              "  },\n"
+              "  \"histogram\": {\n",
+            tmp_s.count,
+            tmp_s.unique,
+            tmp_s.count - tmp_s.unique,
+            tmp_s.unique/16777216.0,
+            tmp_s.total_s.min,
+            tmp_s.count > 1 ? tmp_s.total_s.sum/tmp_s.count : 0.0,
+            tmp_s.total_s.max,
+            tmp_s.count ? 33*33*33 : 0,
+            tmp_s.count ? tmp_s.total_s.covered/(33.0*33*33) : 0.0,
+            tmp_s.count ? tmp_s.total_s.sample_sum/(33*33*33) : 0.0,
+            tmp_s.total_s.sample_max,
+            tmp_s.count ? tmp_s.min_a[0] : 0.0f,
+            tmp_s.count ? tmp_s.max_a[0] : 0.0f,
+            tmp_s.count ? tmp_s.min_a[1] : 0.0f,
+            tmp_s.count ? tmp_s.max_a[1] : 0.0f,
+            tmp_s.count ? tmp_s.min_a[2] : 0.0f,
+            tmp_s.count ? tmp_s.max_a[2] : 0.0f
+        );
+
+        /* Red, green and blue (256 bins) and OKLab L (16 bins). */
+        for (unsigned char histogram = 0; histogram < 4; histogram++) {
+            const char *name_gpa[4] = {"red", "green", "blue", "lightness"};
+            unsigned short bins = histogram < 3 ? 1 << 8 : 16;
+
+            fprintf(output_lp, "    \"%s\": [", name_gpa[histogram]);
+            for (unsigned short bin = 0; bin < bins; bin++)
+                fprintf(
+                    output_lp,
+                    bin ? ", %u" : "%u",
+                    tmp_s.histogram_aa[histogram][bin]
+                );
+            fputs(histogram < 3 ? "],\n" : "]\n", output_lp);
+        }
+        fputs("  }\n}\n", output_lp);
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        self_sp->emit_free_mp(self_sp, tmp_s.head_gp);
+        for (unsigned char axis = 0; axis < 3; axis++)
+            free(tmp_s.grid_s.axis_apa[axis]);
+        free(tmp_s.grid_s.start_ap);
+        free(tmp_s.grid_s.repeat_ap);
+        free(tmp_s.cell_ap);
+        huge_free_f(tmp_s.rgb_ap);
+        free(tmp_s.lab_ap);
+        free(tmp_s.bitmap_apa[0]);
+        free(tmp_s.bitmap_apa[1]);
+        free(tmp_s.repeat_ap);
+        free(tmp_s.thread_ap);
+        free(tmp_s.analyse_ap);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    /*
+     * Palette reduction (reduce subcommand) to "colours" entries:
+     * k-means++ seeds on a sample of the entries, then mini-batch
+     * k-means on OKLab (a batch is assigned to the nearest centres,
+     * then each centre moves to its points at a rate of 1/points).
+     * The samples come from a generator of the seed and the centres
+     * move in batch order, so the result only depends on the seed
+     * (not on the threads or the distance kernel).
+     */
+    struct Reduce {
+        const float *centre_apa[3];
+        unsigned int centres;
+        unsigned int (*centre_fp)(const float *const [3], unsigned int, const float [3]);
+        const float *linear_ap;
+        const unsigned char *rgb_ap;
+        const unsigned int *batch_ap;
+        float *lab_ap;
+        unsigned int *label_ap;
+        unsigned int start;
+        unsigned int end;
+        /* Without a thread, the slice is done by the calling thread. */
+        unsigned char threaded: 1;
+    };
+
+    unsigned int
+    centre_f(const float *const centre_apa[3], unsigned int centres, const float query_a[3]) {
+        /*
+         * Nearest centre (the first one on equal distances).
+         * Keep the same operations (and order) of the AVX2 version.
+         */
+        float best = INFINITY;
+        unsigned int nearest = 0;
+
+        for (unsigned int centre = 0; centre < centres; centre++) {
+            float l = centre_apa[0][centre] - query_a[0];
+            float a = centre_apa[1][centre] - query_a[1];
+            float b = centre_apa[2][centre] - query_a[2];
+            float distance = l*l + a*a + b*b;
+
+            if (distance < best) {
+                best = distance;
+                nearest = centre;
+            }
+        }
+
+        return nearest;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("avx2")))
+    unsigned int
+    centre_avx2_f(
+        const float *const centre_apa[3],
+        unsigned int centres,
+        const float query_a[3]
+    ) {
+        const __m256 l = _mm256_set1_ps(query_a[0]);
+        const __m256 a = _mm256_set1_ps(query_a[1]);
+        const __m256 b = _mm256_set1_ps(query_a[2]);
+        const __m256 infinity = _mm256_set1_ps(INFINITY);
+        __m256i index_v = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i nearest_v = _mm256_setzero_si256();
+        __m256 best_v = infinity;
+        float best_a[8];
+        unsigned int nearest_a[8];
+        float best = INFINITY;
+        unsigned int nearest = 0;
+
+        /*
+         * Each lane keeps its first nearest centre,
+         * the remainder is masked (out of range lanes are infinite).
+         */
+        for (unsigned int centre = 0; centre < centres; centre += 8) {
+            __m256i mask = _mm256_cmpgt_epi32(
+                _mm256_set1_epi32(centres - centre),
+                _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+            );
+            __m256 dl = _mm256_sub_ps(_mm256_maskload_ps(&centre_apa[0][centre], mask), l);
+            __m256 da = _mm256_sub_ps(_mm256_maskload_ps(&centre_apa[1][centre], mask), a);
+            __m256 db = _mm256_sub_ps(_mm256_maskload_ps(&centre_apa[2][centre], mask), b);
+            __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(dl, dl), _mm256_mul_ps(da, da)),
+                _mm256_mul_ps(db, db)
+            );
+            __m256 less;
+
+            distance = _mm256_blendv_ps(infinity, distance, _mm256_castsi256_ps(mask));
+            less = _mm256_cmp_ps(distance, best_v, _CMP_LT_OQ);
+            best_v = _mm256_blendv_ps(best_v, distance, less);
+            nearest_v = _mm256_castps_si256(
+                _mm256_blendv_ps(
+                    _mm256_castsi256_ps(nearest_v),
+                    _mm256_castsi256_ps(index_v),
+                    less
+                )
+            );
+            index_v = _mm256_add_epi32(index_v, _mm256_set1_epi32(8));
+        }
+
+        /* Nearest of the lanes, the first centre on equal distances. */
+        _mm256_storeu_ps(best_a, best_v);
+        _mm256_storeu_si256((__m256i *)nearest_a, nearest_v);
+        for (unsigned char lane = 0; lane < 8; lane++)
+            if (best_a[lane] < best
+                  || (best_a[lane] == best && nearest_a[lane] < nearest)) {
+                best = best_a[lane];
+                nearest = nearest_a[lane];
+            }
+
+        return nearest;
+    }
+#endif
+
+    unsigned long long
+    reduce_rand_f(unsigned long long *state_p) {
+        /* SplitMix64 generator. */
+        unsigned long long value = (*state_p += 0x9e3779b97f4a7c15ull);
+
+        value = (value ^ value >> 30) * 0xbf58476d1ce4e5b9ull;
+        value = (value ^ value >> 27) * 0x94d049bb133111ebull;
+
+        return value ^ value >> 31;
+    }
+
+    void *
+    reduce_work_f(void *reduce_vp) {
+        struct Reduce *reduce_sp = reduce_vp;
+
+        for (unsigned int point = reduce_sp->start; point < reduce_sp->end; point++) {
+            float *lab_ap = &reduce_sp->lab_ap[point*3];
+
+            oklab_f(
+                reduce_sp->linear_ap,
+                &reduce_sp->rgb_ap[(unsigned long long)reduce_sp->batch_ap[point]*3],
+                lab_ap
+            );
+            reduce_sp->label_ap[point] = reduce_sp->centre_fp(
+                reduce_sp->centre_apa,
+                reduce_sp->centres,
+                lab_ap
+            );
+        }
+
+        return NULL;
+    }
+
+    unsigned int
+    reduce_lgen_f(
+        struct Self *self_sp,
+        const unsigned char *rgb_ap,
+        unsigned int count,
+        unsigned int centres,
+        unsigned char *colour_ap,
+        unsigned int (*centre_fp)(const float *const [3], unsigned int, const float [3])
+    ) {
+        /*
+         * Reduce the count entries of rgb_ap to centres colours
+         * (colour_ap), less if the entries have less colours.
+         * Returns the number of colours.
+         */
+        const unsigned int batch = 1 << 12;
+        const unsigned char passes = 1 << 7;
+        struct {
+            unsigned long long state;
+            float linear_a[1 << 8];
+            unsigned int samples;
+            unsigned int *batch_ap;
+            float *lab_ap;
+            unsigned int *label_ap;
+            float *distance_ap;
+            float *centre_apa[3];
+            unsigned int *seen_ap;
+            unsigned int chosen;
+            double sum;
+            unsigned short threads;
+            pthread_t *thread_ap;
+            struct Reduce *reduce_ap;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        if (! count || ! centres)
+            return 0;
+
+        tmp_s.state = self_sp->data_s.reduce_s.seed;
+        for (unsigned short value = 0; value < 1 << 8; value++) {
+            double channel = value/255.0;
+
+            tmp_s.linear_a[value] = (
+                channel <= 0.04045
+                  ? channel/12.92
+                  : pow((channel + 0.055)/1.055, 2.4)
+            );
+        }
+
+        /*
+         * Sample of the seeds: all entries of the small palettes
+         * (so their colours are found again), else random entries.
+         */
+        tmp_s.samples = centres*4 > 1 << 14 ? centres*4 : 1 << 14;
+        if (tmp_s.samples > count)
+            tmp_s.samples = count;
+        tmp_s.batch_ap = malloc(
+            sizeof(int) * (tmp_s.samples > batch ? tmp_s.samples : batch)
+        );
+        tmp_s.lab_ap = malloc(
+            sizeof(float) * (tmp_s.samples > batch ? tmp_s.samples : batch)*3
+        );
+        tmp_s.label_ap = malloc(sizeof(int) * batch);
+        tmp_s.distance_ap = malloc(sizeof(float) * tmp_s.samples);
+        for (unsigned char axis = 0; axis < 3; axis++)
+            tmp_s.centre_apa[axis] = malloc(sizeof(float) * centres);
+        tmp_s.seen_ap = calloc(centres, sizeof(int));
+
+        for (unsigned int sample = 0; sample < tmp_s.samples; sample++) {
+            tmp_s.batch_ap[sample] = (
+                tmp_s.samples == count
+                  ? sample
+                  : (reduce_rand_f(&tmp_s.state) >> 32)*count >> 32
+            );
+            oklab_f(
+                tmp_s.linear_a,
+                &rgb_ap[(unsigned long long)tmp_s.batch_ap[sample]*3],
+                &tmp_s.lab_ap[sample*3]
+            );
+            tmp_s.distance_ap[sample] = INFINITY;
+        }
+
+        /*
+         * k-means++ seeds: the next seed is a sample at random,
+         * weighted by its squared distance to the nearest seed
+         * (0 when all samples are seeds).
+         */
+        for (unsigned int sample = reduce_rand_f(&tmp_s.state) % tmp_s.samples;
+              tmp_s.chosen < centres;
+              ) {
+            double target;
+
+            for (unsigned char axis = 0; axis < 3; axis++)
+                tmp_s.centre_apa[axis][tmp_s.chosen] = tmp_s.lab_ap[sample*3 + axis];
+            tmp_s.chosen++;
+
+            tmp_s.sum = 0.0;
+            for (unsigned int point = 0; point < tmp_s.samples; point++) {
+                float l = tmp_s.lab_ap[point*3] - tmp_s.lab_ap[sample*3];
+                float a = tmp_s.lab_ap[point*3 + 1] - tmp_s.lab_ap[sample*3 + 1];
+                float b = tmp_s.lab_ap[point*3 + 2] - tmp_s.lab_ap[sample*3 + 2];
+                float distance = l*l + a*a + b*b;
+
+                if (distance < tmp_s.distance_ap[point])
+                    tmp_s.distance_ap[point] = distance;
+                tmp_s.sum += tmp_s.distance_ap[point];
+            }
+            if (tmp_s.sum <= 0.0)
+                break;
+
+            target = (reduce_rand_f(&tmp_s.state) >> 11)*0x1.0p-53*tmp_s.sum;
+            for (sample = 0; sample < tmp_s.samples - 1; sample++) {
+                target -= tmp_s.distance_ap[sample];
+                if (target < 0.0 && tmp_s.distance_ap[sample] > 0.0f)
+                    break;
+            }
+            /* Rounding at the end of the sum, the last seedless sample. */
+            while (tmp_s.distance_ap[sample] <= 0.0f)
+                sample--;
+        }
+
+        /* Mini-batches, assigned by the threads. */
+        tmp_s.threads = self_sp->data_s.task_s.threads;
+        if (! tmp_s.threads)
+            tmp_s.threads = 1;
+        if (tmp_s.threads > batch >> 8)
+            tmp_s.threads = batch >> 8;
+        tmp_s.thread_ap = calloc(tmp_s.threads, sizeof(pthread_t));
+        tmp_s.reduce_ap = calloc(tmp_s.threads, sizeof(struct Reduce));
+
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++) {
+            struct Reduce *reduce_sp = &tmp_s.reduce_ap[thread];
+
+            for (unsigned char axis = 0; axis < 3; axis++)
+                reduce_sp->centre_apa[axis] = tmp_s.centre_apa[axis];
+            reduce_sp->centres = tmp_s.chosen;
+            reduce_sp->centre_fp = centre_fp;
+            reduce_sp->linear_ap = tmp_s.linear_a;
+            reduce_sp->rgb_ap = rgb_ap;
+            reduce_sp->batch_ap = tmp_s.batch_ap;
+            reduce_sp->lab_ap = tmp_s.lab_ap;
+            reduce_sp->label_ap = tmp_s.label_ap;
+            reduce_sp->start = batch*thread/tmp_s.threads;
+            reduce_sp->end = batch*(thread + 1)/tmp_s.threads;
+        }
+
+        /* The seeds are all colours of the entries, nothing to move. */
+        if (tmp_s.samples == count && tmp_s.sum <= 0.0)
+            tmp_s.threads = 0;
+
+        for (unsigned char pass = 0; pass < passes && tmp_s.threads; pass++) {
+            for (unsigned int point = 0; point < batch; point++)
+                tmp_s.batch_ap[point] = (reduce_rand_f(&tmp_s.state) >> 32)*count >> 32;
+
+            for (unsigned short thread = 1; thread < tmp_s.threads; thread++) {
+                tmp_s.reduce_ap[thread].threaded = ! pthread_create(
+                    &tmp_s.thread_ap[thread],
+                    NULL,
+                    &reduce_work_f,
+                    &tmp_s.reduce_ap[thread]
+                );
+                if (! tmp_s.reduce_ap[thread].threaded)
+                    reduce_work_f(&tmp_s.reduce_ap[thread]);
+            }
+            reduce_work_f(&tmp_s.reduce_ap[0]);
+            for (unsigned short thread = 1; thread < tmp_s.threads; thread++)
+                if (tmp_s.reduce_ap[thread].threaded)
+                    pthread_join(tmp_s.thread_ap[thread], NULL);
+
+            /* Move the centres, in batch order. */
+            for (unsigned int point = 0; point < batch; point++) {
+                unsigned int centre = tmp_s.label_ap[point];
+                float rate = 1.0f/++tmp_s.seen_ap[centre];
+
+                for (unsigned char axis = 0; axis < 3; axis++)
+                    tmp_s.centre_apa[axis][centre] += (
+                        (tmp_s.lab_ap[point*3 + axis] - tmp_s.centre_apa[axis][centre])
+                          * rate
+                    );
+            }
+        }
+
+        /* Back to 8 bits sRGB. */
+        srgb_table_f(self_sp);
+        space_conv_f(
+            SPACE_OKLAB,
+            tmp_s.centre_apa[0],
+            tmp_s.centre_apa[1],
+            tmp_s.centre_apa[2],
+            colour_ap,
+            tmp_s.chosen,
+            self_sp->table_s.srgb_a
+        );
+        centres = tmp_s.chosen;
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        free(tmp_s.batch_ap);
+        free(tmp_s.lab_ap);
+        free(tmp_s.label_ap);
+        free(tmp_s.distance_ap);
+        for (unsigned char axis = 0; axis < 3; axis++)
+            free(tmp_s.centre_apa[axis]);
+        free(tmp_s.seen_ap);
+        free(tmp_s.thread_ap);
+        free(tmp_s.reduce_ap);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+
+        return centres;
+    }
+
+    void
+    reduce_f(struct Self *self_sp, FILE *output_lp) {
+        struct {
+            char *head_gp;
+            unsigned int count;
+            unsigned char *rgb_ap;
+            unsigned int centres;
+            char *record_gp;
+            unsigned int (*centre_fp)(
+                const float *const [3],
+                unsigned int,
+                const float [3]
+            );
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        /* The entries as raw colours (ACT records), see render_f(). */
+        self_sp->emit_s.format = FORMAT_HEX;
+        self_sp->src_lgen_mp(self_sp);
+
+        /*
+         * GPL columns of a square swatch grid,
+         * if the config has not them
+         * (after src_lgen_f(), the columns of a gpl source are not kept).
+         */
+        if (! (self_sp->data_s.pmap_s.configured & 2)) {
+            self_sp->data_s.pmap_s.columns = 1;
+            while (self_sp->data_s.pmap_s.columns < (1 << 8) - 1
+                  && (unsigned int)self_sp->data_s.pmap_s.columns
+                    * self_sp->data_s.pmap_s.columns
+                    < self_sp->data_s.image_s.colours)
+                self_sp->data_s.pmap_s.columns++;
+        }
+
+        self_sp->emit_s.format = FORMAT_GPL;
+        tmp_s.head_gp = self_sp->head_lgen_mp(self_sp);
+        self_sp->emit_s.format = FORMAT_ACT;
+        self_sp->emit_s.recordl = 3;
+
+        tmp_s.count = self_sp->emit_s.end - self_sp->emit_s.start;
+        tmp_s.rgb_ap = huge_alloc_f(
+            sizeof(char) * tmp_s.count*3 + 1,
+            self_sp->data_s.task_s.pages
+        );
+        fmt_f(self_sp, (char *)tmp_s.rgb_ap, self_sp->emit_s.start, tmp_s.count);
+
+        tmp_s.centre_fp = &centre_f;
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx2"))
+            tmp_s.centre_fp = &centre_avx2_f;
+#endif
+
+        /* The reduced colours are the entries of the output. */
+        free(self_sp->emit_s.colour_ap);
+        free(self_sp->emit_s.name_gp);
+        free(self_sp->emit_s.name_ap);
+        self_sp->emit_s.name_gp = NULL;
+        self_sp->emit_s.name_ap = NULL;
+        self_sp->emit_s.colour_ap = malloc(
+            sizeof(char) * self_sp->data_s.image_s.colours*3 + 1
+        );
+        tmp_s.centres = reduce_lgen_f(
+            self_sp,
+            tmp_s.rgb_ap,
+            tmp_s.count,
+            self_sp->data_s.image_s.colours,
+            self_sp->emit_s.colour_ap,
+            tmp_s.centre_fp
+        );
+
+        self_sp->emit_s.format = FORMAT_GPL;
+        self_sp->emit_s.names = NAMES_NONE;
+        self_sp->emit_s.recordl = 14;
+        self_sp->emit_s.start = 0;
+        self_sp->emit_s.end = tmp_s.centres;
+        self_sp->emit_s.count = tmp_s.centres;
+
+        /* Sort stage (see src_lgen_f()). */
+        if (self_sp->data_s.sort_s.sort != SORT_NONE && tmp_s.centres > 1)
+            self_sp->sort_mp(self_sp);
+
+        tmp_s.record_gp = malloc(sizeof(char) * tmp_s.centres*14 + 1);
+        fwrite(tmp_s.head_gp, sizeof(char), self_sp->emit_s.headl, output_lp);
+        fwrite(
+            tmp_s.record_gp,
+            sizeof(char),
+            fmt_f(self_sp, tmp_s.record_gp, 0, tmp_s.centres),
+            output_lp
+        );
+        fputc('\0', output_lp);
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        self_sp->emit_free_mp(self_sp, tmp_s.head_gp);
+        huge_free_f(tmp_s.rgb_ap);
+        free(tmp_s.record_gp);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    void
+    finput_f(struct Self *self_sp, FILE *input_lp) {
+        struct {
+            char character;
+            unsigned char keyl: 3;
+            char key_g[8];
+            unsigned char valuel;
+            char value_g[1 << 8];
+            /* 0 is a key type and 1 is a value type. */
+            unsigned char type: 1;
+            /* 1 to ignore characters. */
+            unsigned char ignore: 1;
+        } buffer_s;
+        memset(&buffer_s, '\0', sizeof(buffer_s));
+
+        while (! feof(input_lp)) {
+            if (! buffer_s.type) {
+                if (buffer_s.keyl < 7) {
+                    if (! buffer_s.ignore) {
+                        buffer_s.key_g[buffer_s.keyl] = fgetc(input_lp);
+
+                        switch (buffer_s.key_g[buffer_s.keyl]) {
+                            case ' ':
+                                buffer_s.key_g[buffer_s.keyl] = '\0';
+                                buffer_s.keyl = 7;
+                                break;
+                            case '\r':
+                            case '\n':
+                                memset(
+                                    buffer_s.key_g,
+                                    '\0',
+                                    sizeof(buffer_s.key_g)
+                                );
+                                buffer_s.keyl = 0;
+                                break;
+                            case '\xff':
+                                buffer_s.key_g[buffer_s.keyl] = '\0';
+                                break;
+                            default:
+                                if (buffer_s.keyl == 6)
+                                    buffer_s.character = '=';
+
+                                buffer_s.keyl = ++buffer_s.keyl;
+                        }
+                    } else {
+                        buffer_s.character = fgetc(input_lp);
+
+                        switch (buffer_s.character) {
+                            case '\r':
+                            case '\n':
+                                buffer_s.character = '\0';
+                                buffer_s.ignore = FALSE;
+                                break;
+                        }
+                    }
+                } else {
+                    buffer_s.key_g[buffer_s.keyl] = '\0';
+
+                    if (strcmp(buffer_s.key_g, "type") == 0
+                          || strcmp(buffer_s.key_g, "depth") == 0
+                          || strcmp(buffer_s.key_g, "columns") == 0
+                          || strcmp(buffer_s.key_g, "title") == 0
+                          || strcmp(buffer_s.key_g, "author") == 0
+                          || strcmp(buffer_s.key_g, "years") == 0
+                          || strcmp(buffer_s.key_g, "image") == 0
+                          || strcmp(buffer_s.key_g, "colours") == 0
+                          || strcmp(buffer_s.key_g, "threads") == 0
+                          || strcmp(buffer_s.key_g, "dedup") == 0
+                          || strcmp(buffer_s.key_g, "ramp") == 0
+                          || strcmp(buffer_s.key_g, "levels") == 0
+                          || strcmp(buffer_s.key_g, "rlevels") == 0
+                          || strcmp(buffer_s.key_g, "glevels") == 0
+                          || strcmp(buffer_s.key_g, "blevels") == 0
+                          || strcmp(buffer_s.key_g, "format") == 0
+                          || strcmp(buffer_s.key_g, "slice") == 0
+                          || strcmp(buffer_s.key_g, "names") == 0
+                          || strcmp(buffer_s.key_g, "palette") == 0
+                          || strcmp(buffer_s.key_g, "sort") == 0
+                          || strcmp(buffer_s.key_g, "index") == 0
+                          || strcmp(buffer_s.key_g, "cell") == 0
+                          || strcmp(buffer_s.key_g, "resume") == 0
+                          || strcmp(buffer_s.key_g, "cvd") == 0
+                          || strcmp(buffer_s.key_g, "stops") == 0
+                          || strcmp(buffer_s.key_g, "steps") == 0
+                          || strcmp(buffer_s.key_g, "blend") == 0
+                          || strcmp(buffer_s.key_g, "seed") == 0
+                          || strcmp(buffer_s.key_g, "pages") == 0) {
+                        /* Set as value type. */
+                        buffer_s.type = TRUE;
+                    } else {
+                        memset(buffer_s.key_g, '\0', sizeof(buffer_s.key_g));
+                        buffer_s.keyl = 0;
+                        buffer_s.ignore = TRUE;
+                    }
+                }
+            } else {
+                if (buffer_s.valuel < (1 << 8)-1) {
+                    if (! buffer_s.ignore) {
+                        buffer_s.value_g[buffer_s.valuel] = fgetc(input_lp);
+
+                        switch(buffer_s.value_g[buffer_s.valuel]) {
+                            case '=':
+                                buffer_s.character = '=';
+                                buffer_s.value_g[buffer_s.valuel] = '\0';
+                                break;
+                            case ' ':
+                                if (buffer_s.character == '=') {
+                                    buffer_s.character = '\0';
+                                    buffer_s.value_g[buffer_s.valuel] = '\0';
+                                } else
+                                    buffer_s.valuel = ++buffer_s.valuel;
+
+                                break;
+                            case '\r':
+                            case '\n':
+                                buffer_s.value_g[buffer_s.valuel] = '\0';
+                                buffer_s.valuel = (1 << 8) - 1;
+                                buffer_s.value_g[buffer_s.valuel] = '\0';
+                                break;
+                            case '\xff':
+                                buffer_s.value_g[buffer_s.valuel] = '\0';
+                                break;
+                            default:
+                                if (buffer_s.valuel == (1 << 8) - 2)
+                                    buffer_s.character = '!';
+
+                                buffer_s.valuel = ++buffer_s.valuel;
+                        }
+                    }
+                } else {
+                    buffer_s.value_g[buffer_s.valuel] = '\0';
+
+                    if (buffer_s.character == '!') {
+                        buffer_s.character = '\0';
+                        buffer_s.ignore = TRUE;
+                    }
+
+                    if (! buffer_s.ignore) {
+
+                        if (strcmp(buffer_s.key_g, "type") == 0) {
+                            strcpy(self_sp->input_s.type_g, buffer_s.value_g);
+                            //self_sp->input_s.typel = buffer_s.valuel;
+                            self_sp->input_s.typel = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "depth") == 0) {
+                            strcpy(self_sp->input_s.depth_g, buffer_s.value_g);
+                            //self_sp->input_s.depthl = buffer_s.valuel;
+                            self_sp->input_s.depthl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "columns") == 0) {
+                            strcpy(self_sp->input_s.columns_g, buffer_s.value_g);
+                            //self_sp->input_s.columnsl = buffer_s.valuel;
+                            self_sp->input_s.columnsl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "title") == 0) {
+                            strcpy(self_sp->input_s.title_g, buffer_s.value_g);
+                            //self_sp->input_s.titlel = buffer_s.valuel;
+                            self_sp->input_s.titlel = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "author") == 0) {
+                            strcpy(self_sp->input_s.author_g, buffer_s.value_g);
+                            //self_sp->input_s.authorl = buffer_s.valuel;
+                            self_sp->input_s.authorl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "years") == 0) {
+                            strcpy(self_sp->input_s.years_g, buffer_s.value_g);
+                            //self_sp->input_s.yearsl = buffer_s.valuel;
+                            self_sp->input_s.yearsl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "image") == 0) {
+                            strcpy(self_sp->input_s.image_g, buffer_s.value_g);
+                            self_sp->input_s.imagel = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "colours") == 0) {
+                            strcpy(self_sp->input_s.colours_g, buffer_s.value_g);
+                            self_sp->input_s.coloursl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "threads") == 0) {
+                            strcpy(self_sp->input_s.threads_g, buffer_s.value_g);
+                            self_sp->input_s.threadsl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "dedup") == 0) {
+                            strcpy(self_sp->input_s.dedup_g, buffer_s.value_g);
+                            self_sp->input_s.dedupl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "ramp") == 0) {
+                            strcpy(self_sp->input_s.ramp_g, buffer_s.value_g);
+                            self_sp->input_s.rampl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "levels") == 0) {
+                            strcpy(self_sp->input_s.levels_g, buffer_s.value_g);
+                            self_sp->input_s.levelsl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "rlevels") == 0) {
+                            strcpy(self_sp->input_s.rlevels_g, buffer_s.value_g);
+                            self_sp->input_s.rlevelsl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "glevels") == 0) {
+                            strcpy(self_sp->input_s.glevels_g, buffer_s.value_g);
+                            self_sp->input_s.glevelsl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "blevels") == 0) {
+                            strcpy(self_sp->input_s.blevels_g, buffer_s.value_g);
+                            self_sp->input_s.blevelsl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "format") == 0) {
+                            strcpy(self_sp->input_s.format_g, buffer_s.value_g);
+                            self_sp->input_s.formatl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "slice") == 0) {
+                            strcpy(self_sp->input_s.slice_g, buffer_s.value_g);
+                            self_sp->input_s.slicel = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "names") == 0) {
+                            strcpy(self_sp->input_s.names_g, buffer_s.value_g);
+                            self_sp->input_s.namesl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "palette") == 0) {
+                            strcpy(self_sp->input_s.palette_g, buffer_s.value_g);
+                            self_sp->input_s.palettel = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "sort") == 0) {
+                            strcpy(self_sp->input_s.sort_g, buffer_s.value_g);
+                            self_sp->input_s.sortl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "index") == 0) {
+                            strcpy(self_sp->input_s.index_g, buffer_s.value_g);
+                            self_sp->input_s.indexl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "cell") == 0) {
+                            strcpy(self_sp->input_s.cell_g, buffer_s.value_g);
+                            self_sp->input_s.celll = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "resume") == 0) {
+                            strcpy(self_sp->input_s.resume_g, buffer_s.value_g);
+                            self_sp->input_s.resumel = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "cvd") == 0) {
+                            strcpy(self_sp->input_s.cvd_g, buffer_s.value_g);
+                            self_sp->input_s.cvdl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "stops") == 0) {
+                            strcpy(self_sp->input_s.stops_g, buffer_s.value_g);
+                            self_sp->input_s.stopsl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "steps") == 0) {
+                            strcpy(self_sp->input_s.steps_g, buffer_s.value_g);
+                            self_sp->input_s.stepsl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "blend") == 0) {
+                            strcpy(self_sp->input_s.blend_g, buffer_s.value_g);
+                            self_sp->input_s.blendl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "seed") == 0) {
+                            strcpy(self_sp->input_s.seed_g, buffer_s.value_g);
+                            self_sp->input_s.seedl = strlen(buffer_s.value_g) + 1;
+                        } else if (strcmp(buffer_s.key_g, "pages") == 0) {
+                            strcpy(self_sp->input_s.pages_g, buffer_s.value_g);
+                            self_sp->input_s.pagesl = strlen(buffer_s.value_g) + 1;
+                        }
+
+                        memset(
+                            buffer_s.key_g,
+                            '\0',
+                            sizeof(buffer_s.key_g)
+                        );
+                        buffer_s.keyl = 0;
+                        memset(
+                            buffer_s.value_g,
+                            '\0',
+                            sizeof(buffer_s.value_g)
+                        );
+                        buffer_s.valuel = 0;
+                        /* Set as key type. */
+                        buffer_s.type = FALSE;
+                    } else {
+                        buffer_s.character = fgetc(input_lp);
+
+                        switch(buffer_s.character) {
+                            case '\r':
+                            case '\n':
+                                buffer_s.character = '\0';
+                                buffer_s.ignore = FALSE;
+                                break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /*
+     * Page counters of the process (bench and server stats):
+     * page faults of getrusage() and dTLB load misses of a perf
+     * counter on this process and its next threads (-1 without it,
+     * as on perf_event_paranoid > 2 or without the event).
+     */
+    int
+    dtlb_open_f(void) {
+        struct perf_event_attr attr_s;
+
+        memset(&attr_s, 0, sizeof(attr_s));
+        attr_s.size = sizeof(attr_s);
+        attr_s.type = PERF_TYPE_HW_CACHE;
+        attr_s.config = (
+            PERF_COUNT_HW_CACHE_DTLB
+              | PERF_COUNT_HW_CACHE_OP_READ << 8
+              | PERF_COUNT_HW_CACHE_RESULT_MISS << 16
+        );
+        attr_s.inherit = 1;
+        attr_s.exclude_kernel = 1;
+        attr_s.exclude_hv = 1;
+
+        return syscall(SYS_perf_event_open, &attr_s, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+
+    long long
+    dtlb_f(int dtlb) {
+        long long misses = -1;
+
+        if (dtlb < 0 || read(dtlb, &misses, sizeof(misses)) != sizeof(misses))
+            return -1;
+
+        return misses;
+    }
+
+    long
+    faults_f(void) {
+        /* Minor and major page faults. */
+        struct rusage usage_s;
+
+        getrusage(RUSAGE_SELF, &usage_s);
+        return usage_s.ru_minflt + usage_s.ru_majflt;
+    }
+
+    double
+    bench_time_f(void) {
+        struct timespec time_s;
+
+        clock_gettime(CLOCK_MONOTONIC, &time_s);
+        return time_s.tv_sec*1000.0 + time_s.tv_nsec/1000000.0;
+    }
+
+    void
+    bench_f(struct Self *self_sp, int argc, char *arg_gap[]) {
+        /*
+         * Benchmark cases, all cases without arguments.
+         * Each case prints the best time of some runs.
+         */
+        struct {
+            unsigned char runs;
+            double start;
+            double best;
+        } tmp_s = {
+            5,
+            0,
+            0
+        };
+
+        unsigned char
+        bench_case_f(const char *case_gp) {
+            if (argc < 1)
+                return TRUE;
+
+            for (int index = 0; index < argc; index++)
+                if (strcmp(arg_gap[index], case_gp) == 0)
+                    return TRUE;
+
+            return FALSE;
+        }
+
+        void
+        bench_print_f(
+            const char *case_gp,
+            const char *variant_gp,
+            unsigned long long entries
+        ) {
+            printf(
+                "%-8s %-16s %10llu entries %10.3f ms %10.1f Mentries/s\n",
+                case_gp,
+                variant_gp,
+                entries,
+                tmp_s.best,
+                entries/tmp_s.best/1000.0
+            );
+        }
+
+        /* Colour space conversion of a million entries grid. */
+        if (bench_case_f("space")) {
+            const unsigned int entries = 1 << 20;
+            const char *space_gpa[3] = {"hsv", "hsl", "oklab"};
+            float *x_ap = malloc(sizeof(float) * entries);
+            float *y_ap = malloc(sizeof(float) * entries);
+            float *z_ap = malloc(sizeof(float) * entries);
+            unsigned char *rgb_ap = malloc(sizeof(char) * entries*3);
+
+            /* Fill the sRGB table. */
+            free(self_sp->space_lgen_mp(self_sp, SPACE_OKLAB));
+
+            for (unsigned char space = 0; space < 3; space++) {
+                for (unsigned int index = 0; index < entries; index++) {
+                    x_ap[index] = (index & 0xff)/256.0f;
+                    y_ap[index] = (index >> 8 & 0xff)/255.0f;
+                    z_ap[index] = (index >> 16)/15.0f;
+
+                    if (space == SPACE_OKLAB) {
+                        y_ap[index] = -0.234f + 0.510f*y_ap[index];
+                        z_ap[index] = -0.312f + 0.511f*z_ap[index];
+                    }
+                }
+
+                for (unsigned char variant = 0; variant < 2; variant++) {
+                    void (*conv_fp)(
+                        unsigned char,
+                        const float *,
+                        const float *,
+                        const float *,
+                        unsigned char *,
+                        unsigned int,
+                        const unsigned char *
+                    ) = &space_conv_f;
+
+#if defined(__x86_64__) || defined(__i386__)
+                    if (variant && __builtin_cpu_supports("avx2"))
+                        conv_fp = &space_conv_avx2_f;
+                    else if (variant)
+                        continue;
+#else
+                    if (variant)
+                        continue;
+#endif
+
+                    tmp_s.best = 0;
+                    for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                        tmp_s.start = bench_time_f();
+                        conv_fp(
+                            space,
+                            x_ap,
+                            y_ap,
+                            z_ap,
+                            rgb_ap,
+                            entries,
+                            self_sp->table_s.srgb_a
+                        );
+                        tmp_s.start = bench_time_f() - tmp_s.start;
+
+                        if (! run || tmp_s.start < tmp_s.best)
+                            tmp_s.best = tmp_s.start;
+                    }
+
+                    bench_print_f(
+                        space_gpa[space],
+                        variant ? "avx2" : "scalar",
+                        entries
+                    );
+                }
+            }
+
+            free(x_ap);
+            free(y_ap);
+            free(z_ap);
+            free(rgb_ap);
+        }
+
+        /* Colour vision deficiency simulation of a million entries. */
+        if (bench_case_f("cvd")) {
+            const unsigned int entries = 1 << 20;
+            float *channel_apa[3];
+            unsigned char *rgb_apa[3];
+
+            srgb_table_f(self_sp);
+            for (unsigned char channel = 0; channel < 3; channel++) {
+                channel_apa[channel] = malloc(sizeof(float) * entries);
+                rgb_apa[channel] = malloc(sizeof(char) * entries*3);
+
+                for (unsigned int index = 0; index < entries; index++)
+                    channel_apa[channel][index] = (
+                        (index >> channel*7 & 0x7f)/127.0f
+                    );
+            }
+
+            for (unsigned char variant = 0; variant < 2; variant++) {
+                void (*conv_fp)(
+                    const float *,
+                    const float *,
+                    const float *,
+                    unsigned char *[3],
+                    unsigned int,
+                    const unsigned char *
+                ) = &cvd_conv_f;
+
+#if defined(__x86_64__) || defined(__i386__)
+                if (variant && __builtin_cpu_supports("avx2"))
+                    conv_fp = &cvd_conv_avx2_f;
+                else if (variant)
+                    continue;
+#else
+                if (variant)
+                    continue;
+#endif
+
+                tmp_s.best = 0;
+                for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                    tmp_s.start = bench_time_f();
+                    conv_fp(
+                        channel_apa[0],
+                        channel_apa[1],
+                        channel_apa[2],
+                        rgb_apa,
+                        entries,
+                        self_sp->table_s.srgb_a
+                    );
+                    tmp_s.start = bench_time_f() - tmp_s.start;
+
+                    if (! run || tmp_s.start < tmp_s.best)
+                        tmp_s.best = tmp_s.start;
+                }
+
+                bench_print_f("cvd", variant ? "avx2" : "scalar", entries);
+            }
+
+            for (unsigned char channel = 0; channel < 3; channel++) {
+                free(channel_apa[channel]);
+                free(rgb_apa[channel]);
+            }
+        }
+
+        /* Gradient of a million steps (8 stops) in each blend space. */
+        if (bench_case_f("gradient")) {
+            const char *blend_gpa[] = {"srgb", "linear", "oklab"};
+            const unsigned int entries = 1 << 20;
+            unsigned int steps = self_sp->data_s.gradient_s.steps;
+            unsigned char stopl = self_sp->data_s.gradient_s.stopl;
+            unsigned char blend = self_sp->data_s.gradient_s.blend;
+
+            self_sp->data_s.gradient_s.steps = entries;
+            self_sp->data_s.gradient_s.stopl = 8;
+            for (unsigned char stop = 0; stop < 8; stop++)
+                for (unsigned char channel = 0; channel < 3; channel++)
+                    self_sp->data_s.gradient_s.stop_aa[stop][channel] = (
+                        stop >> channel & 1 ? 0xff : stop*0x20
+                    );
+
+            for (unsigned char space = BLEND_SRGB; space <= BLEND_OKLAB; space++) {
+                self_sp->data_s.gradient_s.blend = space;
+
+                tmp_s.best = 0;
+                for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                    tmp_s.start = bench_time_f();
+                    free(self_sp->gradient_lgen_mp(self_sp));
+                    tmp_s.start = bench_time_f() - tmp_s.start;
+
+                    if (! run || tmp_s.start < tmp_s.best)
+                        tmp_s.best = tmp_s.start;
+                }
+
+                bench_print_f("gradient", blend_gpa[space], entries);
+            }
+
+            self_sp->data_s.gradient_s.steps = steps;
+            self_sp->data_s.gradient_s.stopl = stopl;
+            self_sp->data_s.gradient_s.blend = blend;
+        }
+
+        /* Nearest point kernel of analyse on a million points. */
+        if (bench_case_f("analyse")) {
+            const unsigned int entries = 1 << 20;
+            float *axis_apa[3];
+            float near = 0.0f;
+
+            for (unsigned char axis = 0; axis < 3; axis++) {
+                axis_apa[axis] = malloc(sizeof(float) * entries);
+
+                for (unsigned int index = 0; index < entries; index++)
+                    axis_apa[axis][index] = (index >> axis*7 & 0x7f)/127.0f;
+            }
+
+            for (unsigned char variant = 0; variant < 2; variant++) {
+                float (*near_fp)(
+                    const float *const [3],
+                    unsigned int,
+                    unsigned int,
+                    const float [3],
+                    unsigned int,
+                    float
+                ) = &near_f;
+
+#if defined(__x86_64__) || defined(__i386__)
+                if (variant && __builtin_cpu_supports("avx2"))
+                    near_fp = &near_avx2_f;
+                else if (variant)
+                    continue;
+#else
+                if (variant)
+                    continue;
+#endif
+
+                tmp_s.best = 0;
+                for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                    const float query_a[3] = {0.5f, 0.25f, 0.75f};
+
+                    tmp_s.start = bench_time_f();
+                    near += near_fp(
+                        (const float *const *)axis_apa,
+                        0,
+                        entries,
+                        query_a,
+                        run,
+                        INFINITY
+                    );
+                    tmp_s.start = bench_time_f() - tmp_s.start;
+
+                    if (! run || tmp_s.start < tmp_s.best)
+                        tmp_s.best = tmp_s.start;
+                }
+
+                bench_print_f("analyse", variant ? "avx2" : "scalar", entries);
+            }
+
+            /* The result is used (not removed by the compiler). */
+            if (near < 0.0f)
+                putchar('\0');
+
+            for (unsigned char axis = 0; axis < 3; axis++)
+                free(axis_apa[axis]);
+        }
+
+        /* Reduction of all sRGB colours (2**24 entries) to 256. */
+        if (bench_case_f("reduce")) {
+            const unsigned int entries = 1 << 24;
+            unsigned char *rgb_ap = malloc(sizeof(char) * entries*3);
+            unsigned char colour_a[(1 << 8)*3];
+
+            for (unsigned int index = 0; index < entries; index++) {
+                rgb_ap[index*3] = index >> 16;
+                rgb_ap[index*3 + 1] = index >> 8;
+                rgb_ap[index*3 + 2] = index;
+            }
+
+            for (unsigned char variant = 0; variant < 2; variant++) {
+                unsigned int (*centre_fp)(
+                    const float *const [3],
+                    unsigned int,
+                    const float [3]
+                ) = &centre_f;
+
+#if defined(__x86_64__) || defined(__i386__)
+                if (variant && __builtin_cpu_supports("avx2"))
+                    centre_fp = &centre_avx2_f;
+                else if (variant)
+                    continue;
+#else
+                if (variant)
+                    continue;
+#endif
+
+                tmp_s.best = 0;
+                for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                    tmp_s.start = bench_time_f();
+                    reduce_lgen_f(
+                        self_sp,
+                        rgb_ap,
+                        entries,
+                        1 << 8,
+                        colour_a,
+                        centre_fp
+                    );
+                    tmp_s.start = bench_time_f() - tmp_s.start;
+
+                    if (! run || tmp_s.start < tmp_s.best)
+                        tmp_s.best = tmp_s.start;
+                }
+
+                bench_print_f("reduce", variant ? "avx2" : "scalar", entries);
+            }
+
+            free(rgb_ap);
+        }
+
+        /*
+         * Large buffer of 256 MiB by pages (see huge_alloc_f()):
+         * written in order, then scattered as the radix sort,
+         * with the page faults and dTLB misses of the best run.
+         */
+        if (bench_case_f("pages")) {
+            const char *pages_gpa[] = {"small", "thp", "hugetlb", "thp prefault"};
+            const unsigned char pages_a[] = {
+                PAGES_SMALL,
+                PAGES_THP,
+                PAGES_HUGETLB,
+                PAGES_THP | PAGES_PREFAULT
+            };
+            const unsigned int entries = 1 << 26;
+            int dtlb = dtlb_open_f();
+
+            for (unsigned char variant = 0; variant < 4; variant++) {
+                long faults = 0;
+                long long misses = 0;
+
+                tmp_s.best = 0;
+                for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                    long run_faults = faults_f();
+                    long long run_misses = dtlb_f(dtlb);
+                    unsigned int *buffer_ap;
+                    unsigned int index = 0;
+
+                    tmp_s.start = bench_time_f();
+                    buffer_ap = huge_alloc_f(sizeof(int) * entries, pages_a[variant]);
+                    for (unsigned int entry = 0; entry < entries; entry++)
+                        buffer_ap[entry] = entry;
+                    for (unsigned int entry = 0; entry < entries >> 2; entry++) {
+                        index = index*1664525 + 1013904223;
+                        buffer_ap[index >> 6] += entry;
+                    }
+                    /* The result is used (not removed by the compiler). */
+                    if (buffer_ap[index >> 6] == 1)
+                        putchar('\0');
+                    huge_free_f(buffer_ap);
+                    tmp_s.start = bench_time_f() - tmp_s.start;
+
+                    if (! run || tmp_s.start < tmp_s.best) {
+                        tmp_s.best = tmp_s.start;
+                        faults = faults_f() - run_faults;
+                        misses = dtlb < 0 ? -1 : dtlb_f(dtlb) - run_misses;
+                    }
+                }
+
+                bench_print_f("pages", pages_gpa[variant], entries);
+                if (misses < 0)
+                    printf("%-8s %-16s %10ld faults\n", "", "", faults);
+                else
+                    printf(
+                        "%-8s %-16s %10ld faults %10lld dTLB misses\n",
+                        "",
+                        "",
+                        faults,
+                        misses
+                    );
+            }
+
+            if (dtlb >= 0)
+                close(dtlb);
+        }
+
+        /*
+         * Outputs of the batch subcommand: 64 files of 4 MiB
+         * (in a temporary directory) by stdio, the thread pool
+         * and io_uring (see writer_open_f()), until all are written.
+         */
+        if (bench_case_f("writer")) {
+            const char *writer_gpa[] = {"stdio", "threads", "uring"};
+            unsigned int files = 64;
+            const unsigned int filel = 1 << 22;
+            const unsigned int slotl = 1 << 20;
+            char directory_g[] = "/tmp/gplgen.XXXXXX";
+            char path_g[sizeof(directory_g) + 16];
+            char *pattern_gp = malloc(sizeof(char) * slotl);
+
+            for (unsigned int byte = 0; byte < slotl; byte++)
+                pattern_gp[byte] = "0123456789abcdef\n"[byte % 17];
+
+            if (! mkdtemp(directory_g)) {
+                fprintf(
+                    stderr,
+                    "[Error %hhu]: %s: %s\n",
+                    (unsigned char)errno,
+                    directory_g,
+                    strerror(errno)
+                );
+                files = 0;
+            }
+
+            for (unsigned char variant = 0; files && variant < 3; variant++) {
+                const char *variant_gp = writer_gpa[variant];
+
+                tmp_s.best = 0;
+                for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                    struct Writer *writer_sp = NULL;
+                    char *error_gp = NULL;
+                    unsigned long long bytes = 0;
+                    int code;
+
+                    tmp_s.start = bench_time_f();
+                    if (variant)
+                        writer_sp = writer_open_f(self_sp, variant == 2);
+
+                    for (unsigned int file = 0; file < files; file++) {
+                        sprintf(path_g, "%s/%u.gpl", directory_g, file);
+
+                        if (writer_sp) {
+                            struct WriterFile *file_sp = writer_file_f(path_g);
+
+                            for (unsigned int offset = 0;
+                                  file_sp && offset < filel;
+                                  offset += slotl) {
+                                char *slot_gp = writer_slot_f(writer_sp);
+
+                                memcpy(slot_gp, pattern_gp, slotl);
+                                writer_write_f(writer_sp, file_sp, slot_gp, slotl);
+                            }
+                            if (file_sp)
+                                writer_close_f(writer_sp, file_sp);
+                        } else {
+                            FILE *file_lp = fopen(path_g, "w");
+
+                            for (unsigned int offset = 0;
+                                  file_lp && offset < filel;
+                                  offset += slotl)
+                                fwrite(pattern_gp, sizeof(char), slotl, file_lp);
+                            if (file_lp)
+                                fclose(file_lp);
+                        }
+                    }
+
+                    if (writer_sp) {
+                        if (! writer_sp->uring)
+                            variant_gp = writer_gpa[1];
+                        else if (writer_sp->fixed)
+                            variant_gp = "uring fixed";
+                        code = writer_free_f(writer_sp, &error_gp, &bytes);
+                        if (code)
+                            fprintf(
+                                stderr,
+                                "[Error %hhu]: %s: %s\n",
+                                (unsigned char)code,
+                                error_gp,
+                                strerror(code)
+                            );
+                        free(error_gp);
+                    }
+                    tmp_s.start = bench_time_f() - tmp_s.start;
+
+                    if (! run || tmp_s.start < tmp_s.best)
+                        tmp_s.best = tmp_s.start;
+                }
+
+                printf(
+                    "%-8s %-16s %10llu bytes   %10.3f ms %10.1f MiB/s\n",
+                    "writer",
+                    variant_gp,
+                    (unsigned long long)files*filel,
+                    tmp_s.best,
+                    (double)files*filel/1048576.0/tmp_s.best*1000.0
+                );
+            }
+
+            for (unsigned int file = 0; file < files; file++) {
+                sprintf(path_g, "%s/%u.gpl", directory_g, file);
+                unlink(path_g);
+            }
+            rmdir(directory_g);
+            free(pattern_gp);
+        }
+
+        /*
+         * Record writer of each format on the 8/8/8 grid (one thread),
+         * and GPL records with names.
+         */
+        if (bench_case_f("format") || bench_case_f("names")) {
+            const char *format_gpa[] = {"gpl", "hex", "css", "json", "c", "act"};
+            char type_g[] = "rgb";
+            char *type_gp = self_sp->data_s.colour_s.type_gp;
+            char *buffer_gp = malloc(sizeof(char) * (1 << 15) * 32);
+
+            self_sp->data_s.colour_s.type_gp = type_g;
+            memset(self_sp->data_s.colour_s.depth_a, 8, 3);
+            self_sp->data_s.colour_s.depthl = 3;
+
+            for (unsigned char format = FORMAT_GPL; format <= FORMAT_ACT; format++) {
+                self_sp->emit_s.format = format;
+                self_sp->src_lgen_mp(self_sp);
+
+                /* ACT files are limited to 256 colours, not its writer. */
+                self_sp->emit_s.count = 1 << 24;
+
+                tmp_s.best = 0;
+                for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                    tmp_s.start = bench_time_f();
+                    for (unsigned int start = 0;
+                          start < self_sp->emit_s.count;
+                          start += 1 << 15)
+                        fmt_f(self_sp, buffer_gp, start, 1 << 15);
+                    tmp_s.start = bench_time_f() - tmp_s.start;
+
+                    if (! run || tmp_s.start < tmp_s.best)
+                        tmp_s.best = tmp_s.start;
+                }
+
+                bench_print_f("format", format_gpa[format], self_sp->emit_s.count);
+            }
+
+            /* GPL records with and without names. */
+            self_sp->emit_s.format = FORMAT_GPL;
+            for (unsigned char names = NAMES_NONE; names <= NAMES_RGB; names++) {
+                const char *names_gpa[] = {"gpl", "gpl names hex", "gpl names rgb"};
+
+                self_sp->emit_s.names = names;
+                self_sp->src_lgen_mp(self_sp);
+
+                tmp_s.best = 0;
+                for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                    tmp_s.start = bench_time_f();
+                    for (unsigned int start = 0;
+                          start < self_sp->emit_s.count;
+                          start += 1 << 15)
+                        fmt_f(self_sp, buffer_gp, start, 1 << 15);
+                    tmp_s.start = bench_time_f() - tmp_s.start;
+
+                    if (! run || tmp_s.start < tmp_s.best)
+                        tmp_s.best = tmp_s.start;
+                }
+
+                bench_print_f("names", names_gpa[names], self_sp->emit_s.count);
+            }
+
+            self_sp->emit_s.names = NAMES_NONE;
+            self_sp->data_s.colour_s.type_gp = type_gp;
+            self_sp->error_s.code = 0;
+            free(buffer_gp);
+        }
+
+        /*
+         * GPL records by the red depth (green and blue of 8),
+         * the generic writer and the specialised kernels
+         * (make SPECIALISE=1), that must write the same records.
+         */
+        if (bench_case_f("kernel")) {
+            char type_g[] = "rgb";
+            char *type_gp = self_sp->data_s.colour_s.type_gp;
+            char *buffer_gp = malloc(sizeof(char) * (1 << 15) * 14);
+            char *check_gp = malloc(sizeof(char) * (1 << 15) * 14);
+
+            self_sp->data_s.colour_s.type_gp = type_g;
+            self_sp->data_s.colour_s.depthl = 3;
+            self_sp->emit_s.format = FORMAT_GPL;
+            self_sp->emit_s.names = NAMES_NONE;
+
+            for (unsigned char depth = 1; depth <= 8; depth++) {
+                char variant_g[32];
+
+                self_sp->data_s.colour_s.depth_a[0] = depth;
+                self_sp->data_s.colour_s.depth_a[1] = 8;
+                self_sp->data_s.colour_s.depth_a[2] = 8;
+                self_sp->src_lgen_mp(self_sp);
+
+                for (unsigned char generic = 2; generic > 0; generic--) {
+                    self_sp->emit_s.generic = generic - 1;
+#if ! defined(GPLGEN_SPECIALISE)
+                    if (! self_sp->emit_s.generic)
+                        continue;
+#endif
+
+                    tmp_s.best = 0;
+                    for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                        tmp_s.start = bench_time_f();
+                        for (unsigned int start = 0;
+                              start < self_sp->emit_s.count;
+                              start += 1 << 15)
+                            fmt_f(self_sp, buffer_gp, start, 1 << 15);
+                        tmp_s.start = bench_time_f() - tmp_s.start;
+
+                        if (! run || tmp_s.start < tmp_s.best)
+                            tmp_s.best = tmp_s.start;
+                    }
+
+                    sprintf(
+                        variant_g,
+                        "%hhu 8 8 %s",
+                        depth,
+                        self_sp->emit_s.generic ? "generic" : "kernel"
+                    );
+                    bench_print_f("kernel", variant_g, self_sp->emit_s.count);
+                }
+
+                /* The last chunk (with a partial row) of both writers. */
+                self_sp->emit_s.generic = TRUE;
+                fmt_f(self_sp, check_gp, (1 << 15) + 3, 1 << 14);
+                self_sp->emit_s.generic = FALSE;
+                fmt_f(self_sp, buffer_gp, (1 << 15) + 3, 1 << 14);
+                if (memcmp(buffer_gp, check_gp, (1 << 14)*14) != 0)
+                    fprintf(stderr, "kernel: %hhu 8 8: different records\n", depth);
+            }
+
+            self_sp->data_s.colour_s.type_gp = type_gp;
+            self_sp->error_s.code = 0;
+            free(buffer_gp);
+            free(check_gp);
+        }
+
+        /*
+         * GPL reader on the 8/8/8 output (in memory, without names
+         * and with rgb names), with one thread and with all threads.
+         */
+        if (bench_case_f("load")) {
+            const char head_g[] = "GIMP Palette\nName: bench\nColumns: 16\n#\n";
+            char type_g[] = "rgb";
+            char *type_gp = self_sp->data_s.colour_s.type_gp;
+            unsigned short threads = self_sp->data_s.task_s.threads;
+            struct Palette palette_s;
+
+            self_sp->data_s.colour_s.type_gp = type_g;
+            memset(self_sp->data_s.colour_s.depth_a, 8, 3);
+            self_sp->data_s.colour_s.depthl = 3;
+            self_sp->emit_s.format = FORMAT_GPL;
+
+            for (unsigned char names = NAMES_NONE;
+                  names <= NAMES_RGB;
+                  names += NAMES_RGB - NAMES_NONE) {
+                unsigned long long textl;
+                char *text_gp;
+
+                self_sp->emit_s.names = names;
+                self_sp->src_lgen_mp(self_sp);
+                textl = (
+                    sizeof(head_g) - 1
+                      + (unsigned long long)self_sp->emit_s.count
+                        * self_sp->emit_s.recordl
+                );
+                text_gp = malloc(sizeof(char) * textl);
+                memcpy(text_gp, head_g, sizeof(head_g) - 1);
+                fmt_f(
+                    self_sp,
+                    text_gp + sizeof(head_g) - 1,
+                    0,
+                    self_sp->emit_s.count
+                );
+
+                for (unsigned char variant = 0; variant < 2; variant++) {
+                    char variant_g[1 << 5];
+
+                    if (variant && threads == 1)
+                        continue;
+
+                    self_sp->data_s.task_s.threads = variant ? threads : 1;
+                    sprintf(
+                        variant_g,
+                        "%s %hu thr",
+                        names == NAMES_RGB ? "names" : "gpl",
+                        self_sp->data_s.task_s.threads
+                    );
+
+                    tmp_s.best = 0;
+                    for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                        tmp_s.start = bench_time_f();
+                        gpl_parse_f(
+                            text_gp,
+                            textl,
+                            &palette_s,
+                            self_sp->data_s.task_s.threads
+                        );
+                        tmp_s.start = bench_time_f() - tmp_s.start;
+
+                        if (palette_s.count != self_sp->emit_s.count)
+                            tmp_s.start = 0;
+                        gpl_free_f(&palette_s);
+
+                        if (! run || tmp_s.start < tmp_s.best)
+                            tmp_s.best = tmp_s.start;
+                    }
+
+                    bench_print_f("load", variant_g, self_sp->emit_s.count);
+                    printf(
+                        "%-8s %-16s %10llu bytes   %10.1f MB/s\n",
+                        "load",
+                        variant_g,
+                        textl,
+                        textl/tmp_s.best/1000.0
+                    );
+                }
+
+                free(text_gp);
+            }
+
+            self_sp->data_s.task_s.threads = threads;
+            self_sp->emit_s.names = NAMES_NONE;
+            self_sp->data_s.colour_s.type_gp = type_gp;
+        }
+
+        /*
+         * Sort stage of the 8/8/8 grid (with all threads),
+         * and its keys (one thread, scalar and AVX2).
+         */
+        if (bench_case_f("sort")) {
+            const char *sort_gpa[] = {
+                "none",
+                "luminance",
+                "hue",
+                "saturation",
+                "distance"
+            };
+            char type_g[] = "rgb";
+            char *type_gp = self_sp->data_s.colour_s.type_gp;
+            unsigned int *key_ap = malloc(sizeof(unsigned int) * (1 << 24));
+            unsigned char *rgb_ap;
+
+            self_sp->data_s.colour_s.type_gp = type_g;
+            memset(self_sp->data_s.colour_s.depth_a, 8, 3);
+            self_sp->data_s.colour_s.depthl = 3;
+            self_sp->emit_s.format = FORMAT_GPL;
+            self_sp->data_s.sort_s.sort = SORT_NONE;
+            memset(self_sp->data_s.sort_s.ref_a, 0x80, 3);
+            self_sp->src_lgen_mp(self_sp);
+
+            for (unsigned char sort = SORT_LUMINANCE; sort <= SORT_DISTANCE; sort++) {
+                self_sp->data_s.sort_s.sort = sort;
+
+                tmp_s.best = 0;
+                for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                    tmp_s.start = bench_time_f();
+                    self_sp->sort_mp(self_sp);
+                    tmp_s.start = bench_time_f() - tmp_s.start;
+
+                    free(self_sp->emit_s.colour_ap);
+                    self_sp->emit_s.colour_ap = NULL;
+
+                    if (! run || tmp_s.start < tmp_s.best)
+                        tmp_s.best = tmp_s.start;
+                }
+
+                bench_print_f("sort", sort_gpa[sort], self_sp->emit_s.count);
+            }
+
+            /* Unsorted grid of the keys. */
+            self_sp->data_s.sort_s.sort = SORT_NONE;
+            rgb_ap = malloc(sizeof(char) * 3*(1 << 24));
+            for (unsigned int index = 0; index < 1 << 24; index++) {
+                rgb_ap[index*3] = index & 0xff;
+                rgb_ap[index*3 + 1] = index >> 8 & 0xff;
+                rgb_ap[index*3 + 2] = index >> 16;
+            }
+
+            for (unsigned char sort = SORT_LUMINANCE; sort <= SORT_DISTANCE; sort++)
+                for (unsigned char variant = 0; variant < 2; variant++) {
+                    char variant_g[1 << 5];
+                    void (*key_fp)(
+                        unsigned char,
+                        const unsigned char *,
+                        unsigned int *,
+                        unsigned int,
+                        const unsigned char *,
+                        const unsigned char *
+                    ) = &sort_key_f;
+
+#if defined(__x86_64__) || defined(__i386__)
+                    if (variant && __builtin_cpu_supports("avx2"))
+                        key_fp = &sort_key_avx2_f;
+                    else if (variant)
+                        continue;
+#else
+                    if (variant)
+                        continue;
+#endif
+
+                    tmp_s.best = 0;
+                    for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                        tmp_s.start = bench_time_f();
+                        key_fp(
+                            sort,
+                            rgb_ap,
+                            key_ap,
+                            1 << 24,
+                            self_sp->data_s.sort_s.ref_a,
+                            self_sp->table_s.div_a
+                        );
+                        tmp_s.start = bench_time_f() - tmp_s.start;
+
+                        if (! run || tmp_s.start < tmp_s.best)
+                            tmp_s.best = tmp_s.start;
+                    }
+
+                    sprintf(
+                        variant_g,
+                        "%.5s key %s",
+                        sort_gpa[sort],
+                        variant ? "avx2" : "scalar"
+                    );
+                    bench_print_f("sort", variant_g, 1 << 24);
+                }
+
+            self_sp->data_s.colour_s.type_gp = type_gp;
+            memset(self_sp->data_s.sort_s.ref_a, 0, 3);
+            free(rgb_ap);
+            free(key_ap);
+        }
+
+        /*
+         * Palette strings of cpal_lgen_f() (gplgen_cpal()) as the configs
+         * of the release training (make release, ../test/train):
+         * small palettes (mostly their head), gray, a mid depth rgb
+         * and the 8/8/8 grid, each with its setup and config.
+         */
+        if (bench_case_f("cpal")) {
+            const char *train_gpa[][3] = {
+                {"head", "rgb", "1 1 1"},
+                {"gray", "gray", "8"},
+                {"rgb", "rgb", "5 5 5"},
+                {"full", "rgb", "8 8 8"}
+            };
+            const unsigned short repeat_a[] = {1 << 12, 1 << 10, 1 << 6, 1};
+
+            /*
+             * Free unused memory (each run has its setup).
+             * 0 == '\0' == NULL
+             */
+            free(self_sp->data_s.colour_s.type_gp);
+            self_sp->data_s.colour_s.type_gp = NULL;
+            self_sp->setup_free_mp(self_sp);
+
+            for (unsigned char train = 0; train < 4; train++) {
+                unsigned long long entries = 0;
+
+                tmp_s.best = 0;
+                for (unsigned char run = 0; run < tmp_s.runs; run++) {
+                    entries = 0;
+
+                    tmp_s.start = bench_time_f();
+                    for (unsigned short repeat = 0; repeat < repeat_a[train]; repeat++) {
+                        struct Input *input_sp = &self_sp->input_s;
+                        char *cpal_gp;
+
+                        self_sp->setup_mp(self_sp);
+                        memset(input_sp, 0, sizeof(*input_sp));
+                        strcpy(input_sp->type_g, train_gpa[train][1]);
+                        strcpy(input_sp->depth_g, train_gpa[train][2]);
+                        strcpy(input_sp->title_g, "Bench Palette");
+                        strcpy(input_sp->author_g, "Bench <bench@bench.info>");
+                        strcpy(input_sp->years_g, "2022");
+                        input_sp->typel = strlen(input_sp->type_g) + 1;
+                        input_sp->depthl = strlen(input_sp->depth_g) + 1;
+                        input_sp->titlel = strlen(input_sp->title_g) + 1;
+                        input_sp->authorl = strlen(input_sp->author_g) + 1;
+                        input_sp->yearsl = strlen(input_sp->years_g) + 1;
+                        self_sp->config_mp(self_sp, input_sp);
+
+                        cpal_gp = self_sp->cpal_lgen_mp(self_sp);
+                        entries += self_sp->emit_s.count;
+                        huge_free_f(cpal_gp);
+                        self_sp->setup_free_mp(self_sp);
+                    }
+                    tmp_s.start = bench_time_f() - tmp_s.start;
+
+                    if (! run || tmp_s.start < tmp_s.best)
+                        tmp_s.best = tmp_s.start;
+                }
+
+                bench_print_f("cpal", train_gpa[train][0], entries);
+            }
+
+            /* The setup of the other cases. */
+            self_sp->setup_mp(self_sp);
+        }
+
+        memset(&tmp_s, 0, sizeof(tmp_s));
+    }
+
+    void
+    setup_f(struct Self *self_sp) {
+        /* Default values. */
+        struct {
+            unsigned char typel: 3;
+            char type_g[4];
+            unsigned char depthl: 2;
+            char depth_a[3];
+            unsigned char titlel: 4;
+            char title_g[13];
+            unsigned char columns: 5;
+            unsigned char authorl: 4;
+            char author_g[10];
+            unsigned char yearsl: 3;
+            char years_g[5];
+            char code: 1;
+            unsigned char valuel: 3;
+            char value_g[5];
+            time_t tm;
+            struct tm *tm_sp;
+        } tmp_s = {
+            4,
+            "rgb",
+            3,
+            {3, 3, 2},
+            13,
+            "GIMP Palette",
+            16,
+            10,
+            "anonymous",
+            5,
+            "\0\0\0\0",
+            0,
+            5,
+            "none",
+            time(NULL),
+            NULL
+        };
+
+        /* Add year value to tmp_s.years_g. */
+        tmp_s.tm_sp = localtime(&tmp_s.tm);
+        sprintf(tmp_s.years_g, "%hu", tmp_s.tm_sp->tm_year + 1900);
+
+        /* Add dynamic memories to a new structure. */
+        self_sp->data_s.colour_s.type_gp = (
+            malloc(sizeof(char) * tmp_s.typel)
+        );
+        self_sp->data_s.pmap_s.title_gp = (
+            malloc(sizeof(char) * tmp_s.titlel)
+        );
+        self_sp->data_s.copyright_s.author_gp = (
+            malloc(sizeof(char) * tmp_s.authorl)
+        );
+        self_sp->data_s.copyright_s.years_gp = (
+            malloc(sizeof(char) * tmp_s.yearsl)
+        );
+        self_sp->error_s.value_gp = (
+            malloc(sizeof(char) * tmp_s.valuel)
+        );
         memset(
             self_sp->data_s.colour_s.type_gp,
             '\0',
-            self_sp->data_s.colour_s.typel
+            sizeof(char) * tmp_s.typel
+        );
+        memset(
+            self_sp->data_s.pmap_s.title_gp,
+            '\0',
+            sizeof(char) * tmp_s.titlel
+        );
+        memset(
+            self_sp->data_s.copyright_s.author_gp,
+            '\0',
+            sizeof(char) * tmp_s.authorl
+        );
+        memset(
+            self_sp->data_s.copyright_s.years_gp,
+            '\0',
+            sizeof(char) * tmp_s.yearsl
+        );
+        memset(
+            self_sp->error_s.value_gp,
+            '\0',
+            sizeof(char) * tmp_s.valuel
+        );
+
+        /* Add default values to a new structure. */
+        self_sp->data_s.colour_s.typel = tmp_s.typel;
+        strcpy(self_sp->data_s.colour_s.type_gp, tmp_s.type_g);
+        self_sp->data_s.colour_s.depthl = tmp_s.depthl;
+        memcpy(self_sp->data_s.colour_s.depth_a, tmp_s.depth_a, tmp_s.depthl);
+        self_sp->data_s.pmap_s.titlel = tmp_s.titlel;
+        strcpy(self_sp->data_s.pmap_s.title_gp, tmp_s.title_g);
+        self_sp->data_s.pmap_s.columns = tmp_s.columns;
+        self_sp->data_s.copyright_s.authorl = tmp_s.authorl;
+        strcpy(self_sp->data_s.copyright_s.author_gp, tmp_s.author_g);
+        self_sp->data_s.copyright_s.yearsl = tmp_s.yearsl;
+        strcpy(self_sp->data_s.copyright_s.years_gp, tmp_s.years_g);
+        self_sp->error_s.code = tmp_s.code;
+        self_sp->error_s.valuel = tmp_s.valuel;
+        strcpy(self_sp->error_s.value_gp, tmp_s.value_g);
+        self_sp->data_s.image_s.pathl = 0;
+        self_sp->data_s.image_s.path_gp = NULL;
+        self_sp->data_s.image_s.colours = 1 << 8;
+        self_sp->data_s.gpl_s.pathl = 0;
+        self_sp->data_s.gpl_s.path_gp = NULL;
+        self_sp->data_s.pmap_s.configured = 0;
+        self_sp->data_s.pmap_s.cell = 16;
+        self_sp->data_s.sort_s.sort = SORT_NONE;
+        memset(self_sp->data_s.sort_s.ref_a, 0, 3);
+        memset(
+            &self_sp->data_s.gradient_s,
+            0,
+            sizeof(self_sp->data_s.gradient_s)
+        );
+        self_sp->data_s.gradient_s.stopl = 2;
+        memset(self_sp->data_s.gradient_s.stop_aa[1], 0xff, 3);
+        self_sp->data_s.gradient_s.steps = 1 << 8;
+        self_sp->data_s.gradient_s.blend = BLEND_SRGB;
+        self_sp->data_s.reduce_s.seed = 0;
+        self_sp->data_s.colour_s.dedup = FALSE;
+        self_sp->data_s.colour_s.ramp = RAMP_LINEAR;
+        self_sp->emit_s.format = FORMAT_GPL;
+        self_sp->emit_s.names = NAMES_NONE;
+        self_sp->emit_s.index = FALSE;
+        self_sp->emit_s.resume = FALSE;
+        self_sp->emit_s.cvd = FALSE;
+        self_sp->emit_s.generic = FALSE;
+        memset(self_sp->emit_s.slice_a, 0, sizeof(self_sp->emit_s.slice_a));
+        self_sp->data_s.colour_s.gamma = 1.0f;
+        memset(
+            self_sp->data_s.colour_s.levell_a,
+            0,
+            sizeof(self_sp->data_s.colour_s.levell_a)
+        );
+        self_sp->data_s.task_s.threads = sysconf(_SC_NPROCESSORS_ONLN);
+        if (self_sp->data_s.task_s.threads < 1)
+            self_sp->data_s.task_s.threads = 1;
+        self_sp->data_s.task_s.pages = PAGES_THP;
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        memset(
+            tmp_s.tm_sp,
+            0,
+            sizeof(*tmp_s.tm_sp)
+        );
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    void
+    config_f(struct Self *self_sp, struct Input *config_sp) {
+        /* Apply the config values, each value is cleared once applied. */
+        struct {
+            struct Input *config_sp;
+            unsigned char isdigit: 1;
+            char years_g[5];
+            time_t tm;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        tmp_s.config_sp = config_sp;
+        tmp_s.tm = time(NULL);
+        sprintf(tmp_s.years_g, "%hu", localtime(&tmp_s.tm)->tm_year + 1900);
+
+        if (tmp_s.config_sp) {
+            if (tmp_s.config_sp->typel) {
+                memset(
+                    self_sp->data_s.colour_s.type_gp,
+                    '\0',
+                    sizeof(char) * self_sp->data_s.colour_s.typel
+                );
+                self_sp->data_s.colour_s.typel = tmp_s.config_sp->typel;
+
+                self_sp->data_s.colour_s.type_gp = (
+                    realloc(
+                        self_sp->data_s.colour_s.type_gp,
+                        sizeof(char) * self_sp->data_s.colour_s.typel
+                    )
+                );
+
+                strcpy(
+                    self_sp->data_s.colour_s.type_gp,
+                    tmp_s.config_sp->type_g
+                );
+
+                memset(
+                    tmp_s.config_sp->type_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->typel
+                );
+                tmp_s.config_sp->typel = 0;
+            }
+
+            if (tmp_s.config_sp->depthl) {
+                struct {
+                    char *data_ap;
+                    unsigned char lenght: 3;
+                } depth_s = {
+                    malloc(sizeof(char)),
+                    1
+                };
+                depth_s.data_ap[depth_s.lenght - 1] = (
+                    self_sp->data_s.colour_s.depth_a[depth_s.lenght - 1]
+                );
+
+                for (unsigned char index = 0;
+                      index < tmp_s.config_sp->depthl;
+                      index++) {
+                    if ((index == 0
+                          || index == 2
+                          || index == tmp_s.config_sp->depthl - 2)
+                          && isdigit(tmp_s.config_sp->depth_g[index])) {
+                        depth_s.lenght = index/2 + 1;
+
+                        depth_s.data_ap[depth_s.lenght - 1] = (
+                            strtoul(
+                                &tmp_s.config_sp->depth_g[index],
+                                NULL,
+                                10
+                            )
+                        );
+
+                        if (index < tmp_s.config_sp->depthl - 2) {
+                            depth_s.data_ap = (
+                                realloc(
+                                    depth_s.data_ap,
+                                    sizeof(char) * depth_s.lenght + 1
+                                )
+                            );
+                            depth_s.data_ap[depth_s.lenght] = (
+                                self_sp->data_s.colour_s.depth_a[depth_s.lenght]
+                            );
+                        }
+                    }
+
+                    if ((index == 1 || index == 3)
+                          && tmp_s.config_sp->depth_g[index] != ' ') {
+                        break;
+                    }
+                }
+
+                memcpy(self_sp->data_s.colour_s.depth_a, depth_s.data_ap, depth_s.lenght);
+
+                memset(depth_s.data_ap, 0, sizeof(char) * depth_s.lenght);
+                free(depth_s.data_ap);
+                memset(&depth_s, 0, sizeof(depth_s));
+
+                memset(
+                    tmp_s.config_sp->depth_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->depthl
+                );
+                tmp_s.config_sp->depthl = 0;
+            }
+
+            if (tmp_s.config_sp->titlel) {
+                memset(
+                    self_sp->data_s.pmap_s.title_gp,
+                    '\0',
+                    sizeof(char) * self_sp->data_s.pmap_s.titlel
+                );
+                self_sp->data_s.pmap_s.titlel = tmp_s.config_sp->titlel;
+
+                self_sp->data_s.pmap_s.title_gp = (
+                    realloc(
+                        self_sp->data_s.pmap_s.title_gp,
+                        sizeof(char) * self_sp->data_s.pmap_s.titlel
+                    )
+                );
+
+                strcpy(
+                    self_sp->data_s.pmap_s.title_gp,
+                    tmp_s.config_sp->title_g
+                );
+                self_sp->data_s.pmap_s.configured |= 1;
+
+                memset(
+                    tmp_s.config_sp->title_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->titlel
+                );
+                tmp_s.config_sp->titlel = 0;
+            }
+
+            if (tmp_s.config_sp->columnsl) {
+                for (unsigned char index = 0;
+                      index < tmp_s.config_sp->columnsl - 1;
+                      index++)
+                    if (! isdigit(tmp_s.config_sp->columns_g[index]))
+                        break;
+                    else if (index + 1 == tmp_s.config_sp->columnsl - 1)
+                        tmp_s.isdigit = TRUE;
+
+                if (tmp_s.isdigit
+                      && strtoul(tmp_s.config_sp->columns_g, NULL, 10) >= 0) {
+                    self_sp->data_s.pmap_s.columns = (
+                        strtoul(tmp_s.config_sp->columns_g, NULL, 10)
+                    );
+                    self_sp->data_s.pmap_s.configured |= 2;
+                }
+
+                memset(
+                    tmp_s.config_sp->columns_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->columnsl
+                );
+                tmp_s.config_sp->columnsl = 0;
+                tmp_s.isdigit = FALSE;
+            }
+
+            if (tmp_s.config_sp->authorl) {
+                memset(
+                    self_sp->data_s.copyright_s.author_gp,
+                    '\0',
+                    sizeof(char) * self_sp->data_s.copyright_s.authorl
+                );
+                self_sp->data_s.copyright_s.authorl = tmp_s.config_sp->authorl;
+
+                self_sp->data_s.copyright_s.author_gp = (
+                    realloc(
+                        self_sp->data_s.copyright_s.author_gp,
+                        sizeof(char) * self_sp->data_s.copyright_s.authorl
+                    )
+                );
+
+                strcpy(
+                    self_sp->data_s.copyright_s.author_gp,
+                    tmp_s.config_sp->author_g
+                );
+
+                memset(
+                    tmp_s.config_sp->author_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->authorl
+                );
+                tmp_s.config_sp->authorl = 0;
+            }
+
+            if (tmp_s.config_sp->yearsl) {
+                for (unsigned char index = 0;
+                      index < tmp_s.config_sp->yearsl - 1;
+                      index++)
+                    if (! isdigit(tmp_s.config_sp->years_g[index]))
+                        break;
+                    else if (index + 1 == tmp_s.config_sp->yearsl - 1)
+                        tmp_s.isdigit = TRUE;
+
+                if (tmp_s.isdigit
+                      && strtoul(tmp_s.config_sp->years_g, NULL, 10) > 999
+                      && strtoul(tmp_s.config_sp->years_g, NULL, 10)
+                        < strtoul(tmp_s.years_g, NULL, 10)
+                      || ! tmp_s.isdigit) {
+                    memset(
+                        self_sp->data_s.copyright_s.years_gp,
+                        '\0',
+                        sizeof(char) * self_sp->data_s.copyright_s.yearsl
+                    );
+                    self_sp->data_s.copyright_s.yearsl = tmp_s.config_sp->yearsl;
+
+                    self_sp->data_s.copyright_s.years_gp = (
+                        realloc(
+                            self_sp->data_s.copyright_s.years_gp,
+                            sizeof(char) * self_sp->data_s.copyright_s.yearsl
+                        )
+                    );
+
+                    strcpy(
+                        self_sp->data_s.copyright_s.years_gp,
+                        tmp_s.config_sp->years_g
+                    );
+                } else if (tmp_s.isdigit);
+                else {
+                    memset(
+                        self_sp->data_s.copyright_s.years_gp,
+                        '\0',
+                        sizeof(char) * self_sp->data_s.copyright_s.yearsl
+                    );
+                    self_sp->data_s.copyright_s.yearsl = tmp_s.config_sp->yearsl;
+
+                    self_sp->data_s.copyright_s.years_gp = (
+                        realloc(
+                            self_sp->data_s.copyright_s.years_gp,
+                            sizeof(char) * self_sp->data_s.copyright_s.yearsl
+                        )
+                    );
+
+                    strcpy(
+                        self_sp->data_s.copyright_s.years_gp,
+                        tmp_s.config_sp->years_g
+                    );
+                }
+
+                memset(
+                    tmp_s.config_sp->years_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->yearsl
+                );
+                tmp_s.config_sp->yearsl = 0;
+                tmp_s.isdigit = FALSE;
+            }
+
+            if (tmp_s.config_sp->imagel) {
+                self_sp->data_s.image_s.pathl = tmp_s.config_sp->imagel;
+
+                self_sp->data_s.image_s.path_gp = (
+                    realloc(
+                        self_sp->data_s.image_s.path_gp,
+                        sizeof(char) * self_sp->data_s.image_s.pathl
+                    )
+                );
+
+                strcpy(
+                    self_sp->data_s.image_s.path_gp,
+                    tmp_s.config_sp->image_g
+                );
+
+                memset(
+                    tmp_s.config_sp->image_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->imagel
+                );
+                tmp_s.config_sp->imagel = 0;
+            }
+
+            if (tmp_s.config_sp->palettel) {
+                self_sp->data_s.gpl_s.pathl = tmp_s.config_sp->palettel;
+
+                self_sp->data_s.gpl_s.path_gp = (
+                    realloc(
+                        self_sp->data_s.gpl_s.path_gp,
+                        sizeof(char) * self_sp->data_s.gpl_s.pathl
+                    )
+                );
+
+                strcpy(
+                    self_sp->data_s.gpl_s.path_gp,
+                    tmp_s.config_sp->palette_g
+                );
+
+                memset(
+                    tmp_s.config_sp->palette_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->palettel
+                );
+                tmp_s.config_sp->palettel = 0;
+            }
+
+            if (tmp_s.config_sp->coloursl) {
+                for (unsigned char index = 0;
+                      index < tmp_s.config_sp->coloursl - 1;
+                      index++)
+                    if (! isdigit(tmp_s.config_sp->colours_g[index]))
+                        break;
+                    else if (index + 1 == tmp_s.config_sp->coloursl - 1)
+                        tmp_s.isdigit = TRUE;
+
+                /* A box needs at least one of the 1 << 15 bins. */
+                if (tmp_s.isdigit
+                      && strtoul(tmp_s.config_sp->colours_g, NULL, 10) > 0
+                      && strtoul(tmp_s.config_sp->colours_g, NULL, 10)
+                        <= 1 << 15)
+                    self_sp->data_s.image_s.colours = (
+                        strtoul(tmp_s.config_sp->colours_g, NULL, 10)
+                    );
+
+                memset(
+                    tmp_s.config_sp->colours_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->coloursl
+                );
+                tmp_s.config_sp->coloursl = 0;
+                tmp_s.isdigit = FALSE;
+            }
+
+            if (tmp_s.config_sp->threadsl) {
+                for (unsigned char index = 0;
+                      index < tmp_s.config_sp->threadsl - 1;
+                      index++)
+                    if (! isdigit(tmp_s.config_sp->threads_g[index]))
+                        break;
+                    else if (index + 1 == tmp_s.config_sp->threadsl - 1)
+                        tmp_s.isdigit = TRUE;
+
+                if (tmp_s.isdigit
+                      && strtoul(tmp_s.config_sp->threads_g, NULL, 10) > 0
+                      && strtoul(tmp_s.config_sp->threads_g, NULL, 10)
+                        <= 1 << 10)
+                    self_sp->data_s.task_s.threads = (
+                        strtoul(tmp_s.config_sp->threads_g, NULL, 10)
+                    );
+
+                memset(
+                    tmp_s.config_sp->threads_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->threadsl
+                );
+                tmp_s.config_sp->threadsl = 0;
+                tmp_s.isdigit = FALSE;
+            }
+
+            if (tmp_s.config_sp->dedupl) {
+                self_sp->data_s.colour_s.dedup = (
+                    strcmp(tmp_s.config_sp->dedup_g, "yes") == 0
+                      || strcmp(tmp_s.config_sp->dedup_g, "true") == 0
+                      || strcmp(tmp_s.config_sp->dedup_g, "1") == 0
+                );
+
+                memset(
+                    tmp_s.config_sp->dedup_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->dedupl
+                );
+                tmp_s.config_sp->dedupl = 0;
+            }
+
+            if (tmp_s.config_sp->celll) {
+                /* Swatch cells of 1 to 256 pixels. */
+                unsigned long cell = strtoul(tmp_s.config_sp->cell_g, NULL, 10);
+
+                if (cell >= 1 && cell <= 1 << 8)
+                    self_sp->data_s.pmap_s.cell = cell;
+
+                memset(
+                    tmp_s.config_sp->cell_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->celll
+                );
+                tmp_s.config_sp->celll = 0;
+            }
+
+            if (tmp_s.config_sp->indexl) {
+                self_sp->emit_s.index = (
+                    strcmp(tmp_s.config_sp->index_g, "yes") == 0
+                      || strcmp(tmp_s.config_sp->index_g, "true") == 0
+                      || strcmp(tmp_s.config_sp->index_g, "1") == 0
+                );
+
+                memset(
+                    tmp_s.config_sp->index_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->indexl
+                );
+                tmp_s.config_sp->indexl = 0;
+            }
+
+            if (tmp_s.config_sp->resumel) {
+                self_sp->emit_s.resume = (
+                    strcmp(tmp_s.config_sp->resume_g, "yes") == 0
+                      || strcmp(tmp_s.config_sp->resume_g, "true") == 0
+                      || strcmp(tmp_s.config_sp->resume_g, "1") == 0
+                );
+
+                memset(
+                    tmp_s.config_sp->resume_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->resumel
+                );
+                tmp_s.config_sp->resumel = 0;
+            }
+
+            if (tmp_s.config_sp->cvdl) {
+                self_sp->emit_s.cvd = (
+                    strcmp(tmp_s.config_sp->cvd_g, "yes") == 0
+                      || strcmp(tmp_s.config_sp->cvd_g, "true") == 0
+                      || strcmp(tmp_s.config_sp->cvd_g, "1") == 0
+                );
+
+                memset(
+                    tmp_s.config_sp->cvd_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->cvdl
+                );
+                tmp_s.config_sp->cvdl = 0;
+            }
+
+            if (tmp_s.config_sp->stopsl) {
+                /* Gradient stops: "#rrggbb" (or "rrggbb"), 32 at most. */
+                char *value_gp = tmp_s.config_sp->stops_g;
+                unsigned char stopl = 0;
+                unsigned char stop_aa[32][3];
+
+                while (*value_gp && stopl < 32) {
+                    char *end_gp;
+                    unsigned long value;
+
+                    while (*value_gp == ' ' || *value_gp == ',' || *value_gp == '#')
+                        value_gp++;
+                    if (! *value_gp)
+                        break;
+
+                    value = strtoul(value_gp, &end_gp, 16);
+                    if (end_gp - value_gp != 6) {
+                        self_sp->error_mp(self_sp, EINVAL, "stops");
+                        stopl = 0;
+                        break;
+                    }
+
+                    stop_aa[stopl][0] = value >> 16;
+                    stop_aa[stopl][1] = value >> 8 & 0xff;
+                    stop_aa[stopl][2] = value & 0xff;
+                    stopl++;
+                    value_gp = end_gp;
+                }
+
+                /* A stop after the 32nd. */
+                while (stopl && (*value_gp == ' ' || *value_gp == ','))
+                    value_gp++;
+                if (stopl && *value_gp) {
+                    self_sp->error_mp(self_sp, EINVAL, "stops");
+                    stopl = 0;
+                }
+                if (stopl) {
+                    self_sp->data_s.gradient_s.stopl = stopl;
+                    memcpy(self_sp->data_s.gradient_s.stop_aa, stop_aa, stopl*3);
+                }
+
+                memset(
+                    tmp_s.config_sp->stops_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->stopsl
+                );
+                tmp_s.config_sp->stopsl = 0;
+            }
+
+            if (tmp_s.config_sp->stepsl) {
+                /* Gradient entries, 1 to 2**24. */
+                unsigned long steps = strtoul(tmp_s.config_sp->steps_g, NULL, 10);
+
+                if (steps >= 1 && steps <= 1 << 24)
+                    self_sp->data_s.gradient_s.steps = steps;
+                else
+                    self_sp->error_mp(self_sp, EINVAL, "steps");
+
+                memset(
+                    tmp_s.config_sp->steps_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->stepsl
+                );
+                tmp_s.config_sp->stepsl = 0;
+            }
+
+            if (tmp_s.config_sp->blendl) {
+                /* Interpolation space of the gradient: srgb, linear or oklab. */
+                if (strcmp(tmp_s.config_sp->blend_g, "linear") == 0)
+                    self_sp->data_s.gradient_s.blend = BLEND_LINEAR;
+                else if (strcmp(tmp_s.config_sp->blend_g, "oklab") == 0)
+                    self_sp->data_s.gradient_s.blend = BLEND_OKLAB;
+                else if (strcmp(tmp_s.config_sp->blend_g, "srgb") == 0)
+                    self_sp->data_s.gradient_s.blend = BLEND_SRGB;
+                else
+                    self_sp->error_mp(self_sp, EINVAL, "blend");
+
+                memset(
+                    tmp_s.config_sp->blend_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->blendl
+                );
+                tmp_s.config_sp->blendl = 0;
+            }
+
+            if (tmp_s.config_sp->seedl) {
+                /* Seed of the reduce subcommand (a decimal number). */
+                char *end_gp;
+                unsigned long long seed = strtoull(tmp_s.config_sp->seed_g, &end_gp, 10);
+
+                if (end_gp != tmp_s.config_sp->seed_g && ! *end_gp)
+                    self_sp->data_s.reduce_s.seed = seed;
+                else
+                    self_sp->error_mp(self_sp, EINVAL, "seed");
+
+                memset(
+                    tmp_s.config_sp->seed_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->seedl
+                );
+                tmp_s.config_sp->seedl = 0;
+            }
+
+            if (tmp_s.config_sp->pagesl) {
+                /*
+                 * Pages of the large buffers: small, thp or hugetlb
+                 * and the prefault and sequential options.
+                 */
+                char *word_gp = strtok(tmp_s.config_sp->pages_g, " ,");
+                unsigned char pages = PAGES_THP;
+
+                for (; word_gp; word_gp = strtok(NULL, " ,"))
+                    if (strcmp(word_gp, "small") == 0)
+                        pages &= ~(PAGES_THP | PAGES_HUGETLB);
+                    else if (strcmp(word_gp, "thp") == 0)
+                        pages = (pages & ~PAGES_HUGETLB) | PAGES_THP;
+                    else if (strcmp(word_gp, "hugetlb") == 0)
+                        pages |= PAGES_HUGETLB;
+                    else if (strcmp(word_gp, "prefault") == 0)
+                        pages |= PAGES_PREFAULT;
+                    else if (strcmp(word_gp, "sequential") == 0)
+                        pages |= PAGES_SEQUENTIAL;
+                    else
+                        break;
+
+                if (word_gp)
+                    self_sp->error_mp(self_sp, EINVAL, "pages");
+                else
+                    self_sp->data_s.task_s.pages = pages;
+
+                memset(
+                    tmp_s.config_sp->pages_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->pagesl
+                );
+                tmp_s.config_sp->pagesl = 0;
+            }
+
+            if (tmp_s.config_sp->rampl) {
+                if (strcmp(tmp_s.config_sp->ramp_g, "linear") == 0) {
+                    self_sp->data_s.colour_s.ramp = RAMP_LINEAR;
+                } else if (strcmp(tmp_s.config_sp->ramp_g, "srgb") == 0) {
+                    self_sp->data_s.colour_s.ramp = RAMP_SRGB;
+                } else if (strcmp(tmp_s.config_sp->ramp_g, "gamma") == 0) {
+                    /* "gamma" or "gamma <value>" (2.2 by default). */
+                    self_sp->data_s.colour_s.ramp = RAMP_GAMMA;
+                    self_sp->data_s.colour_s.gamma = 2.2f;
+                } else if (strncmp(tmp_s.config_sp->ramp_g, "gamma ", 6) == 0) {
+                    char *end_gp;
+                    double gamma = strtod(&tmp_s.config_sp->ramp_g[6], &end_gp);
+
+                    while (*end_gp == ' ')
+                        end_gp++;
+                    if (end_gp != &tmp_s.config_sp->ramp_g[6] && ! *end_gp
+                          && gamma > 0 && isfinite(gamma)) {
+                        self_sp->data_s.colour_s.ramp = RAMP_GAMMA;
+                        self_sp->data_s.colour_s.gamma = gamma;
+                    } else {
+                        self_sp->error_mp(self_sp, EINVAL, "ramp");
+                    }
+                } else {
+                    self_sp->error_mp(self_sp, EINVAL, "ramp");
+                }
+
+                memset(
+                    tmp_s.config_sp->ramp_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->rampl
+                );
+                tmp_s.config_sp->rampl = 0;
+            }
+
+            /*
+             * Explicit levels (0 to 255, separated by spaces),
+             * "levels" for all channels,
+             * "rlevels", "glevels" and "blevels" for one channel.
+             */
+            struct {
+                const char *key_gp;
+                unsigned char *lenght_p;
+                char *value_gp;
+                unsigned char first;
+                unsigned char last;
+            } levels_a[4] = {
+                {
+                    "levels",
+                    &tmp_s.config_sp->levelsl,
+                    tmp_s.config_sp->levels_g,
+                    0,
+                    2
+                },
+                {
+                    "rlevels",
+                    &tmp_s.config_sp->rlevelsl,
+                    tmp_s.config_sp->rlevels_g,
+                    0,
+                    0
+                },
+                {
+                    "glevels",
+                    &tmp_s.config_sp->glevelsl,
+                    tmp_s.config_sp->glevels_g,
+                    1,
+                    1
+                },
+                {
+                    "blevels",
+                    &tmp_s.config_sp->blevelsl,
+                    tmp_s.config_sp->blevels_g,
+                    2,
+                    2
+                }
+            };
+
+            for (unsigned char key = 0; key < 4; key++) {
+                char *value_gp = levels_a[key].value_gp;
+                char *end_gp = NULL;
+                unsigned short levell = 0;
+                unsigned char level_a[1 << 8];
+
+                if (! *levels_a[key].lenght_p)
+                    continue;
+
+                while (levell < 1 << 8) {
+                    unsigned long level = strtoul(value_gp, &end_gp, 10);
+
+                    if (end_gp == value_gp || level > (1 << 8) - 1)
+                        break;
+
+                    level_a[levell++] = level;
+                    value_gp = end_gp;
+                }
+
+                /* Anything else than the levels (or none) is an error. */
+                while (*value_gp == ' ')
+                    value_gp++;
+                if (*value_gp || ! levell) {
+                    self_sp->error_mp(self_sp, EINVAL, levels_a[key].key_gp);
+                    levell = 0;
+                }
+
+                for (unsigned char channel = levels_a[key].first;
+                      levell && channel <= levels_a[key].last;
+                      channel++) {
+                    self_sp->data_s.colour_s.levell_a[channel] = levell;
+                    memcpy(
+                        self_sp->data_s.colour_s.level_a[channel],
+                        level_a,
+                        levell
+                    );
+                }
+
+                memset(
+                    levels_a[key].value_gp,
+                    '\0',
+                    sizeof(char) * *levels_a[key].lenght_p
+                );
+                *levels_a[key].lenght_p = 0;
+            }
+            memset(levels_a, 0, sizeof(levels_a));
+
+            if (tmp_s.config_sp->formatl) {
+                const char *format_gpa[] = {
+                    "gpl",
+                    "hex",
+                    "css",
+                    "json",
+                    "c",
+                    "act"
+                };
+                unsigned char format = FORMAT_GPL;
+
+                while (format <= FORMAT_ACT
+                      && strcmp(tmp_s.config_sp->format_g, format_gpa[format]) != 0)
+                    format++;
+
+                if (format <= FORMAT_ACT)
+                    self_sp->emit_s.format = format;
+                else
+                    self_sp->error_mp(self_sp, EINVAL, "format");
+
+                memset(
+                    tmp_s.config_sp->format_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->formatl
+                );
+                tmp_s.config_sp->formatl = 0;
+            }
+
+            if (tmp_s.config_sp->slicel) {
+                /* "start end" or "start" (to the last entry). */
+                char *end_gp = NULL;
+
+                self_sp->emit_s.slice_a[0] = (
+                    strtoul(tmp_s.config_sp->slice_g, &end_gp, 10)
+                );
+                self_sp->emit_s.slice_a[1] = strtoul(end_gp, NULL, 10);
+
+                memset(
+                    tmp_s.config_sp->slice_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->slicel
+                );
+                tmp_s.config_sp->slicel = 0;
+            }
+
+            if (tmp_s.config_sp->sortl) {
+                /*
+                 * luminance, hue, saturation, none
+                 * or "distance [R G B]" (from black by default).
+                 */
+                if (strcmp(tmp_s.config_sp->sort_g, "luminance") == 0) {
+                    self_sp->data_s.sort_s.sort = SORT_LUMINANCE;
+                } else if (strcmp(tmp_s.config_sp->sort_g, "hue") == 0) {
+                    self_sp->data_s.sort_s.sort = SORT_HUE;
+                } else if (strcmp(tmp_s.config_sp->sort_g, "saturation") == 0) {
+                    self_sp->data_s.sort_s.sort = SORT_SATURATION;
+                } else if (strncmp(tmp_s.config_sp->sort_g, "distance", 8) == 0
+                      && (! tmp_s.config_sp->sort_g[8]
+                        || tmp_s.config_sp->sort_g[8] == ' ')) {
+                    char *value_gp = &tmp_s.config_sp->sort_g[8];
+                    unsigned char ref_a[3];
+
+                    for (unsigned char channel = 0; channel < 3; channel++) {
+                        unsigned long value = strtoul(value_gp, &value_gp, 10);
+
+                        ref_a[channel] = value < 1 << 8 ? value : (1 << 8) - 1;
+                    }
+
+                    while (*value_gp == ' ')
+                        value_gp++;
+                    if (*value_gp) {
+                        self_sp->error_mp(self_sp, EINVAL, "sort");
+                    } else {
+                        self_sp->data_s.sort_s.sort = SORT_DISTANCE;
+                        memcpy(self_sp->data_s.sort_s.ref_a, ref_a, 3);
+                    }
+                } else if (strcmp(tmp_s.config_sp->sort_g, "none") == 0) {
+                    self_sp->data_s.sort_s.sort = SORT_NONE;
+                } else {
+                    self_sp->error_mp(self_sp, EINVAL, "sort");
+                }
+
+                memset(
+                    tmp_s.config_sp->sort_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->sortl
+                );
+                tmp_s.config_sp->sortl = 0;
+            }
+
+            if (tmp_s.config_sp->namesl) {
+                /*
+                 * Names of the GPL colours: none, hex (#rrggbb), rgb
+                 * or cvd (the simulated colours, see cvd_lgen_f()).
+                 */
+                if (strcmp(tmp_s.config_sp->names_g, "hex") == 0)
+                    self_sp->emit_s.names = NAMES_HEX;
+                else if (strcmp(tmp_s.config_sp->names_g, "rgb") == 0)
+                    self_sp->emit_s.names = NAMES_RGB;
+                else if (strcmp(tmp_s.config_sp->names_g, "cvd") == 0)
+                    self_sp->emit_s.names = NAMES_CVD;
+                else if (strcmp(tmp_s.config_sp->names_g, "none") == 0)
+                    self_sp->emit_s.names = NAMES_NONE;
+                else
+                    self_sp->error_mp(self_sp, EINVAL, "names");
+
+                memset(
+                    tmp_s.config_sp->names_g,
+                    '\0',
+                    sizeof(char) * tmp_s.config_sp->namesl
+                );
+                tmp_s.config_sp->namesl = 0;
+            }
+        }
+
+        /*
+         * Image palette size friendly to the columns:
+         * a multiple of the columns, if it is possible.
+         */
+        if (self_sp->data_s.pmap_s.columns
+              && self_sp->data_s.image_s.colours
+                > self_sp->data_s.pmap_s.columns)
+            self_sp->data_s.image_s.colours -= (
+                self_sp->data_s.image_s.colours
+                  % self_sp->data_s.pmap_s.columns
+            );
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    void
+    setup_free_f(struct Self *self_sp) {
+        /*
+         * Free what setup_f() and config_f() leave after emit_f().
+         * 0 == '\0' == NULL
+         */
+        free(self_sp->data_s.pmap_s.title_gp);
+        free(self_sp->data_s.copyright_s.author_gp);
+        free(self_sp->data_s.copyright_s.years_gp);
+        free(self_sp->data_s.image_s.path_gp);
+        free(self_sp->data_s.gpl_s.path_gp);
+        free(self_sp->error_s.value_gp);
+        self_sp->data_s.pmap_s.title_gp = NULL;
+        self_sp->data_s.copyright_s.author_gp = NULL;
+        self_sp->data_s.copyright_s.years_gp = NULL;
+        self_sp->data_s.image_s.path_gp = NULL;
+        self_sp->data_s.gpl_s.path_gp = NULL;
+        self_sp->error_s.value_gp = NULL;
+        memset(&self_sp->input_s, 0, sizeof(self_sp->input_s));
+    }
+
+    /*
+     * Stream hashing the output, see verify_f():
+     * the blocks (slots of 64 KiB) are hashed by the threads,
+     * each block on its own, and the stream combines their hashes
+     * in order (the same blocks for any size of the writes).
+     */
+    struct Verify {
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        unsigned char closed: 1;
+        unsigned short slots;
+        unsigned int blockl;
+        char *buffer_gp;
+        unsigned int *lenght_ap;
+        unsigned long long *hash_ap;
+        unsigned char *done_ap;
+        /* Blocks given to the threads, taken by them and combined. */
+        unsigned long long next;
+        unsigned long long taken;
+        unsigned long long combined;
+        unsigned int fill;
+        unsigned short threads;
+        pthread_t *thread_ap;
+        unsigned long long lenght;
+        unsigned long long hash;
+    };
+
+    void
+    verify_block_f(struct Verify *verify_sp, unsigned short slot) {
+        /* The hash of a block (seed 0: it does not wait for the others). */
+        verify_sp->hash_ap[slot] = hash_f(
+            (const unsigned char *)&verify_sp->buffer_gp[(size_t)slot*verify_sp->blockl],
+            verify_sp->lenght_ap[slot],
+            0
+        );
+    }
+
+    void *
+    verify_work_f(void *verify_vp) {
+        /* A thread: the given blocks, in any order. */
+        struct Verify *verify_sp = verify_vp;
+
+        pthread_mutex_lock(&verify_sp->mutex);
+        while (TRUE) {
+            unsigned short slot;
+
+            while (verify_sp->taken == verify_sp->next && ! verify_sp->closed)
+                pthread_cond_wait(&verify_sp->cond, &verify_sp->mutex);
+            if (verify_sp->taken == verify_sp->next)
+                break;
+            slot = verify_sp->taken++ % verify_sp->slots;
+            pthread_mutex_unlock(&verify_sp->mutex);
+
+            verify_block_f(verify_sp, slot);
+
+            pthread_mutex_lock(&verify_sp->mutex);
+            verify_sp->done_ap[slot] = TRUE;
+            pthread_cond_broadcast(&verify_sp->cond);
+        }
+        pthread_mutex_unlock(&verify_sp->mutex);
+
+        return NULL;
+    }
+
+    void
+    verify_combine_f(struct Verify *verify_sp, unsigned short blocks) {
+        /* Combine the block hashes in order, until blocks are left. */
+        pthread_mutex_lock(&verify_sp->mutex);
+        while (verify_sp->next - verify_sp->combined > blocks) {
+            unsigned short slot = verify_sp->combined % verify_sp->slots;
+
+            while (! verify_sp->done_ap[slot])
+                pthread_cond_wait(&verify_sp->cond, &verify_sp->mutex);
+            verify_sp->done_ap[slot] = FALSE;
+            verify_sp->hash = hash_f(
+                (const unsigned char *)&verify_sp->hash_ap[slot],
+                sizeof(unsigned long long),
+                verify_sp->hash
+            );
+            verify_sp->combined++;
+        }
+        pthread_mutex_unlock(&verify_sp->mutex);
+    }
+
+    void
+    verify_give_f(struct Verify *verify_sp) {
+        /* Give the filled block to the threads (hashed here without any). */
+        unsigned short slot = verify_sp->next % verify_sp->slots;
+
+        verify_sp->lenght_ap[slot] = verify_sp->fill;
+        verify_sp->fill = 0;
+        if (! verify_sp->threads) {
+            verify_block_f(verify_sp, slot);
+            verify_sp->done_ap[slot] = TRUE;
+        }
+
+        pthread_mutex_lock(&verify_sp->mutex);
+        verify_sp->next++;
+        pthread_cond_broadcast(&verify_sp->cond);
+        pthread_mutex_unlock(&verify_sp->mutex);
+    }
+
+    ssize_t
+    verify_write_f(void *verify_vp, const char *data_gp, size_t datal) {
+        /* The stream: copy the data on the blocks (the only copy). */
+        struct Verify *verify_sp = verify_vp;
+        size_t writel = datal;
+
+        verify_sp->lenght += datal;
+        while (datal) {
+            unsigned int lenght = verify_sp->blockl - verify_sp->fill;
+
+            /* A new block on a free slot (its last hash combined). */
+            if (! verify_sp->fill)
+                verify_combine_f(verify_sp, verify_sp->slots - 1);
+
+            if (lenght > datal)
+                lenght = datal;
+            memcpy(
+                &verify_sp->buffer_gp[
+                    (size_t)(verify_sp->next % verify_sp->slots)*verify_sp->blockl
+                      + verify_sp->fill
+                ],
+                data_gp,
+                lenght
+            );
+            verify_sp->fill += lenght;
+            data_gp += lenght;
+            datal -= lenght;
+
+            if (verify_sp->fill == verify_sp->blockl)
+                verify_give_f(verify_sp);
+        }
+
+        return writel;
+    }
+
+    void
+    verify_f(struct Self *self_sp, const char *manifest_gp) {
+        /*
+         * Hash the GPL files (as written to a file) of all 520 depths,
+         * 8 gray and 512 rgb, with the default values and the years 2022:
+         * emit_f() writes them on a stream of verify_write_f(),
+         * the hash of a depth is the hash of its lenght
+         * and the combined hashes of its blocks.
+         * Without a manifest, print it,
+         * else print the different depths of the manifest.
+         */
+        cookie_io_functions_t cookie_s = {
+            NULL,
+            &verify_write_f,
+            NULL,
+            NULL
+        };
+        struct {
+            FILE *manifest_lp;
+            unsigned short different;
+            unsigned short depths;
+            struct Verify verify_s;
+            double start;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        if (manifest_gp) {
+            tmp_s.manifest_lp = fopen(manifest_gp, "r");
+            if (! tmp_s.manifest_lp) {
+                self_sp->error_mp(self_sp, errno, manifest_gp);
+                status = 1;
+                return;
+            }
+        }
+
+        tmp_s.start = bench_time_f();
+        pthread_mutex_init(&tmp_s.verify_s.mutex, NULL);
+        pthread_cond_init(&tmp_s.verify_s.cond, NULL);
+        tmp_s.verify_s.slots = 64;
+        tmp_s.verify_s.blockl = 1 << 16;
+        tmp_s.verify_s.buffer_gp = malloc(
+            sizeof(char) * tmp_s.verify_s.slots * tmp_s.verify_s.blockl
+        );
+        tmp_s.verify_s.lenght_ap = calloc(tmp_s.verify_s.slots, sizeof(int));
+        tmp_s.verify_s.hash_ap = calloc(
+            tmp_s.verify_s.slots,
+            sizeof(unsigned long long)
+        );
+        tmp_s.verify_s.done_ap = calloc(tmp_s.verify_s.slots, sizeof(char));
+
+        /* The threads created (none: see verify_give_f()). */
+        tmp_s.verify_s.thread_ap = calloc(
+            self_sp->data_s.task_s.threads,
+            sizeof(pthread_t)
+        );
+        while (tmp_s.verify_s.threads < self_sp->data_s.task_s.threads
+              && pthread_create(
+                  &tmp_s.verify_s.thread_ap[tmp_s.verify_s.threads],
+                  NULL,
+                  &verify_work_f,
+                  &tmp_s.verify_s
+                ) == 0)
+            tmp_s.verify_s.threads++;
+
+        /* gray 1 to 8, then rgb 1 1 1 to 8 8 8 (the blue depth first). */
+        for (unsigned short depth = 0; depth < 8 + (1 << 9); depth++) {
+            struct Input *input_sp = &self_sp->input_s;
+            FILE *output_lp;
+            char line_g[1 << 10];
+            char manifest_g[64];
+
+            self_sp->setup_mp(self_sp);
+            memset(input_sp, 0, sizeof(*input_sp));
+            if (depth < 8) {
+                strcpy(input_sp->type_g, "gray");
+                sprintf(input_sp->depth_g, "%hu", depth + 1);
+            } else {
+                strcpy(input_sp->type_g, "rgb");
+                sprintf(
+                    input_sp->depth_g,
+                    "%hu %hu %hu",
+                    ((depth - 8) >> 6) + 1,
+                    ((depth - 8) >> 3 & 7) + 1,
+                    ((depth - 8) & 7) + 1
+                );
+            }
+            sprintf(line_g, "%s %s", input_sp->type_g, input_sp->depth_g);
+            strcpy(input_sp->years_g, "2022");
+            input_sp->typel = strlen(input_sp->type_g) + 1;
+            input_sp->depthl = strlen(input_sp->depth_g) + 1;
+            input_sp->yearsl = strlen(input_sp->years_g) + 1;
+            self_sp->config_mp(self_sp, input_sp);
+
+            tmp_s.verify_s.lenght = 0;
+            tmp_s.verify_s.hash = 0;
+            output_lp = fopencookie(&tmp_s.verify_s, "w", cookie_s);
+            setvbuf(output_lp, NULL, _IOFBF, 1 << 16);
+            self_sp->emit_mp(self_sp, output_lp);
+            fclose(output_lp);
+
+            /* The last block, all hashes combined, then the lenght. */
+            if (tmp_s.verify_s.fill)
+                verify_give_f(&tmp_s.verify_s);
+            verify_combine_f(&tmp_s.verify_s, 0);
+            tmp_s.verify_s.hash = hash_f(
+                (const unsigned char *)&tmp_s.verify_s.hash,
+                sizeof(unsigned long long),
+                tmp_s.verify_s.lenght
+            );
+
+            /* Lines as "TYPE DEPTH HASH LENGHT". */
+            sprintf(
+                &line_g[strlen(line_g)],
+                " %016llx %llu\n",
+                tmp_s.verify_s.hash,
+                tmp_s.verify_s.lenght
+            );
+
+            if (! tmp_s.manifest_lp) {
+                fputs(line_g, stdout);
+            } else if (! fgets(manifest_g, sizeof(manifest_g), tmp_s.manifest_lp)
+                  || strcmp(manifest_g, line_g) != 0) {
+                printf("different: %s", line_g);
+                tmp_s.different++;
+            }
+            tmp_s.depths++;
+
+            /*
+             * Free unused memory.
+             * 0 == '\0' == NULL
+             */
+            self_sp->setup_free_mp(self_sp);
+        }
+
+        if (tmp_s.manifest_lp) {
+            fprintf(
+                stderr,
+                "verify: %hu of %hu depths different (%.3f s)\n",
+                tmp_s.different,
+                tmp_s.depths,
+                (bench_time_f() - tmp_s.start)/1000.0
+            );
+            fclose(tmp_s.manifest_lp);
+            if (tmp_s.different) {
+                self_sp->error_mp(self_sp, EINVAL, manifest_gp);
+                status = 1;
+            }
+        }
+
+        pthread_mutex_lock(&tmp_s.verify_s.mutex);
+        tmp_s.verify_s.closed = TRUE;
+        pthread_cond_broadcast(&tmp_s.verify_s.cond);
+        pthread_mutex_unlock(&tmp_s.verify_s.mutex);
+        for (unsigned short thread = 0; thread < tmp_s.verify_s.threads; thread++)
+            pthread_join(tmp_s.verify_s.thread_ap[thread], NULL);
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        pthread_mutex_destroy(&tmp_s.verify_s.mutex);
+        pthread_cond_destroy(&tmp_s.verify_s.cond);
+        free(tmp_s.verify_s.buffer_gp);
+        free(tmp_s.verify_s.lenght_ap);
+        free(tmp_s.verify_s.hash_ap);
+        free(tmp_s.verify_s.done_ap);
+        free(tmp_s.verify_s.thread_ap);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    /*
+     * Palette server:
+     * a Unix socket with one config (finput_f() format) by connection,
+     * ended by an empty line or by the end of the writing,
+     * answered with the output file (GPL ends with '\0') from a LRU cache.
+     * "stats" (instead of a config) answers the counters.
+     */
+    struct Body {
+        /* LRU list (the most recent first) and hash chain. */
+        struct Body *prev_sp;
+        struct Body *next_sp;
+        struct Body *chain_sp;
+        unsigned long long hash;
+        /* Parsed config and size and mtime of the image and palette. */
+        struct {
+            struct Input input_s;
+            long long stamp_a[4];
+        } key_s;
+        char *data_gp;
+        size_t datal;
+        /* Connections sending it, it is freed by the last one. */
+        unsigned int refs;
+        unsigned char cached: 1;
+    };
+
+    struct Client {
+        int fd;
+        char request_g[1 << 14];
+        unsigned short requestl;
+        struct Body *body_sp;
+        size_t sent;
+        double start;
+        struct Client *next_sp;
+        /* Open connections (only of the event loop). */
+        struct Client *open_prev_sp;
+        struct Client *open_next_sp;
+    };
+
+    struct Server {
+        int epoll;
+        /* Open connections, closed on the shutdown. */
+        struct Client *open_sp;
+        /* Queue, cache and counters. */
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        struct Client *head_sp;
+        struct Client *tail_sp;
+        struct Body **bucket_ap;
+        unsigned int buckets;
+        struct Body *first_sp;
+        struct Body *last_sp;
+        size_t cachel;
+        size_t cache_cap;
+        unsigned int entries;
+        unsigned long long requests;
+        unsigned long long hits;
+        unsigned long long misses;
+        unsigned long long errors;
+        unsigned long long evictions;
+        /* Latency (request end to last byte) by power of 2 microseconds. */
+        unsigned long long latency_a[32];
+        double latency_sum;
+        double latency_max;
+        /* dTLB counter, see dtlb_open_f(). */
+        int dtlb;
+        unsigned char stop: 1;
+    };
+
+    /* Each worker has its own generator (struct Self). */
+    struct ServerWorker {
+        struct Server *server_sp;
+        struct Self self_s;
+        pthread_t thread;
+    };
+
+    void
+    body_free_f(struct Server *server_sp, struct Body *body_sp) {
+        /* Release a body, free it if it is the last user. */
+        pthread_mutex_lock(&server_sp->mutex);
+        body_sp->refs--;
+        if (body_sp->refs || body_sp->cached)
+            body_sp = NULL;
+        pthread_mutex_unlock(&server_sp->mutex);
+
+        if (body_sp) {
+            free(body_sp->data_gp);
+            free(body_sp);
+        }
+    }
+
+    struct Body *
+    body_lgen_f(
+        struct Server *server_sp,
+        struct Self *self_sp,
+        const char *request_gp,
+        unsigned short requestl
+    ) {
+        /*
+         * Body of a request, from the cache or generated
+         * by the generator of the worker (generated twice
+         * if two misses are simultaneous, only the first one is cached).
+         */
+        struct {
+            struct Body *body_sp;
+            struct Body *found_sp;
+            FILE *file_lp;
+            struct stat stat_s;
+            unsigned int bucket;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        tmp_s.body_sp = calloc(1, sizeof(struct Body));
+        tmp_s.body_sp->refs = 1;
+
+        /* Counters of the server. */
+        if (requestl >= 5 && strncmp(request_gp, "stats", 5) == 0
+              && (requestl == 5 || isspace((unsigned char)request_gp[5]))) {
+            unsigned long long latencies = 0;
+            unsigned long long p50 = 0;
+            unsigned long long p99 = 0;
+            unsigned long long count = 0;
+            long long misses = dtlb_f(server_sp->dtlb);
+
+            tmp_s.file_lp = open_memstream(
+                &tmp_s.body_sp->data_gp,
+                &tmp_s.body_sp->datal
+            );
+
+            pthread_mutex_lock(&server_sp->mutex);
+            for (unsigned char bucket = 0; bucket < 32; bucket++)
+                latencies += server_sp->latency_a[bucket];
+            for (unsigned char bucket = 0; bucket < 32; bucket++) {
+                count += server_sp->latency_a[bucket];
+                if (! p50 && count*2 >= latencies && latencies)
+                    p50 = 1ull << (bucket + 1);
+                if (! p99 && count*100 >= latencies*99 && latencies)
+                    p99 = 1ull << (bucket + 1);
+            }
+            fprintf(
+                tmp_s.file_lp,
+                "requests = %llu\nhits = %llu\nmisses = %llu\nerrors = %llu\n"
+                "hitrate = %.3f\nentries = %u\nbytes = %zu\nevictions = %llu\n"
+                "latency = %.1f us (average)\n"
+                "latency = %llu us (50%% under)\nlatency = %llu us (99%% under)\n"
+                "latency = %.1f us (max)\n"
+                "faults = %ld\n",
+                server_sp->requests,
+                server_sp->hits,
+                server_sp->misses,
+                server_sp->errors,
+                server_sp->hits + server_sp->misses
+                  ? (double)server_sp->hits
+                    / (server_sp->hits + server_sp->misses)
+                  : 0.0,
+                server_sp->entries,
+                server_sp->cachel,
+                server_sp->evictions,
+                latencies ? server_sp->latency_sum*1000.0/latencies : 0.0,
+                p50,
+                p99,
+                server_sp->latency_max*1000.0,
+                faults_f()
+            );
+            /* Without the perf counter, see dtlb_open_f(). */
+            if (misses < 0)
+                fprintf(tmp_s.file_lp, "dtlb = n/a\n");
+            else
+                fprintf(tmp_s.file_lp, "dtlb = %lld misses\n", misses);
+            pthread_mutex_unlock(&server_sp->mutex);
+
+            fclose(tmp_s.file_lp);
+            return tmp_s.body_sp;
+        }
+
+        /* Parse the config (the key) with the generator parser. */
+        tmp_s.file_lp = fmemopen((void *)request_gp, requestl, "r");
+        memset(&self_sp->input_s, 0, sizeof(self_sp->input_s));
+        if (tmp_s.file_lp) {
+            self_sp->finput_mp(self_sp, tmp_s.file_lp);
+            fclose(tmp_s.file_lp);
+        }
+        tmp_s.file_lp = NULL;
+        tmp_s.body_sp->key_s.input_s = self_sp->input_s;
+        memset(&self_sp->input_s, 0, sizeof(self_sp->input_s));
+
+        /* Files of the config are part of the key. */
+        if (tmp_s.body_sp->key_s.input_s.imagel
+              && stat(tmp_s.body_sp->key_s.input_s.image_g, &tmp_s.stat_s) == 0) {
+            tmp_s.body_sp->key_s.stamp_a[0] = tmp_s.stat_s.st_size;
+            tmp_s.body_sp->key_s.stamp_a[1] = tmp_s.stat_s.st_mtime;
+        }
+        if (tmp_s.body_sp->key_s.input_s.palettel
+              && stat(tmp_s.body_sp->key_s.input_s.palette_g, &tmp_s.stat_s) == 0) {
+            tmp_s.body_sp->key_s.stamp_a[2] = tmp_s.stat_s.st_size;
+            tmp_s.body_sp->key_s.stamp_a[3] = tmp_s.stat_s.st_mtime;
+        }
+
+        /* FNV-1a hash of the key. */
+        tmp_s.body_sp->hash = 14695981039346656037ull;
+        for (size_t index = 0; index < sizeof(tmp_s.body_sp->key_s); index++)
+            tmp_s.body_sp->hash = (
+                (tmp_s.body_sp->hash ^ ((unsigned char *)&tmp_s.body_sp->key_s)[index])
+                  * 1099511628211ull
+            );
+        tmp_s.bucket = tmp_s.body_sp->hash % server_sp->buckets;
+
+        pthread_mutex_lock(&server_sp->mutex);
+        server_sp->requests++;
+        for (tmp_s.found_sp = server_sp->bucket_ap[tmp_s.bucket];
+              tmp_s.found_sp;
+              tmp_s.found_sp = tmp_s.found_sp->chain_sp)
+            if (tmp_s.found_sp->hash == tmp_s.body_sp->hash
+                  && memcmp(
+                      &tmp_s.found_sp->key_s,
+                      &tmp_s.body_sp->key_s,
+                      sizeof(tmp_s.found_sp->key_s)
+                  ) == 0)
+                break;
+
+        if (tmp_s.found_sp) {
+            struct Body *found_sp = tmp_s.found_sp;
+
+            server_sp->hits++;
+            found_sp->refs++;
+
+            /* Move it to the front of the LRU list. */
+            if (found_sp != server_sp->first_sp) {
+                found_sp->prev_sp->next_sp = found_sp->next_sp;
+                if (found_sp->next_sp)
+                    found_sp->next_sp->prev_sp = found_sp->prev_sp;
+                else
+                    server_sp->last_sp = found_sp->prev_sp;
+                found_sp->prev_sp = NULL;
+                found_sp->next_sp = server_sp->first_sp;
+                server_sp->first_sp->prev_sp = found_sp;
+                server_sp->first_sp = found_sp;
+            }
+            pthread_mutex_unlock(&server_sp->mutex);
+
+            free(tmp_s.body_sp);
+            memset(&tmp_s, 0, sizeof(tmp_s));
+            return found_sp;
+        }
+        server_sp->misses++;
+        pthread_mutex_unlock(&server_sp->mutex);
+
+        /* Generate it as run_f() does, with the output in memory. */
+        self_sp->setup_mp(self_sp);
+        self_sp->input_s = tmp_s.body_sp->key_s.input_s;
+        self_sp->config_mp(self_sp, &self_sp->input_s);
+
+        tmp_s.file_lp = open_memstream(
+            &tmp_s.body_sp->data_gp,
+            &tmp_s.body_sp->datal
         );
-        memset(
-            tmp_s.header_gp,
-            '\0',
-            self_sp->buffer_s.headerl
+        self_sp->emit_mp(self_sp, tmp_s.file_lp);
+        fclose(tmp_s.file_lp);
+        tmp_s.file_lp = NULL;
+
+        /* The error (with the palette) is not cached. */
+        if (self_sp->error_s.code) {
+            tmp_s.file_lp = open_memstream(
+                &tmp_s.body_sp->data_gp,
+                &tmp_s.body_sp->datal
+            );
+            fprintf(
+                tmp_s.file_lp,
+                "[Error %hhu]: %s: %s\n",
+                self_sp->error_s.code,
+                self_sp->error_s.value_gp,
+                strerror(self_sp->error_s.code)
+            );
+            fclose(tmp_s.file_lp);
+            tmp_s.file_lp = NULL;
+        }
+
+        pthread_mutex_lock(&server_sp->mutex);
+        if (self_sp->error_s.code) {
+            server_sp->errors++;
+            self_sp->error_s.code = 0;
+        } else if (tmp_s.body_sp->datal <= server_sp->cache_cap) {
+            /* Add it to the front and evict from the back. */
+            tmp_s.body_sp->cached = TRUE;
+            tmp_s.body_sp->refs++;
+            tmp_s.body_sp->chain_sp = server_sp->bucket_ap[tmp_s.bucket];
+            server_sp->bucket_ap[tmp_s.bucket] = tmp_s.body_sp;
+            tmp_s.body_sp->next_sp = server_sp->first_sp;
+            if (server_sp->first_sp)
+                server_sp->first_sp->prev_sp = tmp_s.body_sp;
+            else
+                server_sp->last_sp = tmp_s.body_sp;
+            server_sp->first_sp = tmp_s.body_sp;
+            server_sp->cachel += tmp_s.body_sp->datal;
+            server_sp->entries++;
+
+            while (server_sp->cachel > server_sp->cache_cap) {
+                struct Body *last_sp = server_sp->last_sp;
+                struct Body **chain_spp = &server_sp->bucket_ap[
+                    last_sp->hash % server_sp->buckets
+                ];
+
+                while (*chain_spp != last_sp)
+                    chain_spp = &(*chain_spp)->chain_sp;
+                *chain_spp = last_sp->chain_sp;
+
+                server_sp->last_sp = last_sp->prev_sp;
+                server_sp->last_sp->next_sp = NULL;
+                server_sp->cachel -= last_sp->datal;
+                server_sp->entries--;
+                server_sp->evictions++;
+
+                last_sp->cached = FALSE;
+                if (! --last_sp->refs) {
+                    free(last_sp->data_gp);
+                    free(last_sp);
+                }
+            }
+        }
+        pthread_mutex_unlock(&server_sp->mutex);
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        self_sp->setup_free_mp(self_sp);
+
+        return tmp_s.body_sp;
+    }
+
+    void
+    client_close_f(struct Server *server_sp, struct Client *client_sp) {
+        /* Close a connection (of the event loop) and free it. */
+        if (client_sp->open_prev_sp)
+            client_sp->open_prev_sp->open_next_sp = client_sp->open_next_sp;
+        else
+            server_sp->open_sp = client_sp->open_next_sp;
+        if (client_sp->open_next_sp)
+            client_sp->open_next_sp->open_prev_sp = client_sp->open_prev_sp;
+
+        if (client_sp->body_sp)
+            body_free_f(server_sp, client_sp->body_sp);
+        close(client_sp->fd);
+        free(client_sp);
+    }
+
+    void *
+    server_work_f(void *worker_vp) {
+        /* Worker: requests of the queue to bodies to send. */
+        struct ServerWorker *worker_sp = worker_vp;
+        struct Server *server_sp = worker_sp->server_sp;
+
+        while (TRUE) {
+            struct Client *client_sp;
+            struct epoll_event event_s;
+
+            pthread_mutex_lock(&server_sp->mutex);
+            while (! server_sp->head_sp && ! server_sp->stop)
+                pthread_cond_wait(&server_sp->cond, &server_sp->mutex);
+            client_sp = server_sp->head_sp;
+            if (client_sp) {
+                server_sp->head_sp = client_sp->next_sp;
+                if (! server_sp->head_sp)
+                    server_sp->tail_sp = NULL;
+            }
+            pthread_mutex_unlock(&server_sp->mutex);
+
+            if (! client_sp)
+                break;
+
+            client_sp->body_sp = body_lgen_f(
+                server_sp,
+                &worker_sp->self_s,
+                client_sp->request_g,
+                client_sp->requestl
+            );
+
+            /* The event loop streams it. */
+            memset(&event_s, 0, sizeof(event_s));
+            event_s.events = EPOLLOUT;
+            event_s.data.ptr = client_sp;
+            epoll_ctl(server_sp->epoll, EPOLL_CTL_ADD, client_sp->fd, &event_s);
+        }
+
+        return NULL;
+    }
+
+    int
+    server_f(struct Self *self_sp, const char *path_gp, size_t cache_cap) {
+        /*
+         * Serve until SIGINT or SIGTERM:
+         * the event loop reads the requests and writes the bodies,
+         * the workers (the threads value) make the bodies.
+         */
+        struct {
+            struct Server server_s;
+            struct sockaddr_un address_s;
+            int socket;
+            int signal;
+            sigset_t signal_s;
+            struct epoll_event event_a[64];
+            unsigned short threads;
+            struct ServerWorker *worker_ap;
+            int code;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        if (strlen(path_gp) >= sizeof(tmp_s.address_s.sun_path))
+            return ENAMETOOLONG;
+
+        tmp_s.server_s.cache_cap = cache_cap;
+        tmp_s.server_s.buckets = 1 << 12;
+        tmp_s.server_s.bucket_ap = calloc(
+            tmp_s.server_s.buckets,
+            sizeof(struct Body *)
         );
-        memset(
-            tmp_s.pmap_gp,
-            '\0',
-            tmp_s.pmapl
+        pthread_mutex_init(&tmp_s.server_s.mutex, NULL);
+        pthread_cond_init(&tmp_s.server_s.cond, NULL);
+        tmp_s.server_s.dtlb = dtlb_open_f();
+
+        /* Signals to the event loop (blocked before the workers). */
+        sigemptyset(&tmp_s.signal_s);
+        sigaddset(&tmp_s.signal_s, SIGINT);
+        sigaddset(&tmp_s.signal_s, SIGTERM);
+        sigaddset(&tmp_s.signal_s, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &tmp_s.signal_s, NULL);
+        sigdelset(&tmp_s.signal_s, SIGPIPE);
+        tmp_s.signal = signalfd(-1, &tmp_s.signal_s, SFD_NONBLOCK | SFD_CLOEXEC);
+
+        tmp_s.address_s.sun_family = AF_UNIX;
+        strcpy(tmp_s.address_s.sun_path, path_gp);
+        unlink(path_gp);
+
+        tmp_s.socket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        tmp_s.server_s.epoll = epoll_create1(EPOLL_CLOEXEC);
+
+        if (tmp_s.signal < 0
+              || tmp_s.socket < 0
+              || tmp_s.server_s.epoll < 0
+              || bind(
+                  tmp_s.socket,
+                  (struct sockaddr *)&tmp_s.address_s,
+                  sizeof(tmp_s.address_s)
+              ) != 0
+              || listen(tmp_s.socket, SOMAXCONN) != 0) {
+            tmp_s.code = errno;
+        } else {
+            struct epoll_event event_s;
+
+            /* NULL is the socket and the server is the signals. */
+            memset(&event_s, 0, sizeof(event_s));
+            event_s.events = EPOLLIN;
+            event_s.data.ptr = NULL;
+            epoll_ctl(tmp_s.server_s.epoll, EPOLL_CTL_ADD, tmp_s.socket, &event_s);
+            event_s.data.ptr = &tmp_s.server_s;
+            epoll_ctl(tmp_s.server_s.epoll, EPOLL_CTL_ADD, tmp_s.signal, &event_s);
+
+            /* The workers are copies of this generator (after its setup). */
+            tmp_s.worker_ap = calloc(
+                self_sp->data_s.task_s.threads,
+                sizeof(struct ServerWorker)
+            );
+            while (tmp_s.threads < self_sp->data_s.task_s.threads) {
+                struct ServerWorker *worker_sp = &tmp_s.worker_ap[tmp_s.threads];
+
+                worker_sp->server_sp = &tmp_s.server_s;
+                worker_sp->self_s = *self_sp;
+                worker_sp->self_s.error_s.value_gp = NULL;
+
+                /* The workers created serve, without any it is an error. */
+                tmp_s.code = pthread_create(
+                    &worker_sp->thread,
+                    NULL,
+                    &server_work_f,
+                    worker_sp
+                );
+                if (tmp_s.code)
+                    break;
+                tmp_s.threads++;
+            }
+            if (tmp_s.threads)
+                tmp_s.code = 0;
+        }
+
+        while (! tmp_s.code && ! tmp_s.server_s.stop) {
+            int events = epoll_wait(tmp_s.server_s.epoll, tmp_s.event_a, 64, -1);
+
+            for (int event = 0; event < events; event++) {
+                struct Client *client_sp = tmp_s.event_a[event].data.ptr;
+
+                if (client_sp == NULL) {
+                    int fd;
+
+                    while ((fd = accept4(
+                              tmp_s.socket,
+                              NULL,
+                              NULL,
+                              SOCK_NONBLOCK | SOCK_CLOEXEC
+                          )) >= 0) {
+                        struct epoll_event event_s;
+
+                        client_sp = malloc(sizeof(struct Client));
+                        client_sp->fd = fd;
+                        client_sp->requestl = 0;
+                        client_sp->body_sp = NULL;
+                        client_sp->sent = 0;
+                        client_sp->next_sp = NULL;
+                        client_sp->open_prev_sp = NULL;
+                        client_sp->open_next_sp = tmp_s.server_s.open_sp;
+                        if (tmp_s.server_s.open_sp)
+                            tmp_s.server_s.open_sp->open_prev_sp = client_sp;
+                        tmp_s.server_s.open_sp = client_sp;
+
+                        memset(&event_s, 0, sizeof(event_s));
+                        event_s.events = EPOLLIN;
+                        event_s.data.ptr = client_sp;
+                        epoll_ctl(tmp_s.server_s.epoll, EPOLL_CTL_ADD, fd, &event_s);
+                    }
+                } else if ((void *)client_sp == &tmp_s.server_s) {
+                    /* Taken from the signalfd, not pending on the return. */
+                    struct signalfd_siginfo siginfo_s;
+
+                    while (read(tmp_s.signal, &siginfo_s, sizeof(siginfo_s)) > 0)
+                        continue;
+                    tmp_s.server_s.stop = TRUE;
+                } else if (! client_sp->body_sp) {
+                    /* Read the request until an empty line or its end. */
+                    unsigned char done = FALSE;
+                    unsigned char closed = FALSE;
+                    ssize_t readl;
+
+                    while (! done) {
+                        readl = read(
+                            client_sp->fd,
+                            &client_sp->request_g[client_sp->requestl],
+                            sizeof(client_sp->request_g) - 1 - client_sp->requestl
+                        );
+                        if (readl > 0)
+                            client_sp->requestl += readl;
+                        else if (readl == 0)
+                            done = TRUE;
+                        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+                            break;
+                        else
+                            done = closed = TRUE;
+
+                        client_sp->request_g[client_sp->requestl] = '\0';
+                        if (client_sp->requestl == sizeof(client_sp->request_g) - 1
+                              || strstr(client_sp->request_g, "\n\n")
+                              || strcmp(client_sp->request_g, "\n") == 0)
+                            done = TRUE;
+                    }
+
+                    /* Without a request (closed or empty), no answer. */
+                    if (closed || (done && ! client_sp->requestl)) {
+                        client_close_f(&tmp_s.server_s, client_sp);
+                    } else if (done) {
+                        /* Out of the loop until the worker adds it back. */
+                        epoll_ctl(
+                            tmp_s.server_s.epoll,
+                            EPOLL_CTL_DEL,
+                            client_sp->fd,
+                            NULL
+                        );
+                        client_sp->start = bench_time_f();
+
+                        pthread_mutex_lock(&tmp_s.server_s.mutex);
+                        if (tmp_s.server_s.tail_sp)
+                            tmp_s.server_s.tail_sp->next_sp = client_sp;
+                        else
+                            tmp_s.server_s.head_sp = client_sp;
+                        tmp_s.server_s.tail_sp = client_sp;
+                        pthread_cond_signal(&tmp_s.server_s.cond);
+                        pthread_mutex_unlock(&tmp_s.server_s.mutex);
+                    }
+                } else {
+                    /* Stream the body, without a copy. */
+                    struct Body *body_sp = client_sp->body_sp;
+                    ssize_t sentl = 1;
+
+                    while (client_sp->sent < body_sp->datal && sentl > 0) {
+                        sentl = send(
+                            client_sp->fd,
+                            &body_sp->data_gp[client_sp->sent],
+                            body_sp->datal - client_sp->sent,
+                            MSG_NOSIGNAL
+                        );
+                        if (sentl > 0)
+                            client_sp->sent += sentl;
+                    }
+
+                    if (client_sp->sent == body_sp->datal
+                          || (sentl < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                        double latency = bench_time_f() - client_sp->start;
+                        unsigned char bucket = 0;
+
+                        while (bucket < 31 && latency*1000.0 >= 1ull << (bucket + 1))
+                            bucket++;
+
+                        pthread_mutex_lock(&tmp_s.server_s.mutex);
+                        tmp_s.server_s.latency_a[bucket]++;
+                        tmp_s.server_s.latency_sum += latency;
+                        if (latency > tmp_s.server_s.latency_max)
+                            tmp_s.server_s.latency_max = latency;
+                        pthread_mutex_unlock(&tmp_s.server_s.mutex);
+
+                        client_close_f(&tmp_s.server_s, client_sp);
+                    }
+                }
+            }
+
+            if (events < 0 && errno != EINTR)
+                tmp_s.code = errno;
+        }
+
+        /* Stop the workers (the queued requests are answered first). */
+        pthread_mutex_lock(&tmp_s.server_s.mutex);
+        tmp_s.server_s.stop = TRUE;
+        pthread_cond_broadcast(&tmp_s.server_s.cond);
+        pthread_mutex_unlock(&tmp_s.server_s.mutex);
+        for (unsigned short thread = 0; thread < tmp_s.threads; thread++)
+            pthread_join(tmp_s.worker_ap[thread].thread, NULL);
+
+        /*
+         * Free unused memory (the connections not answered,
+         * with their bodies not cached, then the cache).
+         * 0 == '\0' == NULL
+         */
+        while (tmp_s.server_s.open_sp)
+            client_close_f(&tmp_s.server_s, tmp_s.server_s.open_sp);
+        while (tmp_s.server_s.first_sp) {
+            struct Body *body_sp = tmp_s.server_s.first_sp;
+
+            tmp_s.server_s.first_sp = body_sp->next_sp;
+            free(body_sp->data_gp);
+            free(body_sp);
+        }
+        if (tmp_s.socket > 0) {
+            close(tmp_s.socket);
+            unlink(path_gp);
+        }
+        if (tmp_s.signal > 0)
+            close(tmp_s.signal);
+        if (tmp_s.server_s.epoll > 0)
+            close(tmp_s.server_s.epoll);
+        if (tmp_s.server_s.dtlb >= 0)
+            close(tmp_s.server_s.dtlb);
+        pthread_mutex_destroy(&tmp_s.server_s.mutex);
+        pthread_cond_destroy(&tmp_s.server_s.cond);
+        free(tmp_s.server_s.bucket_ap);
+        free(tmp_s.worker_ap);
+        pthread_sigmask(SIG_UNBLOCK, &tmp_s.signal_s, NULL);
+
+        return tmp_s.code;
+    }
+
+    /*
+     * Watch mode: regenerate each output when its config is written.
+     * The header keys (title, author, years and columns) only change
+     * the GPL header: it is written in place if its lenght is the same,
+     * or before a copy of the body (copy_file_range) in a new file.
+     */
+    struct Watch {
+        const char *config_gp;
+        const char *output_gp;
+        const char *name_gp;
+        int watch;
+        struct Input input_s;
+        /* Lenght of the GPL head in the output, 0 for no GPL head. */
+        unsigned short headl;
+        unsigned char ready: 1;
+    };
+
+    unsigned char
+    watch_head_f(const struct Input *previous_sp, const struct Input *input_sp) {
+        /*
+         * TRUE if only the header keys are different
+         * (columns also changes the image palette size).
+         */
+        struct {
+            struct Input previous_s;
+            struct Input input_s;
+        } *tmp_sp = malloc(sizeof(*tmp_sp));
+        unsigned char head = FALSE;
+
+        tmp_sp->previous_s = *previous_sp;
+        tmp_sp->input_s = *input_sp;
+
+        for (struct Input *input_sp = &tmp_sp->previous_s;
+              input_sp;
+              input_sp = (
+                  input_sp == &tmp_sp->previous_s ? &tmp_sp->input_s : NULL
+              )) {
+            memset(input_sp->title_g, 0, sizeof(input_sp->title_g));
+            memset(input_sp->author_g, 0, sizeof(input_sp->author_g));
+            memset(input_sp->years_g, 0, sizeof(input_sp->years_g));
+            input_sp->titlel = input_sp->authorl = input_sp->yearsl = 0;
+
+            if (strcmp(input_sp->type_g, "image") != 0) {
+                memset(input_sp->columns_g, 0, sizeof(input_sp->columns_g));
+                input_sp->columnsl = 0;
+            }
+        }
+
+        head = (
+            memcmp(&tmp_sp->previous_s, &tmp_sp->input_s, sizeof(struct Input)) == 0
         );
-        self_sp->data_s.colour_s.depthl = 0;
-        self_sp->data_s.colour_s.typel = 0;
-        self_sp->buffer_s.headerl = 0;
-        free(self_sp->data_s.colour_s.type_gp);
-        free(tmp_s.header_gp);
-        free(tmp_s.pmap_gp);
-        self_sp->data_s.colour_s.type_gp = NULL;
+
+        free(tmp_sp);
+        return head;
+    }
+
+    void
+    watch_gen_f(struct Self *self_sp, struct Watch *watch_sp) {
+        /* Parse the config and regenerate the output (or its head). */
+        struct {
+            FILE *file_lp;
+            struct Input *input_sp;
+            unsigned char head: 1;
+            char *head_gp;
+            unsigned short headl;
+            char *path_gp;
+            int input;
+            int output;
+            struct stat stat_s;
+            double start;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        tmp_s.file_lp = fopen(watch_sp->config_gp, "r");
+        if (! tmp_s.file_lp) {
+            fprintf(
+                stderr,
+                "[Error %hhu]: %s: %s\n",
+                (unsigned char)errno,
+                watch_sp->config_gp,
+                strerror(errno)
+            );
+            return;
+        }
+
+        tmp_s.start = bench_time_f();
+        memset(&self_sp->input_s, 0, sizeof(self_sp->input_s));
+        self_sp->finput_mp(self_sp, tmp_s.file_lp);
+        fclose(tmp_s.file_lp);
+        tmp_s.file_lp = NULL;
+
+        tmp_s.input_sp = malloc(sizeof(struct Input));
+        *tmp_s.input_sp = self_sp->input_s;
+
+        if (watch_sp->ready) {
+            if (memcmp(tmp_s.input_sp, &watch_sp->input_s, sizeof(struct Input)) == 0) {
+                free(tmp_s.input_sp);
+                memset(&self_sp->input_s, 0, sizeof(self_sp->input_s));
+                return;
+            }
+
+            tmp_s.head = (
+                watch_sp->headl
+                  && watch_head_f(&watch_sp->input_s, tmp_s.input_sp)
+                  && stat(watch_sp->output_gp, &tmp_s.stat_s) == 0
+                  && tmp_s.stat_s.st_size >= watch_sp->headl
+            );
+        }
+
+        self_sp->setup_mp(self_sp);
+        self_sp->config_mp(self_sp, &self_sp->input_s);
+
+        if (tmp_s.head) {
+            /* The GPL type has its title and columns in its palette. */
+            if (strcmp(self_sp->data_s.colour_s.type_gp, "gpl") == 0)
+                self_sp->src_lgen_mp(self_sp);
+            tmp_s.head_gp = self_sp->head_lgen_mp(self_sp);
+            tmp_s.headl = self_sp->emit_s.headl;
+
+            if (tmp_s.headl == watch_sp->headl) {
+                /* The same lenght: only the head is written. */
+                tmp_s.output = open(watch_sp->output_gp, O_WRONLY);
+
+                if (tmp_s.output < 0
+                      || pwrite(tmp_s.output, tmp_s.head_gp, tmp_s.headl, 0)
+                        != tmp_s.headl)
+                    self_sp->error_mp(self_sp, errno, watch_sp->output_gp);
+            } else {
+                /* The new head and the old body in a new file. */
+                loff_t offset = watch_sp->headl;
+                ssize_t copyl = 1;
+
+                tmp_s.path_gp = malloc(sizeof(char) * (strlen(watch_sp->output_gp) + 5));
+                sprintf(tmp_s.path_gp, "%s.tmp", watch_sp->output_gp);
+                tmp_s.input = open(watch_sp->output_gp, O_RDONLY);
+                tmp_s.output = open(
+                    tmp_s.path_gp,
+                    O_WRONLY | O_CREAT | O_TRUNC,
+                    tmp_s.stat_s.st_mode & 0777
+                );
+
+                if (tmp_s.input < 0
+                      || tmp_s.output < 0
+                      || write(tmp_s.output, tmp_s.head_gp, tmp_s.headl)
+                        != tmp_s.headl)
+                    copyl = -1;
+
+                while (copyl > 0 && offset < tmp_s.stat_s.st_size) {
+                    copyl = copy_file_range(
+                        tmp_s.input,
+                        &offset,
+                        tmp_s.output,
+                        NULL,
+                        tmp_s.stat_s.st_size - offset,
+                        0
+                    );
+
+                    /* Other file systems: a copy with a buffer. */
+                    if (copyl < 0 && (errno == EXDEV || errno == ENOSYS
+                          || errno == EINVAL || errno == EOPNOTSUPP)) {
+                        char buffer_g[1 << 16];
+
+                        copyl = pread(tmp_s.input, buffer_g, sizeof(buffer_g), offset);
+                        if (copyl > 0 && write(tmp_s.output, buffer_g, copyl) == copyl)
+                            offset += copyl;
+                        else
+                            copyl = -1;
+                    }
+                }
+
+                if (copyl < 0 || rename(tmp_s.path_gp, watch_sp->output_gp) != 0) {
+                    self_sp->error_mp(self_sp, errno, watch_sp->output_gp);
+                    unlink(tmp_s.path_gp);
+                }
+            }
+
+            if (tmp_s.input > 0)
+                close(tmp_s.input);
+            if (tmp_s.output > 0)
+                close(tmp_s.output);
+            watch_sp->headl = tmp_s.headl;
+            self_sp->emit_free_mp(self_sp, tmp_s.head_gp);
+        } else {
+            tmp_s.file_lp = fopen(watch_sp->output_gp, "w");
+
+            if (tmp_s.file_lp) {
+                self_sp->emit_mp(self_sp, tmp_s.file_lp);
+                fclose(tmp_s.file_lp);
+            } else {
+                self_sp->error_mp(self_sp, errno, watch_sp->output_gp);
+                free(self_sp->data_s.colour_s.type_gp);
+                self_sp->data_s.colour_s.type_gp = NULL;
+            }
+            tmp_s.file_lp = NULL;
+
+            watch_sp->headl = (
+                self_sp->emit_s.format == FORMAT_GPL && ! self_sp->emit_s.start
+                  ? self_sp->emit_s.headl
+                  : 0
+            );
+        }
+
+        printf(
+            "%s: %s %s (%.3f ms)\n",
+            watch_sp->config_gp,
+            tmp_s.head ? "head" : "all",
+            watch_sp->output_gp,
+            bench_time_f() - tmp_s.start
+        );
+        fflush(stdout);
+
+        if (self_sp->error_s.code) {
+            fprintf(
+                stderr,
+                "[Error %hhu]: %s: %s\n",
+                self_sp->error_s.code,
+                self_sp->error_s.value_gp,
+                strerror(self_sp->error_s.code)
+            );
+            self_sp->error_s.code = 0;
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        watch_sp->input_s = *tmp_s.input_sp;
+        watch_sp->ready = TRUE;
+        self_sp->setup_free_mp(self_sp);
+        free(tmp_s.input_sp);
+        free(tmp_s.path_gp);
+
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
+    }
+
+    int
+    watch_f(struct Self *self_sp, int argc, char *arg_gap[]) {
+        /* watch CONFIG OUTPUT [CONFIG OUTPUT]... with inotify. */
+        struct {
+            int inotify;
+            unsigned short watches;
+            struct Watch *watch_ap;
+            char *dir_gp;
+            char buffer_g[1 << 12];
+            int code;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        tmp_s.inotify = inotify_init1(IN_CLOEXEC);
+        if (tmp_s.inotify < 0)
+            return errno;
+
+        tmp_s.watches = argc/2;
+        tmp_s.watch_ap = calloc(tmp_s.watches, sizeof(struct Watch));
+
+        /*
+         * The directory of each config is watched:
+         * editors write a new file and rename it.
+         */
+        for (unsigned short watch = 0; watch < tmp_s.watches; watch++) {
+            struct Watch *watch_sp = &tmp_s.watch_ap[watch];
+
+            watch_sp->config_gp = arg_gap[watch*2];
+            watch_sp->output_gp = arg_gap[watch*2 + 1];
+            watch_sp->name_gp = strrchr(watch_sp->config_gp, '/');
+            watch_sp->name_gp = (
+                watch_sp->name_gp ? watch_sp->name_gp + 1 : watch_sp->config_gp
+            );
+
+            tmp_s.dir_gp = strdup(watch_sp->config_gp);
+            if (watch_sp->name_gp == watch_sp->config_gp)
+                strcpy(tmp_s.dir_gp, ".");
+            else if (watch_sp->name_gp - watch_sp->config_gp > 1)
+                tmp_s.dir_gp[watch_sp->name_gp - watch_sp->config_gp - 1] = '\0';
+            else
+                tmp_s.dir_gp[1] = '\0';
+
+            watch_sp->watch = inotify_add_watch(
+                tmp_s.inotify,
+                tmp_s.dir_gp,
+                IN_CLOSE_WRITE | IN_MOVED_TO
+            );
+            if (watch_sp->watch < 0 && ! tmp_s.code)
+                tmp_s.code = errno;
+            free(tmp_s.dir_gp);
+            tmp_s.dir_gp = NULL;
+
+            watch_gen_f(self_sp, watch_sp);
+        }
+
+        while (! tmp_s.code && tmp_s.watches) {
+            ssize_t readl = read(tmp_s.inotify, tmp_s.buffer_g, sizeof(tmp_s.buffer_g));
+            unsigned char *changed_ap;
+
+            if (readl <= 0) {
+                if (errno != EINTR)
+                    tmp_s.code = errno;
+                continue;
+            }
+
+            /* Changes of one read are regenerated once. */
+            changed_ap = calloc(tmp_s.watches, sizeof(unsigned char));
+            for (char *event_gp = tmp_s.buffer_g;
+                  event_gp < tmp_s.buffer_g + readl;
+                  event_gp += sizeof(struct inotify_event)
+                    + ((struct inotify_event *)event_gp)->len) {
+                struct inotify_event *event_sp = (struct inotify_event *)event_gp;
+
+                for (unsigned short watch = 0; watch < tmp_s.watches; watch++)
+                    if (event_sp->len
+                          && tmp_s.watch_ap[watch].watch == event_sp->wd
+                          && strcmp(tmp_s.watch_ap[watch].name_gp, event_sp->name) == 0)
+                        changed_ap[watch] = TRUE;
+            }
+
+            for (unsigned short watch = 0; watch < tmp_s.watches; watch++)
+                if (changed_ap[watch])
+                    watch_gen_f(self_sp, &tmp_s.watch_ap[watch]);
+            free(changed_ap);
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        close(tmp_s.inotify);
+        free(tmp_s.watch_ap);
+
+        return tmp_s.code;
+    }
+
+    void
+    batch_emit_f(struct Self *self_sp, struct Writer *writer_sp, struct WriterFile *file_sp) {
+        /*
+         * Stream the output as emit_f() on the writer:
+         * the chunks are formatted on its slots (one chunk each)
+         * and the writes continue after the return.
+         */
+        struct {
+            char *head_gp;
+            char *slot_gp;
+            struct Stream stream_s;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        self_sp->src_lgen_mp(self_sp);
+        tmp_s.head_gp = self_sp->head_lgen_mp(self_sp);
+
+        if (! self_sp->emit_s.start) {
+            tmp_s.slot_gp = writer_slot_f(writer_sp);
+            memcpy(tmp_s.slot_gp, tmp_s.head_gp, self_sp->emit_s.headl);
+            writer_write_f(writer_sp, file_sp, tmp_s.slot_gp, self_sp->emit_s.headl);
+        }
+
+        tmp_s.stream_s.chunkl = writer_sp->slotl/self_sp->emit_s.recordl;
+        tmp_s.stream_s.writer_sp = writer_sp;
+        tmp_s.stream_s.file_sp = file_sp;
+        emit_stream_f(self_sp, &tmp_s.stream_s);
+
+        /* The tail and, on GPL, the string terminator. */
+        if (self_sp->emit_s.end == self_sp->emit_s.count) {
+            tmp_s.slot_gp = writer_slot_f(writer_sp);
+            memcpy(tmp_s.slot_gp, self_sp->emit_s.tail_g, self_sp->emit_s.taill);
+            tmp_s.slot_gp[self_sp->emit_s.taill] = '\0';
+            writer_write_f(
+                writer_sp,
+                file_sp,
+                tmp_s.slot_gp,
+                self_sp->emit_s.taill + (self_sp->emit_s.format == FORMAT_GPL)
+            );
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        self_sp->emit_free_mp(self_sp, tmp_s.head_gp);
 
         /*
          * Clear all unused data.
          * 0 == '\0' == NULL
          */
         memset(&tmp_s, '\0', sizeof(tmp_s));
-
-        /* Return the palette string. */
-        return cpal_gp;
     }
 
-    void
-    finput_f(struct Self *self_sp, FILE *input_lp) {
+    int
+    batch_f(struct Self *self_sp, int argc, char *arg_gap[]) {
+        /*
+         * Generate the outputs of the configs (MODE CONFIG OUTPUT...):
+         * "uring" and "threads" write them by the writer
+         * (the next palette is generated while the last is written),
+         * "stdio" as watch (one file after the other).
+         */
+        const char *mode_gpa[] = {"stdio", "threads", "uring"};
         struct {
-            char character;
-            unsigned char keyl: 3;
-            char key_g[8];
-            unsigned char valuel;
-            char value_g[1 << 8];
-            /* 0 is a key type and 1 is a value type. */
-            unsigned char type: 1;
-            /* 1 to ignore characters. */
-            unsigned char ignore: 1;
-        } buffer_s;
-        memset(&buffer_s, '\0', sizeof(buffer_s));
+            unsigned char mode;
+            struct Writer *writer_sp;
+            struct WriterFile *file_sp;
+            FILE *file_lp;
+            unsigned int files;
+            unsigned long long bytes;
+            double start;
+            char *error_gp;
+            int code;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
+
+        while (tmp_s.mode < 3 && strcmp(arg_gap[0], mode_gpa[tmp_s.mode]) != 0)
+            tmp_s.mode++;
+        /* An unknown mode or a config without its output. */
+        if (tmp_s.mode == 3 || argc % 2 == 0)
+            return EINVAL;
+
+        tmp_s.start = bench_time_f();
+        if (tmp_s.mode)
+            tmp_s.writer_sp = writer_open_f(self_sp, tmp_s.mode == 2);
+
+        for (int pair = 1; pair + 1 < argc; pair += 2) {
+            tmp_s.file_lp = fopen(arg_gap[pair], "r");
+            if (! tmp_s.file_lp) {
+                fprintf(
+                    stderr,
+                    "[Error %hhu]: %s: %s\n",
+                    (unsigned char)errno,
+                    arg_gap[pair],
+                    strerror(errno)
+                );
+                continue;
+            }
 
-        while (! feof(input_lp)) {
-            if (! buffer_s.type) {
-                if (buffer_s.keyl < 7) {
-                    if (! buffer_s.ignore) {
-                        buffer_s.key_g[buffer_s.keyl] = fgetc(input_lp);
+            memset(&self_sp->input_s, 0, sizeof(self_sp->input_s));
+            self_sp->finput_mp(self_sp, tmp_s.file_lp);
+            fclose(tmp_s.file_lp);
+            tmp_s.file_lp = NULL;
 
-                        switch (buffer_s.key_g[buffer_s.keyl]) {
-                            case ' ':
-                                buffer_s.key_g[buffer_s.keyl] = '\0';
-                                buffer_s.keyl = 7;
-                                break;
-                            case '\r':
-                            case '\n':
-                                memset(
-                                    buffer_s.key_g,
-                                    '\0',
-                                    sizeof(buffer_s.key_g)
-                                );
-                                buffer_s.keyl = 0;
-                                break;
-                            case '\xff':
-                                buffer_s.key_g[buffer_s.keyl] = '\0';
-                                break;
-                            default:
-                                if (buffer_s.keyl == 6)
-                                    buffer_s.character = '=';
+            self_sp->setup_mp(self_sp);
+            self_sp->config_mp(self_sp, &self_sp->input_s);
 
-                                buffer_s.keyl = ++buffer_s.keyl;
-                        }
-                    } else {
-                        buffer_s.character = fgetc(input_lp);
+            if (tmp_s.writer_sp) {
+                tmp_s.file_sp = writer_file_f(arg_gap[pair + 1]);
 
-                        switch (buffer_s.character) {
-                            case '\r':
-                            case '\n':
-                                buffer_s.character = '\0';
-                                buffer_s.ignore = FALSE;
-                                break;
-                        }
-                    }
+                if (tmp_s.file_sp) {
+                    batch_emit_f(self_sp, tmp_s.writer_sp, tmp_s.file_sp);
+                    writer_close_f(tmp_s.writer_sp, tmp_s.file_sp);
+                    tmp_s.files++;
                 } else {
-                    buffer_s.key_g[buffer_s.keyl] = '\0';
-
-                    if (strcmp(buffer_s.key_g, "type") == 0
-                          || strcmp(buffer_s.key_g, "depth") == 0
-                          || strcmp(buffer_s.key_g, "columns") == 0
-                          || strcmp(buffer_s.key_g, "title") == 0
-                          || strcmp(buffer_s.key_g, "author") == 0
-                          || strcmp(buffer_s.key_g, "years") == 0) {
-                        /* Set as value type. */
-                        buffer_s.type = TRUE;
-                    } else {
-                        memset(buffer_s.key_g, '\0', sizeof(buffer_s.key_g));
-                        buffer_s.keyl = 0;
-                        buffer_s.ignore = TRUE;
-                    }
+                    self_sp->error_mp(self_sp, errno, arg_gap[pair + 1]);
+                    free(self_sp->data_s.colour_s.type_gp);
+                    self_sp->data_s.colour_s.type_gp = NULL;
                 }
+                tmp_s.file_sp = NULL;
             } else {
-                if (buffer_s.valuel < (1 << 8)-1) {
-                    if (! buffer_s.ignore) {
-                        buffer_s.value_g[buffer_s.valuel] = fgetc(input_lp);
+                tmp_s.file_lp = fopen(arg_gap[pair + 1], "w");
+
+                if (tmp_s.file_lp) {
+                    self_sp->emit_mp(self_sp, tmp_s.file_lp);
+                    tmp_s.bytes += ftello(tmp_s.file_lp);
+                    if (fclose(tmp_s.file_lp) != 0)
+                        self_sp->error_mp(self_sp, errno, arg_gap[pair + 1]);
+                    tmp_s.files++;
+                } else {
+                    self_sp->error_mp(self_sp, errno, arg_gap[pair + 1]);
+                    free(self_sp->data_s.colour_s.type_gp);
+                    self_sp->data_s.colour_s.type_gp = NULL;
+                }
+                tmp_s.file_lp = NULL;
+            }
 
-                        switch(buffer_s.value_g[buffer_s.valuel]) {
-                            case '=':
-                                buffer_s.character = '=';
-                                buffer_s.value_g[buffer_s.valuel] = '\0';
-                                break;
-                            case ' ':
-                                if (buffer_s.character == '=') {
-                                    buffer_s.character = '\0';
-                                    buffer_s.value_g[buffer_s.valuel] = '\0';
-                                } else
-                                    buffer_s.valuel = ++buffer_s.valuel;
+            if (self_sp->error_s.code) {
+                fprintf(
+                    stderr,
+                    "[Error %hhu]: %s: %s\n",
+                    self_sp->error_s.code,
+                    self_sp->error_s.value_gp,
+                    strerror(self_sp->error_s.code)
+                );
+                self_sp->error_s.code = 0;
+            }
 
-                                break;
-                            case '\r':
-                            case '\n':
-                                buffer_s.value_g[buffer_s.valuel] = '\0';
-                                buffer_s.valuel = (1 << 8) - 1;
-                                buffer_s.value_g[buffer_s.valuel] = '\0';
-                                break;
-                            case '\xff':
-                                buffer_s.value_g[buffer_s.valuel] = '\0';
-                                break;
-                            default:
-                                if (buffer_s.valuel == (1 << 8) - 2)
-                                    buffer_s.character = '!';
+            /*
+             * Free unused memory.
+             * 0 == '\0' == NULL
+             */
+            self_sp->setup_free_mp(self_sp);
+        }
 
-                                buffer_s.valuel = ++buffer_s.valuel;
-                        }
-                    }
-                } else {
-                    buffer_s.value_g[buffer_s.valuel] = '\0';
+        /* Wait for the last writes (their first error). */
+        if (tmp_s.writer_sp) {
+            if (! tmp_s.writer_sp->uring)
+                tmp_s.mode = 1;
+            tmp_s.code = writer_free_f(
+                tmp_s.writer_sp,
+                &tmp_s.error_gp,
+                &tmp_s.bytes
+            );
+            tmp_s.writer_sp = NULL;
+
+            if (tmp_s.code)
+                fprintf(
+                    stderr,
+                    "[Error %hhu]: %s: %s\n",
+                    (unsigned char)tmp_s.code,
+                    tmp_s.error_gp,
+                    strerror(tmp_s.code)
+                );
+        }
+        tmp_s.start = bench_time_f() - tmp_s.start;
+
+        printf(
+            "batch: %u files, %.1f MiB in %.3f ms (%.1f MiB/s, %s)\n",
+            tmp_s.files,
+            tmp_s.bytes/1048576.0,
+            tmp_s.start,
+            tmp_s.bytes/1048576.0/tmp_s.start*1000.0,
+            mode_gpa[tmp_s.mode]
+        );
 
-                    if (buffer_s.character == '!') {
-                        buffer_s.character = '\0';
-                        buffer_s.ignore = TRUE;
-                    }
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        free(tmp_s.error_gp);
 
-                    if (! buffer_s.ignore) {
+        /*
+         * Clear all unused data.
+         * 0 == '\0' == NULL
+         */
+        memset(&tmp_s, '\0', sizeof(tmp_s));
 
-                        if (strcmp(buffer_s.key_g, "type") == 0) {
-                            strcpy(self_sp->input_s.type_g, buffer_s.value_g);
-                            //self_sp->input_s.typel = buffer_s.valuel;
-                            self_sp->input_s.typel = strlen(buffer_s.value_g) + 1;
-                        } else if (strcmp(buffer_s.key_g, "depth") == 0) {
-                            strcpy(self_sp->input_s.depth_g, buffer_s.value_g);
-                            //self_sp->input_s.depthl = buffer_s.valuel;
-                            self_sp->input_s.depthl = strlen(buffer_s.value_g) + 1;
-                        } else if (strcmp(buffer_s.key_g, "columns") == 0) {
-                            strcpy(self_sp->input_s.columns_g, buffer_s.value_g);
-                            //self_sp->input_s.columnsl = buffer_s.valuel;
-                            self_sp->input_s.columnsl = strlen(buffer_s.value_g) + 1;
-                        } else if (strcmp(buffer_s.key_g, "title") == 0) {
-                            strcpy(self_sp->input_s.title_g, buffer_s.value_g);
-                            //self_sp->input_s.titlel = buffer_s.valuel;
-                            self_sp->input_s.titlel = strlen(buffer_s.value_g) + 1;
-                        } else if (strcmp(buffer_s.key_g, "author") == 0) {
-                            strcpy(self_sp->input_s.author_g, buffer_s.value_g);
-                            //self_sp->input_s.authorl = buffer_s.valuel;
-                            self_sp->input_s.authorl = strlen(buffer_s.value_g) + 1;
-                        } else if (strcmp(buffer_s.key_g, "years") == 0) {
-                            strcpy(self_sp->input_s.years_g, buffer_s.value_g);
-                            //self_sp->input_s.yearsl = buffer_s.valuel;
-                            self_sp->input_s.yearsl = strlen(buffer_s.value_g) + 1;
-                        }
+        return 0;
+    }
 
-                        memset(
-                            buffer_s.key_g,
-                            '\0',
-                            sizeof(buffer_s.key_g)
-                        );
-                        buffer_s.keyl = 0;
-                        memset(
-                            buffer_s.value_g,
-                            '\0',
-                            sizeof(buffer_s.value_g)
-                        );
-                        buffer_s.valuel = 0;
-                        /* Set as key type. */
-                        buffer_s.type = FALSE;
-                    } else {
-                        buffer_s.character = fgetc(input_lp);
+    /*
+     * Fan-out of the output to several sinks (OUTPUT [OUTPUT]...):
+     * the palette is generated once on a stream (fopencookie())
+     * of slots (buffers of 1 MiB) and each sink has its own thread
+     * writing the filled slots in order.
+     * A slow sink stops the generation only when it is all slots
+     * behind, the others write until then.
+     */
+    struct FanoutSink {
+        struct Fanout *fanout_sp;
+        const char *path_gp;
+        int fd;
+        FILE *pipe_lp;
+        unsigned long long done;
+        int code;
+        /* Without a thread, the slots are written by fanout_fill_f(). */
+        unsigned char threaded: 1;
+        pthread_t thread;
+    };
 
-                        switch(buffer_s.character) {
-                            case '\r':
-                            case '\n':
-                                buffer_s.character = '\0';
-                                buffer_s.ignore = FALSE;
-                                break;
-                        }
-                    }
-                }
+    struct Fanout {
+        struct Self *self_sp;
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        unsigned char closed: 1;
+        unsigned short slots;
+        unsigned int slotl;
+        char *buffer_gp;
+        unsigned int *lenght_ap;
+        /* Slots filled (in order) and the bytes of the next one. */
+        unsigned long long next;
+        unsigned int fill;
+        unsigned short sinks;
+        struct FanoutSink *sink_ap;
+    };
+
+    void
+    fanout_error_f(struct Self *self_sp, int code, const char *path_gp) {
+        /*
+         * Save the error of a sink, the one saved before (other sink)
+         * is printed first: one error message by failed sink.
+         */
+        if (self_sp->error_s.code)
+            fprintf(
+                stderr,
+                "[Error %hhu]: %s: %s\n",
+                (unsigned char)self_sp->error_s.code,
+                self_sp->error_s.value_gp,
+                strerror(self_sp->error_s.code)
+            );
+        self_sp->error_mp(self_sp, code, path_gp);
+    }
+
+    void
+    fanout_slot_f(struct FanoutSink *sink_sp, unsigned short slot) {
+        /* Write a slot on the sink (nothing after its first error). */
+        struct Fanout *fanout_sp = sink_sp->fanout_sp;
+        unsigned int done = 0;
+
+        while (! sink_sp->code && done < fanout_sp->lenght_ap[slot]) {
+            ssize_t result = write(
+                sink_sp->fd,
+                &fanout_sp->buffer_gp[(size_t)slot*fanout_sp->slotl + done],
+                fanout_sp->lenght_ap[slot] - done
+            );
+
+            if (result > 0)
+                done += result;
+            else if (result < 0 && errno != EINTR)
+                sink_sp->code = errno;
+        }
+    }
+
+    void *
+    fanout_work_f(void *sink_vp) {
+        /*
+         * A sink: the filled slots, in order.
+         * After an error the slots are only skipped (as written),
+         * a closed pipe is EPIPE (SIGPIPE is blocked on this thread).
+         */
+        struct FanoutSink *sink_sp = sink_vp;
+        struct Fanout *fanout_sp = sink_sp->fanout_sp;
+        sigset_t signal_s;
+
+        sigemptyset(&signal_s);
+        sigaddset(&signal_s, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &signal_s, NULL);
+
+        pthread_mutex_lock(&fanout_sp->mutex);
+        while (TRUE) {
+            while (sink_sp->done == fanout_sp->next && ! fanout_sp->closed)
+                pthread_cond_wait(&fanout_sp->cond, &fanout_sp->mutex);
+            if (sink_sp->done == fanout_sp->next)
+                break;
+            pthread_mutex_unlock(&fanout_sp->mutex);
+
+            fanout_slot_f(sink_sp, sink_sp->done % fanout_sp->slots);
+
+            pthread_mutex_lock(&fanout_sp->mutex);
+            sink_sp->done++;
+            pthread_cond_broadcast(&fanout_sp->cond);
+        }
+        pthread_mutex_unlock(&fanout_sp->mutex);
+
+        return NULL;
+    }
+
+    void
+    fanout_fill_f(struct Fanout *fanout_sp) {
+        /* Give the slot to the sinks, wait for the next one free. */
+        pthread_mutex_lock(&fanout_sp->mutex);
+        fanout_sp->lenght_ap[fanout_sp->next % fanout_sp->slots] = fanout_sp->fill;
+        fanout_sp->next++;
+        fanout_sp->fill = 0;
+        pthread_cond_broadcast(&fanout_sp->cond);
+
+        for (unsigned short sink = 0; sink < fanout_sp->sinks; sink++) {
+            struct FanoutSink *sink_sp = &fanout_sp->sink_ap[sink];
+
+            if (sink_sp->threaded)
+                continue;
+            pthread_mutex_unlock(&fanout_sp->mutex);
+            fanout_slot_f(sink_sp, sink_sp->done % fanout_sp->slots);
+            pthread_mutex_lock(&fanout_sp->mutex);
+            sink_sp->done++;
+        }
+
+        for (unsigned short sink = 0; sink < fanout_sp->sinks; sink++)
+            while (fanout_sp->next - fanout_sp->sink_ap[sink].done >= fanout_sp->slots)
+                pthread_cond_wait(&fanout_sp->cond, &fanout_sp->mutex);
+        pthread_mutex_unlock(&fanout_sp->mutex);
+    }
+
+    ssize_t
+    fanout_write_f(void *fanout_vp, const char *data_gp, size_t datal) {
+        /*
+         * The stream: copy the data on the slots (the only copy).
+         * A full slot is given on the next data, the last byte
+         * is kept for fanout_close_f().
+         */
+        struct Fanout *fanout_sp = fanout_vp;
+        size_t writel = datal;
+
+        while (datal) {
+            unsigned int lenght;
+
+            if (fanout_sp->fill == fanout_sp->slotl)
+                fanout_fill_f(fanout_sp);
+            lenght = fanout_sp->slotl - fanout_sp->fill;
+
+            if (lenght > datal)
+                lenght = datal;
+            memcpy(
+                &fanout_sp->buffer_gp[
+                    (size_t)(fanout_sp->next % fanout_sp->slots)*fanout_sp->slotl
+                      + fanout_sp->fill
+                ],
+                data_gp,
+                lenght
+            );
+            fanout_sp->fill += lenght;
+            data_gp += lenght;
+            datal -= lenght;
+        }
+
+        return writel;
+    }
+
+    int
+    fanout_close_f(void *fanout_vp) {
+        /*
+         * Write the last slot, wait for all sinks and close them.
+         * The GPL terminator written by emit_f() is a new line
+         * on stdout (as a single output).
+         * Their errors are printed by fanout_error_f(), -1 on any error.
+         */
+        struct Fanout *fanout_sp = fanout_vp;
+        struct Self *self_sp = fanout_sp->self_sp;
+        unsigned char terminator = (
+            self_sp->emit_s.terminator
+              && fanout_sp->fill
+              && fanout_sp->buffer_gp[
+                  (size_t)(fanout_sp->next % fanout_sp->slots)*fanout_sp->slotl
+                    + fanout_sp->fill - 1
+                ] == '\0'
+        );
+        int code = 0;
+
+        self_sp->emit_s.terminator = FALSE;
+        fanout_sp->fill -= terminator;
+        if (fanout_sp->fill)
+            fanout_fill_f(fanout_sp);
+
+        pthread_mutex_lock(&fanout_sp->mutex);
+        fanout_sp->closed = TRUE;
+        pthread_cond_broadcast(&fanout_sp->cond);
+        pthread_mutex_unlock(&fanout_sp->mutex);
+
+        for (unsigned short sink = 0; sink < fanout_sp->sinks; sink++) {
+            struct FanoutSink *sink_sp = &fanout_sp->sink_ap[sink];
+
+            if (sink_sp->threaded)
+                pthread_join(sink_sp->thread, NULL);
+
+            if (terminator && ! sink_sp->code) {
+                char terminator_g[] = {
+                    sink_sp->fd == STDOUT_FILENO && ! sink_sp->pipe_lp ? '\n' : '\0'
+                };
+
+                if (write(sink_sp->fd, terminator_g, 1) != 1)
+                    sink_sp->code = errno;
+            }
+
+            /* A command with an exit status is an I/O error. */
+            if (sink_sp->pipe_lp) {
+                if (pclose(sink_sp->pipe_lp) != 0 && ! sink_sp->code)
+                    sink_sp->code = EIO;
+            } else if (sink_sp->fd != STDOUT_FILENO) {
+                if (close(sink_sp->fd) != 0 && ! sink_sp->code)
+                    sink_sp->code = errno;
+            }
+
+            if (sink_sp->code) {
+                fanout_error_f(self_sp, sink_sp->code, sink_sp->path_gp);
+                code = sink_sp->code;
+            }
+        }
+
+        /*
+         * Free unused memory.
+         * 0 == '\0' == NULL
+         */
+        pthread_mutex_destroy(&fanout_sp->mutex);
+        pthread_cond_destroy(&fanout_sp->cond);
+        huge_free_f(fanout_sp->buffer_gp);
+        free(fanout_sp->lenght_ap);
+        free(fanout_sp->sink_ap);
+        free(fanout_sp);
+
+        errno = code;
+        return code ? -1 : 0;
+    }
+
+    unsigned char
+    fanout_file_f(const char *output_gp) {
+        /* TRUE if a fan-out output is a file (not stdout or a command). */
+        return strcmp(output_gp, "-") != 0 && output_gp[0] != '|';
+    }
+
+    FILE *
+    fanout_open_f(struct Self *self_sp, int outputs, char *output_gpa[]) {
+        /*
+         * The stream of the sinks: "-" is stdout, "|COMMAND" a pipe
+         * to the shell command (as "|gzip > palette.gpl.gz"),
+         * other outputs are files.
+         * Sinks not opened are printed by fanout_error_f(), NULL without any.
+         */
+        cookie_io_functions_t cookie_s = {
+            NULL,
+            &fanout_write_f,
+            NULL,
+            &fanout_close_f
+        };
+        struct Fanout *fanout_sp = calloc(1, sizeof(struct Fanout));
+        FILE *output_lp;
+
+        fanout_sp->self_sp = self_sp;
+        fanout_sp->sink_ap = calloc(outputs, sizeof(struct FanoutSink));
+        self_sp->emit_s.terminator = FALSE;
+
+        fflush(stdout);
+        for (int output = 0; output < outputs; output++) {
+            struct FanoutSink *sink_sp = &fanout_sp->sink_ap[fanout_sp->sinks];
+
+            sink_sp->fanout_sp = fanout_sp;
+            sink_sp->path_gp = output_gpa[output];
+
+            if (fanout_file_f(output_gpa[output])) {
+                sink_sp->fd = open(
+                    output_gpa[output],
+                    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644
+                );
+            } else if (output_gpa[output][0] == '|') {
+                sink_sp->pipe_lp = popen(&output_gpa[output][1], "we");
+                sink_sp->fd = sink_sp->pipe_lp ? fileno(sink_sp->pipe_lp) : -1;
+            } else {
+                sink_sp->fd = STDOUT_FILENO;
             }
+
+            if (sink_sp->fd < 0)
+                fanout_error_f(self_sp, errno, output_gpa[output]);
+            else
+                fanout_sp->sinks++;
+        }
+
+        if (! fanout_sp->sinks) {
+            free(fanout_sp->sink_ap);
+            free(fanout_sp);
+            return NULL;
         }
+
+        /* 16 slots of 1 MiB: the bound of a slow sink. */
+        pthread_mutex_init(&fanout_sp->mutex, NULL);
+        pthread_cond_init(&fanout_sp->cond, NULL);
+        fanout_sp->slots = 16;
+        fanout_sp->slotl = 1 << 20;
+        fanout_sp->buffer_gp = huge_alloc_f(
+            (size_t)fanout_sp->slots*fanout_sp->slotl,
+            self_sp->data_s.task_s.pages
+        );
+        fanout_sp->lenght_ap = calloc(fanout_sp->slots, sizeof(int));
+
+        /* A sink without a thread is written by the generation. */
+        for (unsigned short sink = 0; sink < fanout_sp->sinks; sink++)
+            fanout_sp->sink_ap[sink].threaded = ! pthread_create(
+                &fanout_sp->sink_ap[sink].thread,
+                NULL,
+                &fanout_work_f,
+                &fanout_sp->sink_ap[sink]
+            );
+
+        /* Chunks larger than the stdio buffer are copied once. */
+        output_lp = fopencookie(fanout_sp, "w", cookie_s);
+        setvbuf(output_lp, NULL, _IOFBF, 1 << 16);
+
+        return output_lp;
     }
 
     void
     run_f(struct Self *self_sp, int argc, char *arg_gap[]) {
-        /* Default values. */
         struct {
-            unsigned char typel: 3;
-            char type_g[4];
-            unsigned char depthl: 2;
-            char depth_a[3];
-            unsigned char titlel: 4;
-            char title_g[13];
-            unsigned char columns: 5;
-            unsigned char authorl: 4;
-            char author_g[10];
-            unsigned char yearsl: 3;
-            char years_g[5];
-            char code: 1;
-            unsigned char valuel: 3;
-            char value_g[5];
-            time_t tm;
-            struct tm *tm_sp;
             char *input_gp;
             char *output_gp;
+            int outputs;
             FILE *file_lp;
+            int code;
             struct Input *config_sp;
-            char *cpal_gp;
-            unsigned char isdigit: 1;
-        } tmp_s = {
-            4,
-            "rgb",
-            3,
-            {3, 3, 2},
-            13,
-            "GIMP Palette",
-            16,
-            10,
-            "anonymous",
-            5,
-            "\0\0\0\0",
-            0,
-            5,
-            "none",
-            time(NULL),
-            NULL,
-            NULL,
-            NULL,
-            NULL,
-            NULL,
-            FALSE
-        };
-
-        /* Add year value to tmp_s.years_g. */
-        tmp_s.tm_sp = localtime(&tmp_s.tm);
-        sprintf(tmp_s.years_g, "%hu", tmp_s.tm_sp->tm_year + 1900);
-
-        /* Add dynamic memories to a new structure. */
-        self_sp->data_s.colour_s.type_gp = (
-            malloc(sizeof(char) * tmp_s.typel)
-        );
-        self_sp->data_s.pmap_s.title_gp = (
-            malloc(sizeof(char) * tmp_s.titlel)
-        );
-        self_sp->data_s.copyright_s.author_gp = (
-            malloc(sizeof(char) * tmp_s.authorl)
-        );
-        self_sp->data_s.copyright_s.years_gp = (
-            malloc(sizeof(char) * tmp_s.yearsl)
-        );
-        self_sp->error_s.value_gp = (
-            malloc(sizeof(char) * tmp_s.valuel)
-        );
-        memset(
-            self_sp->data_s.colour_s.type_gp,
-            '\0',
-            sizeof(char) * tmp_s.typel
-        );
-        memset(
-            self_sp->data_s.pmap_s.title_gp,
-            '\0',
-            sizeof(char) * tmp_s.titlel
-        );
-        memset(
-            self_sp->data_s.copyright_s.author_gp,
-            '\0',
-            sizeof(char) * tmp_s.authorl
-        );
-        memset(
-            self_sp->data_s.copyright_s.years_gp,
-            '\0',
-            sizeof(char) * tmp_s.yearsl
-        );
-        memset(
-            self_sp->error_s.value_gp,
-            '\0',
-            sizeof(char) * tmp_s.valuel
-        );
-
-        /* Add default values to a new structure. */
-        self_sp->data_s.colour_s.typel = tmp_s.typel;
-        strcpy(self_sp->data_s.colour_s.type_gp, tmp_s.type_g);
-        self_sp->data_s.colour_s.depthl = tmp_s.depthl;
-        memcpy(self_sp->data_s.colour_s.depth_a, tmp_s.depth_a, tmp_s.depthl);
-        self_sp->data_s.pmap_s.titlel = tmp_s.titlel;
-        strcpy(self_sp->data_s.pmap_s.title_gp, tmp_s.title_g);
-        self_sp->data_s.pmap_s.columns = tmp_s.columns;
-        self_sp->data_s.copyright_s.authorl = tmp_s.authorl;
-        strcpy(self_sp->data_s.copyright_s.author_gp, tmp_s.author_g);
-        self_sp->data_s.copyright_s.yearsl = tmp_s.yearsl;
-        strcpy(self_sp->data_s.copyright_s.years_gp, tmp_s.years_g);
-        self_sp->error_s.code = tmp_s.code;
-        self_sp->error_s.valuel = tmp_s.valuel;
-        strcpy(self_sp->error_s.value_gp, tmp_s.value_g);
+            unsigned long long key;
+            unsigned char shift: 2;
+            unsigned char analyse: 1;
+            unsigned char reduce: 1;
+        } tmp_s;
+        memset(&tmp_s, 0, sizeof(tmp_s));
 
         /* Add all functions to a new structure. */
         self_sp->bchn_lgen_mp = &bchn_lgen_f;
+        self_sp->image_lgen_mp = &image_lgen_f;
+        self_sp->space_lgen_mp = &space_lgen_f;
+        self_sp->gradient_lgen_mp = &gradient_lgen_f;
+        self_sp->gpl_lgen_mp = &gpl_lgen_f;
+        self_sp->gpl_free_mp = &gpl_free_f;
+        self_sp->index_mp = &index_f;
+        self_sp->lookup_mp = &lookup_f;
+        self_sp->merge_mp = &merge_f;
+        self_sp->sort_mp = &sort_f;
         self_sp->header_lgen_mp = &header_lgen_f;
+        self_sp->src_lgen_mp = &src_lgen_f;
+        self_sp->head_lgen_mp = &head_lgen_f;
+        self_sp->emit_free_mp = &emit_free_f;
         self_sp->cpal_lgen_mp = &cpal_lgen_f;
+        self_sp->emit_mp = &emit_f;
+        self_sp->render_mp = &render_f;
+        self_sp->analyse_mp = &analyse_f;
+        self_sp->reduce_mp = &reduce_f;
+        self_sp->error_mp = &error_f;
         self_sp->finput_mp = &finput_f;
+        self_sp->setup_mp = &setup_f;
+        self_sp->config_mp = &config_f;
+        self_sp->setup_free_mp = &setup_free_f;
+        self_sp->server_mp = &server_f;
+        self_sp->verify_mp = &verify_f;
+        self_sp->watch_mp = &watch_f;
+        self_sp->batch_mp = &batch_f;
+        self_sp->bench_mp = &bench_f;
         self_sp->run_mp = &run_f;
 
+#if defined(GPLGEN_LIBRARY)
+        /* The pull API continues on its structure (see gplgen_open()). */
+        if (library_s.mode == LIBRARY_NEXT) {
+            library_s.cpall = pull_f(self_sp, library_s.buffer_gp, library_s.cap);
+            return;
+        }
+        if (library_s.mode == LIBRARY_CLOSE) {
+            pull_free_f(self_sp);
+            return;
+        }
+#endif
+
+        self_sp->setup_mp(self_sp);
+
         /* This file is in arg_gap[0]. */
 
-        if (argc > 1)
-            tmp_s.input_gp = arg_gap[1];
+        /* Subcommands (instead of an input file) in arg_gap[1]. */
+        if (argc > 1 && strcmp(arg_gap[1], "bench") == 0) {
+            self_sp->bench_mp(self_sp, argc - 2, &arg_gap[2]);
 
-        if (tmp_s.input_gp) {
-            tmp_s.file_lp = fopen(tmp_s.input_gp, "r");
+            /*
+             * Free unused memory.
+             * 0 == '\0' == NULL
+             */
+            free(self_sp->data_s.colour_s.type_gp);
+            free(self_sp->data_s.pmap_s.title_gp);
+            free(self_sp->data_s.copyright_s.author_gp);
+            free(self_sp->data_s.copyright_s.years_gp);
+            free(self_sp->error_s.value_gp);
+            memset(&self_sp->data_s, '\0', sizeof(self_sp->data_s));
+            memset(&tmp_s, '\0', sizeof(tmp_s));
+            return;
+        }
 
-            if (tmp_s.file_lp) {
-                self_sp->finput_mp(self_sp, tmp_s.file_lp);
-                tmp_s.config_sp = &self_sp->input_s;
-                fclose(tmp_s.file_lp);
-            } else {
-                self_sp->error_s.code = errno;
-                self_sp->error_s.valuel = strlen(tmp_s.input_gp) + 1;
-                self_sp->error_s.value_gp = tmp_s.input_gp;
+        /*
+         * verify [MANIFEST] prints the hashes of all depths
+         * or compares them with the manifest (test/manifest).
+         */
+        if (argc > 1 && strcmp(arg_gap[1], "verify") == 0) {
+            /*
+             * Free unused memory (each depth has its setup).
+             * 0 == '\0' == NULL
+             */
+            free(self_sp->data_s.colour_s.type_gp);
+            free(self_sp->data_s.pmap_s.title_gp);
+            free(self_sp->data_s.copyright_s.author_gp);
+            free(self_sp->data_s.copyright_s.years_gp);
+            free(self_sp->error_s.value_gp);
+            self_sp->error_s.value_gp = NULL;
+
+            self_sp->verify_mp(self_sp, argc > 2 ? arg_gap[2] : NULL);
+
+            if (self_sp->error_s.code) {
+                fprintf(
+                    stderr,
+                    "[Error %hhu]: %s: %s\n",
+                    self_sp->error_s.code,
+                    self_sp->error_s.value_gp,
+                    strerror(self_sp->error_s.code)
+                );
+                free(self_sp->error_s.value_gp);
             }
-            tmp_s.file_lp = NULL;
+
+            /*
+             * Clear all unused data.
+             * 0 == '\0' == NULL
+             */
+            memset(&self_sp->data_s, '\0', sizeof(self_sp->data_s));
+            memset(&tmp_s, '\0', sizeof(tmp_s));
+            return;
         }
-        tmp_s.input_gp = NULL;
 
-        if (tmp_s.config_sp) {
-            if (tmp_s.config_sp->type_g) {
-                memset(
-                    self_sp->data_s.colour_s.type_gp,
-                    '\0',
-                    sizeof(char) * self_sp->data_s.colour_s.typel
-                );
-                self_sp->data_s.colour_s.typel = tmp_s.config_sp->typel;
+        /* watch CONFIG OUTPUT [CONFIG OUTPUT]... regenerates on changes. */
+        if (argc > 3 && strcmp(arg_gap[1], "watch") == 0) {
+            int code;
 
-                self_sp->data_s.colour_s.type_gp = (
-                    realloc(
-                        self_sp->data_s.colour_s.type_gp,
-                        sizeof(char) * self_sp->data_s.colour_s.typel
-                    )
-                );
+            /*
+             * Free unused memory (each change has its setup).
+             * 0 == '\0' == NULL
+             */
+            free(self_sp->data_s.colour_s.type_gp);
+            free(self_sp->data_s.pmap_s.title_gp);
+            free(self_sp->data_s.copyright_s.author_gp);
+            free(self_sp->data_s.copyright_s.years_gp);
+            free(self_sp->error_s.value_gp);
+            self_sp->error_s.value_gp = NULL;
 
-                strcpy(
-                    self_sp->data_s.colour_s.type_gp,
-                    tmp_s.config_sp->type_g
-                );
+            code = self_sp->watch_mp(self_sp, argc - 2, &arg_gap[2]);
 
-                memset(
-                    tmp_s.config_sp->type_g,
-                    '\0',
-                    sizeof(char) * tmp_s.config_sp->typel
-                );
-                tmp_s.config_sp->typel = 0;
-            }
+            if (code)
+                fprintf(stderr, "[Error %hhu]: watch: %s\n", (unsigned char)code, strerror(code));
 
-            if (tmp_s.config_sp->depth_g) {
-                struct {
-                    char *data_ap;
-                    unsigned char lenght: 3;
-                } depth_s = {
-                    malloc(sizeof(char)),
-                    1
-                };
-                depth_s.data_ap[depth_s.lenght - 1] = (
-                    self_sp->data_s.colour_s.depth_a[depth_s.lenght - 1]
+            /*
+             * Clear all unused data.
+             * 0 == '\0' == NULL
+             */
+            memset(&self_sp->data_s, '\0', sizeof(self_sp->data_s));
+            memset(&tmp_s, '\0', sizeof(tmp_s));
+            return;
+        }
+
+        /*
+         * batch MODE CONFIG OUTPUT [CONFIG OUTPUT]... writes the outputs
+         * by io_uring ("uring"), a thread pool ("threads") or "stdio".
+         */
+        if (argc > 4 && strcmp(arg_gap[1], "batch") == 0) {
+            int code;
+
+            /*
+             * Free unused memory (each config has its setup).
+             * 0 == '\0' == NULL
+             */
+            free(self_sp->data_s.colour_s.type_gp);
+            free(self_sp->data_s.pmap_s.title_gp);
+            free(self_sp->data_s.copyright_s.author_gp);
+            free(self_sp->data_s.copyright_s.years_gp);
+            free(self_sp->error_s.value_gp);
+            self_sp->error_s.value_gp = NULL;
+
+            code = self_sp->batch_mp(self_sp, argc - 2, &arg_gap[2]);
+
+            if (code)
+                fprintf(
+                    stderr,
+                    "[Error %hhu]: %s: %s\n",
+                    (unsigned char)code,
+                    arg_gap[2],
+                    strerror(code)
                 );
 
-                for (unsigned char index = 0;
-                      index < tmp_s.config_sp->depthl;
-                      index++) {
-                    if ((index == 0
-                          || index == 2
-                          || index == tmp_s.config_sp->depthl - 2)
-                          && isdigit(tmp_s.config_sp->depth_g[index])) {
-                        depth_s.lenght = index/2 + 1;
+            /*
+             * Clear all unused data.
+             * 0 == '\0' == NULL
+             */
+            free(self_sp->error_s.value_gp);
+            memset(&self_sp->data_s, '\0', sizeof(self_sp->data_s));
+            memset(&tmp_s, '\0', sizeof(tmp_s));
+            return;
+        }
 
-                        depth_s.data_ap[depth_s.lenght - 1] = (
-                            strtoul(
-                                &tmp_s.config_sp->depth_g[index],
-                                NULL,
-                                10
-                            )
-                        );
+        /*
+         * serve SOCKET [CACHE] answers the configs on the Unix socket,
+         * with CACHE MiB of bodies (64 by default).
+         */
+        if (argc > 2 && strcmp(arg_gap[1], "serve") == 0) {
+            int code;
 
-                        if (index < tmp_s.config_sp->depthl - 2) {
-                            depth_s.data_ap = (
-                                realloc(
-                                    depth_s.data_ap,
-                                    sizeof(char) * depth_s.lenght + 1
-                                )
-                            );
-                            depth_s.data_ap[depth_s.lenght] = (
-                                self_sp->data_s.colour_s.depth_a[depth_s.lenght]
-                            );
-                        }
-                    }
+            /*
+             * Free unused memory (each request has its setup).
+             * 0 == '\0' == NULL
+             */
+            free(self_sp->data_s.colour_s.type_gp);
+            free(self_sp->data_s.pmap_s.title_gp);
+            free(self_sp->data_s.copyright_s.author_gp);
+            free(self_sp->data_s.copyright_s.years_gp);
+            free(self_sp->error_s.value_gp);
+            self_sp->error_s.value_gp = NULL;
 
-                    if ((index == 1 || index == 3)
-                          && tmp_s.config_sp->depth_g[index] != ' ') {
-                        break;
-                    }
-                }
+            code = self_sp->server_mp(
+                self_sp,
+                arg_gap[2],
+                (argc > 3 ? strtoull(arg_gap[3], NULL, 10) : 64) << 20
+            );
+
+            if (code)
+                fprintf(
+                    stderr,
+                    "[Error %hhu]: %s: %s\n",
+                    (unsigned char)code,
+                    arg_gap[2],
+                    strerror(code)
+                );
+
+            /*
+             * Clear all unused data.
+             * 0 == '\0' == NULL
+             */
+            memset(&self_sp->data_s, '\0', sizeof(self_sp->data_s));
+            memset(&tmp_s, '\0', sizeof(tmp_s));
+            return;
+        }
 
-                memcpy(self_sp->data_s.colour_s.depth_a, depth_s.data_ap, depth_s.lenght);
+        /*
+         * index PALETTE writes the sidecar index PALETTE.idx,
+         * lookup PALETTE FIRST [LAST] prints the entries
+         * FIRST to LAST (not included) by the sidecar index.
+         */
+        if (argc > 2
+              && (strcmp(arg_gap[1], "index") == 0
+                || strcmp(arg_gap[1], "lookup") == 0)) {
+            struct Palette palette_s;
+            int code = 0;
 
-                memset(depth_s.data_ap, 0, sizeof(char) * depth_s.lenght);
-                free(depth_s.data_ap);
-                memset(&depth_s, 0, sizeof(depth_s));
+            memset(&palette_s, 0, sizeof(palette_s));
 
-                memset(
-                    tmp_s.config_sp->depth_g,
-                    '\0',
-                    sizeof(char) * tmp_s.config_sp->depthl
+            if (arg_gap[1][0] == 'i') {
+                code = self_sp->index_mp(self_sp, arg_gap[2], NULL);
+            } else {
+                unsigned int first = argc > 3 ? strtoul(arg_gap[3], NULL, 10) : 0;
+                unsigned int last = (
+                    argc > 4 ? strtoul(arg_gap[4], NULL, 10) : first + 1
                 );
-                tmp_s.config_sp->depthl = 0;
-            }
 
-            if (tmp_s.config_sp->title_g) {
-                memset(
-                    self_sp->data_s.pmap_s.title_gp,
-                    '\0',
-                    sizeof(char) * self_sp->data_s.pmap_s.titlel
+                code = self_sp->lookup_mp(
+                    self_sp,
+                    arg_gap[2],
+                    first,
+                    last,
+                    &palette_s
                 );
-                self_sp->data_s.pmap_s.titlel = tmp_s.config_sp->titlel;
 
-                self_sp->data_s.pmap_s.title_gp = (
-                    realloc(
-                        self_sp->data_s.pmap_s.title_gp,
-                        sizeof(char) * self_sp->data_s.pmap_s.titlel
-                    )
-                );
+                for (unsigned int entry = 0; entry < palette_s.count; entry++) {
+                    unsigned int name = palette_s.name_ap[entry];
+                    int namel = palette_s.name_ap[entry + 1] - name;
+
+                    printf(
+                        "%3hhu %3hhu %3hhu\t%.*s\n",
+                        palette_s.rgb_ap[entry*3],
+                        palette_s.rgb_ap[entry*3 + 1],
+                        palette_s.rgb_ap[entry*3 + 2],
+                        namel ? namel : 1,
+                        namel ? &palette_s.name_gp[name] : "#"
+                    );
+                }
+                self_sp->gpl_free_mp(&palette_s);
+            }
 
-                strcpy(
-                    self_sp->data_s.pmap_s.title_gp,
-                    tmp_s.config_sp->title_g
+            if (code)
+                fprintf(
+                    stderr,
+                    "[Error %hhu]: %s: %s\n",
+                    (unsigned char)code,
+                    arg_gap[2],
+                    strerror(code)
                 );
 
-                memset(
-                    tmp_s.config_sp->title_g,
-                    '\0',
-                    sizeof(char) * tmp_s.config_sp->titlel
-                );
-                tmp_s.config_sp->titlel = 0;
-            }
+            /*
+             * Free unused memory.
+             * 0 == '\0' == NULL
+             */
+            free(self_sp->data_s.colour_s.type_gp);
+            free(self_sp->data_s.pmap_s.title_gp);
+            free(self_sp->data_s.copyright_s.author_gp);
+            free(self_sp->data_s.copyright_s.years_gp);
+            free(self_sp->error_s.value_gp);
+            memset(&self_sp->data_s, '\0', sizeof(self_sp->data_s));
+            memset(&tmp_s, '\0', sizeof(tmp_s));
+            return;
+        }
 
-            if (tmp_s.config_sp->columns_g) {
-                for (unsigned char index = 0;
-                      index < tmp_s.config_sp->columnsl - 1;
-                      index++)
-                    if (! isdigit(tmp_s.config_sp->columns_g[index]))
-                        break;
-                    else if (index + 1 == tmp_s.config_sp->columnsl - 1)
-                        tmp_s.isdigit = TRUE;
+        /*
+         * merge MODE CONFIG OUTPUT PALETTE...
+         * has the config and output arguments shifted by 2,
+         * "-" as no config and as stdout.
+         */
+        if (argc > 1 && strcmp(arg_gap[1], "merge") == 0)
+            tmp_s.shift = 2;
 
-                if (tmp_s.isdigit
-                      && strtoul(tmp_s.config_sp->columns_g, NULL, 10) >= 0)
-                    self_sp->data_s.pmap_s.columns = (
-                        strtoul(tmp_s.config_sp->columns_g, NULL, 10)
-                    );
+        /*
+         * render CONFIG OUTPUT writes the swatch image
+         * (PNG for a .png output, else PPM),
+         * with the arguments shifted by 1 as merge.
+         */
+        if (argc > 1 && strcmp(arg_gap[1], "render") == 0)
+            tmp_s.shift = 1;
 
-                memset(
-                    tmp_s.config_sp->columns_g,
-                    '\0',
-                    sizeof(char) * tmp_s.config_sp->columnsl
-                );
-                tmp_s.config_sp->columnsl = 0;
-                tmp_s.isdigit = FALSE;
-            }
+        /*
+         * analyse CONFIG OUTPUT writes the statistics of the entries
+         * (JSON), with the arguments shifted by 1 as render.
+         */
+        if (argc > 1 && strcmp(arg_gap[1], "analyse") == 0) {
+            tmp_s.shift = 1;
+            tmp_s.analyse = TRUE;
+        }
 
-            if (tmp_s.config_sp->author_g) {
-                memset(
-                    self_sp->data_s.copyright_s.author_gp,
-                    '\0',
-                    sizeof(char) * self_sp->data_s.copyright_s.authorl
-                );
-                self_sp->data_s.copyright_s.authorl = tmp_s.config_sp->authorl;
+        /*
+         * reduce CONFIG OUTPUT writes the entries reduced to "colours"
+         * (GPL), with the arguments shifted by 1 as render.
+         */
+        if (argc > 1 && strcmp(arg_gap[1], "reduce") == 0) {
+            tmp_s.shift = 1;
+            tmp_s.reduce = TRUE;
+        }
 
-                self_sp->data_s.copyright_s.author_gp = (
-                    realloc(
-                        self_sp->data_s.copyright_s.author_gp,
-                        sizeof(char) * self_sp->data_s.copyright_s.authorl
-                    )
-                );
+        if (argc > 1 + tmp_s.shift
+              && ! (tmp_s.shift && strcmp(arg_gap[1 + tmp_s.shift], "-") == 0))
+            tmp_s.input_gp = arg_gap[1 + tmp_s.shift];
 
-                strcpy(
-                    self_sp->data_s.copyright_s.author_gp,
-                    tmp_s.config_sp->author_g
-                );
+        if (tmp_s.input_gp) {
+            tmp_s.file_lp = fopen(tmp_s.input_gp, "r");
 
-                memset(
-                    tmp_s.config_sp->author_g,
-                    '\0',
-                    sizeof(char) * tmp_s.config_sp->authorl
-                );
-                tmp_s.config_sp->authorl = 0;
+            if (tmp_s.file_lp) {
+                self_sp->finput_mp(self_sp, tmp_s.file_lp);
+                tmp_s.config_sp = &self_sp->input_s;
+                fclose(tmp_s.file_lp);
+            } else {
+                self_sp->error_mp(self_sp, errno, tmp_s.input_gp);
             }
+            tmp_s.file_lp = NULL;
+        }
+        tmp_s.input_gp = NULL;
 
-            if (tmp_s.config_sp->years_g) {
-                for (unsigned char index = 0;
-                      index < tmp_s.config_sp->yearsl - 1;
-                      index++)
-                    if (! isdigit(tmp_s.config_sp->years_g[index]))
-                        break;
-                    else if (index + 1 == tmp_s.config_sp->yearsl - 1)
-                        tmp_s.isdigit = TRUE;
+        /*
+         * Key of the checkpoints (resume), the config as read
+         * and the size and mtime of its image and palette (as the server).
+         */
+        if (tmp_s.config_sp) {
+            long long stamp_a[4] = {0, 0, 0, 0};
+            struct stat stat_s;
 
-                if (tmp_s.isdigit
-                      && strtoul(tmp_s.config_sp->years_g, NULL, 10) > 999
-                      && strtoul(tmp_s.config_sp->years_g, NULL, 10)
-                        < strtoul(tmp_s.years_g, NULL, 10)
-                      || ! tmp_s.isdigit) {
-                    memset(
-                        self_sp->data_s.copyright_s.years_gp,
-                        '\0',
-                        sizeof(char) * self_sp->data_s.copyright_s.yearsl
-                    );
-                    self_sp->data_s.copyright_s.yearsl = tmp_s.config_sp->yearsl;
+            if (tmp_s.config_sp->imagel
+                  && stat(tmp_s.config_sp->image_g, &stat_s) == 0) {
+                stamp_a[0] = stat_s.st_size;
+                stamp_a[1] = stat_s.st_mtime;
+            }
+            if (tmp_s.config_sp->palettel
+                  && stat(tmp_s.config_sp->palette_g, &stat_s) == 0) {
+                stamp_a[2] = stat_s.st_size;
+                stamp_a[3] = stat_s.st_mtime;
+            }
 
-                    self_sp->data_s.copyright_s.years_gp = (
-                        realloc(
-                            self_sp->data_s.copyright_s.years_gp,
-                            sizeof(char) * self_sp->data_s.copyright_s.yearsl
-                        )
-                    );
+            tmp_s.key = hash_f(
+                (const unsigned char *)stamp_a,
+                sizeof(stamp_a),
+                hash_f(
+                    (const unsigned char *)tmp_s.config_sp,
+                    sizeof(*tmp_s.config_sp),
+                    0
+                )
+            );
+        }
 
-                    strcpy(
-                        self_sp->data_s.copyright_s.years_gp,
-                        tmp_s.config_sp->years_g
-                    );
-                } else if (tmp_s.isdigit);
-                else {
-                    memset(
-                        self_sp->data_s.copyright_s.years_gp,
-                        '\0',
-                        sizeof(char) * self_sp->data_s.copyright_s.yearsl
-                    );
-                    self_sp->data_s.copyright_s.yearsl = tmp_s.config_sp->yearsl;
+        self_sp->config_mp(self_sp, tmp_s.config_sp);
 
-                    self_sp->data_s.copyright_s.years_gp = (
-                        realloc(
-                            self_sp->data_s.copyright_s.years_gp,
-                            sizeof(char) * self_sp->data_s.copyright_s.yearsl
-                        )
-                    );
+        if (tmp_s.shift == 2)
+            self_sp->merge_mp(
+                self_sp,
+                argc > 2 ? arg_gap[2] : "merge",
+                argc - 5,
+                &arg_gap[5]
+            );
 
-                    strcpy(
-                        self_sp->data_s.copyright_s.years_gp,
-                        tmp_s.config_sp->years_g
-                    );
-                }
+        if (argc > 2 + tmp_s.shift && strcmp(arg_gap[2 + tmp_s.shift], "-") != 0)
+            tmp_s.output_gp = arg_gap[2 + tmp_s.shift];
 
-                memset(
-                    tmp_s.config_sp->years_g,
-                    '\0',
-                    sizeof(char) * tmp_s.config_sp->yearsl
+        /*
+         * More outputs after OUTPUT (not on merge) are written
+         * from the same generation by a fan-out (see fanout_open_f()).
+         */
+        if (tmp_s.shift < 2 && argc > 3 + tmp_s.shift)
+            tmp_s.outputs = argc - 2 - tmp_s.shift;
+
+#if defined(GPLGEN_LIBRARY)
+        /*
+         * Keep the palette string, without the GPL terminator
+         * (only in the lenght of the file),
+         * or its entries and head for the pull API.
+         */
+        if (library_s.mode == LIBRARY_CPAL || library_s.mode == LIBRARY_OPEN) {
+            if (library_s.mode == LIBRARY_CPAL) {
+                library_s.cpal_gp = self_sp->cpal_lgen_mp(self_sp);
+                library_s.filel = self_sp->buffer_s.cpall;
+                library_s.cpall = (
+                    self_sp->buffer_s.cpall
+                      - (
+                          self_sp->emit_s.format == FORMAT_GPL
+                            && self_sp->emit_s.end == self_sp->emit_s.count
+                        )
                 );
-                tmp_s.config_sp->yearsl = 0;
-                tmp_s.isdigit = FALSE;
+            } else {
+                pull_open_f(self_sp);
             }
-        }
+            library_s.code = self_sp->error_s.code;
 
-        tmp_s.cpal_gp = self_sp->cpal_lgen_mp(self_sp);
-        if (argc > 2)
-            tmp_s.output_gp = arg_gap[2];
+            /*
+             * The library runs again on this structure:
+             * free the paths not taken by src_lgen_f().
+             */
+            free(self_sp->data_s.image_s.path_gp);
+            free(self_sp->data_s.gpl_s.path_gp);
+            self_sp->data_s.image_s.path_gp = NULL;
+            self_sp->data_s.gpl_s.path_gp = NULL;
+        } else
+#endif
+        /* Stream the palette to the output file (or to stdout). */
+        if (tmp_s.analyse || tmp_s.reduce) {
+            tmp_s.file_lp = (
+                tmp_s.outputs
+                  ? fanout_open_f(self_sp, tmp_s.outputs, &arg_gap[2 + tmp_s.shift])
+                  : tmp_s.output_gp ? fopen(tmp_s.output_gp, "w") : stdout
+            );
+            if (tmp_s.file_lp) {
+                if (tmp_s.analyse)
+                    self_sp->analyse_mp(self_sp, tmp_s.file_lp);
+                else
+                    self_sp->reduce_mp(self_sp, tmp_s.file_lp);
+                if (tmp_s.file_lp != stdout)
+                    fclose(tmp_s.file_lp);
+            } else if (! tmp_s.outputs) {
+                self_sp->error_mp(self_sp, errno, tmp_s.output_gp);
+            }
+            tmp_s.file_lp = NULL;
+        } else if (tmp_s.shift == 1) {
+            unsigned char png = (
+                tmp_s.output_gp
+                  && strlen(tmp_s.output_gp) > 4
+                  && strcmp(&tmp_s.output_gp[strlen(tmp_s.output_gp) - 4], ".png") == 0
+            );
 
-        if (tmp_s.output_gp) {
-            tmp_s.file_lp = fopen(tmp_s.output_gp, "w");
+            tmp_s.file_lp = (
+                tmp_s.outputs
+                  ? fanout_open_f(self_sp, tmp_s.outputs, &arg_gap[2 + tmp_s.shift])
+                  : tmp_s.output_gp ? fopen(tmp_s.output_gp, "w") : stdout
+            );
             if (tmp_s.file_lp) {
-                fwrite(
-                    tmp_s.cpal_gp,
-                    sizeof(char),
-                    self_sp->buffer_s.cpall,
-                    tmp_s.file_lp
-                );
-                fclose(tmp_s.file_lp);
+                self_sp->render_mp(self_sp, tmp_s.file_lp, png);
+                if (tmp_s.file_lp != stdout)
+                    fclose(tmp_s.file_lp);
+            } else if (! tmp_s.outputs) {
+                self_sp->error_mp(self_sp, errno, tmp_s.output_gp);
+            }
+            tmp_s.file_lp = NULL;
+        } else if (tmp_s.output_gp || tmp_s.outputs) {
+            /* A fan-out has no checkpoint (resume). */
+            tmp_s.file_lp = (
+                tmp_s.outputs
+                  ? fanout_open_f(self_sp, tmp_s.outputs, &arg_gap[2 + tmp_s.shift])
+                  : self_sp->emit_s.resume
+                    ? ckpt_open_f(self_sp, tmp_s.output_gp, tmp_s.key)
+                    : fopen(tmp_s.output_gp, "w")
+            );
+            if (tmp_s.file_lp) {
+                /* Variant files (cvd) are named by the (first) output file. */
+                if (tmp_s.output_gp
+                      && (! tmp_s.outputs || fanout_file_f(tmp_s.output_gp)))
+                    self_sp->emit_s.cvd_gp = tmp_s.output_gp;
+                else if (self_sp->emit_s.cvd)
+                    self_sp->error_mp(self_sp, EINVAL, "cvd");
+                self_sp->emit_mp(self_sp, tmp_s.file_lp);
+                self_sp->emit_s.cvd_gp = NULL;
+
+                /*
+                 * The checkpoint is only needed until the output ends
+                 * (written without errors),
+                 * the errors of a fan-out are saved by its sinks.
+                 */
+                tmp_s.code = ferror(tmp_s.file_lp) ? EIO : 0;
+                if (fclose(tmp_s.file_lp) != 0)
+                    tmp_s.code = errno;
+                if (tmp_s.code) {
+                    if (! tmp_s.outputs)
+                        self_sp->error_mp(self_sp, tmp_s.code, tmp_s.output_gp);
+                } else if (self_sp->emit_s.ckpt_gp) {
+                    unlink(self_sp->emit_s.ckpt_gp);
+                }
+                free(self_sp->emit_s.ckpt_gp);
+                self_sp->emit_s.ckpt_gp = NULL;
+
+                /* The index of each output file. */
+                for (int output = 0;
+                      self_sp->emit_s.index
+                        && self_sp->emit_s.format == FORMAT_GPL
+                        && output < (tmp_s.outputs ? tmp_s.outputs : 1);
+                      output++) {
+                    char *path_gp = (
+                        tmp_s.outputs
+                          ? arg_gap[2 + tmp_s.shift + output]
+                          : tmp_s.output_gp
+                    );
+                    int code;
+
+                    if (tmp_s.outputs && ! fanout_file_f(path_gp))
+                        continue;
+
+                    code = self_sp->index_mp(
+                        self_sp,
+                        path_gp,
+                        self_sp->emit_s.index_s.recordl
+                          ? &self_sp->emit_s.index_s
+                          : NULL
+                    );
+
+                    if (code)
+                        self_sp->error_mp(self_sp, code, path_gp);
+                }
             } else {
-                self_sp->error_s.code = errno;
-                self_sp->error_s.valuel = strlen(tmp_s.output_gp) + 1;
-                self_sp->error_s.value_gp = tmp_s.output_gp;
-                printf("%s\n", tmp_s.cpal_gp);
+                if (! tmp_s.outputs)
+                    self_sp->error_mp(self_sp, errno, tmp_s.output_gp);
+                self_sp->emit_mp(self_sp, stdout);
             }
             tmp_s.file_lp = NULL;
         } else {
-            printf("%s\n", tmp_s.cpal_gp);
+            /* Variant files (cvd) are named by an output file, not stdout. */
+            if (self_sp->emit_s.cvd)
+                self_sp->error_mp(self_sp, EINVAL, "cvd");
+            self_sp->emit_mp(self_sp, stdout);
         }
         tmp_s.output_gp = NULL;
 
@@ -1309,7 +12330,7 @@ GPLGenC(int argc, char *arg_gap[])
                 "[Error %hhu]: %s: %s\n",
                 error_s.code,
                 error_s.value_gp,
-                strerror(tmp_s.code)
+                strerror(error_s.code)
             );
 
             /*
@@ -1321,11 +12342,6 @@ GPLGenC(int argc, char *arg_gap[])
                 '\0',
                 sizeof(char) * self_sp->error_s.valuel
             );
-            memset(
-                error_s.value_gp,
-                '\0',
-                sizeof(char) * tmp_s.valuel
-            );
             self_sp->error_s.code = 0;
             self_sp->error_s.valuel = 0;
             free(self_sp->error_s.value_gp);
@@ -1338,28 +12354,6 @@ GPLGenC(int argc, char *arg_gap[])
             memset(&error_s, '\0', sizeof(error_s));
         }
 
-        /*
-         * Free unused memory.
-         * 0 == '\0' == NULL
-         */
-        memset(
-            tmp_s.tm_sp,
-            0,
-            sizeof(*tmp_s.tm_sp)
-        );
-        /*memset(
-            tmp_s.config_sp,
-            '\0',
-            sizeof(char) * tmp_s.configl
-        );*/
-        memset(
-            tmp_s.cpal_gp,
-            '\0',
-            sizeof(char) * self_sp->buffer_s.cpall
-        );
-        self_sp->buffer_s.cpall = 0;
-        free(tmp_s.cpal_gp);
-
         /*
          * Clear all unused data.
          * 0 == '\0' == NULL
@@ -1373,6 +12367,16 @@ GPLGenC(int argc, char *arg_gap[])
      */
     static struct Self self_s;
 
+#if defined(GPLGEN_LIBRARY)
+    /* Each context of the pull API has its own structure. */
+    if (library_s.mode == LIBRARY_OPEN)
+        library_s.self_vp = calloc(1, sizeof(struct Self));
+    if (library_s.self_vp) {
+        run_f(library_s.self_vp, argc, arg_gap);
+        return library_s.self_vp;
+    }
+#endif
+
     /*
      * Run this structure function
      * to emulate the class constructor method.
@@ -1384,9 +12388,124 @@ GPLGenC(int argc, char *arg_gap[])
 }
 
 
+#if defined(GPLGEN_LIBRARY)
+/*
+ * Library function of the bindings (gplgen_py.c and gplgen_lua.c):
+ * the palette string of a config file (NULL for the defaults)
+ * and its lenght, to free by gplgen_free().
+ * *filel_p is the lenght of the file written by the command:
+ * a GPL file ends with the string terminator (after the lenght).
+ * As the command, errors are printed and the palette is made anyway,
+ * *code_p is the error code (0 without errors).
+ */
+char *
+gplgen_cpal(
+    const char *input_gp,
+    unsigned long long *cpall_p,
+    unsigned long long *filel_p,
+    int *code_p
+)
+{
+    char *arg_gap[] = {"gplgen", (char *)input_gp, NULL};
+    char *cpal_gp;
+
+    library_s.mode = LIBRARY_CPAL;
+    GPLGenC(input_gp ? 2 : 1, arg_gap);
+
+    cpal_gp = library_s.cpal_gp;
+    *cpall_p = library_s.cpall;
+    *filel_p = library_s.filel;
+    *code_p = library_s.code;
+
+    /*
+     * Clear all unused data.
+     * 0 == '\0' == NULL
+     */
+    memset(&library_s, '\0', sizeof(library_s));
+
+    return cpal_gp;
+}
+
+/* Free a palette string of gplgen_cpal() (it can be 2 MiB pages). */
+void
+gplgen_free(char *cpal_gp)
+{
+    huge_free_f(cpal_gp);
+}
+
+/*
+ * Pull API of the library:
+ * gplgen_open() makes a context of a config file (NULL for the defaults),
+ * each gplgen_next_chunk() writes the next bytes of the palette string
+ * (up to cap, 0 at the end) and gplgen_close() frees the context
+ * at any time (to cancel).
+ * The context has the entries and the loop position only,
+ * a chunk does not allocate memory.
+ */
+struct GPLGenC *
+gplgen_open(const char *input_gp, int *code_p)
+{
+    char *arg_gap[] = {"gplgen", (char *)input_gp, NULL};
+    struct GPLGenC *ctx_p;
+
+    library_s.mode = LIBRARY_OPEN;
+    ctx_p = GPLGenC(input_gp ? 2 : 1, arg_gap);
+    *code_p = library_s.code;
+
+    /*
+     * Clear all unused data.
+     * 0 == '\0' == NULL
+     */
+    memset(&library_s, '\0', sizeof(library_s));
+
+    return ctx_p;
+}
+
+unsigned long long
+gplgen_next_chunk(struct GPLGenC *ctx_p, char *buffer_gp, unsigned long long cap)
+{
+    char *arg_gap[] = {"gplgen", NULL};
+    unsigned long long size;
+
+    library_s.mode = LIBRARY_NEXT;
+    library_s.self_vp = ctx_p;
+    library_s.buffer_gp = buffer_gp;
+    library_s.cap = cap;
+    GPLGenC(1, arg_gap);
+    size = library_s.cpall;
+
+    /*
+     * Clear all unused data.
+     * 0 == '\0' == NULL
+     */
+    memset(&library_s, '\0', sizeof(library_s));
+
+    return size;
+}
+
+void
+gplgen_close(struct GPLGenC *ctx_p)
+{
+    char *arg_gap[] = {"gplgen", NULL};
+
+    library_s.mode = LIBRARY_CLOSE;
+    library_s.self_vp = ctx_p;
+    GPLGenC(1, arg_gap);
+    free(ctx_p);
+
+    /*
+     * Clear all unused data.
+     * 0 == '\0' == NULL
+     */
+    memset(&library_s, '\0', sizeof(library_s));
+}
+#else
 /* Initial C function. */
 int
 main(int argc, char *arg_gap[])
 {
     GPLGenC(argc, arg_gap);
+
+    return status;
 }
+#endif
@@ -0,0 +1,52 @@
+/* C17 - ISO/IEC 9899:2018 standard revision */
+
+/*
+ * A GIMP palette generator (library functions)
+ * Copyright (C) 2022 Márcio Silva <coadde@hyperbola.info>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Library functions of gplgen.c (built with GPLGEN_LIBRARY),
+ * as used by the bindings (gplgen_py.c and gplgen_lua.c):
+ * gplgen_cpal() and gplgen_free() for the whole palette string,
+ * gplgen_open(), gplgen_next_chunk() and gplgen_close()
+ * for the pull API (see them in gplgen.c).
+ */
+
+#if ! defined(GPLGEN_H)
+#define GPLGEN_H
+
+/* Context of the pull API (opaque). */
+struct GPLGenC;
+
+char *gplgen_cpal(
+    const char *input_gp,
+    unsigned long long *cpall_p,
+    unsigned long long *filel_p,
+    int *code_p
+);
+void gplgen_free(char *cpal_gp);
+
+struct GPLGenC *gplgen_open(const char *input_gp, int *code_p);
+unsigned long long gplgen_next_chunk(
+    struct GPLGenC *ctx_p,
+    char *buffer_gp,
+    unsigned long long cap
+);
+void gplgen_close(struct GPLGenC *ctx_p);
+
+#endif
@@ -0,0 +1,208 @@
+/* C17 - ISO/IEC 9899:2018 standard revision */
+
+/*
+ * A GIMP palette generator (Lua module)
+ * Copyright (C) 2022 Márcio Silva <coadde@hyperbola.info>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Lua 5.4 C module (make lua) of the C generator,
+ * with the metatable of gplgen.lua:
+ *
+ *     require('gplgen_c')
+ *     palette = GPLGenC:new_f({[0] = 'gplgen', 'CONFIG', 'OUTPUT'})
+ *     text = palette:cpal_lgen_m()
+ *
+ * GPLGenC:new_f(args) runs as the script (OUTPUT or stdout),
+ * OUTPUT is the file of the command (with the GPL string terminator)
+ * and an error of the config raises a Lua error after the output.
+ * The object (userdata) keeps the palette string of the C generator:
+ * #palette is its lenght and run_m() writes it without a copy,
+ * only cpal_lgen_m() and tostring() copy it (as a Lua string).
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <lauxlib.h>
+#include <lua.h>
+
+/* Library functions of gplgen.c (make lua builds it with GPLGEN_LIBRARY). */
+#include "gplgen.h"
+
+/* The object (userdata), not the context of the pull API. */
+struct GPLGenCObject {
+    char *cpal_gp;
+    unsigned long long cpall;
+    /* Lenght of the output file (with the GPL string terminator). */
+    unsigned long long filel;
+};
+
+static int
+run_m(lua_State *lua_sp) {
+    struct GPLGenCObject *self_sp = luaL_checkudata(lua_sp, 1, "GPLGenC");
+    int code;
+    struct {
+        const char *input_gp;
+        const char *output_gp;
+        FILE *file_lp;
+        int code;
+    } tmp_s;
+    memset(&tmp_s, 0, sizeof(tmp_s));
+
+    /* This script is in args[0]. */
+    if (lua_istable(lua_sp, 2)) {
+        lua_geti(lua_sp, 2, 1);
+        lua_geti(lua_sp, 2, 2);
+        tmp_s.input_gp = lua_tostring(lua_sp, -2);
+        tmp_s.output_gp = lua_tostring(lua_sp, -1);
+    }
+
+    gplgen_free(self_sp->cpal_gp);
+    self_sp->cpal_gp = gplgen_cpal(
+        tmp_s.input_gp,
+        &self_sp->cpall,
+        &self_sp->filel,
+        &tmp_s.code
+    );
+
+    /* As the script, print the palette on output errors. */
+    if (tmp_s.output_gp) {
+        tmp_s.file_lp = fopen(tmp_s.output_gp, "w");
+
+        if (! tmp_s.file_lp)
+            fprintf(
+                stderr,
+                "[Error %hhu]: %s: %s\n",
+                (unsigned char)errno,
+                tmp_s.output_gp,
+                strerror(errno)
+            );
+    }
+
+    /* As the command: the file as written, stdout with a new line. */
+    fwrite(
+        self_sp->cpal_gp,
+        sizeof(char),
+        tmp_s.file_lp ? self_sp->filel : self_sp->cpall,
+        tmp_s.file_lp ? tmp_s.file_lp : stdout
+    );
+    if (tmp_s.file_lp) {
+        fclose(tmp_s.file_lp);
+    } else {
+        fputc('\n', stdout);
+        fflush(stdout);
+    }
+
+    /* The error of the config (printed by the library) as a Lua error. */
+    code = tmp_s.code;
+
+    /*
+     * Clear all unused data.
+     * 0 == '\0' == NULL
+     */
+    memset(&tmp_s, '\0', sizeof(tmp_s));
+
+    if (code)
+        return luaL_error(lua_sp, "[Error %d]: %s", code, strerror(code));
+    return 0;
+}
+
+static int
+cpal_lgen_m(lua_State *lua_sp) {
+    struct GPLGenCObject *self_sp = luaL_checkudata(lua_sp, 1, "GPLGenC");
+
+    lua_pushlstring(lua_sp, self_sp->cpal_gp ? self_sp->cpal_gp : "", self_sp->cpall);
+    return 1;
+}
+
+static int
+len_m(lua_State *lua_sp) {
+    struct GPLGenCObject *self_sp = luaL_checkudata(lua_sp, 1, "GPLGenC");
+
+    lua_pushinteger(lua_sp, self_sp->cpall);
+    return 1;
+}
+
+static int
+gc_m(lua_State *lua_sp) {
+    struct GPLGenCObject *self_sp = luaL_checkudata(lua_sp, 1, "GPLGenC");
+
+    /*
+     * Free unused memory.
+     * 0 == '\0' == NULL
+     */
+    gplgen_free(self_sp->cpal_gp);
+    self_sp->cpal_gp = NULL;
+    self_sp->cpall = 0;
+    self_sp->filel = 0;
+
+    return 0;
+}
+
+static int
+new_f(lua_State *lua_sp) {
+    struct GPLGenCObject *self_sp;
+
+    /* GPLGenC:new_f(args), self is the GPLGenC table. */
+    self_sp = lua_newuserdata(lua_sp, sizeof(struct GPLGenCObject));
+    memset(self_sp, 0, sizeof(*self_sp));
+    luaL_setmetatable(lua_sp, "GPLGenC");
+
+    /* Run this method to emulate the class constructor. */
+    lua_pushcfunction(lua_sp, &run_m);
+    lua_pushvalue(lua_sp, -2);
+    lua_pushvalue(lua_sp, 2);
+    lua_call(lua_sp, 2, 0);
+
+    /* Return to a new userdata as class object. */
+    return 1;
+}
+
+int
+luaopen_gplgen_c(lua_State *lua_sp) {
+    static const luaL_Reg method_a[] = {
+        {"run_m", &run_m},
+        {"cpal_lgen_m", &cpal_lgen_m},
+        {NULL, NULL}
+    };
+    static const luaL_Reg meta_a[] = {
+        {"__len", &len_m},
+        {"__tostring", &cpal_lgen_m},
+        {"__gc", &gc_m},
+        {NULL, NULL}
+    };
+    static const luaL_Reg class_a[] = {
+        {"new_f", &new_f},
+        {NULL, NULL}
+    };
+
+    luaL_newmetatable(lua_sp, "GPLGenC");
+    luaL_setfuncs(lua_sp, meta_a, 0);
+    luaL_newlib(lua_sp, method_a);
+    lua_setfield(lua_sp, -2, "__index");
+    lua_pop(lua_sp, 1);
+
+    /* The GPLGenC table (class) as the script, also returned. */
+    luaL_newlib(lua_sp, class_a);
+    lua_pushvalue(lua_sp, -1);
+    lua_setglobal(lua_sp, "GPLGenC");
+
+    return 1;
+}
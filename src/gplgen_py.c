@@ -0,0 +1,274 @@
+/* C17 - ISO/IEC 9899:2018 standard revision */
+
+/*
+ * A GIMP palette generator (Python module)
+ * Copyright (C) 2022 Márcio Silva <coadde@hyperbola.info>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * CPython extension module (make python) of the C generator,
+ * with the class of gplgen.py:
+ *
+ *     from gplgen_c import GPLGenC
+ *     palette = GPLGenC(['gplgen', 'CONFIG', 'OUTPUT'])
+ *     view = palette.cpal_lgen_m()
+ *
+ * GPLGenC(args) runs as the script (OUTPUT or stdout),
+ * OUTPUT is the file of the command (with the GPL string terminator)
+ * and an error of the config raises OSError after the output.
+ * The object keeps the palette string as a read-only buffer
+ * (memoryview() and cpal_lgen_m() do not copy it).
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Library functions of gplgen.c (make python builds it with GPLGEN_LIBRARY). */
+#include "gplgen.h"
+
+typedef struct {
+    PyObject_HEAD
+    char *cpal_gp;
+    unsigned long long cpall;
+    /* Lenght of the output file (with the GPL string terminator). */
+    unsigned long long filel;
+    /* Buffers exported (the palette string is kept until 0). */
+    Py_ssize_t exports;
+} GPLGenCObject;
+
+static PyObject *
+run_m(GPLGenCObject *self_sp, PyObject *args_op) {
+    struct {
+        PyObject *list_op;
+        const char *input_gp;
+        const char *output_gp;
+        FILE *file_lp;
+        int code;
+    } tmp_s;
+    memset(&tmp_s, 0, sizeof(tmp_s));
+
+    if (! PyArg_ParseTuple(args_op, "|O", &tmp_s.list_op))
+        return NULL;
+    if (self_sp->exports) {
+        PyErr_SetString(PyExc_BufferError, "the palette has exported buffers");
+        return NULL;
+    }
+
+    /* This script is in args[0]. */
+    if (tmp_s.list_op) {
+        tmp_s.list_op = PySequence_Fast(tmp_s.list_op, "args must be a sequence");
+        if (! tmp_s.list_op)
+            return NULL;
+
+        if (PySequence_Fast_GET_SIZE(tmp_s.list_op) > 1)
+            tmp_s.input_gp = PyUnicode_AsUTF8(
+                PySequence_Fast_GET_ITEM(tmp_s.list_op, 1)
+            );
+        if (PySequence_Fast_GET_SIZE(tmp_s.list_op) > 2)
+            tmp_s.output_gp = PyUnicode_AsUTF8(
+                PySequence_Fast_GET_ITEM(tmp_s.list_op, 2)
+            );
+        if (PyErr_Occurred()) {
+            Py_DECREF(tmp_s.list_op);
+            return NULL;
+        }
+    }
+
+    gplgen_free(self_sp->cpal_gp);
+    self_sp->cpal_gp = gplgen_cpal(
+        tmp_s.input_gp,
+        &self_sp->cpall,
+        &self_sp->filel,
+        &tmp_s.code
+    );
+
+    /* As the script, print the palette on output errors. */
+    if (tmp_s.output_gp) {
+        tmp_s.file_lp = fopen(tmp_s.output_gp, "w");
+
+        if (! tmp_s.file_lp)
+            fprintf(
+                stderr,
+                "[Error %hhu]: %s: %s\n",
+                (unsigned char)errno,
+                tmp_s.output_gp,
+                strerror(errno)
+            );
+    }
+    if (! tmp_s.file_lp) {
+        PyObject *stdout_op = PySys_GetObject("stdout");
+
+        /* Python writes its buffered text before the palette. */
+        if (stdout_op && ! PyObject_CallMethod(stdout_op, "flush", NULL))
+            PyErr_Clear();
+    }
+
+    /* As the command: the file as written, stdout with a new line. */
+    fwrite(
+        self_sp->cpal_gp,
+        sizeof(char),
+        tmp_s.file_lp ? self_sp->filel : self_sp->cpall,
+        tmp_s.file_lp ? tmp_s.file_lp : stdout
+    );
+    if (tmp_s.file_lp) {
+        fclose(tmp_s.file_lp);
+    } else {
+        fputc('\n', stdout);
+        fflush(stdout);
+    }
+
+    /* The error of the config (printed by the library) as OSError. */
+    if (tmp_s.code) {
+        errno = tmp_s.code;
+        PyErr_SetFromErrno(PyExc_OSError);
+    }
+
+    /*
+     * Clear all unused data.
+     * 0 == '\0' == NULL
+     */
+    Py_XDECREF(tmp_s.list_op);
+    memset(&tmp_s, '\0', sizeof(tmp_s));
+
+    if (PyErr_Occurred())
+        return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+cpal_lgen_m(GPLGenCObject *self_sp, PyObject *Py_UNUSED(args_op)) {
+    /* A read-only view of the palette string (no copy). */
+    return PyMemoryView_FromObject((PyObject *)self_sp);
+}
+
+static int
+init_m(GPLGenCObject *self_sp, PyObject *args_op, PyObject *kwds_op) {
+    PyObject *none_op;
+
+    if (kwds_op && PyDict_Size(kwds_op)) {
+        PyErr_SetString(PyExc_TypeError, "GPLGenC() takes no keyword arguments");
+        return -1;
+    }
+
+    /* Run this method to emulate the class constructor. */
+    none_op = run_m(self_sp, args_op);
+    if (! none_op)
+        return -1;
+    Py_DECREF(none_op);
+
+    return 0;
+}
+
+static void
+dealloc_m(GPLGenCObject *self_sp) {
+    /*
+     * Free unused memory.
+     * 0 == '\0' == NULL
+     */
+    gplgen_free(self_sp->cpal_gp);
+    self_sp->cpal_gp = NULL;
+    Py_TYPE(self_sp)->tp_free((PyObject *)self_sp);
+}
+
+static int
+getbuffer_m(GPLGenCObject *self_sp, Py_buffer *view_sp, int flags) {
+    int code = PyBuffer_FillInfo(
+        view_sp,
+        (PyObject *)self_sp,
+        self_sp->cpal_gp,
+        self_sp->cpall,
+        1,
+        flags
+    );
+
+    if (! code)
+        self_sp->exports++;
+
+    return code;
+}
+
+static void
+releasebuffer_m(GPLGenCObject *self_sp, Py_buffer *Py_UNUSED(view_sp)) {
+    self_sp->exports--;
+}
+
+static PyMethodDef method_a[] = {
+    {
+        "run_m",
+        (PyCFunction)run_m,
+        METH_VARARGS,
+        "Make the palette of args (script, config, output)."
+    },
+    {
+        "cpal_lgen_m",
+        (PyCFunction)cpal_lgen_m,
+        METH_NOARGS,
+        "Return the palette string as a read-only memoryview."
+    },
+    {NULL}
+};
+
+static PyBufferProcs buffer_s = {
+    (getbufferproc)getbuffer_m,
+    (releasebufferproc)releasebuffer_m
+};
+
+static PyTypeObject type_s = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "gplgen_c.GPLGenC",
+    .tp_doc = "A GIMP palette generator (C engine).",
+    .tp_basicsize = sizeof(GPLGenCObject),
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc)init_m,
+    .tp_dealloc = (destructor)dealloc_m,
+    .tp_as_buffer = &buffer_s,
+    .tp_methods = method_a
+};
+
+static struct PyModuleDef module_s = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "gplgen_c",
+    .m_doc = "A GIMP palette generator (C engine).",
+    .m_size = -1
+};
+
+PyMODINIT_FUNC
+PyInit_gplgen_c(void) {
+    PyObject *module_op;
+
+    if (PyType_Ready(&type_s) < 0)
+        return NULL;
+
+    module_op = PyModule_Create(&module_s);
+    if (! module_op)
+        return NULL;
+
+    Py_INCREF(&type_s);
+    if (PyModule_AddObject(module_op, "GPLGenC", (PyObject *)&type_s) < 0) {
+        Py_DECREF(&type_s);
+        Py_DECREF(module_op);
+        return NULL;
+    }
+
+    return module_op;
+}
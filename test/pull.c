@@ -0,0 +1,119 @@
+/* C17 - ISO/IEC 9899:2018 standard revision */
+
+/*
+ * A GIMP palette generator (pull API test)
+ * Copyright (C) 2022 Márcio Silva <coadde@hyperbola.info>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Test of the pull API (make verify_pull):
+ *
+ *     gplgen_pull CONFIG...
+ *
+ * the chunks of gplgen_next_chunk(), one after another, are the palette
+ * string of gplgen_cpal() for each cap (1 byte, a small odd cap and
+ * 64 KiB). The exit status is 1 if any is different.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Library functions of gplgen.c (built with GPLGEN_LIBRARY). */
+#include "gplgen.h"
+
+int
+main(int argc, char *arg_gap[])
+{
+    static const unsigned long long cap_a[3] = {1, 4093, 1 << 16};
+    struct {
+        char *cpal_gp;
+        unsigned long long cpall;
+        unsigned long long filel;
+        char *buffer_gp;
+        struct GPLGenC *ctx_p;
+        unsigned long long offset;
+        unsigned long long size;
+        unsigned int cases;
+        unsigned int different;
+        int code;
+    } tmp_s;
+    memset(&tmp_s, 0, sizeof(tmp_s));
+
+    tmp_s.buffer_gp = malloc(sizeof(char) * cap_a[2]);
+
+    for (int arg = 1; arg < argc; arg++) {
+        tmp_s.cpal_gp = gplgen_cpal(
+            arg_gap[arg],
+            &tmp_s.cpall,
+            &tmp_s.filel,
+            &tmp_s.code
+        );
+
+        for (unsigned char cap = 0; cap < 3; cap++) {
+            tmp_s.ctx_p = gplgen_open(arg_gap[arg], &tmp_s.code);
+            tmp_s.offset = 0;
+            tmp_s.cases++;
+
+            /* Each chunk against the same bytes of the palette string. */
+            while ((tmp_s.size = gplgen_next_chunk(
+                    tmp_s.ctx_p,
+                    tmp_s.buffer_gp,
+                    cap_a[cap]
+                  )) > 0) {
+                if (tmp_s.size > cap_a[cap]
+                      || tmp_s.size > tmp_s.cpall - tmp_s.offset
+                      || memcmp(
+                          tmp_s.buffer_gp,
+                          &tmp_s.cpal_gp[tmp_s.offset],
+                          tmp_s.size
+                        ) != 0)
+                    break;
+                tmp_s.offset += tmp_s.size;
+            }
+            gplgen_close(tmp_s.ctx_p);
+
+            if (tmp_s.size || tmp_s.offset != tmp_s.cpall) {
+                fprintf(
+                    stderr,
+                    "%s: cap %llu: different after %llu of %llu bytes\n",
+                    arg_gap[arg],
+                    cap_a[cap],
+                    tmp_s.offset,
+                    tmp_s.cpall
+                );
+                tmp_s.different++;
+            }
+        }
+
+        gplgen_free(tmp_s.cpal_gp);
+    }
+
+    printf(
+        "pull: %u of %u caps different\n",
+        tmp_s.different,
+        tmp_s.cases
+    );
+
+    /*
+     * Free unused memory.
+     * 0 == '\0' == NULL
+     */
+    free(tmp_s.buffer_gp);
+
+    return tmp_s.different ? 1 : 0;
+}
@@ -0,0 +1,209 @@
+/* C17 - ISO/IEC 9899:2018 standard revision */
+
+/*
+ * A GIMP palette generator (server test)
+ * Copyright (C) 2022 Márcio Silva <coadde@hyperbola.info>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Test of the serve subcommand (make verify_cases):
+ *
+ *     gplgen_serve COMMAND SOCKET CONFIG OUTPUT...
+ *
+ * "COMMAND serve SOCKET" is started, each CONFIG is asked twice
+ * (made, then from the cache) and both bodies are compared with its
+ * OUTPUT file, the stats must count the second ones as hits
+ * and the server must stop without errors on SIGTERM.
+ * The exit status is 1 if any is different.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Read a whole file (or socket) to a new buffer, NULL on errors. */
+static char *
+read_f(int file, size_t *lenght_p)
+{
+    size_t size = 1 << 12;
+    char *data_gp = malloc(sizeof(char) * size);
+    ssize_t count;
+
+    *lenght_p = 0;
+    while ((count = read(file, &data_gp[*lenght_p], size - *lenght_p)) > 0) {
+        *lenght_p += count;
+        if (*lenght_p == size)
+            data_gp = realloc(data_gp, sizeof(char) * (size *= 2));
+    }
+    if (count < 0) {
+        free(data_gp);
+        return NULL;
+    }
+
+    return data_gp;
+}
+
+static char *
+file_f(const char *path_gp, size_t *lenght_p)
+{
+    FILE *file_lp = fopen(path_gp, "r");
+    char *data_gp;
+
+    if (! file_lp)
+        return NULL;
+    data_gp = read_f(fileno(file_lp), lenght_p);
+    fclose(file_lp);
+
+    return data_gp;
+}
+
+/* A request on the socket and its body (the connection is refused: NULL). */
+static char *
+request_f(const char *socket_gp, const char *request_gp, size_t requestl, size_t *bodyl_p)
+{
+    struct sockaddr_un address_s;
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    char *body_gp = NULL;
+
+    memset(&address_s, 0, sizeof(address_s));
+    address_s.sun_family = AF_UNIX;
+    strncpy(address_s.sun_path, socket_gp, sizeof(address_s.sun_path) - 1);
+
+    if (client >= 0
+          && connect(client, (struct sockaddr *)&address_s, sizeof(address_s)) == 0
+          && write(client, request_gp, requestl) == (ssize_t)requestl
+          && shutdown(client, SHUT_WR) == 0)
+        body_gp = read_f(client, bodyl_p);
+    if (client >= 0)
+        close(client);
+
+    return body_gp;
+}
+
+int
+main(int argc, char *arg_gap[])
+{
+    struct {
+        pid_t server;
+        int status;
+        char *config_gp;
+        size_t configl;
+        char *output_gp;
+        size_t outputl;
+        char *body_gp;
+        size_t bodyl;
+        char hits_g[32];
+        unsigned int requests;
+        unsigned int different;
+    } tmp_s;
+    memset(&tmp_s, 0, sizeof(tmp_s));
+
+    if (argc < 3 || argc % 2 == 0) {
+        fprintf(stderr, "%s COMMAND SOCKET CONFIG OUTPUT...\n", arg_gap[0]);
+        return 1;
+    }
+
+    unlink(arg_gap[2]);
+    tmp_s.server = fork();
+    if (! tmp_s.server) {
+        execl(arg_gap[1], arg_gap[1], "serve", arg_gap[2], (char *)NULL);
+        _exit(127);
+    }
+
+    /* Wait for the socket (the stats answer), 5 seconds at most. */
+    for (unsigned short wait = 0; wait < 500; wait++) {
+        struct timespec time_s = {0, 10000000};
+
+        tmp_s.body_gp = request_f(arg_gap[2], "stats", 5, &tmp_s.bodyl);
+        if (tmp_s.body_gp)
+            break;
+        nanosleep(&time_s, NULL);
+    }
+    free(tmp_s.body_gp);
+    tmp_s.body_gp = NULL;
+
+    for (int arg = 3; arg + 1 < argc; arg += 2) {
+        tmp_s.config_gp = file_f(arg_gap[arg], &tmp_s.configl);
+        tmp_s.output_gp = file_f(arg_gap[arg + 1], &tmp_s.outputl);
+
+        for (unsigned char ask = 0; ask < 2; ask++) {
+            if (tmp_s.config_gp)
+                tmp_s.body_gp = request_f(
+                    arg_gap[2],
+                    tmp_s.config_gp,
+                    tmp_s.configl,
+                    &tmp_s.bodyl
+                );
+            tmp_s.requests++;
+
+            if (! tmp_s.body_gp || ! tmp_s.output_gp
+                  || tmp_s.bodyl != tmp_s.outputl
+                  || memcmp(tmp_s.body_gp, tmp_s.output_gp, tmp_s.bodyl) != 0) {
+                fprintf(stderr, "%s: request %u: different\n", arg_gap[arg], ask + 1);
+                tmp_s.different++;
+            }
+
+            free(tmp_s.body_gp);
+            tmp_s.body_gp = NULL;
+        }
+
+        free(tmp_s.config_gp);
+        free(tmp_s.output_gp);
+    }
+
+    /* The second request of each config is a hit. */
+    sprintf(tmp_s.hits_g, "\nhits = %u\n", tmp_s.requests/2);
+    tmp_s.body_gp = request_f(arg_gap[2], "stats", 5, &tmp_s.bodyl);
+    tmp_s.body_gp = tmp_s.body_gp ? realloc(tmp_s.body_gp, tmp_s.bodyl + 1) : NULL;
+    if (tmp_s.body_gp)
+        tmp_s.body_gp[tmp_s.bodyl] = '\0';
+    if (! tmp_s.body_gp || ! strstr(tmp_s.body_gp, tmp_s.hits_g)) {
+        fprintf(stderr, "%s: stats: different\n", arg_gap[2]);
+        tmp_s.different++;
+    }
+    tmp_s.requests++;
+
+    kill(tmp_s.server, SIGTERM);
+    waitpid(tmp_s.server, &tmp_s.status, 0);
+    if (! WIFEXITED(tmp_s.status) || WEXITSTATUS(tmp_s.status)) {
+        fprintf(stderr, "%s: the server did not stop without errors\n", arg_gap[1]);
+        tmp_s.different++;
+    }
+    unlink(arg_gap[2]);
+
+    printf(
+        "serve: %u of %u requests different\n",
+        tmp_s.different,
+        tmp_s.requests
+    );
+
+    /*
+     * Free unused memory.
+     * 0 == '\0' == NULL
+     */
+    free(tmp_s.body_gp);
+
+    return tmp_s.different ? 1 : 0;
+}